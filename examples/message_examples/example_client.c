@@ -50,7 +50,7 @@ int send_and_receive(ClientContext* client, Message* msg) {
 
     ssize_t received = receive_data(client, recv_buffer, BUFFER_SIZE);
     if (received > 0) {
-        if (deserialize_message(recv_buffer, received, &response) == SUCCESS) {
+        if (deserialize_message(recv_buffer, received, &response) > 0) {
             LOG_INFO("Received response type %d, sequence %lu", 
                     response.type, response.sequence_num);
             return SUCCESS;
@@ -62,7 +62,7 @@ int send_and_receive(ClientContext* client, Message* msg) {
 
 void send_orders(ClientContext* client) {
     Order buy_order = {
-        .order_id = 1001,
+        .client_order_id = 1001,
         .type = ORDER_TYPE_MARKET,
         .side = ORDER_SIDE_BUY,
         .status = ORDER_STATUS_NEW,
@@ -70,9 +70,9 @@ void send_orders(ClientContext* client) {
         .quantity = 100,
         .filled_quantity = 0,
         .remaining_quantity = 100,
-        .creation_time = time(NULL),
-        .modification_time = time(NULL),
-        .expiration_time = time(NULL) + 86400
+        .creation_time = clock_now_ns(),
+        .modification_time = clock_now_ns(),
+        .expiration_time = clock_now_ns() + 86400 * NANOS_PER_SECOND
     };
     strncpy(buy_order.symbol, "AAPL", MAX_SYMBOL_LENGTH);
     strncpy(buy_order.client_id, "CLIENT001", MAX_CLIENT_ID_LENGTH);
@@ -81,12 +81,12 @@ void send_orders(ClientContext* client) {
     Message buy_msg = {
         .type = MSG_ORDER_NEW,
         .sequence_num = 1,
-        .timestamp = time(NULL),
+        .timestamp = clock_now_ns(),
         .data.order = buy_order
     };
 
     Order sell_order = {
-        .order_id = 1002,
+        .client_order_id = 1002,
         .type = ORDER_TYPE_LIMIT,
         .side = ORDER_SIDE_SELL,
         .status = ORDER_STATUS_NEW,
@@ -94,9 +94,9 @@ void send_orders(ClientContext* client) {
         .quantity = 200,
         .filled_quantity = 0,
         .remaining_quantity = 200,
-        .creation_time = time(NULL),
-        .modification_time = time(NULL),
-        .expiration_time = time(NULL) + 86400 * 30
+        .creation_time = clock_now_ns(),
+        .modification_time = clock_now_ns(),
+        .expiration_time = clock_now_ns() + 30 * 86400 * NANOS_PER_SECOND
     };
     strncpy(sell_order.symbol, "MSFT", MAX_SYMBOL_LENGTH);
     strncpy(sell_order.client_id, "CLIENT001", MAX_CLIENT_ID_LENGTH);
@@ -105,7 +105,7 @@ void send_orders(ClientContext* client) {
     Message sell_msg = {
         .type = MSG_ORDER_NEW,
         .sequence_num = 2,
-        .timestamp = time(NULL),
+        .timestamp = clock_now_ns(),
         .data.order = sell_order
     };
 
@@ -123,14 +123,14 @@ void send_market_data(ClientContext* client) {
         .ask_size = 700,
         .volume = 1000000,
         .num_trades = 1250,
-        .timestamp = time(NULL)
+        .timestamp = clock_now_ns()
     };
     strncpy(data1.symbol, "AAPL", MAX_SYMBOL_LENGTH);
 
     Message mkt_msg1 = {
         .type = MSG_MARKET_DATA,
         .sequence_num = 3,
-        .timestamp = time(NULL),
+        .timestamp = clock_now_ns(),
         .data.market_data = data1
     };
 
@@ -143,14 +143,14 @@ void send_market_data(ClientContext* client) {
         .ask_size = 400,
         .volume = 750000,
         .num_trades = 980,
-        .timestamp = time(NULL)
+        .timestamp = clock_now_ns()
     };
     strncpy(data2.symbol, "MSFT", MAX_SYMBOL_LENGTH);
 
     Message mkt_msg2 = {
         .type = MSG_MARKET_DATA,
         .sequence_num = 4,
-        .timestamp = time(NULL),
+        .timestamp = clock_now_ns(),
         .data.market_data = data2
     };
 
@@ -158,13 +158,15 @@ void send_market_data(ClientContext* client) {
     send_and_receive(client, &mkt_msg2);
 }
 
+// Trades come only from the server's matching, so each of these is answered
+// with an MSG_ERROR
 void send_trade_executions(ClientContext* client) {
     TradeExecution trade1 = {
         .trade_id = 5001,
         .order_id = 1001,
         .price = double_to_price(150.50),
         .quantity = 100,
-        .timestamp = time(NULL)
+        .timestamp = clock_now_ns()
     };
     strncpy(trade1.symbol, "AAPL", MAX_SYMBOL_LENGTH);
     strncpy(trade1.buyer_id, "CLIENT001", MAX_CLIENT_ID_LENGTH);
@@ -173,7 +175,7 @@ void send_trade_executions(ClientContext* client) {
     Message trade_msg1 = {
         .type = MSG_TRADE_EXEC,
         .sequence_num = 5,
-        .timestamp = time(NULL),
+        .timestamp = clock_now_ns(),
         .data.trade = trade1
     };
 
@@ -182,7 +184,7 @@ void send_trade_executions(ClientContext* client) {
         .order_id = 1002,
         .price = double_to_price(280.75),
         .quantity = 200,
-        .timestamp = time(NULL)
+        .timestamp = clock_now_ns()
     };
     strncpy(trade2.symbol, "MSFT", MAX_SYMBOL_LENGTH);
     strncpy(trade2.buyer_id, "MARKET", MAX_CLIENT_ID_LENGTH);
@@ -191,7 +193,7 @@ void send_trade_executions(ClientContext* client) {
     Message trade_msg2 = {
         .type = MSG_TRADE_EXEC,
         .sequence_num = 6,
-        .timestamp = time(NULL),
+        .timestamp = clock_now_ns(),
         .data.trade = trade2
     };
 
@@ -203,13 +205,13 @@ void send_heartbeats(ClientContext* client) {
     Message heartbeat1 = {
         .type = MSG_HEARTBEAT,
         .sequence_num = 7,
-        .timestamp = time(NULL)
+        .timestamp = clock_now_ns()
     };
 
     Message heartbeat2 = {
         .type = MSG_HEARTBEAT,
         .sequence_num = 8,
-        .timestamp = time(NULL)
+        .timestamp = clock_now_ns()
     };
 
     send_and_receive(client, &heartbeat1);
@@ -16,6 +16,7 @@ void on_trade(const TradeExecution* trade, void* user_data __attribute__((unused
     LOG_INFO("Received trade execution:");
     LOG_INFO("  Trade ID: %lu", trade->trade_id);
     LOG_INFO("  Order ID: %lu", trade->order_id);
+    LOG_INFO("  Client Order ID: %lu", trade->client_order_id);
     LOG_INFO("  Symbol: %s", trade->symbol);
     LOG_INFO("  Price: %.2f", price_to_double(trade->price));
     LOG_INFO("  Quantity: %u", trade->quantity);
@@ -53,7 +54,7 @@ int main(void) {
     }
 
     Order order = {
-        .order_id = 12345,
+        .client_order_id = 12345,
         .type = ORDER_TYPE_LIMIT,
         .side = ORDER_SIDE_BUY,
         .status = ORDER_STATUS_NEW,
@@ -61,9 +62,9 @@ int main(void) {
         .quantity = 100,
         .filled_quantity = 0,
         .remaining_quantity = 100,
-        .creation_time = time(NULL),
-        .modification_time = time(NULL),
-        .expiration_time = time(NULL) + 86400
+        .creation_time = clock_now_ns(),
+        .modification_time = clock_now_ns(),
+        .expiration_time = clock_now_ns() + 86400 * NANOS_PER_SECOND
     };
     
     strncpy(order.symbol, "AAPL", MAX_SYMBOL_LENGTH);
@@ -76,8 +77,8 @@ int main(void) {
         return 1;
     }
 
-    LOG_INFO("Sent order: ID=%lu, Symbol=%s, Price=%.2f, Quantity=%u, Side=%s",
-             order.order_id, order.symbol, 
+    LOG_INFO("Sent order: Client ID=%lu, Symbol=%s, Price=%.2f, Quantity=%u, Side=%s",
+             order.client_order_id, order.symbol, 
              price_to_double(order.price), 
              order.quantity,
              order.side == ORDER_SIDE_BUY ? "BUY" : "SELL");
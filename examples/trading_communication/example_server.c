@@ -19,16 +19,17 @@ void example_handle_order(const Order* order, int client_socket) {
     Message response = {
         .type = MSG_TRADE_EXEC,
         .sequence_num = 1,
-        .timestamp = time(NULL)
+        .timestamp = clock_now_ns()
     };
 
     TradeExecution* trade = &response.data.trade;
     trade->trade_id = 98765;
     trade->order_id = order->order_id;
+    trade->client_order_id = order->client_order_id;
     strncpy(trade->symbol, order->symbol, MAX_SYMBOL_LENGTH);
     trade->price = order->price;
     trade->quantity = order->quantity;
-    trade->timestamp = time(NULL);
+    trade->timestamp = clock_now_ns();
     strncpy(trade->buyer_id, order->client_id, MAX_CLIENT_ID_LENGTH);
     strncpy(trade->seller_id, "MARKET", MAX_CLIENT_ID_LENGTH);
 
@@ -43,7 +44,7 @@ void example_handle_order(const Order* order, int client_socket) {
 
 void example_handle_client_message(ServerContext* context, int client_socket, const uint8_t* data, size_t size) {
     Message msg;
-    if (deserialize_message(data, size, &msg) == SUCCESS) {
+    if (deserialize_message(data, size, &msg) > 0) {
         switch (msg.type) {
             case MSG_ORDER_NEW:
                 // First process using the server's handler
@@ -25,6 +25,11 @@ void cleanup_client(ClientContext* context);
 // Message sending
 int send_order(ClientContext* context, const Order* order);
 int request_market_data(ClientContext* context, const char* symbol);
+// Ask for this client's PnL in a symbol, or over all symbols when symbol is NULL or empty
+int request_pnl(ClientContext* context, const char* symbol);
+// The receiver thread sends one every HEARTBEAT_INTERVAL_MS, so the server
+// never times out a connected client
+int send_heartbeat(ClientContext* context);
 ssize_t send_data(ClientContext* context, const void* data, size_t size);
 ssize_t receive_data(ClientContext* context, void* buffer, size_t size);
 
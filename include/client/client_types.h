@@ -34,8 +34,9 @@ typedef struct {
     uint64_t orders_sent;
     uint64_t trades_received;
     uint64_t errors_encountered;
-    time_t connect_time;
-    time_t last_heartbeat;
+    uint64_t sequence_gaps;         // Server messages missing from the session sequence
+    uint64_t connect_time;          // Nanoseconds since the epoch
+    uint64_t last_heartbeat;        // Nanoseconds since the epoch
 } ClientStats;
 
 // Client configuration
@@ -57,6 +58,7 @@ typedef struct {
     void (*on_order_status)(const Order* order, void* user_data);
     void (*on_trade)(const TradeExecution* trade, void* user_data);
     void (*on_error)(ErrorCode error, const char* message, void* user_data);
+    void (*on_pnl)(const PnlReport* report, void* user_data);
 } ClientCallbacks;
 
 // Client context
@@ -67,6 +69,8 @@ typedef struct {
     ClientConfig config;
     ClientCallbacks callbacks;
     void* user_data;
+    uint64_t sequence_num;          // Last outbound sequence number
+    uint64_t inbound_sequence;      // Last sequence number received this session
     pthread_t receiver_thread;
     pthread_mutex_t state_mutex;
     pthread_mutex_t stats_mutex;
@@ -0,0 +1,63 @@
+#ifndef TRADESYNTH_BINARY_LOG_H
+#define TRADESYNTH_BINARY_LOG_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stddef.h>
+
+// Binary log file layout:
+//   LogBinaryHeader, followed by site_count call-site entries
+//   (LogBinarySiteEntry + file, func and format strings), followed by
+//   records (LogBinaryRecordHeader + payload). A new header may follow
+//   at any record boundary when the logger is reopened in append mode.
+#define LOG_BINARY_MAGIC "TSLOGBIN"
+#define LOG_BINARY_MAGIC_LENGTH 8
+#define LOG_BINARY_VERSION 1
+
+// Site id used for records that carry preformatted text
+#define LOG_SITE_DYNAMIC 0xFFFFFFFFu
+
+// Maximum number of captured arguments per call site
+#define LOG_MAX_ARGS 16
+
+// Argument encodings in a record payload
+typedef enum {
+    LOG_ARG_INT = 1,      // 4 bytes (int and smaller, also '*' widths)
+    LOG_ARG_LONG = 2,     // 8 bytes (l, ll, z, j, t)
+    LOG_ARG_DOUBLE = 3,   // 8 bytes (L formats are not captured)
+    LOG_ARG_STRING = 4,   // uint16 length followed by the bytes
+    LOG_ARG_POINTER = 5   // 8 bytes
+} LogArgType;
+
+typedef struct {
+    char magic[LOG_BINARY_MAGIC_LENGTH];
+    uint32_t version;
+    uint32_t site_count;
+    uint64_t ticks_per_second;
+    uint64_t base_ticks;
+    int64_t base_realtime_ns;
+} LogBinaryHeader;
+
+typedef struct {
+    uint32_t id;
+    uint32_t level;
+    uint32_t line;
+    uint16_t file_length;
+    uint16_t func_length;
+    uint32_t format_length;
+} LogBinarySiteEntry;
+
+typedef struct {
+    uint32_t site_id;
+    uint16_t payload_size;
+    uint8_t level;
+    uint8_t reserved;
+    uint64_t ticks;
+} LogBinaryRecordHeader;
+
+// Format string handling
+int parse_log_format(const char* format, uint8_t* arg_types, int max_args);
+int format_log_payload(const char* format, const uint8_t* payload, size_t payload_size,
+                       char* buffer, size_t buffer_size);
+
+#endif // TRADESYNTH_BINARY_LOG_H
@@ -0,0 +1,103 @@
+#ifndef TRADESYNTH_CLOCK_H
+#define TRADESYNTH_CLOCK_H
+
+#include <stdint.h>
+#include <time.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#define NANOS_PER_SECOND 1000000000ULL
+#define NANOS_PER_MILLI 1000000ULL
+#define NANOS_PER_MICRO 1000ULL
+#define NANOS_PER_DAY (86400ULL * NANOS_PER_SECOND)
+
+// Set during calibration when the TSC is invariant (constant_tsc and
+// nonstop_tsc); otherwise the clock falls back to vDSO clock_gettime().
+extern int clock_tsc_usable;
+
+// Fixed-point ns-per-tick multiplier (32.32), valid after calibration
+extern uint64_t clock_ns_per_tick_q32;
+
+// Wall clock anchor taken at calibration
+extern uint64_t clock_base_ticks;
+extern uint64_t clock_base_realtime_ns;
+
+// Per-thread time of the inbound frame being processed
+extern __thread uint64_t clock_current_frame_ns;
+
+// Tick counter calibration (measured once, thread-safe)
+uint64_t clock_ticks_per_second(void);
+
+// Final stretch of clock_wait_until() that is spun rather than slept
+#define CLOCK_SPIN_NS 50000ULL
+
+/**
+ * Block until CLOCK_MONOTONIC_RAW reaches target_ns: sleep while the target
+ * is far off, then spin for the last CLOCK_SPIN_NS so pacing loops hit
+ * their schedule to within a few microseconds.
+ */
+void clock_wait_until(uint64_t target_ns);
+
+static inline uint64_t clock_monotonic_raw_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC_RAW, &ts);
+    return (uint64_t)ts.tv_sec * NANOS_PER_SECOND + (uint64_t)ts.tv_nsec;
+}
+
+/**
+ * Read the raw cycle counter. On x86 with an invariant TSC this is rdtsc,
+ * elsewhere it falls back to CLOCK_MONOTONIC_RAW in nanoseconds. Use
+ * clock_ticks_per_second() or clock_ticks_to_ns() to convert differences.
+ */
+static inline uint64_t clock_ticks(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    if (__builtin_expect(clock_tsc_usable, 1)) {
+        return __rdtsc();
+    }
+#endif
+    return clock_monotonic_raw_ns();
+}
+
+/**
+ * Convert a tick count (usually a difference) to nanoseconds.
+ */
+static inline uint64_t clock_ticks_to_ns(uint64_t ticks) {
+    return (uint64_t)(((unsigned __int128)ticks * clock_ns_per_tick_q32) >> 32);
+}
+
+/**
+ * Current time in nanoseconds since the epoch. Monotonic: it advances with
+ * the tick counter from a wall clock anchor taken at calibration, so it
+ * never steps with NTP adjustments.
+ */
+static inline uint64_t clock_now_ns(void) {
+    if (__builtin_expect(clock_base_realtime_ns == 0, 0)) {
+        clock_ticks_per_second();
+    }
+    return clock_base_realtime_ns + clock_ticks_to_ns(clock_ticks() - clock_base_ticks);
+}
+
+/**
+ * Take the timestamp for a new inbound frame. Every handler that runs for
+ * the frame reuses it through clock_frame_time().
+ */
+static inline uint64_t clock_frame_begin(void) {
+    clock_current_frame_ns = clock_now_ns();
+    return clock_current_frame_ns;
+}
+
+/**
+ * Timestamp of the frame being processed on this thread, or the current
+ * time when the thread is not processing a frame.
+ */
+static inline uint64_t clock_frame_time(void) {
+    return clock_current_frame_ns ? clock_current_frame_ns : clock_now_ns();
+}
+
+static inline void clock_frame_end(void) {
+    clock_current_frame_ns = 0;
+}
+
+#endif // TRADESYNTH_CLOCK_H
@@ -0,0 +1,65 @@
+#ifndef TRADESYNTH_LATENCY_H
+#define TRADESYNTH_LATENCY_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include "common/clock.h"
+
+// Log-linear (HDR-style) buckets: values below 2^(SUB_BITS+1) are exact,
+// larger values keep SUB_BITS bits of precision (about 3% relative error).
+#define LATENCY_SUB_BUCKET_BITS 5
+#define LATENCY_SUB_BUCKET_COUNT (1 << LATENCY_SUB_BUCKET_BITS)
+#define LATENCY_MAX_SHIFT 30
+#define LATENCY_BUCKET_COUNT (LATENCY_SUB_BUCKET_COUNT * (LATENCY_MAX_SHIFT + 2))
+#define LATENCY_MAX_TRACKABLE_NS ((uint64_t)(2 * LATENCY_SUB_BUCKET_COUNT - 1) << LATENCY_MAX_SHIFT)
+
+// Order pipeline stages
+typedef enum {
+    STAGE_RECV = 0,     // Kernel receive timestamp to user space
+    STAGE_DECODE,       // deserialize_message
+    STAGE_RISK,         // Pre-trade checks
+    STAGE_MATCH,        // Book update and matching
+    STAGE_ENCODE,       // serialize_message for responses
+    STAGE_SEND,         // send() of responses
+    STAGE_COUNT
+} LatencyStage;
+
+// Plain histogram, used for merged snapshots and by single-threaded tools
+typedef struct {
+    uint64_t counts[LATENCY_BUCKET_COUNT];
+    uint64_t total_count;
+    uint64_t sum;
+    uint64_t min;
+    uint64_t max;
+} LatencyHistogram;
+
+// Histogram operations
+void latency_histogram_reset(LatencyHistogram* histogram);
+void latency_histogram_record(LatencyHistogram* histogram, uint64_t value);
+void latency_histogram_merge(LatencyHistogram* dest, const LatencyHistogram* src);
+uint64_t latency_histogram_percentile(const LatencyHistogram* histogram, double percentile);
+double latency_histogram_mean(const LatencyHistogram* histogram);
+
+// HdrHistogram-compatible percentile distribution, values divided by unit_ns
+void latency_histogram_print_distribution(const LatencyHistogram* histogram, FILE* output,
+                                          double unit_ns);
+
+// Per-thread stage recording, merged on demand
+void latency_record(LatencyStage stage, uint64_t nanoseconds);
+int latency_snapshot(LatencyStage stage, LatencyHistogram* out);
+void latency_reset(void);
+void latency_dump(FILE* output);
+void latency_log_summary(void);
+const char* latency_stage_to_string(LatencyStage stage);
+
+/**
+ * Record the time since start_ticks against a stage and return the current
+ * tick count so consecutive stages can be chained without extra clock reads.
+ */
+static inline uint64_t latency_record_since(LatencyStage stage, uint64_t start_ticks) {
+    uint64_t now = clock_ticks();
+    latency_record(stage, clock_ticks_to_ns(now - start_ticks));
+    return now;
+}
+
+#endif // TRADESYNTH_LATENCY_H
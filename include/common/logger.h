@@ -2,10 +2,13 @@
 #define TRADESYNTH_LOGGER_H
 
 #include <stdio.h>
+#include <stdint.h>
 #include <time.h>
 #include <string.h>
 #include <stdarg.h>
 #include <pthread.h>
+#include "common/binary_log.h"
+#include "common/clock.h"
 
 typedef enum {
     LOG_TRACE,
@@ -16,11 +19,28 @@ typedef enum {
     LOG_FATAL
 } LogLevel;
 
+// What a thread does when its log ring is full
+typedef enum {
+    LOG_OVERFLOW_DROP,   // Discard the record and count it (never blocks)
+    LOG_OVERFLOW_BLOCK   // Wait for the writer thread to make room
+} LogOverflowPolicy;
+
+// Output encoding
+typedef enum {
+    LOG_FORMAT_TEXT,     // Human-readable lines, formatted on the writer thread
+    LOG_FORMAT_BINARY    // Raw arguments, decoded offline by tradesynth_logcat
+} LogFormat;
+
 // Errors
 #define SUCCESS 0
 #define ERROR_INVALID_PARAM -1
 #define ERROR_FILE_OPEN -2
 
+// Asynchronous logger defaults
+#define LOG_DEFAULT_RING_CAPACITY 1024
+#define LOG_DEFAULT_FLUSH_INTERVAL_US 1000
+#define LOG_MAX_MESSAGE_LENGTH 216
+
 // Color codes for different log levels
 #define ANSI_COLOR_RED     "\x1b[31m"
 #define ANSI_COLOR_GREEN   "\x1b[32m"
@@ -30,26 +50,66 @@ typedef enum {
 #define ANSI_COLOR_CYAN    "\x1b[36m"
 #define ANSI_COLOR_RESET   "\x1b[0m"
 
+// Logger configuration
+typedef struct {
+    const char* log_file_path;          // NULL logs to stderr
+    LogLevel min_level;
+    LogOverflowPolicy overflow_policy;
+    uint32_t ring_capacity;             // Records per thread, rounded up to a power of two
+    uint32_t flush_interval_us;         // Writer thread idle sleep
+    int console_output;                 // Also echo records to stdout with colors (text only)
+    LogFormat format;
+} LoggerConfig;
+
+// Static description of one LOG_* call site. Every site is placed in the
+// tslog_sites section so the logger can enumerate them at startup and
+// write the format table into binary logs.
+typedef struct {
+    LogLevel level;
+    int line;
+    const char* file;
+    const char* func;
+    const char* format;
+    uint32_t id;                        // Assigned by init_logger()
+    int32_t num_args;                   // -1 if the format cannot be captured
+    uint8_t arg_types[LOG_MAX_ARGS];
+} LogSite;
+
 // Function declarations
 int init_logger(const char* log_file_path, LogLevel min_level);
-void log_message(LogLevel level, const char* file, int line, const char* func, const char* format, ...);
+int init_logger_with_config(const LoggerConfig* config);
+void log_message(LogLevel level, const char* file, int line, const char* func, const char* format, ...)
+    __attribute__((format(printf, 5, 6)));
+void log_site_message(LogSite* site, const char* format, ...) __attribute__((format(printf, 2, 3)));
+const char* log_level_to_string(LogLevel level);
+void flush_logger(void);
+uint64_t get_dropped_log_count(void);
 void close_logger(void);
 
+// Log from a call site registered in the format table
+#define LOG_AT(lvl, fmt, ...) \
+    do { \
+        static LogSite _log_site __attribute__((section("tslog_sites"), used, aligned(8))) = { \
+            .level = (lvl), .line = __LINE__, .file = __FILE__, .func = __func__, .format = (fmt) \
+        }; \
+        log_site_message(&_log_site, fmt, ##__VA_ARGS__); \
+    } while (0)
+
 // Convenience macros
-#define LOG_TRACE(...) log_message(LOG_TRACE, __FILE__, __LINE__, __func__, __VA_ARGS__)
-#define LOG_DEBUG(...) log_message(LOG_DEBUG, __FILE__, __LINE__, __func__, __VA_ARGS__)
-#define LOG_INFO(...)  log_message(LOG_INFO,  __FILE__, __LINE__, __func__, __VA_ARGS__)
-#define LOG_WARN(...)  log_message(LOG_WARN,  __FILE__, __LINE__, __func__, __VA_ARGS__)
-#define LOG_ERROR(...) log_message(LOG_ERROR, __FILE__, __LINE__, __func__, __VA_ARGS__)
-#define LOG_FATAL(...) log_message(LOG_FATAL, __FILE__, __LINE__, __func__, __VA_ARGS__)
-
-// Performance logging macros
+#define LOG_TRACE(...) LOG_AT(LOG_TRACE, __VA_ARGS__)
+#define LOG_DEBUG(...) LOG_AT(LOG_DEBUG, __VA_ARGS__)
+#define LOG_INFO(...)  LOG_AT(LOG_INFO,  __VA_ARGS__)
+#define LOG_WARN(...)  LOG_AT(LOG_WARN,  __VA_ARGS__)
+#define LOG_ERROR(...) LOG_AT(LOG_ERROR, __VA_ARGS__)
+#define LOG_FATAL(...) LOG_AT(LOG_FATAL, __VA_ARGS__)
+
+// Performance logging macros (wall time from the tick counter, in nanoseconds).
+// For continuous measurement use the stage histograms in common/latency.h.
 #define LOG_PERF_START(name) \
-    clock_t _start_##name = clock();
+    uint64_t _start_##name = clock_ticks();
 
 #define LOG_PERF_END(name) \
-    clock_t _end_##name = clock(); \
-    double _duration_##name = ((double)(_end_##name - _start_##name)) / CLOCKS_PER_SEC * 1000; \
-    LOG_DEBUG("Performance [%s]: %.2f ms", #name, _duration_##name);
+    uint64_t _duration_##name = clock_ticks_to_ns(clock_ticks() - _start_##name); \
+    LOG_DEBUG("Performance [%s]: %lu ns", #name, _duration_##name);
 
 #endif // TRADESYNTH_LOGGER_H
@@ -0,0 +1,176 @@
+#ifndef TRADESYNTH_METRICS_H
+#define TRADESYNTH_METRICS_H
+
+#include <stdio.h>
+#include <stddef.h>
+#include "common/types.h"
+#include "common/latency.h"
+
+// Live server statistics, published by the server's metrics thread into a
+// shared-memory segment (/dev/shm/NAME) and read by tradesynth_top or the
+// HTTP endpoint. The hot path only updates counters it owns; the metrics
+// thread copies them into the segment every interval, so readers never
+// touch a cache line the hot path writes. The segment is a seqlock:
+// generation is odd while a publish is in progress.
+#define METRICS_MAGIC "TSSTATS1"
+#define METRICS_VERSION 5
+#define METRICS_DEFAULT_INTERVAL_MS 100
+#define METRICS_MAX_THREADS 128
+#define METRICS_THREAD_NAME_LENGTH 16
+#define METRICS_ADDRESS_LENGTH 24       // "255.255.255.255:65535"
+
+// Histograms in the segment: the pipeline stages, then journal group commit
+#define METRICS_HISTOGRAM_JOURNAL_SYNC STAGE_COUNT
+#define METRICS_HISTOGRAM_COUNT (STAGE_COUNT + 1)
+
+typedef struct {
+    uint64_t total_connections;
+    uint64_t active_connections;
+    uint64_t messages_processed;
+    uint64_t messages_sent;
+    uint64_t errors_encountered;
+    uint64_t bytes_received;
+    uint64_t bytes_sent;
+    uint64_t journal_events;
+    uint64_t journal_bytes;
+    uint64_t journal_syncs;
+    uint64_t journal_queue_full;
+    uint64_t ticks_captured;
+    uint64_t ticks_dropped;
+    uint64_t risk_rejects;          // Orders stopped by any pre-trade check
+    uint64_t throttled;             // Inbound messages over a rate limit
+    uint64_t orders_expired;        // Past their expiration time or day end
+    uint64_t sessions_timed_out;    // Silent longer than the socket timeout
+} MetricsTotals;
+
+// One row per client slot; inactive slots keep their last values
+typedef struct {
+    uint32_t active;
+    uint32_t reserved;
+    char client_id[MAX_CLIENT_ID_LENGTH];
+    char address[METRICS_ADDRESS_LENGTH];
+    uint64_t connect_time;          // Nanoseconds since the epoch
+    uint64_t last_heartbeat;
+    uint64_t messages_received;
+    uint64_t messages_sent;
+    uint64_t bytes_received;
+} MetricsConnection;
+
+// One row per symbol id; prices are in ticks of 10^price_exponent, 0 if none
+typedef struct {
+    char symbol[MAX_SYMBOL_LENGTH];
+    int32_t price_exponent;
+    uint32_t bid_orders;            // Resting orders
+    uint32_t ask_orders;
+    uint32_t reserved;
+    int64_t best_bid;
+    int64_t best_ask;
+    uint64_t best_bid_size;         // Visible quantity at the best prices, without iceberg reserve
+    uint64_t best_ask_size;
+    int64_t last_price;
+    uint64_t orders;                // Orders accepted by the book this session
+    uint64_t trades;
+    uint64_t volume;
+} MetricsSymbol;
+
+// One row per registered thread slot; slots are reused as threads come and go
+typedef struct {
+    char name[METRICS_THREAD_NAME_LENGTH];
+    uint32_t active;
+    uint32_t tid;
+    uint64_t cpu_ns;                // Thread CPU time
+    uint64_t messages_processed;
+    uint64_t messages_sent;
+    uint64_t bytes_received;
+    uint64_t bytes_sent;
+    uint64_t errors;
+} MetricsThread;
+
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t header_size;           // Offset of the connection rows
+    uint64_t segment_size;
+    uint64_t generation;            // Seqlock, odd while the publisher writes
+    uint64_t publish_time;          // Nanoseconds since the epoch
+    uint64_t start_time;
+    uint32_t pid;
+    uint32_t interval_ms;
+    uint32_t connection_capacity;
+    uint32_t symbol_capacity;
+    uint32_t thread_capacity;
+    uint32_t symbol_count;          // Rows in use; connections and threads use their flags
+    MetricsTotals totals;
+    LatencyHistogram histograms[METRICS_HISTOGRAM_COUNT];
+} MetricsHeader;
+
+// Rows follow the header, connections then symbols then threads
+static inline MetricsConnection* metrics_connections(const MetricsHeader* header) {
+    return (MetricsConnection*)((char*)header + header->header_size);
+}
+
+static inline MetricsSymbol* metrics_symbols(const MetricsHeader* header) {
+    return (MetricsSymbol*)(metrics_connections(header) + header->connection_capacity);
+}
+
+static inline MetricsThread* metrics_threads(const MetricsHeader* header) {
+    return (MetricsThread*)(metrics_symbols(header) + header->symbol_capacity);
+}
+
+/**
+ * Size of a segment with the given row capacities.
+ */
+size_t metrics_segment_size(uint32_t connections, uint32_t symbols, uint32_t threads);
+
+/**
+ * Initialise a zeroed segment of metrics_segment_size() bytes.
+ */
+void metrics_segment_init(MetricsHeader* header, uint32_t connections, uint32_t symbols,
+                          uint32_t threads, uint32_t interval_ms);
+
+// Bracket every write to the segment; a single publisher is assumed
+static inline void metrics_publish_begin(MetricsHeader* header) {
+    __atomic_store_n(&header->generation, header->generation + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+}
+
+static inline void metrics_publish_end(MetricsHeader* header) {
+    __atomic_store_n(&header->generation, header->generation + 1, __ATOMIC_RELEASE);
+}
+
+// A segment mapped read-only, and a private copy of its last consistent state
+typedef struct {
+    const MetricsHeader* segment;
+    size_t map_size;
+    MetricsHeader* snapshot;
+} MetricsReader;
+
+/**
+ * Map a published segment for reading.
+ *
+ * @param name Shared-memory object name, e.g. "/tradesynth-8080".
+ * @return int SUCCESS, ERROR_INVALID_PARAM if it does not exist or
+ *         ERROR_INVALID_STATE if it is not a compatible segment.
+ */
+int metrics_reader_open(MetricsReader* reader, const char* name);
+void metrics_reader_close(MetricsReader* reader);
+
+/**
+ * Copy a consistent snapshot of the segment into reader->snapshot, retrying
+ * while a publish is in progress. Only the shared mapping is read.
+ *
+ * @return int SUCCESS, or ERROR_TIMEOUT if no stable copy could be taken.
+ */
+int metrics_reader_read(MetricsReader* reader);
+
+// Name of a segment histogram, e.g. "match" or "journal_sync"
+const char* metrics_histogram_name(int index);
+
+/**
+ * Write a snapshot in the Prometheus text exposition format.
+ *
+ * @return int SUCCESS, or ERROR_INVALID_STATE on an output error.
+ */
+int metrics_write_prometheus(const MetricsHeader* snapshot, FILE* output);
+
+#endif // TRADESYNTH_METRICS_H
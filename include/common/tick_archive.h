@@ -0,0 +1,116 @@
+#ifndef TRADESYNTH_TICK_ARCHIVE_H
+#define TRADESYNTH_TICK_ARCHIVE_H
+
+#include "common/tick_store.h"
+
+// Columnar archive of one symbol-day of ticks, built from tick files by
+// tradesynth_compact. Records are cut into blocks of
+// TICK_ARCHIVE_BLOCK_RECORDS; within a block every column is stored
+// separately as zigzag-encoded deltas, bit-packed at the narrowest width
+// that fits the block. Values are split round-robin over four lanes and
+// each lane is delta-coded and packed on its own, so decoding runs four
+// values per step with vector shifts, masks and adds.
+//
+// Layout: TickArchiveHeader, the blocks (each a TickArchiveChunk per
+// column followed by the packed column words), then the block index
+// (one TickArchiveBlock per block) at header.index_offset.
+#define TICK_ARCHIVE_MAGIC "TSARCHV1"
+#define TICK_ARCHIVE_VERSION 1
+#define TICK_ARCHIVE_BLOCK_RECORDS 1024
+#define TICK_ARCHIVE_LANES 4
+
+typedef enum {
+    TICK_COLUMN_TIMESTAMP,
+    TICK_COLUMN_TYPE,
+    TICK_COLUMN_QUANTITY,
+    TICK_COLUMN_PRICE,
+    TICK_COLUMN_BID,
+    TICK_COLUMN_ASK,
+    TICK_COLUMN_BID_SIZE,
+    TICK_COLUMN_ASK_SIZE,
+    TICK_COLUMN_VOLUME,
+    TICK_COLUMN_ID,
+    TICK_COLUMN_COUNT
+} TickColumn;
+
+#define TICK_COLUMN_BIT(column) (1u << (column))
+#define TICK_COLUMNS_ALL ((1u << TICK_COLUMN_COUNT) - 1)
+
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t block_records;
+    char symbol[MAX_SYMBOL_LENGTH];
+    int32_t price_exponent;
+    uint32_t day;
+    uint64_t record_count;
+    uint64_t block_count;
+    uint64_t index_offset;
+    uint64_t min_timestamp;
+    uint64_t max_timestamp;
+} TickArchiveHeader;
+
+// Block index entry; timestamps bound the block so scans skip it unread
+typedef struct {
+    uint64_t min_timestamp;
+    uint64_t max_timestamp;
+    uint64_t offset;            // From the start of the file
+    uint32_t record_count;
+    uint32_t size;
+} TickArchiveBlock;
+
+// Column header inside a block
+typedef struct {
+    int64_t base[TICK_ARCHIVE_LANES];   // First value of each lane
+    uint32_t offset;                    // Packed words, from the block start
+    uint32_t width;                     // Bits per value, 0 if the column is constant per lane
+} TickArchiveChunk;
+
+// An archive mapped read-only
+typedef struct {
+    const TickArchiveHeader* header;
+    const TickArchiveBlock* blocks;
+    const uint8_t* data;
+    size_t map_size;
+} TickArchive;
+
+// Decoded rows of one block; columns that were not requested are NULL
+typedef struct {
+    uint32_t count;
+    const int64_t* columns[TICK_COLUMN_COUNT];
+} TickBlockView;
+
+// Return non-zero to stop the scan
+typedef int (*TickArchiveScanFn)(const TickBlockView* view, void* arg);
+
+/**
+ * Compact tick files of one symbol and day into an archive. Records keep
+ * the order of the inputs, so segments should be passed in order.
+ *
+ * @return int SUCCESS, ERROR_INVALID_PARAM if the inputs disagree on
+ *         symbol or tick size, ERROR_MEMORY_ALLOC, or ERROR_INVALID_STATE
+ *         if the archive cannot be written.
+ */
+int tick_archive_write(const char* path, const TickFile* files, int file_count);
+
+/**
+ * Map an archive for scanning.
+ *
+ * @return int SUCCESS, ERROR_INVALID_PARAM if the file cannot be opened or
+ *         ERROR_INVALID_STATE if it is not a compatible archive.
+ */
+int tick_archive_open(TickArchive* archive, const char* path);
+void tick_archive_close(TickArchive* archive);
+
+/**
+ * Decode the requested columns of every block overlapping
+ * [start_ns, end_ns) and pass the rows inside that range to fn, a block
+ * at a time. Blocks outside the range are skipped through the index.
+ *
+ * @param columns Mask of TICK_COLUMN_BIT() values.
+ * @return int64_t Rows passed to fn, or a negative error.
+ */
+int64_t tick_archive_scan(const TickArchive* archive, uint64_t start_ns, uint64_t end_ns,
+                          uint32_t columns, TickArchiveScanFn fn, void* arg);
+
+#endif // TRADESYNTH_TICK_ARCHIVE_H
@@ -0,0 +1,81 @@
+#ifndef TRADESYNTH_TICK_STORE_H
+#define TRADESYNTH_TICK_STORE_H
+
+#include <stddef.h>
+#include "common/types.h"
+
+// Tick files hold fixed-size records of captured market data and trades,
+// one file per symbol and UTC day: DIR/YYYYMMDD/SYMBOL.ticks, with
+// SYMBOL.N.ticks segments once a file fills. Files are preallocated and
+// written through a shared mapping; record_count in the header is
+// published after each record, so readers may map a file while it grows.
+#define TICK_STORE_MAGIC "TSTICKS1"
+#define TICK_STORE_VERSION 1
+#define TICK_STORE_DEFAULT_RECORDS (1u << 20)
+
+typedef enum {
+    TICK_MARKET_DATA = 1,
+    TICK_TRADE = 2
+} TickType;
+
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t record_size;
+    char symbol[MAX_SYMBOL_LENGTH];
+    int32_t price_exponent;     // Every price in the file is in ticks of 10^price_exponent
+    uint32_t day;               // Days since the epoch (UTC)
+    uint64_t capacity;          // Records the file was preallocated for
+    uint64_t record_count;      // Published with release stores by the writer
+    uint64_t created_ns;
+} TickFileHeader;
+
+// One cache line per record
+typedef struct {
+    uint64_t timestamp;         // Capture time, nanoseconds since the epoch
+    uint32_t type;              // TickType
+    uint32_t quantity;          // Trade quantity, or last size for market data
+    int64_t price;              // Trade price or last price
+    int64_t bid;                // Quote in force when the tick was captured
+    int64_t ask;
+    uint32_t bid_size;
+    uint32_t ask_size;
+    uint64_t volume;            // Cumulative volume after this tick
+    uint64_t id;                // Trade id, or the reported trade count for market data
+} TickRecord;
+
+// A tick file mapped read-only
+typedef struct {
+    const TickFileHeader* header;
+    const TickRecord* records;
+    size_t map_size;
+} TickFile;
+
+/**
+ * Build the path of a tick file segment.
+ *
+ * @return int Length of the path, or -1 if it does not fit.
+ */
+int tick_file_path(char* buffer, size_t size, const char* dir, const char* symbol,
+                   uint32_t day, uint32_t segment);
+
+/**
+ * Map a tick file for reading. Records are read in place from the
+ * mapping; nothing is copied.
+ *
+ * @return int SUCCESS, ERROR_INVALID_PARAM if the file cannot be opened or
+ *         ERROR_INVALID_STATE if it is not a compatible tick file.
+ */
+int tick_file_open(TickFile* file, const char* path);
+void tick_file_close(TickFile* file);
+
+// Records visible so far; grows while the server is writing the file
+static inline uint64_t tick_file_count(const TickFile* file) {
+    return __atomic_load_n(&file->header->record_count, __ATOMIC_ACQUIRE);
+}
+
+static inline Price tick_price(const TickFile* file, int64_t ticks) {
+    return price_from_ticks(ticks, file->header->price_exponent);
+}
+
+#endif // TRADESYNTH_TICK_STORE_H
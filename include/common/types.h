@@ -5,7 +5,6 @@
 #include <stdint.h>
 #include <sys/socket.h>
 #include <netinet/in.h>
-#include <math.h>
 #include <pthread.h>
 
 // Constants
@@ -15,6 +14,11 @@
 #define BUFFER_SIZE 4096
 #define MAX_CLIENTS 100
 
+// Fixed-point prices
+#define PRICE_MAX_EXPONENT 18
+#define DEFAULT_PRICE_EXPONENT -6
+#define DEFAULT_TICK_EXPONENT -2
+
 // Error codes
 typedef enum {
     SUCCESS = 0,
@@ -33,7 +37,8 @@ typedef enum {
     ERROR_INVALID_MESSAGE = -13,
     ERROR_INVALID_ORDER = -14,
     ERROR_ORDER_NOT_FOUND = -15,
-    ERROR_MARKET_DATA = -16
+    ERROR_MARKET_DATA = -16,
+    ERROR_THROTTLED = -17           // Message over a session or client rate limit
 } ErrorCode;
 
 // Message types
@@ -46,7 +51,8 @@ typedef enum {
     MSG_ORDER_STATUS = 5,
     MSG_MARKET_DATA = 6,
     MSG_TRADE_EXEC = 7,
-    MSG_ERROR = 8
+    MSG_ERROR = 8,
+    MSG_PNL = 9                     // PnL query, answered with the filled-in report
 } MessageType;
 
 // Order types
@@ -88,7 +94,8 @@ typedef struct {
 
 // Order structure
 typedef struct {
-    uint64_t order_id;
+    uint64_t order_id;              // Assigned by the server; cancels and modifies name it
+    uint64_t client_order_id;       // The client's own reference, echoed on statuses and trades
     char symbol[MAX_SYMBOL_LENGTH];
     char client_id[MAX_CLIENT_ID_LENGTH];
     OrderType type;
@@ -96,12 +103,15 @@ typedef struct {
     OrderStatus status;
     TimeInForce time_in_force;
     Price price;
+    Price stop_price;               // Trigger of stop and stop-limit orders
     uint32_t quantity;
     uint32_t filled_quantity;
     uint32_t remaining_quantity;
-    time_t creation_time;
-    time_t modification_time;
-    time_t expiration_time;
+    uint32_t display_quantity;      // Iceberg slice shown at a time, 0 to show it all
+    uint32_t visible_quantity;      // Of the remaining quantity, the part shown while it rests
+    uint64_t creation_time;         // Nanoseconds since the epoch
+    uint64_t modification_time;     // Nanoseconds since the epoch
+    uint64_t expiration_time;       // Nanoseconds since the epoch, 0 for none
 } Order;
 
 // Market Data structure
@@ -115,30 +125,48 @@ typedef struct {
     uint32_t ask_size;
     uint64_t volume;
     uint32_t num_trades;
-    time_t timestamp;
+    uint64_t timestamp;             // Nanoseconds since the epoch
+    Price indicative_price;         // Uncross price while the symbol is in a call auction, zero otherwise
+    uint64_t indicative_volume;     // Quantity that would trade at it
 } MarketData;
 
 // Trade execution structure
 typedef struct {
     uint64_t trade_id;
-    uint64_t order_id;
+    uint64_t order_id;              // Of the aggressor
+    uint64_t client_order_id;       // The aggressor's client order id
     char symbol[MAX_SYMBOL_LENGTH];
     Price price;
     uint32_t quantity;
-    time_t timestamp;
+    uint64_t timestamp;             // Nanoseconds since the epoch
     char buyer_id[MAX_CLIENT_ID_LENGTH];
     char seller_id[MAX_CLIENT_ID_LENGTH];
 } TradeExecution;
 
+// Profit and loss of a client in one symbol, or over all symbols when the
+// symbol is empty. Amounts are in currency units; per-symbol fields are
+// zero in the totals.
+typedef struct {
+    char client_id[MAX_CLIENT_ID_LENGTH];
+    char symbol[MAX_SYMBOL_LENGTH];
+    int64_t position;               // Net filled quantity, negative when short
+    Price average_price;            // Per share, of the open position
+    Price mark;                     // Last trade the position is valued at
+    Price realized_pnl;             // Closed since the session started
+    Price unrealized_pnl;           // Open position at the mark
+    uint64_t timestamp;             // Nanoseconds since the epoch
+} PnlReport;
+
 // Message structure
 typedef struct {
     MessageType type;
     uint64_t sequence_num;
-    time_t timestamp;
+    uint64_t timestamp;             // Nanoseconds since the epoch
     union {
         Order order;
         MarketData market_data;
         TradeExecution trade;
+        PnlReport pnl;
         struct {
             ErrorCode code;
             char message[MAX_ERROR_MSG_LENGTH];
@@ -149,20 +177,88 @@ typedef struct {
 // Forward declaration
 struct ServerContext;
 
+// Powers of ten for exact integer rescaling (10^0 .. 10^18)
+static const int64_t PRICE_POW10[PRICE_MAX_EXPONENT + 1] = {
+    1LL,
+    10LL,
+    100LL,
+    1000LL,
+    10000LL,
+    100000LL,
+    1000000LL,
+    10000000LL,
+    100000000LL,
+    1000000000LL,
+    10000000000LL,
+    100000000000LL,
+    1000000000000LL,
+    10000000000000LL,
+    100000000000000LL,
+    1000000000000000LL,
+    10000000000000000LL,
+    100000000000000000LL,
+    1000000000000000000LL
+};
+
 // Price manipulation functions
 static inline Price create_price(int64_t mantissa, int32_t exponent) {
     Price p = {mantissa, exponent};
     return p;
 }
 
+/**
+ * Convert a price to double. For display only: matching, risk and
+ * comparisons work on integer ticks.
+ */
 static inline double price_to_double(Price p) {
-    return (double)p.mantissa * pow(10, p.exponent);
+    if (p.exponent >= 0) {
+        int32_t e = p.exponent > PRICE_MAX_EXPONENT ? PRICE_MAX_EXPONENT : p.exponent;
+        return (double)p.mantissa * (double)PRICE_POW10[e];
+    }
+    int32_t e = -p.exponent > PRICE_MAX_EXPONENT ? PRICE_MAX_EXPONENT : -p.exponent;
+    return (double)p.mantissa / (double)PRICE_POW10[e];
 }
 
+/**
+ * Convert a double to a price with DEFAULT_PRICE_EXPONENT decimals,
+ * rounding to the nearest representable value. Intended for user input.
+ */
 static inline Price double_to_price(double value) {
     Price p;
-    p.exponent = -6;  // 6 decimal places precision
-    p.mantissa = (int64_t)(value * pow(10, -p.exponent));
+    p.exponent = DEFAULT_PRICE_EXPONENT;
+    double scaled = value * (double)PRICE_POW10[-DEFAULT_PRICE_EXPONENT];
+    p.mantissa = (int64_t)(scaled >= 0 ? scaled + 0.5 : scaled - 0.5);
+    return p;
+}
+
+/**
+ * Express a price as an integer number of ticks of 10^tick_exponent.
+ *
+ * @param p Price to convert.
+ * @param tick_exponent Exponent of one tick (e.g. -2 for cents).
+ * @param ticks Output tick count.
+ * @return int 0 on success, -1 if the price is not a whole number of
+ *         ticks or does not fit in 64 bits.
+ */
+static inline int price_to_ticks(Price p, int32_t tick_exponent, int64_t* ticks) {
+    int32_t shift = p.exponent - tick_exponent;
+    if (shift == 0 || p.mantissa == 0) {
+        *ticks = p.mantissa;
+        return 0;
+    }
+    if (shift > PRICE_MAX_EXPONENT || -shift > PRICE_MAX_EXPONENT) return -1;
+
+    if (shift > 0) {
+        return __builtin_mul_overflow(p.mantissa, PRICE_POW10[shift], ticks) ? -1 : 0;
+    }
+    int64_t divisor = PRICE_POW10[-shift];
+    if (p.mantissa % divisor != 0) return -1;
+    *ticks = p.mantissa / divisor;
+    return 0;
+}
+
+static inline Price price_from_ticks(int64_t ticks, int32_t tick_exponent) {
+    Price p = {ticks, tick_exponent};
     return p;
 }
 
@@ -10,8 +10,8 @@
 #include <math.h>
 
 // Time utilities
-time_t get_current_timestamp(void);
-char* format_timestamp(time_t timestamp, char* buffer, size_t buffer_size);
+uint64_t get_current_timestamp(void);
+char* format_timestamp(uint64_t timestamp_ns, char* buffer, size_t buffer_size);
 int64_t get_time_diff_ms(struct timespec* start, struct timespec* end);
 
 // String utilities
@@ -49,6 +49,7 @@ double calculate_vwap(const MarketData* data, const TradeExecution* trades, size
 int compare_prices(const Price* p1, const Price* p2);
 void normalize_price(Price* price);
 char* price_to_string(const Price* price, char* buffer, size_t buffer_size);
+size_t format_price(const Price* price, char* buffer, size_t buffer_size); // Length, 0 if it does not fit
 int parse_price_string(const char* str, Price* price);
 
 // Error handling
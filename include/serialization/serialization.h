@@ -7,7 +7,7 @@
 #include <string.h>
 #include <endian.h>
 
-#define SERIALIZATION_VERSION 1
+#define SERIALIZATION_VERSION 2
 #define MAX_MESSAGE_SIZE 8192
 
 typedef enum {
@@ -25,11 +25,18 @@ typedef struct {
     uint32_t message_size;
     MessageType type;
     uint32_t payload_size;
+    uint64_t sequence_num;
+    uint64_t timestamp;         // Nanoseconds since the epoch
     uint32_t checksum;
+    uint32_t reserved;
 } MessageHeader;
 
 // Function declarations
 int serialize_message(const Message* msg, uint8_t* buffer, size_t buffer_size);
+
+// Decode the first message in buffer. Returns the bytes it occupies, so a
+// stream can be walked message by message, SERIAL_ERROR_INCOMPLETE if more
+// data is needed, or another negative SerializationError.
 int deserialize_message(const uint8_t* buffer, size_t buffer_size, Message* msg);
 uint32_t calculate_checksum(const uint8_t* data, size_t size);
 int validate_message_header(const MessageHeader* header);
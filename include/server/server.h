@@ -13,13 +13,28 @@
 #include <arpa/inet.h>
 #include "common/types.h"
 #include "common/logger.h"
+#include "common/latency.h"
 #include "serialization/serialization.h"
 #include "server/server_types.h"
 #include "server/server_core.h"
 #include "server/server_network.h"
 #include "server/server_handlers.h"
+#include "server/server_symbols.h"
+#include "server/server_positions.h"
+#include "server/server_risk.h"
+#include "server/server_throttle.h"
+#include "server/server_timers.h"
+#include "server/server_orderbook.h"
+#include "server/server_journal.h"
+#include "server/server_snapshot.h"
+#include "server/server_tick_store.h"
+#include "server/server_metrics.h"
 
 // Shared extern declaration for server running flag
 extern volatile sig_atomic_t server_running;
 
+// Set by SIGUSR1 to request a latency summary from the main loop
+extern volatile sig_atomic_t latency_dump_requested;
+extern volatile sig_atomic_t risk_reload_requested;
+
 #endif // TRADESYNTH_SERVER_H
@@ -6,23 +6,57 @@
 #include "server/server_types.h"
 
 // Generic message handling function
-int handle_message(ServerContext* context, int client_socket, const Message* msg);
+int handle_message(ServerContext* context, ClientConnection* client, const Message* msg);
+
+/**
+ * Next id from the order or trade id space. Each thread reserves
+ * ID_BLOCK_SIZE ids at a time and hands them out locally, so ids are
+ * unique and increasing per thread but not ordered across threads.
+ */
 uint64_t generate_order_id(ServerContext* context);
 uint64_t generate_trade_id(ServerContext* context);
 
 // Message type handlers
-int handle_heartbeat(ServerContext* context, int client_socket, const Message* msg);
-int handle_order_message(ServerContext* context, int client_socket, const Message* msg);
-int handle_market_data(ServerContext* context, int client_socket, const Message* msg);
-int handle_trade_exec(ServerContext* context, int client_socket, const Message* msg);
-int handle_error(ServerContext* context, int client_socket, const Message* msg);
+int handle_heartbeat(ServerContext* context, ClientConnection* client, const Message* msg);
+int handle_order_message(ServerContext* context, ClientConnection* client, const Message* msg);
+int handle_market_data(ServerContext* context, ClientConnection* client, const Message* msg);
+int handle_trade_exec(ServerContext* context, ClientConnection* client, const Message* msg);
+int handle_error(ServerContext* context, ClientConnection* client, const Message* msg);
 
 // Core processing functions
+int process_order_message(ServerContext* context, const Message* msg);
 int process_order(ServerContext* context, const Order* order);
+int process_cancel_order(ServerContext* context, const Order* order);
+int process_modify_order(ServerContext* context, const Order* order);
+int process_order_status(ServerContext* context, const Order* order);
 int broadcast_market_data(ServerContext* context, const MarketData* market_data);
-int process_trade_execution(ServerContext* context, const TradeExecution* trade);
+
+// Cancel a book's orders whose deadlines have passed by now and tell their
+// owners; the timer tick calls it for books with a deadline due
+uint32_t expire_orders(ServerContext* context, OrderBook* book, uint64_t now);
+
+// Run a book's auction schedule up to now: uncross a call that has ended and
+// start one that has begun. Orders arriving at the book do the same first;
+// the timer tick calls it for books whose phase_due has passed.
+void advance_auction(ServerContext* context, OrderBook* book, uint64_t now);
+
+/**
+ * Send every client a book's indicative uncross price and volume while it
+ * is in a call and its orders changed since the last quote, and a zeroed
+ * quote once the call is over. Main thread only.
+ *
+ * @return int 1 if a quote went out.
+ */
+int publish_indicative(ServerContext* context, OrderBook* book);
+
+// Answer a MSG_PNL query with the session client's PnL in the named symbol,
+// or its totals when the symbol is empty. Reads positions without locking.
+int process_pnl_query(ServerContext* context, ClientConnection* client, const PnlReport* query);
 
 // Helper functions
 int send_response_message(int client_socket, const Message* response);
 
+// Send a MSG_ERROR on a session, in its outbound sequence
+int send_error(ClientConnection* client, ErrorCode code, const char* text);
+
 #endif // TRADESYNTH_SERVER_HANDLERS_H
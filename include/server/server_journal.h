@@ -0,0 +1,87 @@
+#ifndef TRADESYNTH_SERVER_JOURNAL_H
+#define TRADESYNTH_SERVER_JOURNAL_H
+
+#include "common/types.h"
+#include "server/server_types.h"
+
+// Write-ahead journal of inbound orders, cancels and trades. Producers
+// enqueue fixed-size records on a lock-free ring; a dedicated thread
+// writes them and group-commits with fdatasync.
+#define JOURNAL_MAGIC "TSJOURNL"
+#define JOURNAL_VERSION 4
+#define JOURNAL_QUEUE_CAPACITY 65536
+#define JOURNAL_DEFAULT_SYNC_INTERVAL_US 1000
+#define JOURNAL_DEFAULT_SYNC_EVENTS 1024
+
+typedef enum {
+    JOURNAL_ORDER_NEW = 1,
+    JOURNAL_ORDER_CANCEL = 2,
+    JOURNAL_ORDER_MODIFY = 3,
+    JOURNAL_TRADE = 4,
+    JOURNAL_AUCTION_CALL = 5,       // The order carries only the symbol and, as expiration_time, the uncross time
+    JOURNAL_AUCTION_UNCROSS = 6     // The order carries only the symbol
+} JournalEventType;
+
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t record_size;
+    uint64_t created_ns;
+} JournalFileHeader;
+
+typedef struct {
+    uint64_t sequence;          // Dense from 1 across restarts
+    uint64_t timestamp;         // Nanoseconds since the epoch
+    uint32_t type;              // JournalEventType
+    uint32_t checksum;          // Over every other field
+    union {
+        Order order;
+        TradeExecution trade;
+    } data;
+} JournalRecord;
+
+typedef struct Journal Journal;
+
+/**
+ * Open or create a journal and start its writer thread. An existing file
+ * is validated and any torn tail left by a crash is truncated.
+ *
+ * @param path Journal file path.
+ * @param sync_interval_us fdatasync at most this long after the first
+ *        unsynced write, 0 to disable the time trigger.
+ * @param sync_events fdatasync after this many unsynced records, 0 to
+ *        disable the count trigger. With both triggers disabled the
+ *        journal is written but left to kernel writeback.
+ * @param stats Server statistics receiving journal counters, may be NULL.
+ * @return Journal* Open journal, or NULL on error.
+ */
+Journal* journal_open(const char* path, uint32_t sync_interval_us, uint32_t sync_events,
+                      ServerStats* stats);
+void journal_close(Journal* journal);
+
+// Enqueue events and return their sequence, 0 without a journal. Never
+// blocks on I/O, only spins if the ring is full.
+uint64_t journal_append_order(Journal* journal, JournalEventType type, const Order* order);
+uint64_t journal_append_trade(Journal* journal, const TradeExecution* trade);
+
+// Non-zero once a write or fdatasync has failed, 0 without a journal. The
+// writer keeps draining the ring but writes nothing more, and the order
+// path refuses new orders and modifies, which could no longer be recovered.
+int journal_failed(Journal* journal);
+
+// Sequence of the last record enqueued
+uint64_t journal_last_sequence(Journal* journal);
+
+typedef int (*JournalReplayFn)(const JournalRecord* record, void* arg);
+
+/**
+ * Read a journal file and call fn for every record after after_sequence,
+ * in order. Records are fixed-size and dense, so the start is found by
+ * offset rather than by scanning. Stops at the first invalid record or
+ * when fn returns non-zero.
+ *
+ * @return int64_t Number of records passed to fn, or a negative error.
+ */
+int64_t journal_replay(const char* path, uint64_t after_sequence, JournalReplayFn fn, void* arg);
+
+#endif // TRADESYNTH_SERVER_JOURNAL_H
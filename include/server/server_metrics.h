@@ -0,0 +1,59 @@
+#ifndef TRADESYNTH_SERVER_METRICS_H
+#define TRADESYNTH_SERVER_METRICS_H
+
+#include "common/metrics.h"
+#include "server/server_types.h"
+
+// Publishing side of the stats segment (see common/metrics.h for the layout
+// and the reader). A metrics thread copies connection, symbol, thread and
+// latency counters into the segment every interval and, if enabled, serves
+// it over plaintext HTTP on 127.0.0.1 in the Prometheus text format.
+typedef struct Metrics Metrics;
+
+// Counters each thread keeps for itself on its own cache line
+typedef enum {
+    THREAD_MESSAGES_PROCESSED = 0,
+    THREAD_MESSAGES_SENT,
+    THREAD_BYTES_RECEIVED,
+    THREAD_BYTES_SENT,
+    THREAD_ERRORS,
+    THREAD_COUNTER_COUNT
+} ThreadCounter;
+
+/**
+ * Create the segment and start the metrics thread. Nothing is started if
+ * the configuration disables both the segment and the HTTP endpoint.
+ *
+ * @return int SUCCESS, ERROR_INVALID_STATE if the segment cannot be
+ *         created, ERROR_SOCKET_BIND if the HTTP port is unavailable or
+ *         ERROR_THREAD_CREATE.
+ */
+int metrics_start(ServerContext* context);
+
+// Publish once more, stop the thread and remove the segment
+void metrics_stop(ServerContext* context);
+
+/**
+ * Copy the current counters into the segment. Called by the metrics
+ * thread every interval; exposed for tests.
+ */
+void metrics_publish(ServerContext* context);
+
+// The segment as last published, NULL when metrics are not running
+const MetricsHeader* metrics_segment(const ServerContext* context);
+
+/**
+ * Name the calling thread in the per-thread rows, registering it if
+ * needed. Threads that never call this are registered on their first
+ * counter update as "thread".
+ */
+void metrics_thread_name(const char* name);
+
+/**
+ * Add to one of the calling thread's counters. Only the owning thread
+ * writes its slot, so this is a plain load and store with no locked
+ * instruction and no shared cache line.
+ */
+void metrics_thread_add(ThreadCounter counter, uint64_t amount);
+
+#endif // TRADESYNTH_SERVER_METRICS_H
@@ -0,0 +1,171 @@
+#ifndef TRADESYNTH_SERVER_ORDERBOOK_H
+#define TRADESYNTH_SERVER_ORDERBOOK_H
+
+#include "common/types.h"
+#include "server/server_types.h"
+
+// Price-time priority limit order book. Callers hold book->lock for
+// writing around every mutating call; nothing here does I/O.
+//
+// An iceberg rests with only display_quantity showing. Each slice queues
+// like an order of its own: once it fills the entry refills from the
+// hidden reserve and moves to the back of its level.
+//
+// Stop and stop-limit orders wait off the book in two more level arrays,
+// one per side, sorted so the nearest trigger is last. A trade only has to
+// look at that last level of each, and a sweep takes whole levels, so
+// releasing stops costs the number triggered, not the number pending. A
+// pending stop holds an entry and an order id like a resting order.
+//
+// A book in BOOK_PHASE_CALL matches nothing: limit orders rest, crossed or
+// not, stops stay parked and orders that cannot rest are refused. The
+// uncross then trades the crossed part at one price.
+#define ORDERBOOK_INITIAL_LEVELS 64
+
+typedef struct {
+    const Order* aggressor;     // Incoming order, or the buy in an uncross; quantities before this fill
+    const Order* resting;       // Book order, quantities before this fill
+    int64_t price;              // Ticks, the resting order's price or the uncross price
+    uint32_t quantity;
+    int uncross;                // Set when both orders were resting, in an auction uncross
+} OrderFill;
+
+// What an uncross would do now
+typedef struct {
+    int64_t price;              // Ticks, 0 when the book is not crossed
+    uint64_t volume;            // Quantity that would trade at it
+    int64_t imbalance;          // Buy quantity left over at it, negative for sell
+} AuctionQuote;
+
+// One price level as market data sees it: hidden iceberg reserve left out
+typedef struct {
+    int64_t price;              // Ticks
+    uint64_t quantity;          // Visible quantity
+    uint32_t order_count;
+} BookDepthLevel;
+
+typedef void (*OrderFillCallback)(OrderBook* book, const OrderFill* fill, void* arg);
+typedef void (*OrderBookVisitor)(const OrderBookEntry* entry, void* arg);
+
+// A released stop after it went through matching (rested, filled or
+// cancelled), or an expired order
+typedef void (*OrderReleaseCallback)(OrderBook* book, const Order* order, void* arg);
+
+// Market orders and IOC/FOK limit orders never rest, so never take an entry
+static inline int order_can_rest(const Order* order) {
+    return order->type != ORDER_TYPE_MARKET &&
+           order->time_in_force != TIF_IOC && order->time_in_force != TIF_FOK;
+}
+
+int orderbook_init(OrderBook* book, uint32_t max_orders);
+void orderbook_destroy(OrderBook* book);
+
+/**
+ * Match an incoming order against the book and rest any limit remainder.
+ * The order's filled/remaining quantities and status are updated in place.
+ * A stop is parked until the last trade reaches its stop price, or enters
+ * at once as a market (stop) or limit (stop-limit) order if it already has.
+ * A FOK the opposite side cannot fill within its limit is cancelled
+ * without a fill, judged from level totals before any queue is touched.
+ *
+ * @return int SUCCESS, ERROR_INVALID_ORDER for an off-tick price, a zero or
+ *         duplicate order id, a display quantity above the order's or an
+ *         order that cannot rest during a call,
+ *         ERROR_ORDERBOOK_FULL if the remainder cannot
+ *         rest (fills already made stand).
+ */
+int orderbook_add_order(OrderBook* book, Order* order, OrderFillCallback on_fill, void* arg);
+int orderbook_cancel_order(OrderBook* book, uint64_t order_id, Order* cancelled);
+
+/**
+ * Change the price and/or quantity of a resting order. A pure quantity
+ * reduction keeps time priority; anything else is cancel/replace and the
+ * replacement may trade. order carries the new values and receives the
+ * resulting state. quantity is the new size of the whole order, fills
+ * included; a replacement keeps the fills, and a size at or below them
+ * cancels what is left. An iceberg keeps its display quantity, unless
+ * that is now more than the whole order.
+ */
+int orderbook_modify_order(OrderBook* book, Order* order, OrderFillCallback on_fill, void* arg);
+
+/**
+ * Release the stops the book's last trade has reached into matching, those
+ * triggered together in arrival order, then any their own trades trigger.
+ * Call after every operation that may have traded. Nothing is released
+ * during a call.
+ *
+ * @return uint32_t Number of stops released.
+ */
+uint32_t orderbook_release_stops(OrderBook* book, OrderFillCallback on_fill,
+                                 OrderReleaseCallback on_release, void* arg);
+
+/**
+ * Cancel every resting order and pending stop whose deadline has passed by
+ * now (ns), reporting each as cancelled. A deadline is the order's
+ * expiration_time, or for a DAY order the book's next day end after it was
+ * entered, whichever is sooner; orders arm it as they rest.
+ *
+ * @return uint32_t Number of orders expired.
+ */
+uint32_t orderbook_expire(OrderBook* book, uint64_t now, OrderReleaseCallback on_expire, void* arg);
+
+// Rest an order (or park a stop) exactly as given, visible slice included,
+// behind any at its price, without matching
+int orderbook_restore_order(OrderBook* book, const Order* order);
+
+const OrderBookEntry* orderbook_find_order(const OrderBook* book, uint64_t order_id);
+
+/**
+ * Choose how incoming orders share a price level they do not take whole:
+ * price-time fills oldest first; pro-rata splits in proportion to the
+ * resting quantities, an order whose share comes to less than
+ * min_allocation getting none of it, with the remainder oldest first;
+ * hybrid fills fifo_percent of the incoming quantity oldest first and the
+ * rest pro-rata. Set after orderbook_init and before the book sees
+ * orders; the first pro-rata or hybrid policy sizes the book's sharing
+ * arrays to max_orders.
+ *
+ * @return int SUCCESS, ERROR_INVALID_PARAM for an unknown policy or a percentage over 100,
+ *         or ERROR_MEMORY_ALLOC if the sharing arrays cannot be allocated.
+ */
+int orderbook_set_match_policy(OrderBook* book, MatchPolicy policy, uint32_t min_allocation,
+                               uint32_t fifo_percent);
+
+// Visit resting orders bids then asks, best price first, in time priority,
+// then pending buy and sell stops, nearest trigger first
+void orderbook_for_each(const OrderBook* book, OrderBookVisitor visit, void* arg);
+
+// Copy the book's counters into its stats slot; call with the book write
+// locked after every change to it
+void orderbook_publish_stats(OrderBook* book);
+
+/**
+ * Take a consistent copy of the stats slot without the book lock.
+ *
+ * @return int SUCCESS, or ERROR_TIMEOUT if a publish was always in the way.
+ */
+int orderbook_read_stats(const OrderBook* book, BookStats* stats);
+
+// Fill levels with up to count price levels of one side, best first, and
+// return how many there were
+uint32_t orderbook_depth(const OrderBook* book, OrderSide side, BookDepthLevel* levels, uint32_t count);
+
+/**
+ * The price an uncross would trade at: the one with the most executable
+ * volume, then the least imbalance, then nearest the last trade, then the
+ * lowest. A single pass over the crossed price levels.
+ *
+ * @return int SUCCESS, with a zero quote for a book that does not cross.
+ */
+int orderbook_auction_quote(const OrderBook* book, AuctionQuote* quote);
+
+/**
+ * Trade the crossed part of the book at its auction quote price, bids and
+ * asks in priority order, every fill at that one price. The caller moves
+ * the book out of its call.
+ *
+ * @return uint64_t Quantity traded.
+ */
+uint64_t orderbook_uncross(OrderBook* book, OrderFillCallback on_fill, void* arg);
+
+#endif // TRADESYNTH_SERVER_ORDERBOOK_H
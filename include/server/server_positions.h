@@ -0,0 +1,94 @@
+#ifndef TRADESYNTH_SERVER_POSITIONS_H
+#define TRADESYNTH_SERVER_POSITIONS_H
+
+#include "common/types.h"
+#include "server/server_types.h"
+#include "server/server_orderbook.h"
+
+// Per-client positions in one flat table, row account id * max_symbols +
+// symbol id. Client ids get a dense account id on first use; lookups are
+// lock-free and only registration takes position_lock. A row is written
+// only under its symbol's book lock, so the pre-trade check reads it with
+// plain loads and no lock.
+//
+// PnL is kept up to date rather than computed on demand. A fill that
+// reduces a position realizes against its average cost; each symbol keeps
+// a list of the accounts with an open position in it, and a new mark
+// revalues just those rows. Rows fold every change into their account's
+// sums, so a client's totals are two loads.
+#define DEFAULT_POSITION_LIMIT 1000000
+#define DEFAULT_MAX_ACCOUNTS 1024
+
+// Notional amounts (costs, exposures, limits, PnL) are integers of 10^NOTIONAL_EXPONENT
+#define NOTIONAL_EXPONENT -2
+
+// Average prices are reported finer than notionals so cost / quantity keeps its digits
+#define AVERAGE_PRICE_EXPONENT -6
+
+int initialize_position_table(ServerContext* context);
+void cleanup_position_table(ServerContext* context);
+
+// Dense account id of a client, registering it if needed; UINT32_MAX if the table is full
+uint32_t get_or_create_account(ServerContext* context, const char* client_id);
+
+// Account id of a known client, UINT32_MAX otherwise; never takes a lock
+uint32_t find_account(ServerContext* context, const char* client_id);
+
+// Position row of a client in a symbol, NULL if the client has no account
+ClientPosition* find_position(ServerContext* context, const char* client_id, uint32_t symbol_id);
+
+static inline ClientPosition* position_row(ServerContext* context, uint32_t account_id,
+                                           uint32_t symbol_id) {
+    return &context->positions[(size_t)account_id * context->config.max_symbols + symbol_id];
+}
+
+/**
+ * Notional of a quantity at a price in ticks of 10^tick_exponent, in
+ * NOTIONAL_EXPONENT units. Rounds sub-unit amounts up and saturates at
+ * INT64_MAX, so a limit compare never wraps.
+ */
+static inline int64_t position_notional(int64_t price_ticks, uint64_t quantity, int32_t tick_exponent) {
+    if (price_ticks < 0) price_ticks = -price_ticks;
+    int64_t notional;
+    if (__builtin_mul_overflow(price_ticks, (int64_t)quantity, &notional)) return INT64_MAX;
+
+    int32_t shift = tick_exponent - NOTIONAL_EXPONENT;
+    if (shift >= 0) {
+        if (shift > PRICE_MAX_EXPONENT ||
+            __builtin_mul_overflow(notional, PRICE_POW10[shift], &notional)) {
+            return INT64_MAX;
+        }
+        return notional;
+    }
+    if (-shift > PRICE_MAX_EXPONENT) return notional > 0 ? 1 : 0;
+    int64_t divisor = PRICE_POW10[-shift];
+    return notional / divisor + (notional % divisor != 0);
+}
+
+// Move both parties' positions, book any PnL the fill realized, and release
+// the resting order's open quantity, both orders' in an uncross. Each side
+// is valued at its fill price.
+void position_apply_fill(ServerContext* context, const OrderBook* book, const OrderFill* fill);
+
+// Add (or with a negative quantity, release) resting quantity of an order
+void position_add_open(ServerContext* context, const OrderBook* book, const Order* order,
+                       int64_t quantity);
+
+/**
+ * Value every open position in a symbol at a new mark, in ticks. Only the
+ * symbol's holder list is walked, so the cost is the number of clients
+ * holding it, not the size of the table. Caller holds the book lock.
+ */
+void position_mark(ServerContext* context, OrderBook* book, int64_t price);
+
+// Fill a PnL report for a client in one symbol, or its totals without a
+// book; lock-free, from the rows and account sums as they stand
+int position_report(ServerContext* context, const char* client_id, const OrderBook* book,
+                    PnlReport* report);
+
+// Set a restored position and add its cost and PnL to the account totals;
+// its unrealized PnL follows from the next position_mark()
+void position_restore(ServerContext* context, uint32_t account_id, uint32_t symbol_id,
+                      int64_t position, int64_t cost, int64_t realized_pnl, uint64_t total_volume);
+
+#endif // TRADESYNTH_SERVER_POSITIONS_H
@@ -0,0 +1,91 @@
+#ifndef TRADESYNTH_SERVER_RISK_H
+#define TRADESYNTH_SERVER_RISK_H
+
+#include "common/types.h"
+#include "server/server_types.h"
+
+// Pre-trade risk gate, run on every new order and modify before it reaches
+// the book.
+// Every check is a constant number of loads: the symbol's and the client's
+// limit rows, the client's position row and account totals. Limits live in
+// one read-mostly table that a reload replaces whole with a pointer swap,
+// so the hot path never takes a lock and never sees a half-updated table.
+// Notional limits are in NOTIONAL_EXPONENT units (cents); 0 disables a
+// check.
+#define DEFAULT_MAX_ORDER_QUANTITY 1000000
+
+typedef struct {
+    uint32_t max_order_quantity;
+    uint32_t collar_bps;            // Max distance from the last trade, basis points
+    int64_t max_order_notional;
+} SymbolRiskLimits;
+
+typedef struct {
+    uint32_t max_order_quantity;
+    uint32_t position_limit;        // Shares per symbol either way, ServerConfig.position_limit by default
+    int64_t max_order_notional;
+    int64_t max_net_exposure;       // Either way, including resting orders
+    int64_t max_gross_exposure;
+    int64_t credit_limit;
+} ClientRiskLimits;
+
+// Rows are indexed by symbol id and account id; ids without a row of
+// their own (registered after the load) use the defaults
+struct RiskLimits {
+    uint32_t symbol_rows;
+    uint32_t client_rows;
+    SymbolRiskLimits symbol_default;
+    ClientRiskLimits client_default;
+    SymbolRiskLimits* symbols;
+    ClientRiskLimits* clients;
+    struct RiskLimits* retired;     // Older tables kept until shutdown
+};
+
+/**
+ * Load limits from ServerConfig.risk_limits_file (defaults only if empty)
+ * and install them. Called at startup and on SIGHUP; a file that fails to
+ * parse leaves the current limits in force.
+ *
+ * File format, one rule per line, '#' starts a comment:
+ *   symbol  NAME|*  [max_qty=N] [max_notional=X] [collar_bps=N]
+ *   client  ID|*    [max_qty=N] [max_notional=X] [position=N]
+ *                   [net=X] [gross=X] [credit=X]
+ * '*' sets the default for every symbol or client; notionals are decimal
+ * currency amounts.
+ *
+ * @return int SUCCESS, ERROR_INVALID_PARAM if the file cannot be read or
+ *         ERROR_CONFIG_INVALID on a malformed line.
+ */
+int risk_load_limits(ServerContext* context);
+
+// Free the current and every retired table
+void risk_cleanup(ServerContext* context);
+
+/**
+ * Run every pre-trade check on a new order.
+ *
+ * @param book The order's book.
+ * @param last_price Last trade price in ticks of the book, 0 if none yet.
+ * @param failed Receives the failing check, may be NULL.
+ * @return int SUCCESS, ERROR_POSITION_LIMIT or ERROR_RISK_LIMIT.
+ */
+int risk_check_order(ServerContext* context, const OrderBook* book, const Order* order,
+                     int64_t last_price, RiskCheck* failed);
+
+/**
+ * Run the same checks on a modify. The per-order limits apply to its whole
+ * new size and price; the position and exposure limits to what it leaves
+ * open after the resting order's fills, in place of what the resting order
+ * has open now. A modify that adds neither shares nor notional passes.
+ *
+ * @param terms The resting order with the new price and quantity applied.
+ * @param resting The order as it rests, with its fills.
+ * @return int SUCCESS, ERROR_POSITION_LIMIT or ERROR_RISK_LIMIT.
+ */
+int risk_check_modify(ServerContext* context, const OrderBook* book, const Order* terms,
+                      const Order* resting, int64_t last_price, RiskCheck* failed);
+
+// Name of a check, e.g. "collar"
+const char* risk_check_name(RiskCheck check);
+
+#endif // TRADESYNTH_SERVER_RISK_H
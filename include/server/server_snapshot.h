@@ -0,0 +1,74 @@
+#ifndef TRADESYNTH_SERVER_SNAPSHOT_H
+#define TRADESYNTH_SERVER_SNAPSHOT_H
+
+#include "common/types.h"
+#include "server/server_types.h"
+
+// Point-in-time copies of every order book so a restart only replays the
+// journal written after the snapshot.
+#define SNAPSHOT_MAGIC "TSSNAPSH"
+#define SNAPSHOT_END_MAGIC "TSSNAPEN"
+#define SNAPSHOT_VERSION 9
+#define SNAPSHOT_RETAIN 2
+#define DEFAULT_SNAPSHOT_INTERVAL 60
+
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t book_count;
+    uint64_t created_ns;
+    uint64_t next_order_id;         // First id of each space no thread had reserved
+    uint64_t next_trade_id;
+    uint64_t journal_sequence;      // Journal position before the first book was copied
+    uint64_t order_count;
+} SnapshotFileHeader;
+
+// Followed by order_count resting orders, bids then asks, in priority
+// order, then position_count positions
+typedef struct {
+    char symbol[MAX_SYMBOL_LENGTH];
+    int32_t tick_exponent;
+    uint32_t order_count;
+    uint32_t position_count;
+    uint32_t phase;                 // BookPhase
+    uint64_t last_journal_sequence; // Journal events up to here are in the copy
+    uint64_t total_volume;
+    int64_t last_trade;             // Ticks; pending stops trigger against it
+    uint64_t call_ends;             // Uncross time of a book in a call
+    MarketData market_data;
+} SnapshotBookHeader;
+
+// A client's filled position in the book's symbol; open quantities are
+// rebuilt from the resting orders
+typedef struct {
+    char client_id[MAX_CLIENT_ID_LENGTH];
+    int64_t position;
+    int64_t cost;                   // Signed average cost, NOTIONAL_EXPONENT units
+    int64_t realized_pnl;           // NOTIONAL_EXPONENT units; unrealized is re-marked
+    uint64_t total_volume;
+} SnapshotPosition;
+
+typedef struct {
+    char magic[8];
+    uint64_t order_count;
+} SnapshotFileTrailer;
+
+/**
+ * Write a snapshot of all books into config.snapshot_dir. Each book is
+ * copied under its own read lock, so matching on other books carries on;
+ * a book's copy records the last journal event applied to it.
+ *
+ * @return int SUCCESS or an error code.
+ */
+int snapshot_write(ServerContext* context);
+
+/**
+ * Rebuild books from the newest valid snapshot, then replay the journal
+ * tail after it. Journal events already contained in a book's copy are
+ * skipped per book. Without a snapshot the whole journal is replayed.
+ *
+ * @return int SUCCESS or an error code.
+ */
+int snapshot_restore(ServerContext* context);
+
+#endif // TRADESYNTH_SERVER_SNAPSHOT_H
@@ -0,0 +1,23 @@
+#ifndef TRADESYNTH_SERVER_SYMBOLS_H
+#define TRADESYNTH_SERVER_SYMBOLS_H
+
+#include "common/types.h"
+#include "server/server_types.h"
+
+// Symbol registry. Each symbol gets a dense id that indexes order_books and
+// market_data_cache; lookups are lock-free, creation takes order_book_lock.
+// Books are created only from the configuration, the risk limits file,
+// state recovery and admin calls; client messages only look symbols up.
+int initialize_symbol_table(ServerContext* context);
+void cleanup_symbol_table(ServerContext* context);
+int register_configured_symbols(ServerContext* context);
+OrderBook* find_order_book(ServerContext* context, const char* symbol);
+OrderBook* get_or_create_order_book(ServerContext* context, const char* symbol);
+int set_symbol_tick_exponent(ServerContext* context, const char* symbol, int32_t tick_exponent);
+
+// Market data cache, prices normalized to the symbol's tick exponent
+int update_symbol_market_data(ServerContext* context, const MarketData* market_data);
+int update_symbol_last_trade(ServerContext* context, const TradeExecution* trade);
+int get_symbol_market_data(ServerContext* context, const OrderBook* book, MarketData* market_data);
+
+#endif // TRADESYNTH_SERVER_SYMBOLS_H
@@ -0,0 +1,59 @@
+#ifndef TRADESYNTH_SERVER_THROTTLE_H
+#define TRADESYNTH_SERVER_THROTTLE_H
+
+#include "common/types.h"
+#include "server/server_types.h"
+#include "serialization/serialization.h"
+
+// Inbound rate limits. Every session has a message and an order bucket, and
+// so does every client id across all its sessions. The network loop charges
+// a message from its header alone, before it is decoded, using the frame's
+// clock_now_ns() timestamp, so a flood is shed at the cost of a header copy
+// and no timer runs anywhere. New orders and modifies are orders; cancels
+// count as messages only, so a throttled client can still pull its quotes.
+// Heartbeats are never throttled.
+
+// Derive bucket periods from ServerConfig.throttle and allocate client buckets
+int throttle_init(ServerContext* context);
+void throttle_cleanup(ServerContext* context);
+
+/**
+ * Take one token from a bucket refilling one token per interval_ns and
+ * holding window_ns / interval_ns. Lock-free; safe on a bucket shared by
+ * several threads.
+ *
+ * @return int 1 if a token was taken, 0 if the bucket is empty.
+ */
+static inline int throttle_take(ThrottleBucket* bucket, uint64_t interval_ns, uint64_t window_ns,
+                                uint64_t now) {
+    uint64_t full_at = atomic_load_explicit(&bucket->full_at, memory_order_relaxed);
+    for (;;) {
+        uint64_t next = (full_at > now ? full_at : now) + interval_ns;
+        if (next - now > window_ns) return 0;
+        if (atomic_compare_exchange_weak_explicit(&bucket->full_at, &full_at, next,
+                                                  memory_order_relaxed, memory_order_relaxed)) {
+            return 1;
+        }
+    }
+}
+
+/**
+ * Charge an inbound message to its session's and client's buckets. Buckets
+ * are tried session first, messages before orders; a refused message still
+ * spends the tokens it took from buckets tried before.
+ *
+ * @return ThrottleKind The bucket that refused it, THROTTLE_COUNT if admitted.
+ */
+ThrottleKind throttle_admit(ServerContext* context, ClientConnection* client, MessageType type,
+                            uint64_t now);
+
+// Count a refused message and answer it with an ERROR_THROTTLED MSG_ERROR,
+// at most one per refill interval of the refusing bucket; the next error
+// sent says how many rejects went unanswered since the last
+void throttle_reject(ServerContext* context, ClientConnection* client, ThrottleKind kind,
+                     const MessageHeader* header, const uint8_t* payload, uint64_t now);
+
+// Name of a bucket kind, e.g. "session orders"
+const char* throttle_kind_name(ThrottleKind kind);
+
+#endif // TRADESYNTH_SERVER_THROTTLE_H
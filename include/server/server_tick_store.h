@@ -0,0 +1,53 @@
+#ifndef TRADESYNTH_SERVER_TICK_STORE_H
+#define TRADESYNTH_SERVER_TICK_STORE_H
+
+#include "common/tick_store.h"
+#include "server/server_types.h"
+
+// Capture side of the tick store (see common/tick_store.h for the file
+// format and the reader). Each symbol appends to its own mapped file under
+// a short spin lock. Appends make no syscalls: the timer tick creates and
+// maps each symbol's next file ahead of time, and a rollover swaps it in.
+typedef struct TickStore TickStore;
+
+// How long before midnight UTC the next day's files are prepared
+#define TICK_STORE_PREPARE_LEAD_NS (60 * NANOS_PER_SECOND)
+
+/**
+ * Open a tick store rooted at dir. No files are created until
+ * tick_store_prepare asks for them.
+ *
+ * @param records_per_file Records preallocated per file, 0 for
+ *        TICK_STORE_DEFAULT_RECORDS.
+ * @param stats Server statistics receiving capture counters, may be NULL.
+ */
+TickStore* tick_store_open(const char* dir, uint32_t max_symbols, uint64_t records_per_file,
+                           ServerStats* stats);
+void tick_store_close(TickStore* store);
+
+/**
+ * Have the book's next file ready before its appends need it: today's
+ * while it has none, the next segment once the current one is half full,
+ * and tomorrow's in the last TICK_STORE_PREPARE_LEAD_NS of the day. Also
+ * unmaps the file the last rollover replaced. Does the file syscalls, so
+ * one thread at a time calls it per book, off the matching path: the
+ * server's symbol registration for a new book, then its timer tick for
+ * every book. A NULL store is a no-op.
+ *
+ * @param now Current time (ns since the epoch).
+ * @return int SUCCESS, or ERROR_INVALID_STATE if the file could not be
+ *         created; that day is not retried.
+ */
+int tick_store_prepare(TickStore* store, const OrderBook* book, uint64_t now);
+
+/**
+ * Append a record to the book's current file, swapping in the prepared
+ * one when the record's UTC day changes or the file is full. A NULL store
+ * is a no-op.
+ *
+ * @return int SUCCESS, or ERROR_INVALID_STATE if the record was dropped
+ *         because no prepared file was ready.
+ */
+int tick_store_append(TickStore* store, const OrderBook* book, const TickRecord* record);
+
+#endif // TRADESYNTH_SERVER_TICK_STORE_H
@@ -0,0 +1,78 @@
+#ifndef TRADESYNTH_SERVER_TIMERS_H
+#define TRADESYNTH_SERVER_TIMERS_H
+
+#include "common/types.h"
+#include "server/server_types.h"
+
+// Hierarchical timing wheel. Time is cut into ticks of 2^TIMER_TICK_SHIFT ns
+// (about a millisecond). Level 0 has a slot per tick for the next
+// TIMER_SLOTS ticks; each level above has a slot per whole rotation of the
+// one below. A timer sits in the lowest level whose span reaches its tick,
+// and moves down a level each time its slot comes round, so arming and
+// cancelling are a list link and an unlink, and advancing costs the slots
+// that hold timers plus one cascade per timer per level. Occupancy bitmaps
+// let an advance jump straight over empty slots, however long the wheel
+// was left alone. Nothing here locks, sleeps or makes a thread or timerfd;
+// the owner advances the wheel from its own loop under its own lock.
+//
+// The server keeps one wheel per book for order expiry, under the book's
+// lock, and one for session heartbeats owned by the main loop.
+#define TIMER_TICK_SHIFT 20
+
+typedef void (*TimerCallback)(TimerNode* node, void* arg);
+
+// Start an empty wheel at now (ns); timers are never due before it
+void timer_wheel_init(TimerWheel* wheel, uint64_t now);
+
+// Arm node to fire at the first advance at or after deadline (ns), moving it if already armed
+void timer_arm(TimerWheel* wheel, TimerNode* node, uint64_t deadline);
+
+// Disarm node; a no-op if it is not armed
+void timer_cancel(TimerWheel* wheel, TimerNode* node);
+
+static inline int timer_armed(const TimerNode* node) {
+    return node->link != NULL;
+}
+
+/**
+ * Advance the wheel to now (ns), calling fire for every timer due by then,
+ * earliest tick first. A timer is disarmed before its callback, which may
+ * arm or cancel any timer in the same wheel, itself included.
+ *
+ * @return uint32_t Number of timers fired.
+ */
+uint32_t timer_wheel_advance(TimerWheel* wheel, uint64_t now, TimerCallback fire, void* arg);
+
+// Ns at which an advance next has work, UINT64_MAX for an empty wheel. May be
+// early after a cancel, never late.
+static inline uint64_t timer_wheel_due(const TimerWheel* wheel) {
+    return wheel->due == UINT64_MAX ? UINT64_MAX : wheel->due << TIMER_TICK_SHIFT;
+}
+
+// Set up the session wheel from ServerConfig.socket_timeout
+void timers_init(ServerContext* context);
+
+// Watch a newly accepted session for silence; main thread only
+void timers_watch_session(ServerContext* context, ClientConnection* client);
+
+/**
+ * Run everything due by now (ns): time out silent sessions, move books
+ * through the auction schedule, publish indicative quotes of books in a
+ * call, expire orders in every book with a deadline passed and prepare
+ * books' next tick files. Called by the main loop.
+ */
+void timers_tick(ServerContext* context, uint64_t now);
+
+// First time (ns) after now that is day_end_seconds past midnight UTC
+uint64_t timers_next_day_end(uint32_t day_end_seconds, uint64_t now);
+
+/**
+ * Where the auction schedule puts books at now (ns): in the opening call
+ * from the day end (or midnight) until auction_open, in the closing call
+ * from auction_close until the day end, continuous otherwise. call_ends
+ * receives the uncross time of the call now is in, 0 outside one, and
+ * next the first time after now the answer may change, UINT64_MAX if never.
+ */
+BookPhase timers_auction_phase(const ServerConfig* config, uint64_t now, uint64_t* call_ends, uint64_t* next);
+
+#endif // TRADESYNTH_SERVER_TIMERS_H
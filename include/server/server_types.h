@@ -6,6 +6,7 @@
 #include <netinet/in.h>
 #include "common/types.h"
 #include "common/logger.h"
+#include "common/latency.h"
 
 // Server configuration defaults
 #define DEFAULT_PORT 8080
@@ -14,6 +15,7 @@
 #define MAX_PENDING_CONNECTIONS 10
 #define MAX_SYMBOLS 1000
 #define MAX_ORDERS_PER_SYMBOL 10000
+#define ID_BLOCK_SIZE 4096              // Ids a thread reserves per trip to the shared counter
 
 // Server error codes
 #define ERROR_MAX_CLIENTS -100
@@ -22,42 +24,216 @@
 #define ERROR_ORDERBOOK_FULL -103
 #define ERROR_SYMBOL_NOT_FOUND -104
 #define ERROR_POSITION_LIMIT -105
+#define ERROR_RISK_LIMIT -106
+#define ERROR_ACCOUNT_NOT_FOUND -107
+#define ERROR_JOURNAL_FAILED -108
 
 // Forward declarations
 typedef struct ServerContext ServerContext;
+typedef struct Journal Journal;
+typedef struct TickStore TickStore;
+typedef struct Metrics Metrics;
+typedef struct RiskLimits RiskLimits;
+
+// Hierarchical timing wheel, see server_timers.h. TIMER_LEVELS wheels of
+// TIMER_SLOTS slots each; a slot spans TIMER_SLOTS times the one below.
+#define TIMER_SLOT_BITS 6
+#define TIMER_SLOTS (1 << TIMER_SLOT_BITS)
+#define TIMER_LEVELS 6
+
+// Intrusive, so arming a timer never allocates
+typedef struct TimerNode {
+   struct TimerNode* next;
+   struct TimerNode** link;      // The pointer that points at this node, NULL when not armed
+   uint64_t expires;             // Wheel tick the timer is due at
+   uint32_t slot;                // Index into the wheel's slots, TIMER_LEVELS * TIMER_SLOTS if too far out
+} TimerNode;
+
+typedef struct TimerWheel {
+   uint64_t current;             // Last tick processed
+   uint64_t due;                 // Tick the wheel next has work at, UINT64_MAX when empty
+   uint32_t count;               // Armed timers
+   uint64_t occupied[TIMER_LEVELS];             // A bit per non-empty slot
+   TimerNode* slots[TIMER_LEVELS * TIMER_SLOTS];
+   TimerNode* overflow;          // Due beyond the top wheel's reach
+} TimerWheel;
 
 // Order book structures
 typedef struct OrderBookEntry {
    Order order;
+   int64_t price_ticks;          // Limit price in ticks of the book, trigger price for a stop
    struct OrderBookEntry* next;
    struct OrderBookEntry* prev;
-   time_t entry_time;
+   uint64_t entry_time;          // Nanoseconds since the epoch
+   uint64_t sequence;            // Arrival order of a pending stop in its book
+   TimerNode expiry;             // Armed while the order has a deadline
 } OrderBookEntry;
 
+// Order id index slot; the id is kept inline so probes stay in the index
+typedef struct OrderIndexSlot {
+   uint64_t order_id;            // 0 marks an empty slot
+   OrderBookEntry* entry;
+} OrderIndexSlot;
+
+// All resting orders at one price, oldest first
+typedef struct PriceLevel {
+   int64_t price;                // Ticks
+   uint64_t total_quantity;      // Sum of remaining quantities
+   uint64_t visible_quantity;    // Sum of visible quantities, what depth shows
+   uint32_t order_count;
+   OrderBookEntry* head;
+   OrderBookEntry* tail;
+} PriceLevel;
+
+// Price levels of one side, sorted so the best price is last
+typedef struct BookSide {
+   PriceLevel* levels;
+   uint32_t level_count;
+   uint32_t level_capacity;
+} BookSide;
+
+// How an incoming order's quantity is shared among the orders at one price
+typedef enum {
+   MATCH_PRICE_TIME = 0,         // Oldest first
+   MATCH_PRO_RATA,               // In proportion to each order's visible quantity
+   MATCH_HYBRID,                 // A fixed part oldest first, the rest pro-rata
+   MATCH_POLICY_COUNT
+} MatchPolicy;
+
+#define MAX_MATCH_POLICIES 16
+#define MAX_CONFIGURED_SYMBOLS 256
+#define DEFAULT_HYBRID_FIFO_PERCENT 40
+
+// A symbol that does not match price-time
+typedef struct {
+   char symbol[MAX_SYMBOL_LENGTH];
+   MatchPolicy policy;
+   uint32_t min_allocation;      // Pro-rata shares below this are not given out pro-rata
+   uint32_t fifo_percent;        // Hybrid: percent of the incoming quantity filled oldest first
+} SymbolMatchPolicy;
+
+// Continuous books match on arrival; in a call auction orders only collect
+// until the uncross trades the crossed part at a single price
+typedef enum {
+   BOOK_PHASE_CONTINUOUS = 0,
+   BOOK_PHASE_CALL
+} BookPhase;
+
+// A book's counters as of its last change, for the metrics thread. Written
+// under the book lock and read without it: a seqlock, generation odd while
+// the writer is in it. Prices are in ticks of 10^tick_exponent, 0 if none.
+typedef struct {
+   uint64_t generation;
+   int32_t tick_exponent;
+   uint32_t bid_orders;
+   uint32_t ask_orders;
+   int64_t best_bid;
+   int64_t best_ask;
+   uint64_t best_bid_size;       // Visible quantity
+   uint64_t best_ask_size;
+   uint64_t orders;
+   uint64_t trades;
+   uint64_t volume;
+} BookStats;
+
 typedef struct OrderBook {
    char symbol[MAX_SYMBOL_LENGTH];
-   OrderBookEntry* bids;
-   OrderBookEntry* asks;
+   uint32_t symbol_id;           // Index into order_books and market_data_cache
+   int32_t tick_exponent;        // Tick size is 10^tick_exponent
+   BookSide bids;
+   BookSide asks;
    uint32_t bid_count;
    uint32_t ask_count;
+
+   // Pending stops by trigger price, the nearest trigger last like the best
+   // price of a side; they hold book entries but are not part of the book
+   BookSide buy_stops;
+   BookSide sell_stops;
+   uint32_t stop_count;
+   uint64_t stop_sequence;
+   int64_t last_trade;           // Ticks, what stops trigger on; 0 before the first trade
+   OrderBookEntry** triggered;   // Stops released by one trade, sorted into arrival order
+   uint32_t triggered_capacity;
+
    Price best_bid;
    Price best_ask;
    uint64_t total_volume;
+   uint64_t order_count;         // New orders accepted this session, counted by process_order
+   uint64_t trade_count;         // Fills this session
+   uint64_t last_journal_sequence;  // Last journal event applied to this book
+   atomic_int_least64_t mark;    // Last trade in ticks, open positions are valued at it
+
+   // Preallocated entries and an order id index for cancels
+   OrderBookEntry* entries;
+   OrderBookEntry* free_entries;
+   uint32_t max_orders;
+   OrderIndexSlot* order_index;
+   uint32_t order_index_mask;
+
+   // Orders with a deadline: an expiration time, or the day end for DAY orders
+   uint32_t day_end_seconds;     // After midnight UTC, 0 when DAY orders never expire
+   uint64_t day_end;             // Cached day end in ns, for DAY orders entered the day before it
+   TimerWheel expiries;
+   atomic_uint_least64_t next_expiry;  // Ns the wheel next has work at, read without the lock
+
+   // Matching policy, and scratch for sharing out a level pro-rata
+   MatchPolicy match_policy;
+   uint32_t min_allocation;
+   uint32_t fifo_percent;
+   OrderBookEntry** share_entries;  // A level's orders in time priority
+   uint32_t* shares;             // Their visible quantities, then what each is allocated
+
+   // Call auction state
+   BookPhase phase;
+   uint64_t call_ends;           // Ns the current call uncrosses at, 0 for no set time
+   atomic_uint_least64_t phase_due;  // Ns the auction schedule next needs a look, read without the lock
+   uint64_t revision;            // Bumped by every change to resting orders
+   uint64_t quoted_revision;     // Main thread only: revision of the last indicative quote sent
+   uint32_t quoting;             // Main thread only: an indicative quote is out
+
+   BookStats stats;
+
    pthread_rwlock_t lock;
 } OrderBook;
 
-// Client position tracking
+// One client's position in one symbol, in shares. Written under the
+// symbol's book lock, read lock-free by the pre-trade check.
 typedef struct ClientPosition {
-   char client_id[MAX_CLIENT_ID_LENGTH];
-   char symbol[MAX_SYMBOL_LENGTH];
-   int64_t position;
-   Price average_price;
-   Price realized_pnl;
-   Price unrealized_pnl;
-   uint64_t total_volume;
-   uint32_t open_orders;
+   atomic_int_least64_t position;       // Net filled quantity, negative when short
+   atomic_uint_least64_t open_buy;      // Remaining quantity of resting buys
+   atomic_uint_least64_t open_sell;
+   atomic_uint_least64_t total_volume;  // Filled quantity this session
+   atomic_int_least64_t cost;           // Signed notional of the position at average cost
+   atomic_int_least64_t realized_pnl;   // Notional units, from fills that reduced the position
+   atomic_int_least64_t unrealized_pnl; // Notional units, position at the book's mark less cost
+   uint32_t holder_slot;                // 1-based place in the symbol's holder list, 0 when flat
 } ClientPosition;
 
+// One client's totals over all symbols, in notional units. Rows of
+// different symbols update them under different book locks, so these
+// take atomic adds; they are only touched by that client's own orders.
+typedef struct AccountExposure {
+   atomic_int_least64_t net;            // Sum of position costs
+   atomic_int_least64_t gross;          // Sum of absolute position costs
+   atomic_int_least64_t long_cost;      // Sum of long position costs, the credit in use
+   atomic_int_least64_t open_buy;       // Notional of resting buys at their limit prices
+   atomic_int_least64_t open_sell;
+   atomic_int_least64_t realized_pnl;   // Sums of the rows' PnL, so a query reads two words
+   atomic_int_least64_t unrealized_pnl;
+} __attribute__((aligned(64))) AccountExposure;
+
+// Token bucket kept as the time it is next full (GCRA): one word, so a
+// bucket shared by several sessions updates with a single compare-exchange
+typedef struct {
+   atomic_uint_least64_t full_at;       // Nanoseconds, clock_now_ns() time base
+} ThrottleBucket;
+
+// A client id's buckets, shared by all its sessions
+typedef struct ClientThrottle {
+   ThrottleBucket messages;
+   ThrottleBucket orders;
+} __attribute__((aligned(64))) ClientThrottle;
+
 // Client connection
 typedef struct ClientConnection {
    // Socket and network info
@@ -70,20 +246,26 @@ typedef struct ClientConnection {
    pthread_t thread;
    ServerContext* context;
    
-   // Timing info
-   time_t connect_time;
-   time_t last_heartbeat;
+   // Timing info (nanoseconds since the epoch)
+   uint64_t connect_time;
+   uint64_t last_heartbeat;
+   TimerNode heartbeat_timer;    // In the main loop's session wheel, main thread only
    
    // Message counters
    atomic_uint_least64_t messages_sent;
    atomic_uint_least64_t messages_received;
+   atomic_uint_least64_t bytes_received;
    
-   // Connection state
+   // Connection state; the lock orders sends so sequence numbers match the wire
    pthread_mutex_t lock;
-   
-   // Client specific data
-   ClientPosition* positions;
-   uint32_t num_positions;
+   uint64_t outbound_sequence;   // Last sequence number sent this session
+
+   // Inbound rate limits, touched only by the session's handler thread
+   ThrottleBucket message_bucket;
+   ThrottleBucket order_bucket;
+   uint32_t account_id;          // Account of id, UINT32_MAX until the first order
+   uint32_t throttle_suppressed; // Rejects not answered since the last ERROR_THROTTLED
+   uint64_t throttle_notice_due; // No ERROR_THROTTLED before this, clock_now_ns() time base
 } ClientConnection;
 
 // Server states
@@ -96,6 +278,32 @@ typedef enum {
    SERVER_ERROR
 } ServerState;
 
+// Inbound rate limits, see server_throttle.h
+typedef enum {
+   THROTTLE_SESSION_MESSAGES = 0,
+   THROTTLE_SESSION_ORDERS,
+   THROTTLE_CLIENT_MESSAGES,
+   THROTTLE_CLIENT_ORDERS,
+   THROTTLE_COUNT
+} ThrottleKind;
+
+typedef struct {
+   uint32_t rate;                // Per second, 0 for no limit
+   uint32_t burst;               // Back-to-back allowance, 0 for one second's worth
+} ThrottleLimit;
+
+// Pre-trade checks, see server_risk.h
+typedef enum {
+   RISK_CHECK_QUANTITY = 0,      // Order quantity
+   RISK_CHECK_NOTIONAL,          // Order notional
+   RISK_CHECK_COLLAR,            // Limit price too far from the last trade
+   RISK_CHECK_POSITION,          // Shares long or short in the symbol
+   RISK_CHECK_NET,               // Net notional over all symbols
+   RISK_CHECK_GROSS,             // Gross notional over all symbols
+   RISK_CHECK_CREDIT,            // Cost of long positions and resting buys
+   RISK_CHECK_COUNT
+} RiskCheck;
+
 // Server statistics
 typedef struct {
    atomic_size_t total_connections;
@@ -103,22 +311,65 @@ typedef struct {
    atomic_size_t messages_processed;
    atomic_size_t errors_encountered;
    atomic_uint_least64_t bytes_received;
-   atomic_uint_least64_t bytes_sent;
+   atomic_uint_least64_t bytes_sent;             // Summed from per-thread counters on each metrics publish
    time_t start_time;
    time_t last_error_time;
+
+   // Journal throughput and group commit latency
+   atomic_uint_least64_t journal_events;
+   atomic_uint_least64_t journal_bytes;
+   atomic_uint_least64_t journal_syncs;
+   atomic_uint_least64_t journal_sync_max_ns;
+   atomic_uint_least64_t journal_queue_full;     // Appends that waited on a full ring
+   LatencyHistogram journal_sync_latency;        // Written by the journal thread only
+
+   // Tick capture
+   atomic_uint_least64_t ticks_captured;
+   atomic_uint_least64_t ticks_dropped;          // No prepared file was ready
+   atomic_uint_least64_t tick_files;
+
+   // Orders stopped by the pre-trade gate, by RiskCheck
+   atomic_uint_least64_t risk_rejects[RISK_CHECK_COUNT];
+
+   // Inbound messages dropped by a rate limit, by ThrottleKind
+   atomic_uint_least64_t throttled[THROTTLE_COUNT];
+
+   // Timer wheel events
+   atomic_uint_least64_t orders_expired;
+   atomic_uint_least64_t sessions_timed_out;
 } ServerStats;
 
 // Server configuration
 typedef struct {
    int port;
    int max_clients;
-   int socket_timeout;
+   int socket_timeout;               // Seconds a session may stay silent, 0 for no limit
    char bind_address[INET_ADDRSTRLEN];
    LogLevel log_level;
    char log_file[256];
    uint32_t max_symbols;
    uint32_t max_orders_per_symbol;
-   uint32_t position_limit;
+   uint32_t position_limit;          // Max long or short shares per client and symbol, 0 for the default
+   uint32_t max_accounts;            // Client ids with positions, 0 for the default
+   char risk_limits_file[256];       // Per-symbol and per-client limits, empty for defaults
+   ThrottleLimit throttle[THROTTLE_COUNT];  // Inbound rate limits, all off by default
+   uint32_t day_end;                 // Seconds after midnight UTC that DAY orders expire at, 0 for never
+   uint32_t auction_open;            // Seconds after midnight UTC the opening call uncrosses at, 0 for none
+   uint32_t auction_close;           // Seconds after midnight UTC the closing call starts at, 0 for none
+   SymbolMatchPolicy match_policies[MAX_MATCH_POLICIES];  // Symbols not listed match price-time
+   uint32_t match_policy_count;
+   char symbols[MAX_CONFIGURED_SYMBOLS][MAX_SYMBOL_LENGTH];  // Tradable symbols, registered at startup
+   uint32_t symbol_count;
+   char journal_file[256];           // Empty disables journaling
+   uint32_t journal_sync_interval_us;
+   uint32_t journal_sync_events;
+   char snapshot_dir[256];           // Empty disables snapshots
+   uint32_t snapshot_interval;       // Seconds between snapshots, 0 for shutdown only
+   char tick_dir[256];               // Empty disables tick capture
+   uint64_t tick_records_per_file;
+   char metrics_name[64];            // Shared-memory stats segment, empty disables
+   uint32_t metrics_interval_ms;     // Publish interval, 0 for METRICS_DEFAULT_INTERVAL_MS
+   int metrics_http_port;            // Local plaintext metrics endpoint, 0 disables
    void* (*client_handler)(void*);
 } ServerConfig;
 
@@ -127,7 +378,12 @@ struct ServerContext {
    // Core server info
    int server_socket;
    ServerState state;
-   atomic_uint_least64_t sequence_num;
+   uint64_t id_epoch;             // Tells apart blocks cached from an earlier context
+
+   // Separate order and trade id spaces, each reserved ID_BLOCK_SIZE at a
+   // time so assigning an id is a thread-local increment
+   _Alignas(64) atomic_uint_least64_t next_order_id;   // First id no thread has reserved
+   _Alignas(64) atomic_uint_least64_t next_trade_id;
    
    // Configuration
    ServerConfig config;
@@ -144,18 +400,45 @@ struct ServerContext {
    pthread_mutex_t clients_mutex;
    pthread_t accept_thread;
    
-   // Market data
+   // Market data, indexed by symbol id
    MarketData* market_data_cache;
    pthread_rwlock_t market_data_lock;
    
-   // Order management 
+   // Order management, books indexed by symbol id
    OrderBook* order_books;
    uint32_t symbol_count;
+   atomic_uint_least32_t* symbol_index;   // Open-addressed, holds symbol id + 1
+   uint32_t symbol_index_mask;
    pthread_rwlock_t order_book_lock;
    
-   // Risk management
+   // Durability and capture
+   Journal* journal;
+   TickStore* tick_store;
+   Metrics* metrics;
+
+   // Risk management: positions indexed by account id * max_symbols + symbol id
    ClientPosition* positions;
-   pthread_rwlock_t position_lock;
+   uint32_t* holders;                             // Per symbol, max_accounts ids of non-flat rows
+   uint32_t* holder_counts;                       // Indexed by symbol id, under its book lock
+   AccountExposure* exposures;                    // Indexed by account id
+   char (*account_ids)[MAX_CLIENT_ID_LENGTH];     // Client id of each account
+   uint32_t account_count;
+   atomic_uint_least32_t* account_index;          // Open-addressed, holds account id + 1
+   uint32_t account_index_mask;
+   pthread_rwlock_t position_lock;                // Taken only to register an account
+   _Atomic(RiskLimits*) risk_limits;              // Swapped whole on reload, see server_risk.h
+
+   // Inbound rate limits: bucket period and depth in ns per ThrottleKind,
+   // client buckets indexed by account id
+   int throttle_active;                           // Any limit configured
+   uint64_t throttle_interval_ns[THROTTLE_COUNT];
+   uint64_t throttle_window_ns[THROTTLE_COUNT];
+   ClientThrottle* client_throttles;
+
+   // Heartbeat deadlines, ticked by the main loop; books keep their own
+   // wheels for order expiry
+   TimerWheel sessions;
+   uint64_t session_timeout_ns;                   // 0 when sessions never time out
 };
 
 #endif // TRADESYNTH_SERVER_TYPES_H
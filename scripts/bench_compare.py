@@ -0,0 +1,89 @@
+#!/usr/bin/env python3
+"""Compare microbenchmark results against a saved baseline.
+
+Usage: bench_compare.py BASELINE CURRENT [--threshold PCT]
+
+BASELINE and CURRENT are directories of JSON files written by the bench_*
+programs (`make bench` writes them to bench-results/), or single files.
+A case regresses when its median ns/op is more than the threshold slower
+than the baseline and the slowdown is larger than the noise of both runs
+(the spread between their fastest and slowest samples). Exits 1 if any
+case regressed, so the script can gate a CI job.
+"""
+
+import argparse
+import json
+import os
+import sys
+
+
+def load_results(path):
+    files = []
+    if os.path.isdir(path):
+        files = sorted(os.path.join(path, name) for name in os.listdir(path) if name.endswith(".json"))
+    elif os.path.isfile(path):
+        files = [path]
+
+    results = {}
+    for file_name in files:
+        with open(file_name) as handle:
+            report = json.load(handle)
+        for case in report.get("results", []):
+            results["%s/%s" % (report["suite"], case["name"])] = case
+    return results
+
+
+def noise(case):
+    # Relative spread of the samples around the median
+    median = case["ns_per_op"]
+    return (case["max"] - case["min"]) / median if median > 0 else 0.0
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Flag microbenchmark regressions against a baseline.")
+    parser.add_argument("baseline")
+    parser.add_argument("current")
+    parser.add_argument("--threshold", type=float, default=5.0,
+                        help="Slowdown in percent that counts as a regression (default: 5)")
+    args = parser.parse_args()
+
+    baseline = load_results(args.baseline)
+    current = load_results(args.current)
+    if not baseline:
+        print("No baseline results in %s; save one with: make bench BENCH_RESULTS=%s"
+              % (args.baseline, args.baseline))
+        return 2
+    if not current:
+        print("No results in %s" % args.current)
+        return 2
+
+    regressions = 0
+    print("%-36s %12s %12s %9s" % ("benchmark", "baseline", "current", "change"))
+    for name in sorted(set(baseline) | set(current)):
+        if name not in baseline or name not in current:
+            print("%-36s %12s %12s %9s" % (name,
+                  "%.2f" % baseline[name]["ns_per_op"] if name in baseline else "-",
+                  "%.2f" % current[name]["ns_per_op"] if name in current else "-", "new" if name in current else "removed"))
+            continue
+
+        before = baseline[name]["ns_per_op"]
+        after = current[name]["ns_per_op"]
+        change = (after - before) / before * 100.0 if before > 0 else 0.0
+        tolerance = max(args.threshold, 100.0 * max(noise(baseline[name]), noise(current[name])))
+
+        verdict = ""
+        if change > tolerance:
+            verdict = "  REGRESSION"
+            regressions += 1
+        elif change < -tolerance:
+            verdict = "  improved"
+        print("%-36s %12.2f %12.2f %+8.1f%%%s" % (name, before, after, change, verdict))
+
+    if regressions:
+        print("\n%d regression(s) over %.1f%%" % (regressions, args.threshold))
+        return 1
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -1,19 +1,88 @@
 #include "client/client.h"
 #include <fcntl.h>
+#include <poll.h>
+#include <netinet/tcp.h>
 #include <stdatomic.h>
 
+static void dispatch_message(ClientContext* context, const Message* msg) {
+    atomic_fetch_add(&context->stats.messages_received, 1);
+
+    // The server numbers each session's messages from 1 without gaps
+    if (msg->sequence_num != context->inbound_sequence + 1) {
+        LOG_WARN("Sequence gap: expected %lu, received %lu",
+                 context->inbound_sequence + 1, msg->sequence_num);
+        atomic_fetch_add(&context->stats.sequence_gaps, 1);
+    }
+    context->inbound_sequence = msg->sequence_num;
+
+    switch (msg->type) {
+        case MSG_ORDER_STATUS:
+            if (context->callbacks.on_order_status) {
+                context->callbacks.on_order_status(&msg->data.order, context->user_data);
+            }
+            break;
+
+        case MSG_MARKET_DATA:
+            if (context->callbacks.on_market_data) {
+                context->callbacks.on_market_data(&msg->data.market_data, context->user_data);
+            }
+            break;
+
+        case MSG_TRADE_EXEC:
+            if (context->callbacks.on_trade) {
+                context->callbacks.on_trade(&msg->data.trade, context->user_data);
+            }
+            atomic_fetch_add(&context->stats.trades_received, 1);
+            break;
+
+        case MSG_ERROR:
+            if (context->callbacks.on_error) {
+                context->callbacks.on_error(msg->data.error.code, msg->data.error.message,
+                                            context->user_data);
+            }
+            atomic_fetch_add(&context->stats.errors_encountered, 1);
+            break;
+
+        case MSG_HEARTBEAT:
+            context->stats.last_heartbeat = msg->timestamp;
+            break;
+
+        case MSG_PNL:
+            if (context->callbacks.on_pnl) {
+                context->callbacks.on_pnl(&msg->data.pnl, context->user_data);
+            }
+            break;
+
+        default:
+            LOG_WARN("Received unknown message type: %d", msg->type);
+    }
+}
+
 void* message_receiver_thread(void* arg) {
     ClientContext* context = (ClientContext*)arg;
     uint8_t buffer[BUFFER_SIZE];
+    size_t buffered = 0;
     Message msg;
 
+    uint64_t next_heartbeat = clock_monotonic_raw_ns() + HEARTBEAT_INTERVAL_MS * NANOS_PER_MILLI;
+
     while (context->running) {
-        ssize_t bytes_received = recv(context->socket, buffer, BUFFER_SIZE, MSG_DONTWAIT);
+        // Wait for data or the next heartbeat; disconnect_from_server() shuts
+        // the socket down to wake it
+        uint64_t now = clock_monotonic_raw_ns();
+        if (now >= next_heartbeat) {
+            send_heartbeat(context);
+            next_heartbeat = now + HEARTBEAT_INTERVAL_MS * NANOS_PER_MILLI;
+        }
+        struct pollfd reader = { .fd = context->socket, .events = POLLIN };
+        int wait_ms = (int)((next_heartbeat - now + NANOS_PER_MILLI - 1) / NANOS_PER_MILLI);
+        int ready = poll(&reader, 1, wait_ms);
+        if (ready == 0 || (ready < 0 && errno == EINTR)) continue;
+
+        ssize_t bytes_received = recv(context->socket, buffer + buffered, BUFFER_SIZE - buffered, 0);
         if (bytes_received < 0) {
-            if (errno == EAGAIN || errno == EWOULDBLOCK) {
-                usleep(100000);  // Sleep 100ms if no data
-                continue;
-            }
+            if (errno == EINTR) continue;
+            if (!context->running) break;
             LOG_ERROR("Error receiving from server: %s", strerror(errno));
             break;
         } else if (bytes_received == 0) {
@@ -21,36 +90,22 @@ void* message_receiver_thread(void* arg) {
             break;
         }
 
-        if (deserialize_message(buffer, bytes_received, &msg) != SUCCESS) {
-            LOG_ERROR("Failed to deserialize message");
-            continue;
-        }
-
-        atomic_fetch_add(&context->stats.messages_received, 1);
-
-        switch (msg.type) {
-            case MSG_ORDER_STATUS:
-                if (context->callbacks.on_order_status) {
-                    context->callbacks.on_order_status(&msg.data.order, context->user_data);
-                }
+        // TCP is a byte stream: decode every whole message, keep the tail
+        buffered += (size_t)bytes_received;
+        size_t offset = 0;
+        while (offset < buffered) {
+            int consumed = deserialize_message(buffer + offset, buffered - offset, &msg);
+            if (consumed == SERIAL_ERROR_INCOMPLETE) break;
+            if (consumed < 0) {
+                LOG_ERROR("Failed to deserialize message");
+                offset = buffered;
                 break;
-
-            case MSG_MARKET_DATA:
-                if (context->callbacks.on_market_data) {
-                    context->callbacks.on_market_data(&msg.data.market_data, context->user_data);
-                }
-                break;
-
-            case MSG_TRADE_EXEC:
-                if (context->callbacks.on_trade) {
-                    context->callbacks.on_trade(&msg.data.trade, context->user_data);
-                }
-                atomic_fetch_add(&context->stats.trades_received, 1);
-                break;
-
-            default:
-                LOG_WARN("Received unknown message type: %d", msg.type);
+            }
+            offset += (size_t)consumed;
+            dispatch_message(context, &msg);
         }
+        buffered -= offset;
+        memmove(buffer, buffer + offset, buffered);
     }
 
     pthread_mutex_lock(&context->state_mutex);
@@ -137,13 +192,36 @@ int connect_to_server(ClientContext* context) {
         if (errno != EINPROGRESS) {
             LOG_ERROR("Failed to connect to server: %s", strerror(errno));
             close(context->socket);
+            context->socket = -1;
             return ERROR_SOCKET_CONNECT;
         }
     }
 
+    // Bound the handshake by the socket timeout, then go back to blocking I/O
+    int timeout_s = context->config.socket_timeout > 0 ? context->config.socket_timeout
+                                                       : DEFAULT_SOCKET_TIMEOUT;
+    struct pollfd connecting = { .fd = context->socket, .events = POLLOUT };
+    int connect_error = 0;
+    socklen_t error_size = sizeof(connect_error);
+    int ready = poll(&connecting, 1, timeout_s * 1000);
+    if (ready <= 0 ||
+        getsockopt(context->socket, SOL_SOCKET, SO_ERROR, &connect_error, &error_size) < 0 ||
+        connect_error != 0) {
+        LOG_ERROR("Failed to connect to server: %s",
+                  ready == 0 ? "timed out" : strerror(connect_error ? connect_error : errno));
+        close(context->socket);
+        context->socket = -1;
+        return ready == 0 ? ERROR_TIMEOUT : ERROR_SOCKET_CONNECT;
+    }
+    fcntl(context->socket, F_SETFL, flags);
+
+    int no_delay = 1;
+    setsockopt(context->socket, IPPROTO_TCP, TCP_NODELAY, &no_delay, sizeof(no_delay));
+
     pthread_mutex_lock(&context->state_mutex);
     context->state = CLIENT_CONNECTED;
-    context->stats.connect_time = time(NULL);
+    context->inbound_sequence = 0;
+    context->stats.connect_time = clock_now_ns();
     pthread_mutex_unlock(&context->state_mutex);
 
     if (pthread_create(&context->receiver_thread, NULL, message_receiver_thread, context) != 0) {
@@ -205,12 +283,12 @@ int request_market_data(ClientContext* context, const char* symbol) {
 
     Message msg = {
         .type = MSG_MARKET_DATA,
-        .timestamp = time(NULL)
+        .timestamp = clock_now_ns()
     };
     strncpy(msg.data.market_data.symbol, symbol, MAX_SYMBOL_LENGTH - 1);
 
     uint8_t buffer[BUFFER_SIZE];
-    size_t msg_size = serialize_message(&msg, buffer, BUFFER_SIZE);
+    int msg_size = serialize_message(&msg, buffer, BUFFER_SIZE);
     if (msg_size <= 0) {
         LOG_ERROR("Failed to serialize market data request");
         return ERROR_SERIALIZATION;
@@ -226,24 +304,81 @@ int request_market_data(ClientContext* context, const char* symbol) {
     return SUCCESS;
 }
 
+int request_pnl(ClientContext* context, const char* symbol) {
+    if (!context) return ERROR_INVALID_PARAM;
+    if (context->state != CLIENT_CONNECTED) return ERROR_INVALID_STATE;
+
+    Message msg = {
+        .type = MSG_PNL,
+        .timestamp = clock_now_ns()
+    };
+    memcpy(msg.data.pnl.client_id, context->config.client_id, MAX_CLIENT_ID_LENGTH);
+    msg.data.pnl.client_id[MAX_CLIENT_ID_LENGTH - 1] = '\0';
+    if (symbol) {
+        strncpy(msg.data.pnl.symbol, symbol, MAX_SYMBOL_LENGTH - 1);
+    }
+
+    uint8_t buffer[BUFFER_SIZE];
+    int msg_size = serialize_message(&msg, buffer, BUFFER_SIZE);
+    if (msg_size <= 0) {
+        LOG_ERROR("Failed to serialize PnL request");
+        return ERROR_SERIALIZATION;
+    }
+
+    if (send(context->socket, buffer, msg_size, 0) < 0) {
+        LOG_ERROR("Failed to send PnL request: %s", strerror(errno));
+        return ERROR_SOCKET_CONNECT;
+    }
+
+    atomic_fetch_add(&context->stats.messages_sent, 1);
+    return SUCCESS;
+}
+
+int send_heartbeat(ClientContext* context) {
+    if (!context) return ERROR_INVALID_PARAM;
+    if (context->state != CLIENT_CONNECTED) return ERROR_INVALID_STATE;
+
+    Message msg = {
+        .type = MSG_HEARTBEAT,
+        .timestamp = clock_now_ns()
+    };
+
+    uint8_t buffer[BUFFER_SIZE];
+    int msg_size = serialize_message(&msg, buffer, BUFFER_SIZE);
+    if (msg_size <= 0) {
+        return ERROR_SERIALIZATION;
+    }
+
+    if (send(context->socket, buffer, msg_size, MSG_NOSIGNAL) != (ssize_t)msg_size) {
+        return ERROR_SOCKET_CONNECT;
+    }
+
+    atomic_fetch_add(&context->stats.messages_sent, 1);
+    return SUCCESS;
+}
+
 int send_order(ClientContext* context, const Order* order) {
     if (!context || !order) return ERROR_INVALID_PARAM;
     if (context->state != CLIENT_CONNECTED) return ERROR_INVALID_STATE;
 
     Message msg = {
         .type = MSG_ORDER_NEW,
-        .sequence_num = 1,
-        .timestamp = time(NULL),
+        .sequence_num = atomic_fetch_add(&context->sequence_num, 1) + 1,
+        .timestamp = clock_now_ns(),
         .data.order = *order
     };
+    // The server routes statuses and fills by client id
+    if (msg.data.order.client_id[0] == '\0') {
+        memcpy(msg.data.order.client_id, context->config.client_id, MAX_CLIENT_ID_LENGTH);
+    }
 
     uint8_t buffer[BUFFER_SIZE];
-    size_t serialized_size = serialize_message(&msg, buffer, BUFFER_SIZE);
+    int serialized_size = serialize_message(&msg, buffer, BUFFER_SIZE);
     if (serialized_size <= 0) {
         return ERROR_SERIALIZATION;
     }
 
-    if (send(context->socket, buffer, serialized_size, 0) != (ssize_t)serialized_size) {
+    if (send(context->socket, buffer, serialized_size, MSG_NOSIGNAL) != (ssize_t)serialized_size) {
         return ERROR_SOCKET_CONNECT;
     }
 
@@ -0,0 +1,270 @@
+#include "common/binary_log.h"
+#include <string.h>
+
+typedef enum {
+    LENGTH_NONE,
+    LENGTH_SHORT,
+    LENGTH_LONG,
+    LENGTH_LONG_DOUBLE
+} LengthModifier;
+
+// One parsed printf conversion
+typedef struct {
+    const char* start;         // Points at the '%'
+    const char* end;           // One past the conversion character
+    int star_width;
+    int star_precision;
+    const char* length_start;  // Length modifier span, empty if none
+    const char* length_end;
+    LengthModifier length;
+    char conversion;
+} LogConversion;
+
+/**
+ * Scan one conversion specification starting at the '%'.
+ *
+ * @return int 1 on success, 0 for "%%", -1 for an unsupported specification.
+ */
+static int scan_conversion(const char* p, LogConversion* conv) {
+    memset(conv, 0, sizeof(*conv));
+    conv->start = p++;
+
+    if (*p == '%') {
+        conv->end = p + 1;
+        return 0;
+    }
+
+    while (*p && strchr("-+ #0'", *p)) p++;
+
+    if (*p == '*') {
+        conv->star_width = 1;
+        p++;
+    } else {
+        while (*p >= '0' && *p <= '9') p++;
+    }
+
+    if (*p == '.') {
+        p++;
+        if (*p == '*') {
+            conv->star_precision = 1;
+            p++;
+        } else {
+            while (*p >= '0' && *p <= '9') p++;
+        }
+    }
+
+    conv->length_start = p;
+    switch (*p) {
+        case 'h':
+            conv->length = LENGTH_SHORT;
+            p += (p[1] == 'h') ? 2 : 1;
+            break;
+        case 'l':
+            conv->length = LENGTH_LONG;
+            p += (p[1] == 'l') ? 2 : 1;
+            break;
+        case 'z':
+        case 'j':
+        case 't':
+            conv->length = LENGTH_LONG;
+            p++;
+            break;
+        case 'L':
+            conv->length = LENGTH_LONG_DOUBLE;
+            p++;
+            break;
+        default:
+            break;
+    }
+    conv->length_end = p;
+
+    if (!*p || !strchr("diuoxXcfFeEgGaAsp", *p)) {
+        return -1;
+    }
+    // long double, wchar_t* and wint_t arguments cannot be read back as the
+    // double, char* or int the payload encodes; those sites log as text
+    if (conv->length == LENGTH_LONG_DOUBLE ||
+        (conv->length == LENGTH_LONG && (*p == 's' || *p == 'c'))) {
+        return -1;
+    }
+    conv->conversion = *p;
+    conv->end = p + 1;
+    return 1;
+}
+
+static LogArgType conversion_arg_type(const LogConversion* conv) {
+    switch (conv->conversion) {
+        case 's':
+            return LOG_ARG_STRING;
+        case 'p':
+            return LOG_ARG_POINTER;
+        case 'f': case 'F': case 'e': case 'E':
+        case 'g': case 'G': case 'a': case 'A':
+            return LOG_ARG_DOUBLE;
+        case 'c':
+            return LOG_ARG_INT;
+        default:
+            return conv->length == LENGTH_LONG ? LOG_ARG_LONG : LOG_ARG_INT;
+    }
+}
+
+/**
+ * Work out which arguments a printf format consumes and how they are encoded.
+ *
+ * @param format printf-style format string.
+ * @param arg_types Output array of LogArgType values.
+ * @param max_args Capacity of arg_types.
+ * @return int Number of arguments, or -1 if the format cannot be captured.
+ */
+int parse_log_format(const char* format, uint8_t* arg_types, int max_args) {
+    if (!format || !arg_types) return -1;
+
+    int count = 0;
+    const char* p = format;
+    while ((p = strchr(p, '%')) != NULL) {
+        LogConversion conv;
+        int result = scan_conversion(p, &conv);
+        if (result < 0) return -1;
+        p = conv.end;
+        if (result == 0) continue;
+
+        int needed = conv.star_width + conv.star_precision + 1;
+        if (count + needed > max_args) return -1;
+
+        if (conv.star_width) arg_types[count++] = LOG_ARG_INT;
+        if (conv.star_precision) arg_types[count++] = LOG_ARG_INT;
+        arg_types[count++] = (uint8_t)conversion_arg_type(&conv);
+    }
+    return count;
+}
+
+static int read_payload(const uint8_t** cursor, const uint8_t* end, void* out, size_t size) {
+    if ((size_t)(end - *cursor) < size) return -1;
+    memcpy(out, *cursor, size);
+    *cursor += size;
+    return 0;
+}
+
+/**
+ * Build a printf spec for one conversion with '*' fields replaced by the
+ * captured values and the length modifier normalized to the captured type.
+ */
+static void build_spec(const LogConversion* conv, int width, int precision,
+                       const char* length, char* spec, size_t spec_size) {
+    size_t pos = 0;
+    const char* p = conv->start;
+
+    while (p < conv->length_start && pos + 16 < spec_size) {
+        if (*p == '*') {
+            int is_precision = (p > conv->start && p[-1] == '.');
+            int value = is_precision ? precision : width;
+            if (is_precision && value < 0) {
+                pos--;  // Negative precision means none; drop the '.'
+            } else {
+                pos += snprintf(spec + pos, spec_size - pos, "%d", value);
+            }
+        } else {
+            spec[pos++] = *p;
+        }
+        p++;
+    }
+    pos += snprintf(spec + pos, spec_size - pos, "%s%c", length, conv->conversion);
+    spec[pos < spec_size ? pos : spec_size - 1] = '\0';
+}
+
+/**
+ * Render a captured argument payload through its format string.
+ *
+ * @param format The call site's format string.
+ * @param payload Captured argument bytes.
+ * @param payload_size Size of the payload.
+ * @param buffer Output buffer, always NUL-terminated.
+ * @param buffer_size Size of the output buffer.
+ * @return int Number of characters written, or -1 if the payload is malformed.
+ */
+int format_log_payload(const char* format, const uint8_t* payload, size_t payload_size,
+                       char* buffer, size_t buffer_size) {
+    if (!format || !buffer || buffer_size == 0) return -1;
+
+    const uint8_t* cursor = payload;
+    const uint8_t* end = payload + payload_size;
+    size_t pos = 0;
+    const char* p = format;
+
+    buffer[0] = '\0';
+    while (*p && pos + 1 < buffer_size) {
+        if (*p != '%') {
+            buffer[pos++] = *p++;
+            continue;
+        }
+
+        LogConversion conv;
+        int result = scan_conversion(p, &conv);
+        if (result < 0) break;
+        p = conv.end;
+        if (result == 0) {
+            buffer[pos++] = '%';
+            continue;
+        }
+
+        int width = 0;
+        int precision = 0;
+        if (conv.star_width && read_payload(&cursor, end, &width, sizeof(width)) < 0) return -1;
+        if (conv.star_precision && read_payload(&cursor, end, &precision, sizeof(precision)) < 0) return -1;
+
+        char spec[64];
+        int written = 0;
+        size_t room = buffer_size - pos;
+        switch (conversion_arg_type(&conv)) {
+            case LOG_ARG_INT: {
+                int32_t value;
+                if (read_payload(&cursor, end, &value, sizeof(value)) < 0) return -1;
+                char length[3] = {0};
+                size_t length_size = (size_t)(conv.length_end - conv.length_start);
+                memcpy(length, conv.length_start, length_size < 2 ? length_size : 2);
+                build_spec(&conv, width, precision, length, spec, sizeof(spec));
+                written = snprintf(buffer + pos, room, spec, (int)value);
+                break;
+            }
+            case LOG_ARG_LONG: {
+                int64_t value;
+                if (read_payload(&cursor, end, &value, sizeof(value)) < 0) return -1;
+                build_spec(&conv, width, precision, "ll", spec, sizeof(spec));
+                written = snprintf(buffer + pos, room, spec, (long long)value);
+                break;
+            }
+            case LOG_ARG_DOUBLE: {
+                double value;
+                if (read_payload(&cursor, end, &value, sizeof(value)) < 0) return -1;
+                build_spec(&conv, width, precision, "", spec, sizeof(spec));
+                written = snprintf(buffer + pos, room, spec, value);
+                break;
+            }
+            case LOG_ARG_STRING: {
+                uint16_t length;
+                char text[1024];
+                if (read_payload(&cursor, end, &length, sizeof(length)) < 0) return -1;
+                if (length >= sizeof(text) || (size_t)(end - cursor) < length) return -1;
+                memcpy(text, cursor, length);
+                text[length] = '\0';
+                cursor += length;
+                build_spec(&conv, width, precision, "", spec, sizeof(spec));
+                written = snprintf(buffer + pos, room, spec, text);
+                break;
+            }
+            case LOG_ARG_POINTER: {
+                uint64_t value;
+                if (read_payload(&cursor, end, &value, sizeof(value)) < 0) return -1;
+                build_spec(&conv, width, precision, "", spec, sizeof(spec));
+                written = snprintf(buffer + pos, room, spec, (void*)(uintptr_t)value);
+                break;
+            }
+        }
+
+        if (written < 0) return -1;
+        pos += ((size_t)written < room) ? (size_t)written : room - 1;
+    }
+
+    buffer[pos] = '\0';
+    return (int)pos;
+}
@@ -0,0 +1,105 @@
+#include "common/clock.h"
+#include <stdio.h>
+#include <string.h>
+#include <pthread.h>
+
+#define CLOCK_CALIBRATION_NS 20000000L
+
+static pthread_once_t calibration_once = PTHREAD_ONCE_INIT;
+static uint64_t ticks_per_second = NANOS_PER_SECOND;
+
+int clock_tsc_usable = 0;
+uint64_t clock_ns_per_tick_q32 = 1ULL << 32;
+uint64_t clock_base_ticks = 0;
+uint64_t clock_base_realtime_ns = 0;
+__thread uint64_t clock_current_frame_ns = 0;
+
+/**
+ * Check /proc/cpuinfo for a TSC that runs at a constant rate in all
+ * power states. Without both flags TSC deltas are not comparable.
+ */
+static int detect_invariant_tsc(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    FILE* cpuinfo = fopen("/proc/cpuinfo", "r");
+    if (!cpuinfo) return 0;
+
+    char line[4096];
+    int usable = 0;
+    while (fgets(line, sizeof(line), cpuinfo)) {
+        if (strncmp(line, "flags", 5) == 0) {
+            usable = strstr(line, " constant_tsc") != NULL &&
+                     strstr(line, " nonstop_tsc") != NULL;
+            break;
+        }
+    }
+    fclose(cpuinfo);
+    return usable;
+#else
+    return 0;
+#endif
+}
+
+static uint64_t realtime_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return (uint64_t)ts.tv_sec * NANOS_PER_SECOND + (uint64_t)ts.tv_nsec;
+}
+
+static void calibrate_ticks(void) {
+    clock_tsc_usable = detect_invariant_tsc();
+
+    if (clock_tsc_usable) {
+        struct timespec pause = { .tv_sec = 0, .tv_nsec = CLOCK_CALIBRATION_NS };
+
+        uint64_t start_ns = clock_monotonic_raw_ns();
+        uint64_t start_ticks = clock_ticks();
+        nanosleep(&pause, NULL);
+        uint64_t end_ticks = clock_ticks();
+        uint64_t end_ns = clock_monotonic_raw_ns();
+
+        if (end_ns > start_ns && end_ticks > start_ticks) {
+            ticks_per_second = (uint64_t)((double)(end_ticks - start_ticks) * 1e9 /
+                                          (double)(end_ns - start_ns));
+        } else {
+            clock_tsc_usable = 0;
+        }
+    }
+
+    if (!clock_tsc_usable) {
+        ticks_per_second = NANOS_PER_SECOND;
+    }
+    clock_ns_per_tick_q32 = (uint64_t)(((unsigned __int128)NANOS_PER_SECOND << 32) / ticks_per_second);
+
+    // Anchor the tick counter to the wall clock
+    clock_base_ticks = clock_ticks();
+    clock_base_realtime_ns = realtime_ns();
+}
+
+/**
+ * Get the number of clock_ticks() per second.
+ *
+ * The first call detects whether the TSC is usable, calibrates it against
+ * CLOCK_MONOTONIC_RAW (about 20ms) and anchors clock_now_ns() to the wall
+ * clock; later calls are a single load. Call it once at startup before
+ * relying on clock_ticks_to_ns() or clock_now_ns().
+ *
+ * @return uint64_t Ticks per second.
+ */
+uint64_t clock_ticks_per_second(void) {
+    pthread_once(&calibration_once, calibrate_ticks);
+    return ticks_per_second;
+}
+
+void clock_wait_until(uint64_t target_ns) {
+    uint64_t now = clock_monotonic_raw_ns();
+    if (now + CLOCK_SPIN_NS < target_ns) {
+        uint64_t sleep_ns = target_ns - now - CLOCK_SPIN_NS;
+        struct timespec delay = {
+            .tv_sec = (time_t)(sleep_ns / NANOS_PER_SECOND),
+            .tv_nsec = (long)(sleep_ns % NANOS_PER_SECOND)
+        };
+        nanosleep(&delay, NULL);
+    }
+    while (clock_monotonic_raw_ns() < target_ns) {
+    }
+}
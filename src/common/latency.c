@@ -0,0 +1,345 @@
+#include "common/latency.h"
+#include "common/logger.h"
+#include <stdlib.h>
+#include <math.h>
+#include <string.h>
+#include <stdatomic.h>
+#include <pthread.h>
+
+// Per-thread stage counters. Only the owning thread writes; readers merge
+// with relaxed loads, so recording never takes a lock or a locked add.
+typedef struct {
+    atomic_uint_least64_t counts[LATENCY_BUCKET_COUNT];
+    atomic_uint_least64_t total_count;
+    atomic_uint_least64_t sum;
+    atomic_uint_least64_t min;
+    atomic_uint_least64_t max;
+} StageCounters;
+
+typedef struct LatencyRecorder {
+    StageCounters stages[STAGE_COUNT];
+    struct LatencyRecorder* next;
+} LatencyRecorder;
+
+static pthread_mutex_t recorder_mutex = PTHREAD_MUTEX_INITIALIZER;
+static LatencyRecorder* recorder_list = NULL;
+static LatencyHistogram retired_totals[STAGE_COUNT];
+static pthread_key_t recorder_key;
+static pthread_once_t recorder_key_once = PTHREAD_ONCE_INIT;
+static __thread LatencyRecorder* thread_recorder = NULL;
+
+static const char* stage_strings[] = {
+    "recv", "decode", "risk", "match", "encode", "send"
+};
+
+static inline uint32_t bucket_index(uint64_t value) {
+    if (value > LATENCY_MAX_TRACKABLE_NS) value = LATENCY_MAX_TRACKABLE_NS;
+    if (value < 2 * LATENCY_SUB_BUCKET_COUNT) return (uint32_t)value;
+
+    uint32_t msb = 63 - (uint32_t)__builtin_clzll(value);
+    uint32_t shift = msb - LATENCY_SUB_BUCKET_BITS;
+    return LATENCY_SUB_BUCKET_COUNT * shift + (uint32_t)(value >> shift);
+}
+
+// Highest value that lands in a bucket
+static inline uint64_t bucket_upper_bound(uint32_t index) {
+    if (index < 2 * LATENCY_SUB_BUCKET_COUNT) return index;
+
+    uint32_t shift = index / LATENCY_SUB_BUCKET_COUNT - 1;
+    uint64_t top = index - (uint64_t)LATENCY_SUB_BUCKET_COUNT * shift;
+    return ((top + 1) << shift) - 1;
+}
+
+void latency_histogram_reset(LatencyHistogram* histogram) {
+    memset(histogram, 0, sizeof(*histogram));
+    histogram->min = UINT64_MAX;
+}
+
+void latency_histogram_record(LatencyHistogram* histogram, uint64_t value) {
+    histogram->counts[bucket_index(value)]++;
+    histogram->total_count++;
+    histogram->sum += value;
+    if (value < histogram->min) histogram->min = value;
+    if (value > histogram->max) histogram->max = value;
+}
+
+void latency_histogram_merge(LatencyHistogram* dest, const LatencyHistogram* src) {
+    for (uint32_t i = 0; i < LATENCY_BUCKET_COUNT; i++) {
+        dest->counts[i] += src->counts[i];
+    }
+    dest->total_count += src->total_count;
+    dest->sum += src->sum;
+    if (src->min < dest->min) dest->min = src->min;
+    if (src->max > dest->max) dest->max = src->max;
+}
+
+/**
+ * Get the value at a percentile (0-100), reported as the upper bound of
+ * the bucket that contains it and never more than the recorded maximum.
+ */
+uint64_t latency_histogram_percentile(const LatencyHistogram* histogram, double percentile) {
+    if (histogram->total_count == 0) return 0;
+    if (percentile >= 100.0) return histogram->max;
+
+    uint64_t target = (uint64_t)((percentile / 100.0) * (double)histogram->total_count + 0.5);
+    if (target == 0) target = 1;
+
+    uint64_t seen = 0;
+    for (uint32_t i = 0; i < LATENCY_BUCKET_COUNT; i++) {
+        seen += histogram->counts[i];
+        if (seen >= target) {
+            uint64_t value = bucket_upper_bound(i);
+            return value < histogram->max ? value : histogram->max;
+        }
+    }
+    return histogram->max;
+}
+
+double latency_histogram_mean(const LatencyHistogram* histogram) {
+    if (histogram->total_count == 0) return 0.0;
+    return (double)histogram->sum / (double)histogram->total_count;
+}
+
+/**
+ * Write the histogram in HdrHistogram's percentile distribution format, so
+ * it can be plotted with the standard HdrHistogram tools. Percentiles are
+ * reported five steps per halving of the remaining distance to 100%.
+ */
+void latency_histogram_print_distribution(const LatencyHistogram* histogram, FILE* output,
+                                          double unit_ns) {
+    fprintf(output, "%12s %14s %10s %14s\n\n", "Value", "Percentile", "TotalCount", "1/(1-Percentile)");
+
+    uint64_t total = histogram->total_count;
+    double percentile = 0.0;
+    uint32_t bucket = 0;
+    uint64_t seen = 0;
+    while (total > 0) {
+        // Smallest bucket holding the percentile, with the count up to it
+        uint64_t target = (uint64_t)(percentile / 100.0 * (double)total + 0.5);
+        if (target == 0) target = 1;
+        while (bucket < LATENCY_BUCKET_COUNT && seen + histogram->counts[bucket] < target) {
+            seen += histogram->counts[bucket++];
+        }
+        if (bucket == LATENCY_BUCKET_COUNT) break;
+
+        uint64_t value = bucket_upper_bound(bucket);
+        if (value > histogram->max) value = histogram->max;
+        uint64_t count = seen + histogram->counts[bucket];
+        if (count >= total) break;
+
+        fprintf(output, "%12.3f %14.12f %10lu %14.2f\n", (double)value / unit_ns,
+                percentile / 100.0, count, 100.0 / (100.0 - percentile));
+
+        double remaining = 100.0 - percentile;
+        double half = 1.0;
+        while (half * 2.0 <= 100.0 / remaining + 1e-9) half *= 2.0;
+        percentile += 100.0 / half / 10.0;
+    }
+    if (total > 0) {
+        fprintf(output, "%12.3f %14.12f %10lu %14s\n", (double)histogram->max / unit_ns,
+                1.0, total, "inf");
+    }
+
+    double mean = latency_histogram_mean(histogram);
+    double variance = 0.0;
+    for (uint32_t i = 0; i < LATENCY_BUCKET_COUNT; i++) {
+        if (histogram->counts[i] == 0) continue;
+        double deviation = (double)bucket_upper_bound(i) - mean;
+        variance += deviation * deviation * (double)histogram->counts[i];
+    }
+    if (total > 0) variance /= (double)total;
+
+    fprintf(output, "#[Mean    = %12.3f, StdDeviation   = %12.3f]\n", mean / unit_ns,
+            sqrt(variance) / unit_ns);
+    fprintf(output, "#[Max     = %12.3f, Total count    = %12lu]\n",
+            (double)histogram->max / unit_ns, total);
+    fprintf(output, "#[Buckets = %12d, SubBuckets     = %12d]\n",
+            LATENCY_MAX_SHIFT + 2, LATENCY_SUB_BUCKET_COUNT);
+}
+
+static void add_counters(LatencyHistogram* dest, const StageCounters* src) {
+    for (uint32_t i = 0; i < LATENCY_BUCKET_COUNT; i++) {
+        dest->counts[i] += atomic_load_explicit(&src->counts[i], memory_order_relaxed);
+    }
+    uint64_t count = atomic_load_explicit(&src->total_count, memory_order_relaxed);
+    if (count == 0) return;
+
+    uint64_t min = atomic_load_explicit(&src->min, memory_order_relaxed);
+    uint64_t max = atomic_load_explicit(&src->max, memory_order_relaxed);
+    dest->total_count += count;
+    dest->sum += atomic_load_explicit(&src->sum, memory_order_relaxed);
+    if (min < dest->min) dest->min = min;
+    if (max > dest->max) dest->max = max;
+}
+
+// Fold an exiting thread's samples into the retired totals
+static void retire_recorder(void* arg) {
+    LatencyRecorder* recorder = (LatencyRecorder*)arg;
+    if (!recorder) return;
+
+    pthread_mutex_lock(&recorder_mutex);
+    LatencyRecorder** link = &recorder_list;
+    while (*link && *link != recorder) link = &(*link)->next;
+    if (*link) *link = recorder->next;
+    for (int stage = 0; stage < STAGE_COUNT; stage++) {
+        add_counters(&retired_totals[stage], &recorder->stages[stage]);
+    }
+    pthread_mutex_unlock(&recorder_mutex);
+
+    free(recorder);
+}
+
+static void create_recorder_key(void) {
+    pthread_key_create(&recorder_key, retire_recorder);
+    for (int stage = 0; stage < STAGE_COUNT; stage++) {
+        latency_histogram_reset(&retired_totals[stage]);
+    }
+}
+
+static LatencyRecorder* get_thread_recorder(void) {
+    if (thread_recorder) return thread_recorder;
+
+    pthread_once(&recorder_key_once, create_recorder_key);
+
+    LatencyRecorder* recorder = calloc(1, sizeof(LatencyRecorder));
+    if (!recorder) return NULL;
+    for (int stage = 0; stage < STAGE_COUNT; stage++) {
+        atomic_init(&recorder->stages[stage].min, UINT64_MAX);
+    }
+
+    pthread_mutex_lock(&recorder_mutex);
+    recorder->next = recorder_list;
+    recorder_list = recorder;
+    pthread_mutex_unlock(&recorder_mutex);
+
+    pthread_setspecific(recorder_key, recorder);
+    thread_recorder = recorder;
+    return recorder;
+}
+
+static inline void bump(atomic_uint_least64_t* counter, uint64_t amount) {
+    atomic_store_explicit(counter,
+                          atomic_load_explicit(counter, memory_order_relaxed) + amount,
+                          memory_order_relaxed);
+}
+
+/**
+ * Record one latency sample for a stage on the calling thread.
+ *
+ * @param stage Pipeline stage.
+ * @param nanoseconds Duration in nanoseconds.
+ */
+void latency_record(LatencyStage stage, uint64_t nanoseconds) {
+    LatencyRecorder* recorder = get_thread_recorder();
+    if (!recorder || stage >= STAGE_COUNT) return;
+
+    StageCounters* counters = &recorder->stages[stage];
+    bump(&counters->counts[bucket_index(nanoseconds)], 1);
+    bump(&counters->total_count, 1);
+    bump(&counters->sum, nanoseconds);
+    if (nanoseconds < atomic_load_explicit(&counters->min, memory_order_relaxed)) {
+        atomic_store_explicit(&counters->min, nanoseconds, memory_order_relaxed);
+    }
+    if (nanoseconds > atomic_load_explicit(&counters->max, memory_order_relaxed)) {
+        atomic_store_explicit(&counters->max, nanoseconds, memory_order_relaxed);
+    }
+}
+
+/**
+ * Merge every thread's samples for a stage into a plain histogram.
+ *
+ * @param stage Pipeline stage.
+ * @param out Destination histogram, overwritten.
+ * @return int SUCCESS (0) on success, ERROR_INVALID_PARAM otherwise.
+ */
+int latency_snapshot(LatencyStage stage, LatencyHistogram* out) {
+    if (!out || stage >= STAGE_COUNT) return ERROR_INVALID_PARAM;
+
+    pthread_once(&recorder_key_once, create_recorder_key);
+    latency_histogram_reset(out);
+
+    pthread_mutex_lock(&recorder_mutex);
+    latency_histogram_merge(out, &retired_totals[stage]);
+    for (LatencyRecorder* recorder = recorder_list; recorder; recorder = recorder->next) {
+        add_counters(out, &recorder->stages[stage]);
+    }
+    pthread_mutex_unlock(&recorder_mutex);
+    return SUCCESS;
+}
+
+/**
+ * Discard all samples recorded so far. Samples recorded concurrently by
+ * other threads may survive the reset.
+ */
+void latency_reset(void) {
+    pthread_once(&recorder_key_once, create_recorder_key);
+
+    pthread_mutex_lock(&recorder_mutex);
+    for (int stage = 0; stage < STAGE_COUNT; stage++) {
+        latency_histogram_reset(&retired_totals[stage]);
+    }
+    for (LatencyRecorder* recorder = recorder_list; recorder; recorder = recorder->next) {
+        for (int stage = 0; stage < STAGE_COUNT; stage++) {
+            StageCounters* counters = &recorder->stages[stage];
+            for (uint32_t i = 0; i < LATENCY_BUCKET_COUNT; i++) {
+                atomic_store_explicit(&counters->counts[i], 0, memory_order_relaxed);
+            }
+            atomic_store_explicit(&counters->total_count, 0, memory_order_relaxed);
+            atomic_store_explicit(&counters->sum, 0, memory_order_relaxed);
+            atomic_store_explicit(&counters->min, UINT64_MAX, memory_order_relaxed);
+            atomic_store_explicit(&counters->max, 0, memory_order_relaxed);
+        }
+    }
+    pthread_mutex_unlock(&recorder_mutex);
+}
+
+/**
+ * Print a percentile table for every stage.
+ */
+void latency_dump(FILE* output) {
+    static LatencyHistogram histogram;
+    static pthread_mutex_t dump_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+    pthread_mutex_lock(&dump_mutex);
+    fprintf(output, "%-8s %12s %10s %10s %10s %10s %10s\n",
+            "stage", "count", "mean(ns)", "p50(ns)", "p99(ns)", "p99.9(ns)", "max(ns)");
+    for (int stage = 0; stage < STAGE_COUNT; stage++) {
+        latency_snapshot(stage, &histogram);
+        fprintf(output, "%-8s %12lu %10.0f %10lu %10lu %10lu %10lu\n",
+                stage_strings[stage],
+                histogram.total_count,
+                latency_histogram_mean(&histogram),
+                latency_histogram_percentile(&histogram, 50.0),
+                latency_histogram_percentile(&histogram, 99.0),
+                latency_histogram_percentile(&histogram, 99.9),
+                histogram.max);
+    }
+    pthread_mutex_unlock(&dump_mutex);
+}
+
+/**
+ * Write the percentile table for every stage that has samples to the log.
+ */
+void latency_log_summary(void) {
+    static LatencyHistogram histogram;
+    static pthread_mutex_t summary_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+    pthread_mutex_lock(&summary_mutex);
+    for (int stage = 0; stage < STAGE_COUNT; stage++) {
+        latency_snapshot(stage, &histogram);
+        if (histogram.total_count == 0) continue;
+        LOG_INFO("Latency [%s]: count=%lu p50=%luns p99=%luns p99.9=%luns max=%luns",
+                 stage_strings[stage],
+                 histogram.total_count,
+                 latency_histogram_percentile(&histogram, 50.0),
+                 latency_histogram_percentile(&histogram, 99.0),
+                 latency_histogram_percentile(&histogram, 99.9),
+                 histogram.max);
+    }
+    pthread_mutex_unlock(&summary_mutex);
+}
+
+const char* latency_stage_to_string(LatencyStage stage) {
+    if (stage >= STAGE_COUNT) return "unknown";
+    return stage_strings[stage];
+}
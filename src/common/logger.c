@@ -1,14 +1,75 @@
 #include "common/logger.h"
+#include "common/clock.h"
 #include <stdlib.h>
 #include <stdarg.h>
+#include <inttypes.h>
+#include <stdatomic.h>
 #include <time.h>
 #include <string.h>
 #include <pthread.h>
+#include <sched.h>
+
+#define LOG_CACHE_LINE 64
+#define LOG_BATCH_BUFFER_SIZE 65536
+
+// A single log record as captured on the calling thread. The data area
+// holds formatted text, or raw arguments for a binary-capable site.
+typedef struct {
+    uint64_t timestamp;     // clock_now_ns() (text) or clock_ticks() (binary)
+    LogSite* site;          // NULL for records logged through log_message()
+    const char* file;
+    const char* func;
+    int32_t line;
+    uint16_t level;
+    uint16_t size;          // Bytes used in data
+    uint8_t data[LOG_MAX_MESSAGE_LENGTH];
+} LogRecord;
+
+// Single-producer/single-consumer ring owned by one logging thread
+typedef struct LogRing {
+    // Producer side
+    _Alignas(LOG_CACHE_LINE) atomic_uint_least64_t head;
+    uint64_t cached_tail;
+
+    // Consumer side
+    _Alignas(LOG_CACHE_LINE) atomic_uint_least64_t tail;
+    atomic_int retired;
+
+    uint64_t mask;
+    struct LogRing* next;
+    LogRecord* records;
+} LogRing;
+
+// Call sites collected by the linker from every LOG_* macro
+extern LogSite __start_tslog_sites[] __attribute__((weak));
+extern LogSite __stop_tslog_sites[] __attribute__((weak));
 
 // Global state
 static FILE* log_file = NULL;
 static LogLevel minimum_level = LOG_INFO;
-static pthread_mutex_t log_mutex = PTHREAD_MUTEX_INITIALIZER;
+static LogOverflowPolicy overflow_policy = LOG_OVERFLOW_DROP;
+static LogFormat log_format = LOG_FORMAT_TEXT;
+static uint32_t ring_capacity = LOG_DEFAULT_RING_CAPACITY;
+static uint32_t flush_interval_us = LOG_DEFAULT_FLUSH_INTERVAL_US;
+static int console_output = 1;
+
+// Asynchronous writer state
+static atomic_int logger_running = 0;
+static pthread_t writer_thread;
+static pthread_mutex_t registry_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_mutex_t drain_mutex = PTHREAD_MUTEX_INITIALIZER;
+static LogRing* ring_list = NULL;
+static pthread_key_t ring_key;
+static pthread_once_t ring_key_once = PTHREAD_ONCE_INIT;
+static __thread LogRing* thread_ring = NULL;
+static atomic_uint_least64_t total_dropped = 0;
+static uint64_t reported_dropped = 0;
+
+// Batch buffers, only touched by whoever holds drain_mutex
+static char console_batch[LOG_BATCH_BUFFER_SIZE];
+static char file_batch[LOG_BATCH_BUFFER_SIZE];
+static size_t console_batch_len = 0;
+static size_t file_batch_len = 0;
 
 // Log level strings and colors
 static const char* level_strings[] = {
@@ -24,27 +85,475 @@ static const char* level_colors[] = {
     ANSI_COLOR_MAGENTA  // FATAL
 };
 
+static void retire_ring(void* arg) {
+    LogRing* ring = (LogRing*)arg;
+    if (ring) {
+        atomic_store_explicit(&ring->retired, 1, memory_order_release);
+    }
+}
+
+static void create_ring_key(void) {
+    pthread_key_create(&ring_key, retire_ring);
+}
+
+static uint32_t round_up_pow2(uint32_t value) {
+    uint32_t result = 1;
+    while (result < value) result <<= 1;
+    return result;
+}
+
+/**
+ * Get the calling thread's ring, registering a new one on first use.
+ * Registration is the only point where a logging thread takes a lock.
+ */
+static LogRing* get_thread_ring(void) {
+    if (thread_ring) return thread_ring;
+
+    pthread_once(&ring_key_once, create_ring_key);
+
+    LogRing* ring = aligned_alloc(LOG_CACHE_LINE, sizeof(LogRing));
+    if (!ring) return NULL;
+    memset(ring, 0, sizeof(LogRing));
+
+    uint32_t capacity = round_up_pow2(ring_capacity);
+    ring->records = calloc(capacity, sizeof(LogRecord));
+    if (!ring->records) {
+        free(ring);
+        return NULL;
+    }
+    ring->mask = capacity - 1;
+
+    pthread_mutex_lock(&registry_mutex);
+    ring->next = ring_list;
+    ring_list = ring;
+    pthread_mutex_unlock(&registry_mutex);
+
+    pthread_setspecific(ring_key, ring);
+    thread_ring = ring;
+    return ring;
+}
+
+/**
+ * Number the call sites and work out how each one's arguments are captured.
+ */
+static uint32_t register_log_sites(void) {
+    if (!__start_tslog_sites || !__stop_tslog_sites) return 0;
+
+    uint32_t count = (uint32_t)(__stop_tslog_sites - __start_tslog_sites);
+    for (uint32_t i = 0; i < count; i++) {
+        LogSite* site = &__start_tslog_sites[i];
+        site->id = i;
+        site->num_args = parse_log_format(site->format, site->arg_types, LOG_MAX_ARGS);
+    }
+    return count;
+}
+
+/**
+ * Write the binary header and call-site format table.
+ */
+static int write_binary_header(uint32_t site_count) {
+    uint64_t ticks_per_second = clock_ticks_per_second();
+    LogBinaryHeader header = {
+        .version = LOG_BINARY_VERSION,
+        .site_count = site_count,
+        .ticks_per_second = ticks_per_second,
+        .base_ticks = clock_base_ticks,
+        .base_realtime_ns = (int64_t)clock_base_realtime_ns
+    };
+    memcpy(header.magic, LOG_BINARY_MAGIC, LOG_BINARY_MAGIC_LENGTH);
+
+    if (fwrite(&header, sizeof(header), 1, log_file) != 1) return ERROR_FILE_OPEN;
+
+    for (uint32_t i = 0; i < site_count; i++) {
+        const LogSite* site = &__start_tslog_sites[i];
+        LogBinarySiteEntry entry = {
+            .id = site->id,
+            .level = (uint32_t)site->level,
+            .line = (uint32_t)site->line,
+            .file_length = (uint16_t)strlen(site->file),
+            .func_length = (uint16_t)strlen(site->func),
+            .format_length = (uint32_t)strlen(site->format)
+        };
+        fwrite(&entry, sizeof(entry), 1, log_file);
+        fwrite(site->file, 1, entry.file_length, log_file);
+        fwrite(site->func, 1, entry.func_length, log_file);
+        fwrite(site->format, 1, entry.format_length, log_file);
+    }
+    fflush(log_file);
+    return SUCCESS;
+}
+
+static void flush_batches(void) {
+    if (console_batch_len > 0) {
+        fwrite(console_batch, 1, console_batch_len, stdout);
+        fflush(stdout);
+        console_batch_len = 0;
+    }
+    if (file_batch_len > 0) {
+        if (log_file) {
+            fwrite(file_batch, 1, file_batch_len, log_file);
+            fflush(log_file);
+        }
+        file_batch_len = 0;
+    }
+}
+
+// What snprintf actually stored, not what it would have needed
+static inline size_t stored_length(int written, size_t room) {
+    if (written < 0) return 0;
+    return (size_t)written < room ? (size_t)written : room - 1;
+}
+
+static void append_text(uint64_t timestamp_ns, LogLevel level, const char* file,
+                        int line, const char* func, const char* message) {
+    // Formatting the calendar time is the expensive part, so reuse it per second
+    static time_t cached_second = (time_t)-1;
+    static char cached_timestamp[32];
+
+    time_t second = (time_t)(timestamp_ns / NANOS_PER_SECOND);
+    if (second != cached_second) {
+        struct tm local_time;
+        localtime_r(&second, &local_time);
+        strftime(cached_timestamp, sizeof(cached_timestamp), "%Y-%m-%d %H:%M:%S", &local_time);
+        cached_second = second;
+    }
+
+    // Leave room for the longest possible line before formatting into a batch
+    size_t worst_case = LOG_MAX_MESSAGE_LENGTH + 512;
+    if (console_batch_len + worst_case > LOG_BATCH_BUFFER_SIZE ||
+        file_batch_len + worst_case > LOG_BATCH_BUFFER_SIZE) {
+        flush_batches();
+    }
+
+    long nanos = (long)(timestamp_ns % NANOS_PER_SECOND);
+    if (console_output) {
+        size_t room = LOG_BATCH_BUFFER_SIZE - console_batch_len;
+        int written = snprintf(console_batch + console_batch_len, room,
+                               "%s%s.%09ld [%-5s] (%s:%d - %s) %s" ANSI_COLOR_RESET "\n",
+                               level_colors[level], cached_timestamp, nanos,
+                               level_strings[level], file, line, func, message);
+        console_batch_len += stored_length(written, room);
+    }
+    if (log_file && log_file != stderr) {
+        size_t room = LOG_BATCH_BUFFER_SIZE - file_batch_len;
+        int written = snprintf(file_batch + file_batch_len, room,
+                               "%s.%09ld [%-5s] (%s:%d - %s) %s\n",
+                               cached_timestamp, nanos, level_strings[level],
+                               file, line, func, message);
+        file_batch_len += stored_length(written, room);
+    }
+}
+
+static void append_binary(uint32_t site_id, LogLevel level, uint64_t ticks,
+                          const void* payload, size_t payload_size) {
+    LogBinaryRecordHeader header = {
+        .site_id = site_id,
+        .payload_size = (uint16_t)payload_size,
+        .level = (uint8_t)level,
+        .ticks = ticks
+    };
+
+    if (file_batch_len + sizeof(header) + payload_size > LOG_BATCH_BUFFER_SIZE) {
+        flush_batches();
+    }
+    memcpy(file_batch + file_batch_len, &header, sizeof(header));
+    memcpy(file_batch + file_batch_len + sizeof(header), payload, payload_size);
+    file_batch_len += sizeof(header) + payload_size;
+}
+
+/**
+ * Binary logs carry preformatted text as a dynamic record:
+ * uint32 line, file and func as NUL-terminated strings, then the message.
+ */
+static void append_binary_text(LogLevel level, uint64_t ticks, const char* file,
+                               int line, const char* func, const char* message, size_t length) {
+    uint8_t payload[LOG_MAX_MESSAGE_LENGTH + 512];
+    size_t file_size = strlen(file) + 1;
+    size_t func_size = strlen(func) + 1;
+    uint32_t line_number = (uint32_t)line;
+
+    if (sizeof(line_number) + file_size + func_size + length > sizeof(payload)) return;
+
+    size_t pos = 0;
+    memcpy(payload + pos, &line_number, sizeof(line_number));
+    pos += sizeof(line_number);
+    memcpy(payload + pos, file, file_size);
+    pos += file_size;
+    memcpy(payload + pos, func, func_size);
+    pos += func_size;
+    memcpy(payload + pos, message, length);
+    pos += length;
+
+    append_binary(LOG_SITE_DYNAMIC, level, ticks, payload, pos);
+}
+
+static void emit_record(const LogRecord* record) {
+    LogLevel level = (LogLevel)record->level;
+
+    if (log_format == LOG_FORMAT_BINARY) {
+        if (record->site && record->site->num_args >= 0) {
+            append_binary(record->site->id, level, record->timestamp, record->data, record->size);
+        } else {
+            append_binary_text(level, record->timestamp, record->file, record->line,
+                               record->func, (const char*)record->data, record->size);
+        }
+        return;
+    }
+    append_text(record->timestamp, level, record->file, record->line,
+                record->func, (const char*)record->data);
+}
+
+static void emit_internal(LogLevel level, int line, const char* func, const char* message) {
+    if (log_format == LOG_FORMAT_BINARY) {
+        append_binary_text(level, clock_ticks(), __FILE__, line, func, message, strlen(message));
+    } else {
+        append_text(clock_now_ns(), level, __FILE__, line, func, message);
+    }
+}
+
+static void report_dropped_records(void) {
+    uint64_t dropped = atomic_load_explicit(&total_dropped, memory_order_relaxed);
+    if (dropped == reported_dropped) return;
+
+    char message[LOG_MAX_MESSAGE_LENGTH];
+    snprintf(message, sizeof(message), "Dropped %" PRIu64 " log records (ring full)",
+             dropped - reported_dropped);
+    emit_internal(LOG_WARN, __LINE__, __func__, message);
+    reported_dropped = dropped;
+}
+
+/**
+ * Drain every registered ring into the batch buffers and write them out.
+ * Must be called with drain_mutex held, which keeps each ring single-consumer.
+ *
+ * @return size_t Number of records written.
+ */
+static size_t drain_rings(void) {
+    size_t written = 0;
+
+    pthread_mutex_lock(&registry_mutex);
+    LogRing** link = &ring_list;
+    while (*link) {
+        LogRing* ring = *link;
+        int retired = atomic_load_explicit(&ring->retired, memory_order_acquire);
+        uint64_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+        uint64_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+
+        while (tail != head) {
+            emit_record(&ring->records[tail & ring->mask]);
+            tail++;
+            written++;
+        }
+        atomic_store_explicit(&ring->tail, tail, memory_order_release);
+
+        // The owning thread has exited and everything it wrote is out
+        if (retired) {
+            *link = ring->next;
+            free(ring->records);
+            free(ring);
+            continue;
+        }
+        link = &ring->next;
+    }
+    pthread_mutex_unlock(&registry_mutex);
+
+    report_dropped_records();
+    flush_batches();
+    return written;
+}
+
+static void* log_writer_main(void* arg) {
+    (void)arg;
+    struct timespec idle = {
+        .tv_sec = flush_interval_us / 1000000,
+        .tv_nsec = (long)(flush_interval_us % 1000000) * 1000
+    };
+
+    while (atomic_load_explicit(&logger_running, memory_order_acquire)) {
+        pthread_mutex_lock(&drain_mutex);
+        size_t written = drain_rings();
+        pthread_mutex_unlock(&drain_mutex);
+
+        if (written == 0) {
+            nanosleep(&idle, NULL);
+        }
+    }
+    return NULL;
+}
+
+/**
+ * Write a record directly on the calling thread. Used before the logger is
+ * started, after it is closed, and when a ring cannot be allocated.
+ */
+static void log_message_sync(LogLevel level, const char* file, int line, const char* func,
+                             const char* format, va_list args) {
+    char message[LOG_MAX_MESSAGE_LENGTH];
+    vsnprintf(message, sizeof(message), format, args);
+
+    pthread_mutex_lock(&drain_mutex);
+    if (log_format == LOG_FORMAT_BINARY && log_file) {
+        append_binary_text(level, clock_ticks(), file, line, func, message, strlen(message));
+    } else {
+        append_text(clock_now_ns(), level, file, line, func, message);
+    }
+    flush_batches();
+    pthread_mutex_unlock(&drain_mutex);
+}
+
+/**
+ * Claim the next slot in the calling thread's ring.
+ *
+ * @return LogRecord* The slot, or NULL if the record was dropped.
+ */
+static LogRecord* reserve_record(LogRing* ring, LogLevel level, uint64_t* head_out) {
+    uint64_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    if (head - ring->cached_tail > ring->mask) {
+        ring->cached_tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+        while (head - ring->cached_tail > ring->mask) {
+            if (overflow_policy == LOG_OVERFLOW_DROP && level != LOG_FATAL) {
+                atomic_fetch_add_explicit(&total_dropped, 1, memory_order_relaxed);
+                return NULL;
+            }
+            sched_yield();
+            ring->cached_tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+        }
+    }
+    *head_out = head;
+    return &ring->records[head & ring->mask];
+}
+
+static void commit_record(LogRing* ring, uint64_t head, LogLevel level) {
+    atomic_store_explicit(&ring->head, head + 1, memory_order_release);
+
+    // Exit on fatal errors once everything before them is on disk
+    if (level == LOG_FATAL) {
+        flush_logger();
+        exit(EXIT_FAILURE);
+    }
+}
+
+static void format_record_text(LogRecord* record, const char* format, va_list args) {
+    int length = vsnprintf((char*)record->data, sizeof(record->data), format, args);
+    if (length < 0) length = 0;
+    if ((size_t)length >= sizeof(record->data)) length = sizeof(record->data) - 1;
+    record->size = (uint16_t)length;
+}
+
+/**
+ * Copy the raw argument values for a binary-capable site into the record.
+ */
+static void capture_record_args(LogRecord* record, const LogSite* site, va_list args) {
+    uint8_t* cursor = record->data;
+    uint8_t* end = record->data + sizeof(record->data);
+
+    for (int i = 0; i < site->num_args; i++) {
+        switch (site->arg_types[i]) {
+            case LOG_ARG_INT: {
+                int32_t value = va_arg(args, int);
+                if (end - cursor < (ptrdiff_t)sizeof(value)) goto done;
+                memcpy(cursor, &value, sizeof(value));
+                cursor += sizeof(value);
+                break;
+            }
+            case LOG_ARG_LONG: {
+                int64_t value = va_arg(args, long long);
+                if (end - cursor < (ptrdiff_t)sizeof(value)) goto done;
+                memcpy(cursor, &value, sizeof(value));
+                cursor += sizeof(value);
+                break;
+            }
+            case LOG_ARG_DOUBLE: {
+                double value = va_arg(args, double);
+                if (end - cursor < (ptrdiff_t)sizeof(value)) goto done;
+                memcpy(cursor, &value, sizeof(value));
+                cursor += sizeof(value);
+                break;
+            }
+            case LOG_ARG_POINTER: {
+                uint64_t value = (uint64_t)(uintptr_t)va_arg(args, void*);
+                if (end - cursor < (ptrdiff_t)sizeof(value)) goto done;
+                memcpy(cursor, &value, sizeof(value));
+                cursor += sizeof(value);
+                break;
+            }
+            case LOG_ARG_STRING: {
+                const char* value = va_arg(args, const char*);
+                if (!value) value = "(null)";
+                if (end - cursor < (ptrdiff_t)sizeof(uint16_t)) goto done;
+                size_t room = (size_t)(end - cursor) - sizeof(uint16_t);
+                size_t length = strnlen(value, room);
+                uint16_t stored = (uint16_t)length;
+                memcpy(cursor, &stored, sizeof(stored));
+                memcpy(cursor + sizeof(stored), value, length);
+                cursor += sizeof(stored) + length;
+                break;
+            }
+        }
+    }
+done:
+    // Strings are cut to fit, but an argument after them that does not fit
+    // is dropped; format_log_payload rejects a payload short of its format,
+    // and logcat prints the record as undecodable
+    record->size = (uint16_t)(cursor - record->data);
+}
+
 /**
- * Initialize the logger.
+ * Initialize the logger with default asynchronous settings.
  * 
  * @param log_file_path Path to the log file. If NULL, logs are written to stderr.
  * @param min_level Minimum log level to capture.
  * @return int SUCCESS (0) on success, error code otherwise.
  */
 int init_logger(const char* log_file_path, LogLevel min_level) {
+    LoggerConfig config = {
+        .log_file_path = log_file_path,
+        .min_level = min_level,
+        .overflow_policy = LOG_OVERFLOW_DROP,
+        .ring_capacity = LOG_DEFAULT_RING_CAPACITY,
+        .flush_interval_us = LOG_DEFAULT_FLUSH_INTERVAL_US,
+        .console_output = 1,
+        .format = LOG_FORMAT_TEXT
+    };
+    return init_logger_with_config(&config);
+}
+
+/**
+ * Initialize the logger and start the background writer thread.
+ * 
+ * @param config Logger configuration.
+ * @return int SUCCESS (0) on success, error code otherwise.
+ */
+int init_logger_with_config(const LoggerConfig* config) {
+    if (!config) return ERROR_INVALID_PARAM;
+
     // Validate log level
-    if (min_level < LOG_TRACE || min_level > LOG_FATAL) {
-        fprintf(stderr, "Invalid log level: %d\n", min_level);
+    if (config->min_level < LOG_TRACE || config->min_level > LOG_FATAL) {
+        fprintf(stderr, "Invalid log level: %d\n", config->min_level);
         return ERROR_INVALID_PARAM;
     }
 
-    minimum_level = min_level;
+    if (config->format == LOG_FORMAT_BINARY && !config->log_file_path) {
+        fprintf(stderr, "Binary logging requires a log file\n");
+        return ERROR_INVALID_PARAM;
+    }
+
+    if (atomic_load(&logger_running)) {
+        close_logger();
+    }
+
+    minimum_level = config->min_level;
+    overflow_policy = config->overflow_policy;
+    ring_capacity = config->ring_capacity ? config->ring_capacity : LOG_DEFAULT_RING_CAPACITY;
+    flush_interval_us = config->flush_interval_us ? config->flush_interval_us
+                                                  : LOG_DEFAULT_FLUSH_INTERVAL_US;
+    console_output = config->console_output && config->format == LOG_FORMAT_TEXT;
 
     // Open log file if a path is provided
-    if (log_file_path) {
-        log_file = fopen(log_file_path, "a");
+    if (config->log_file_path) {
+        log_file = fopen(config->log_file_path,
+                         config->format == LOG_FORMAT_BINARY ? "ab" : "a");
         if (!log_file) {
-            fprintf(stderr, "Failed to open log file: %s\n", log_file_path);
+            fprintf(stderr, "Failed to open log file: %s\n", config->log_file_path);
             return ERROR_FILE_OPEN;
         }
     } else {
@@ -52,13 +561,33 @@ int init_logger(const char* log_file_path, LogLevel min_level) {
         log_file = stderr;
     }
 
+    uint32_t site_count = register_log_sites();
+    log_format = config->format;
+    if (log_format == LOG_FORMAT_BINARY && write_binary_header(site_count) != SUCCESS) {
+        fprintf(stderr, "Failed to write binary log header: %s\n", config->log_file_path);
+        fclose(log_file);
+        log_file = NULL;
+        log_format = LOG_FORMAT_TEXT;
+        return ERROR_FILE_OPEN;
+    }
+
+    atomic_store(&logger_running, 1);
+    if (pthread_create(&writer_thread, NULL, log_writer_main, NULL) != 0) {
+        atomic_store(&logger_running, 0);
+        fprintf(stderr, "Failed to start log writer thread\n");
+        return ERROR_INVALID_PARAM;
+    }
+
     // Log initialization success
-    LOG_INFO("Logger initialized with minimum level: %s", level_strings[min_level]);
+    LOG_INFO("Logger initialized with minimum level: %s", level_strings[config->min_level]);
     return SUCCESS;
 }
 
 /**
- * Log a message with a specified log level.
+ * Log a preformatted message with a specified log level.
+ *
+ * The caller only formats the message into its own ring; timestamps are
+ * rendered and I/O is done in batches by the writer thread.
  * 
  * @param level Log level of the message.
  * @param file Source file where the log is called.
@@ -69,65 +598,131 @@ int init_logger(const char* log_file_path, LogLevel min_level) {
 void log_message(LogLevel level, const char* file, int line, const char* func, const char* format, ...) {
     if (level < minimum_level) return;
 
-    time_t now;
-    time(&now);
-    struct tm* local_time = localtime(&now);
-
-    char timestamp[32];
-    strftime(timestamp, sizeof(timestamp), "%Y-%m-%d %H:%M:%S", local_time);
+    va_list args;
+    va_start(args, format);
 
-    pthread_mutex_lock(&log_mutex);
+    LogRing* ring = NULL;
+    if (atomic_load_explicit(&logger_running, memory_order_acquire)) {
+        ring = get_thread_ring();
+    }
+    if (!ring) {
+        log_message_sync(level, file, line, func, format, args);
+        va_end(args);
+        if (level == LOG_FATAL) {
+            exit(EXIT_FAILURE);
+        }
+        return;
+    }
 
-    // Write to stdout with colors
-    printf("%s%s [%-5s] (%s:%d - %s) ",
-           level_colors[level],
-           timestamp,
-           level_strings[level],
-           file,
-           line,
-           func);
+    uint64_t head;
+    LogRecord* record = reserve_record(ring, level, &head);
+    if (!record) {
+        va_end(args);
+        return;
+    }
 
-    va_list args;
-    va_start(args, format);
-    vprintf(format, args);
+    record->timestamp = log_format == LOG_FORMAT_BINARY ? clock_ticks() : clock_now_ns();
+    record->site = NULL;
+    record->file = file;
+    record->func = func;
+    record->line = line;
+    record->level = (uint16_t)level;
+    format_record_text(record, format, args);
     va_end(args);
 
-    printf(ANSI_COLOR_RESET "\n");
+    commit_record(ring, head, level);
+}
 
-    // Write to log file if opened
-    if (log_file && log_file != stderr) {
-        fprintf(log_file, "%s [%-5s] (%s:%d - %s) ",
-                timestamp,
-                level_strings[level],
-                file,
-                line,
-                func);
+/**
+ * Log from a registered call site (used by the LOG_* macros).
+ *
+ * In binary mode the caller only stores a tick count and the raw argument
+ * values; formatting happens offline in tradesynth_logcat.
+ *
+ * @param site Static call-site descriptor.
+ * @param format The site's format string, repeated for compile-time checks.
+ */
+void log_site_message(LogSite* site, const char* format, ...) {
+    if (site->level < minimum_level) return;
 
-        va_list file_args;
-        va_start(file_args, format);
-        vfprintf(log_file, format, file_args);
-        va_end(file_args);
+    va_list args;
+    va_start(args, format);
 
-        fprintf(log_file, "\n");
-        fflush(log_file);
+    LogRing* ring = NULL;
+    if (atomic_load_explicit(&logger_running, memory_order_acquire)) {
+        ring = get_thread_ring();
+    }
+    if (!ring) {
+        log_message_sync(site->level, site->file, site->line, site->func, format, args);
+        va_end(args);
+        if (site->level == LOG_FATAL) {
+            exit(EXIT_FAILURE);
+        }
+        return;
     }
 
-    pthread_mutex_unlock(&log_mutex);
+    uint64_t head;
+    LogRecord* record = reserve_record(ring, site->level, &head);
+    if (!record) {
+        va_end(args);
+        return;
+    }
 
-    // Exit on fatal errors
-    if (level == LOG_FATAL) {
-        exit(EXIT_FAILURE);
+    record->site = site;
+    record->file = site->file;
+    record->func = site->func;
+    record->line = site->line;
+    record->level = (uint16_t)site->level;
+    if (log_format == LOG_FORMAT_BINARY && site->num_args >= 0) {
+        record->timestamp = clock_ticks();
+        capture_record_args(record, site, args);
+    } else {
+        record->timestamp = log_format == LOG_FORMAT_BINARY ? clock_ticks() : clock_now_ns();
+        format_record_text(record, format, args);
     }
+    va_end(args);
+
+    commit_record(ring, head, site->level);
+}
+
+/**
+ * Get the display name of a log level.
+ */
+const char* log_level_to_string(LogLevel level) {
+    if (level < LOG_TRACE || level > LOG_FATAL) return "UNKNOWN";
+    return level_strings[level];
+}
+
+/**
+ * Synchronously write out every record logged so far.
+ */
+void flush_logger(void) {
+    pthread_mutex_lock(&drain_mutex);
+    drain_rings();
+    pthread_mutex_unlock(&drain_mutex);
+}
+
+/**
+ * Get the number of records discarded because a ring was full.
+ */
+uint64_t get_dropped_log_count(void) {
+    return atomic_load_explicit(&total_dropped, memory_order_relaxed);
 }
 
 /**
  * Close the logger and release resources.
  */
 void close_logger(void) {
+    if (!atomic_load(&logger_running)) return;
+
+    LOG_INFO("Closing logger");
+    atomic_store(&logger_running, 0);
+    pthread_join(writer_thread, NULL);
+    flush_logger();
+
     if (log_file && log_file != stderr) {
-        LOG_INFO("Closing logger");
         fclose(log_file);
-        log_file = NULL;
     }
+    log_file = NULL;
+    log_format = LOG_FORMAT_TEXT;
 }
-
@@ -0,0 +1,350 @@
+#include "common/metrics.h"
+#include "common/utils.h"
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define METRICS_READ_ATTEMPTS 1000
+
+// Rows are read in place by tools built separately from the server
+_Static_assert(sizeof(MetricsConnection) % 8 == 0, "MetricsConnection must stay 8-byte aligned");
+_Static_assert(sizeof(MetricsSymbol) % 8 == 0, "MetricsSymbol must stay 8-byte aligned");
+_Static_assert(sizeof(MetricsThread) % 8 == 0, "MetricsThread must stay 8-byte aligned");
+
+static const char* journal_sync_name = "journal_sync";
+
+static size_t header_size(void) {
+    return (sizeof(MetricsHeader) + 63) & ~(size_t)63;
+}
+
+size_t metrics_segment_size(uint32_t connections, uint32_t symbols, uint32_t threads) {
+    return header_size() +
+           (size_t)connections * sizeof(MetricsConnection) +
+           (size_t)symbols * sizeof(MetricsSymbol) +
+           (size_t)threads * sizeof(MetricsThread);
+}
+
+void metrics_segment_init(MetricsHeader* header, uint32_t connections, uint32_t symbols,
+                          uint32_t threads, uint32_t interval_ms) {
+    memcpy(header->magic, METRICS_MAGIC, sizeof(header->magic));
+    header->version = METRICS_VERSION;
+    header->header_size = (uint32_t)header_size();
+    header->segment_size = metrics_segment_size(connections, symbols, threads);
+    header->start_time = clock_now_ns();
+    header->pid = (uint32_t)getpid();
+    header->interval_ms = interval_ms;
+    header->connection_capacity = connections;
+    header->symbol_capacity = symbols;
+    header->thread_capacity = threads;
+    for (int i = 0; i < METRICS_HISTOGRAM_COUNT; i++) {
+        latency_histogram_reset(&header->histograms[i]);
+    }
+}
+
+int metrics_reader_open(MetricsReader* reader, const char* name) {
+    if (!reader || !name) return ERROR_INVALID_PARAM;
+    memset(reader, 0, sizeof(*reader));
+
+    int fd = shm_open(name, O_RDONLY, 0);
+    if (fd < 0) return ERROR_INVALID_PARAM;
+
+    struct stat st;
+    if (fstat(fd, &st) < 0 || (size_t)st.st_size < sizeof(MetricsHeader)) {
+        close(fd);
+        return ERROR_INVALID_STATE;
+    }
+
+    size_t size = (size_t)st.st_size;
+    void* data = mmap(NULL, size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) return ERROR_INVALID_STATE;
+
+    const MetricsHeader* header = data;
+    if (memcmp(header->magic, METRICS_MAGIC, sizeof(header->magic)) != 0 ||
+        header->version != METRICS_VERSION ||
+        header->header_size != header_size() ||
+        header->segment_size > size ||
+        header->segment_size != metrics_segment_size(header->connection_capacity,
+                                                     header->symbol_capacity,
+                                                     header->thread_capacity)) {
+        munmap(data, size);
+        return ERROR_INVALID_STATE;
+    }
+
+    reader->snapshot = malloc(header->segment_size);
+    if (!reader->snapshot) {
+        munmap(data, size);
+        return ERROR_MEMORY_ALLOC;
+    }
+    reader->segment = header;
+    reader->map_size = size;
+    return SUCCESS;
+}
+
+void metrics_reader_close(MetricsReader* reader) {
+    if (!reader || !reader->segment) return;
+    munmap((void*)reader->segment, reader->map_size);
+    free(reader->snapshot);
+    memset(reader, 0, sizeof(*reader));
+}
+
+int metrics_reader_read(MetricsReader* reader) {
+    if (!reader || !reader->segment) return ERROR_INVALID_PARAM;
+
+    const MetricsHeader* segment = reader->segment;
+    for (int attempt = 0; attempt < METRICS_READ_ATTEMPTS; attempt++) {
+        uint64_t before = __atomic_load_n(&segment->generation, __ATOMIC_ACQUIRE);
+        if (before & 1) {
+            // A publish takes microseconds; back off rather than spin on its lines
+            struct timespec pause = { .tv_sec = 0, .tv_nsec = 50000 };
+            nanosleep(&pause, NULL);
+            continue;
+        }
+
+        memcpy(reader->snapshot, segment, segment->segment_size);
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        if (__atomic_load_n(&segment->generation, __ATOMIC_RELAXED) == before) {
+            return SUCCESS;
+        }
+    }
+    return ERROR_TIMEOUT;
+}
+
+const char* metrics_histogram_name(int index) {
+    if (index == METRICS_HISTOGRAM_JOURNAL_SYNC) return journal_sync_name;
+    return latency_stage_to_string((LatencyStage)index);
+}
+
+// Label values are quoted; escape what the exposition format requires
+static void write_label(FILE* output, const char* value, size_t max_length) {
+    for (size_t i = 0; i < max_length && value[i] != '\0'; i++) {
+        char c = value[i];
+        if (c == '\\' || c == '"') fputc('\\', output);
+        if (c == '\n') {
+            fputs("\\n", output);
+            continue;
+        }
+        fputc(c, output);
+    }
+}
+
+static void write_counter(FILE* output, const char* name, const char* help, uint64_t value) {
+    fprintf(output, "# HELP tradesynth_%s %s\n# TYPE tradesynth_%s counter\ntradesynth_%s %lu\n",
+            name, help, name, name, value);
+}
+
+static void write_gauge(FILE* output, const char* name, const char* help, double value) {
+    fprintf(output, "# HELP tradesynth_%s %s\n# TYPE tradesynth_%s gauge\ntradesynth_%s %.9g\n",
+            name, help, name, name, value);
+}
+
+static void write_family(FILE* output, const char* name, const char* type, const char* help) {
+    fprintf(output, "# HELP tradesynth_%s %s\n# TYPE tradesynth_%s %s\n", name, help, name, type);
+}
+
+static void write_price(FILE* output, int64_t ticks, int32_t exponent) {
+    char buffer[32];
+    Price price = price_from_ticks(ticks, exponent);
+    if (format_price(&price, buffer, sizeof(buffer)) == 0) {
+        snprintf(buffer, sizeof(buffer), "%.9g", price_to_double(price));
+    }
+    fputs(buffer, output);
+}
+
+static void write_connections(const MetricsHeader* snapshot, FILE* output) {
+    static const struct {
+        const char* name;
+        const char* help;
+        size_t offset;
+    } families[] = {
+        { "connection_messages_received_total", "Messages received on the connection",
+          offsetof(MetricsConnection, messages_received) },
+        { "connection_messages_sent_total", "Messages sent on the connection",
+          offsetof(MetricsConnection, messages_sent) },
+        { "connection_bytes_received_total", "Bytes received on the connection",
+          offsetof(MetricsConnection, bytes_received) }
+    };
+
+    const MetricsConnection* connections = metrics_connections(snapshot);
+    for (size_t f = 0; f < sizeof(families) / sizeof(families[0]); f++) {
+        write_family(output, families[f].name, "counter", families[f].help);
+        for (uint32_t i = 0; i < snapshot->connection_capacity; i++) {
+            const MetricsConnection* connection = &connections[i];
+            if (!connection->active) continue;
+            uint64_t value;
+            memcpy(&value, (const char*)connection + families[f].offset, sizeof(value));
+            fprintf(output, "tradesynth_%s{slot=\"%u\",client=\"", families[f].name, i);
+            write_label(output, connection->client_id, MAX_CLIENT_ID_LENGTH);
+            fprintf(output, "\",address=\"%.*s\"} %lu\n", METRICS_ADDRESS_LENGTH,
+                    connection->address, value);
+        }
+    }
+}
+
+static void write_symbols(const MetricsHeader* snapshot, FILE* output) {
+    const MetricsSymbol* symbols = metrics_symbols(snapshot);
+    uint32_t count = snapshot->symbol_count < snapshot->symbol_capacity ?
+                     snapshot->symbol_count : snapshot->symbol_capacity;
+
+    static const struct {
+        const char* name;
+        const char* help;
+        size_t offset;
+    } counters[] = {
+        { "symbol_orders_total", "Orders accepted by the book", offsetof(MetricsSymbol, orders) },
+        { "symbol_trades_total", "Fills in the book", offsetof(MetricsSymbol, trades) },
+        { "symbol_volume_total", "Quantity traded in the book", offsetof(MetricsSymbol, volume) }
+    };
+    for (size_t f = 0; f < sizeof(counters) / sizeof(counters[0]); f++) {
+        write_family(output, counters[f].name, "counter", counters[f].help);
+        for (uint32_t i = 0; i < count; i++) {
+            uint64_t value;
+            memcpy(&value, (const char*)&symbols[i] + counters[f].offset, sizeof(value));
+            fprintf(output, "tradesynth_%s{symbol=\"", counters[f].name);
+            write_label(output, symbols[i].symbol, MAX_SYMBOL_LENGTH);
+            fprintf(output, "\"} %lu\n", value);
+        }
+    }
+
+    write_family(output, "symbol_resting_orders", "gauge", "Orders resting in the book");
+    for (uint32_t i = 0; i < count; i++) {
+        for (int side = 0; side < 2; side++) {
+            fputs("tradesynth_symbol_resting_orders{symbol=\"", output);
+            write_label(output, symbols[i].symbol, MAX_SYMBOL_LENGTH);
+            fprintf(output, "\",side=\"%s\"} %u\n", side ? "ask" : "bid",
+                    side ? symbols[i].ask_orders : symbols[i].bid_orders);
+        }
+    }
+
+    write_family(output, "symbol_best_size", "gauge", "Visible quantity at the best price");
+    for (uint32_t i = 0; i < count; i++) {
+        for (int side = 0; side < 2; side++) {
+            fputs("tradesynth_symbol_best_size{symbol=\"", output);
+            write_label(output, symbols[i].symbol, MAX_SYMBOL_LENGTH);
+            fprintf(output, "\",side=\"%s\"} %lu\n", side ? "ask" : "bid",
+                    side ? symbols[i].best_ask_size : symbols[i].best_bid_size);
+        }
+    }
+
+    static const struct {
+        const char* name;
+        const char* help;
+        size_t offset;
+    } prices[] = {
+        { "symbol_best_bid", "Best bid price", offsetof(MetricsSymbol, best_bid) },
+        { "symbol_best_ask", "Best ask price", offsetof(MetricsSymbol, best_ask) },
+        { "symbol_last_price", "Last trade price", offsetof(MetricsSymbol, last_price) }
+    };
+    for (size_t f = 0; f < sizeof(prices) / sizeof(prices[0]); f++) {
+        write_family(output, prices[f].name, "gauge", prices[f].help);
+        for (uint32_t i = 0; i < count; i++) {
+            int64_t ticks;
+            memcpy(&ticks, (const char*)&symbols[i] + prices[f].offset, sizeof(ticks));
+            if (ticks == 0) continue;
+            fprintf(output, "tradesynth_%s{symbol=\"", prices[f].name);
+            write_label(output, symbols[i].symbol, MAX_SYMBOL_LENGTH);
+            fputs("\"} ", output);
+            write_price(output, ticks, symbols[i].price_exponent);
+            fputc('\n', output);
+        }
+    }
+}
+
+static void write_threads(const MetricsHeader* snapshot, FILE* output) {
+    static const struct {
+        const char* name;
+        const char* help;
+        size_t offset;
+    } families[] = {
+        { "thread_messages_processed_total", "Messages processed by the thread",
+          offsetof(MetricsThread, messages_processed) },
+        { "thread_messages_sent_total", "Messages sent by the thread",
+          offsetof(MetricsThread, messages_sent) },
+        { "thread_bytes_received_total", "Bytes received by the thread",
+          offsetof(MetricsThread, bytes_received) },
+        { "thread_bytes_sent_total", "Bytes sent by the thread",
+          offsetof(MetricsThread, bytes_sent) },
+        { "thread_errors_total", "Errors seen by the thread", offsetof(MetricsThread, errors) }
+    };
+
+    const MetricsThread* threads = metrics_threads(snapshot);
+    write_family(output, "thread_cpu_seconds_total", "counter", "CPU time used by the thread");
+    for (uint32_t i = 0; i < snapshot->thread_capacity; i++) {
+        if (!threads[i].active) continue;
+        fputs("tradesynth_thread_cpu_seconds_total{thread=\"", output);
+        write_label(output, threads[i].name, METRICS_THREAD_NAME_LENGTH);
+        fprintf(output, "\",tid=\"%u\"} %.9f\n", threads[i].tid,
+                (double)threads[i].cpu_ns / NANOS_PER_SECOND);
+    }
+
+    for (size_t f = 0; f < sizeof(families) / sizeof(families[0]); f++) {
+        write_family(output, families[f].name, "counter", families[f].help);
+        for (uint32_t i = 0; i < snapshot->thread_capacity; i++) {
+            if (!threads[i].active) continue;
+            uint64_t value;
+            memcpy(&value, (const char*)&threads[i] + families[f].offset, sizeof(value));
+            fprintf(output, "tradesynth_%s{thread=\"", families[f].name);
+            write_label(output, threads[i].name, METRICS_THREAD_NAME_LENGTH);
+            fprintf(output, "\",tid=\"%u\"} %lu\n", threads[i].tid, value);
+        }
+    }
+}
+
+static void write_latencies(const MetricsHeader* snapshot, FILE* output) {
+    static const double quantiles[] = { 0.5, 0.9, 0.99, 0.999, 1.0 };
+
+    write_family(output, "latency_seconds", "summary", "Latency of each order pipeline stage");
+    for (int i = 0; i < METRICS_HISTOGRAM_COUNT; i++) {
+        const LatencyHistogram* histogram = &snapshot->histograms[i];
+        const char* stage = metrics_histogram_name(i);
+        for (size_t q = 0; q < sizeof(quantiles) / sizeof(quantiles[0]); q++) {
+            uint64_t value = latency_histogram_percentile(histogram, 100.0 * quantiles[q]);
+            fprintf(output, "tradesynth_latency_seconds{stage=\"%s\",quantile=\"%g\"} %.9f\n",
+                    stage, quantiles[q], (double)value / NANOS_PER_SECOND);
+        }
+        fprintf(output, "tradesynth_latency_seconds_sum{stage=\"%s\"} %.9f\n", stage,
+                (double)histogram->sum / NANOS_PER_SECOND);
+        fprintf(output, "tradesynth_latency_seconds_count{stage=\"%s\"} %lu\n", stage,
+                histogram->total_count);
+    }
+}
+
+int metrics_write_prometheus(const MetricsHeader* snapshot, FILE* output) {
+    if (!snapshot || !output) return ERROR_INVALID_PARAM;
+
+    const MetricsTotals* totals = &snapshot->totals;
+    write_gauge(output, "uptime_seconds", "Seconds since the server started",
+                (double)(snapshot->publish_time - snapshot->start_time) / NANOS_PER_SECOND);
+    write_counter(output, "connections_total", "Connections accepted", totals->total_connections);
+    write_gauge(output, "connections_active", "Connections open", (double)totals->active_connections);
+    write_counter(output, "messages_processed_total", "Messages received and dispatched",
+                  totals->messages_processed);
+    write_counter(output, "messages_sent_total", "Messages sent to clients", totals->messages_sent);
+    write_counter(output, "errors_total", "Malformed or failed messages", totals->errors_encountered);
+    write_counter(output, "bytes_received_total", "Bytes received from clients", totals->bytes_received);
+    write_counter(output, "bytes_sent_total", "Bytes sent to clients", totals->bytes_sent);
+    write_counter(output, "journal_events_total", "Events journaled", totals->journal_events);
+    write_counter(output, "journal_bytes_total", "Bytes journaled", totals->journal_bytes);
+    write_counter(output, "journal_syncs_total", "Journal fdatasync calls", totals->journal_syncs);
+    write_counter(output, "journal_queue_full_total", "Journal appends that waited on a full ring",
+                  totals->journal_queue_full);
+    write_counter(output, "ticks_captured_total", "Ticks written to tick files", totals->ticks_captured);
+    write_counter(output, "ticks_dropped_total", "Ticks dropped for want of a file", totals->ticks_dropped);
+    write_counter(output, "risk_rejects_total", "Orders rejected by pre-trade risk checks",
+                  totals->risk_rejects);
+    write_counter(output, "throttled_total", "Inbound messages rejected by rate limits", totals->throttled);
+    write_counter(output, "orders_expired_total", "Orders cancelled at their expiration time or day end",
+                  totals->orders_expired);
+    write_counter(output, "sessions_timed_out_total", "Sessions dropped for silence", totals->sessions_timed_out);
+
+    write_connections(snapshot, output);
+    write_symbols(snapshot, output);
+    write_threads(snapshot, output);
+    write_latencies(snapshot, output);
+
+    return ferror(output) ? ERROR_INVALID_STATE : SUCCESS;
+}
@@ -0,0 +1,356 @@
+#include "common/tick_archive.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+// Four 64-bit lanes; GCC lowers the operators to SSE2/AVX2/NEON as available
+typedef uint64_t TickLanes __attribute__((vector_size(TICK_ARCHIVE_LANES * sizeof(uint64_t))));
+
+_Static_assert(TICK_ARCHIVE_BLOCK_RECORDS % TICK_ARCHIVE_LANES == 0,
+               "Blocks must hold whole lane groups");
+_Static_assert(sizeof(TickArchiveChunk) % sizeof(uint64_t) == 0,
+               "Packed words must stay 8-byte aligned");
+
+static int64_t column_value(const TickRecord* record, TickColumn column) {
+    switch (column) {
+        case TICK_COLUMN_TIMESTAMP: return (int64_t)record->timestamp;
+        case TICK_COLUMN_TYPE:      return record->type;
+        case TICK_COLUMN_QUANTITY:  return record->quantity;
+        case TICK_COLUMN_PRICE:     return record->price;
+        case TICK_COLUMN_BID:       return record->bid;
+        case TICK_COLUMN_ASK:       return record->ask;
+        case TICK_COLUMN_BID_SIZE:  return record->bid_size;
+        case TICK_COLUMN_ASK_SIZE:  return record->ask_size;
+        case TICK_COLUMN_VOLUME:    return (int64_t)record->volume;
+        case TICK_COLUMN_ID:        return (int64_t)record->id;
+        default:                    return 0;
+    }
+}
+
+static inline uint64_t zigzag_encode(uint64_t delta) {
+    return (delta << 1) ^ (uint64_t)((int64_t)delta >> 63);
+}
+
+// Words of one lane, rounded up; every lane packs the same number of values
+static inline uint32_t lane_words(uint32_t lane_length, uint32_t width) {
+    return (uint32_t)(((uint64_t)(lane_length - 1) * width + 63) / 64);
+}
+
+/**
+ * Encode one column of a block into words (lane-interleaved, sized for
+ * the widest case) and fill in its chunk header. Returns the number of
+ * words used.
+ */
+static uint32_t encode_column(const int64_t* values, uint32_t lane_length,
+                              TickArchiveChunk* chunk, uint64_t* words) {
+    uint32_t value_count = lane_length * TICK_ARCHIVE_LANES;
+    uint64_t encoded[TICK_ARCHIVE_BLOCK_RECORDS];
+    uint64_t widest = 0;
+
+    for (uint32_t lane = 0; lane < TICK_ARCHIVE_LANES; lane++) {
+        chunk->base[lane] = values[lane];
+    }
+    for (uint32_t i = TICK_ARCHIVE_LANES; i < value_count; i++) {
+        encoded[i] = zigzag_encode((uint64_t)values[i] - (uint64_t)values[i - TICK_ARCHIVE_LANES]);
+        widest |= encoded[i];
+    }
+
+    uint32_t width = widest ? 64 - (uint32_t)__builtin_clzll(widest) : 0;
+    uint32_t word_count = lane_words(lane_length, width) * TICK_ARCHIVE_LANES;
+    chunk->width = width;
+    memset(words, 0, word_count * sizeof(uint64_t));
+
+    for (uint32_t k = 1; k < lane_length && width > 0; k++) {
+        uint64_t bit = (uint64_t)(k - 1) * width;
+        uint32_t word = (uint32_t)(bit >> 6);
+        uint32_t shift = (uint32_t)(bit & 63);
+        for (uint32_t lane = 0; lane < TICK_ARCHIVE_LANES; lane++) {
+            uint64_t value = encoded[k * TICK_ARCHIVE_LANES + lane];
+            words[word * TICK_ARCHIVE_LANES + lane] |= value << shift;
+            if (shift + width > 64) {
+                words[(word + 1) * TICK_ARCHIVE_LANES + lane] |= value >> (64 - shift);
+            }
+        }
+    }
+    return word_count;
+}
+
+/**
+ * Unpack, zigzag-decode and prefix-sum one column, four lanes per step.
+ * out receives lane_length * TICK_ARCHIVE_LANES values.
+ */
+static void decode_column(const uint8_t* block, const TickArchiveChunk* chunk,
+                          uint32_t lane_length, int64_t* out) {
+    TickLanes sum;
+    memcpy(&sum, chunk->base, sizeof(sum));
+    memcpy(out, &sum, sizeof(sum));
+
+    uint32_t width = chunk->width;
+    if (width == 0) {
+        for (uint32_t k = 1; k < lane_length; k++) {
+            memcpy(out + k * TICK_ARCHIVE_LANES, &sum, sizeof(sum));
+        }
+        return;
+    }
+
+    const uint64_t* words = (const uint64_t*)(block + chunk->offset);
+    uint64_t mask = width == 64 ? ~0ULL : (1ULL << width) - 1;
+    uint64_t bit = 0;
+
+    for (uint32_t k = 1; k < lane_length; k++, bit += width) {
+        uint32_t word = (uint32_t)(bit >> 6);
+        uint32_t shift = (uint32_t)(bit & 63);
+
+        TickLanes value;
+        memcpy(&value, words + word * TICK_ARCHIVE_LANES, sizeof(value));
+        value >>= shift;
+        if (shift + width > 64) {
+            TickLanes spill;
+            memcpy(&spill, words + (word + 1) * TICK_ARCHIVE_LANES, sizeof(spill));
+            value |= spill << (64 - shift);
+        }
+        value &= mask;
+
+        sum += (value >> 1) ^ -(value & 1);
+        memcpy(out + k * TICK_ARCHIVE_LANES, &sum, sizeof(sum));
+    }
+}
+
+static int write_all(FILE* file, const void* data, size_t size) {
+    return fwrite(data, 1, size, file) == size ? 0 : -1;
+}
+
+/**
+ * Encode records[0..count) as one block at the current file position.
+ */
+static int write_block(FILE* file, const TickRecord* records, uint32_t count,
+                       uint64_t offset, TickArchiveBlock* entry, uint64_t* words) {
+    int64_t values[TICK_ARCHIVE_BLOCK_RECORDS];
+    TickArchiveChunk chunks[TICK_COLUMN_COUNT];
+    uint32_t lane_length = (count + TICK_ARCHIVE_LANES - 1) / TICK_ARCHIVE_LANES;
+    uint32_t chunk_offset = sizeof(chunks);
+    uint64_t* column_words[TICK_COLUMN_COUNT];
+    uint32_t word_counts[TICK_COLUMN_COUNT];
+
+    entry->min_timestamp = UINT64_MAX;
+    entry->max_timestamp = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        if (records[i].timestamp < entry->min_timestamp) entry->min_timestamp = records[i].timestamp;
+        if (records[i].timestamp > entry->max_timestamp) entry->max_timestamp = records[i].timestamp;
+    }
+
+    for (int column = 0; column < TICK_COLUMN_COUNT; column++) {
+        for (uint32_t i = 0; i < lane_length * TICK_ARCHIVE_LANES; i++) {
+            // Pad the last lane group by repeating the final value
+            values[i] = column_value(&records[i < count ? i : count - 1], column);
+        }
+        column_words[column] = words + column * (TICK_ARCHIVE_BLOCK_RECORDS + TICK_ARCHIVE_LANES);
+        word_counts[column] = encode_column(values, lane_length, &chunks[column], column_words[column]);
+        chunks[column].offset = chunk_offset;
+        chunk_offset += word_counts[column] * sizeof(uint64_t);
+    }
+
+    if (write_all(file, chunks, sizeof(chunks)) < 0) return -1;
+    for (int column = 0; column < TICK_COLUMN_COUNT; column++) {
+        if (write_all(file, column_words[column], word_counts[column] * sizeof(uint64_t)) < 0) {
+            return -1;
+        }
+    }
+
+    entry->offset = offset;
+    entry->record_count = count;
+    entry->size = chunk_offset;
+    return 0;
+}
+
+int tick_archive_write(const char* path, const TickFile* files, int file_count) {
+    if (!path || !files || file_count <= 0) return ERROR_INVALID_PARAM;
+
+    TickArchiveHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, TICK_ARCHIVE_MAGIC, sizeof(header.magic));
+    header.version = TICK_ARCHIVE_VERSION;
+    header.block_records = TICK_ARCHIVE_BLOCK_RECORDS;
+    memcpy(header.symbol, files[0].header->symbol, MAX_SYMBOL_LENGTH);
+    header.price_exponent = files[0].header->price_exponent;
+    header.day = files[0].header->day;
+    header.min_timestamp = UINT64_MAX;
+
+    uint64_t block_capacity = 0;
+    for (int i = 0; i < file_count; i++) {
+        const TickFileHeader* input = files[i].header;
+        if (strncmp(input->symbol, header.symbol, MAX_SYMBOL_LENGTH) != 0 ||
+            input->price_exponent != header.price_exponent) {
+            return ERROR_INVALID_PARAM;
+        }
+        block_capacity += (tick_file_count(&files[i]) + TICK_ARCHIVE_BLOCK_RECORDS - 1) /
+                          TICK_ARCHIVE_BLOCK_RECORDS;
+    }
+
+    // Blocks are cut per input file, so segment boundaries need no copying
+    TickArchiveBlock* index = calloc(block_capacity ? block_capacity : 1, sizeof(TickArchiveBlock));
+    uint64_t* words = malloc(TICK_COLUMN_COUNT * (TICK_ARCHIVE_BLOCK_RECORDS + TICK_ARCHIVE_LANES) *
+                             sizeof(uint64_t));
+    if (!index || !words) {
+        free(index);
+        free(words);
+        return ERROR_MEMORY_ALLOC;
+    }
+
+    char temp_path[512];
+    snprintf(temp_path, sizeof(temp_path), "%s.tmp", path);
+    FILE* file = fopen(temp_path, "wb");
+    if (!file) {
+        free(index);
+        free(words);
+        return ERROR_INVALID_STATE;
+    }
+
+    int failed = write_all(file, &header, sizeof(header));
+    uint64_t offset = sizeof(header);
+
+    for (int i = 0; i < file_count && !failed; i++) {
+        uint64_t count = tick_file_count(&files[i]);
+        for (uint64_t start = 0; start < count && !failed; start += TICK_ARCHIVE_BLOCK_RECORDS) {
+            uint32_t block_count = (uint32_t)(count - start < TICK_ARCHIVE_BLOCK_RECORDS ?
+                                              count - start : TICK_ARCHIVE_BLOCK_RECORDS);
+            TickArchiveBlock* entry = &index[header.block_count];
+            failed = write_block(file, &files[i].records[start], block_count, offset, entry, words);
+            if (failed) break;
+
+            offset += entry->size;
+            header.block_count++;
+            header.record_count += block_count;
+            if (entry->min_timestamp < header.min_timestamp) header.min_timestamp = entry->min_timestamp;
+            if (entry->max_timestamp > header.max_timestamp) header.max_timestamp = entry->max_timestamp;
+        }
+    }
+
+    if (header.record_count == 0) {
+        header.min_timestamp = 0;
+    }
+    header.index_offset = offset;
+    failed = failed ||
+             write_all(file, index, header.block_count * sizeof(TickArchiveBlock)) < 0 ||
+             fseek(file, 0, SEEK_SET) != 0 ||
+             write_all(file, &header, sizeof(header)) < 0 ||
+             fflush(file) != 0 ||
+             fsync(fileno(file)) != 0;
+    failed = fclose(file) != 0 || failed;
+    free(index);
+    free(words);
+
+    if (failed || rename(temp_path, path) != 0) {
+        unlink(temp_path);
+        return ERROR_INVALID_STATE;
+    }
+    return SUCCESS;
+}
+
+int tick_archive_open(TickArchive* archive, const char* path) {
+    if (!archive || !path) return ERROR_INVALID_PARAM;
+    memset(archive, 0, sizeof(*archive));
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return ERROR_INVALID_PARAM;
+
+    struct stat st;
+    if (fstat(fd, &st) < 0 || (size_t)st.st_size < sizeof(TickArchiveHeader)) {
+        close(fd);
+        return ERROR_INVALID_STATE;
+    }
+
+    size_t size = (size_t)st.st_size;
+    void* data = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) return ERROR_INVALID_STATE;
+
+    const TickArchiveHeader* header = data;
+    if (memcmp(header->magic, TICK_ARCHIVE_MAGIC, sizeof(header->magic)) != 0 ||
+        header->version != TICK_ARCHIVE_VERSION ||
+        header->block_records != TICK_ARCHIVE_BLOCK_RECORDS ||
+        header->index_offset > size ||
+        header->block_count > (size - header->index_offset) / sizeof(TickArchiveBlock)) {
+        munmap(data, size);
+        return ERROR_INVALID_STATE;
+    }
+
+    madvise(data, size, MADV_SEQUENTIAL);
+
+    archive->header = header;
+    archive->blocks = (const TickArchiveBlock*)((const uint8_t*)data + header->index_offset);
+    archive->data = data;
+    archive->map_size = size;
+    return SUCCESS;
+}
+
+void tick_archive_close(TickArchive* archive) {
+    if (!archive || !archive->data) return;
+    munmap((void*)archive->data, archive->map_size);
+    memset(archive, 0, sizeof(*archive));
+}
+
+int64_t tick_archive_scan(const TickArchive* archive, uint64_t start_ns, uint64_t end_ns,
+                          uint32_t columns, TickArchiveScanFn fn, void* arg) {
+    if (!archive || !archive->data || !fn) return ERROR_INVALID_PARAM;
+
+    columns &= TICK_COLUMNS_ALL;
+    int64_t* buffer = aligned_alloc(64, TICK_COLUMN_COUNT * TICK_ARCHIVE_BLOCK_RECORDS * sizeof(int64_t));
+    uint16_t* selected = malloc(TICK_ARCHIVE_BLOCK_RECORDS * sizeof(uint16_t));
+    if (!buffer || !selected) {
+        free(buffer);
+        free(selected);
+        return ERROR_MEMORY_ALLOC;
+    }
+
+    int64_t rows = 0;
+    for (uint64_t b = 0; b < archive->header->block_count; b++) {
+        const TickArchiveBlock* entry = &archive->blocks[b];
+        if (entry->max_timestamp < start_ns || entry->min_timestamp >= end_ns) continue;
+
+        // A block straddling the range needs its timestamps to filter rows
+        int partial = entry->min_timestamp < start_ns || entry->max_timestamp >= end_ns;
+        uint32_t decode = columns | (partial ? TICK_COLUMN_BIT(TICK_COLUMN_TIMESTAMP) : 0);
+
+        const uint8_t* block = archive->data + entry->offset;
+        const TickArchiveChunk* chunks = (const TickArchiveChunk*)block;
+        uint32_t lane_length = (entry->record_count + TICK_ARCHIVE_LANES - 1) / TICK_ARCHIVE_LANES;
+
+        TickBlockView view = { .count = entry->record_count };
+        for (int column = 0; column < TICK_COLUMN_COUNT; column++) {
+            if (!(decode & TICK_COLUMN_BIT(column))) continue;
+            int64_t* out = buffer + column * TICK_ARCHIVE_BLOCK_RECORDS;
+            decode_column(block, &chunks[column], lane_length, out);
+            if (columns & TICK_COLUMN_BIT(column)) view.columns[column] = out;
+        }
+
+        if (partial) {
+            const int64_t* timestamps = buffer + TICK_COLUMN_TIMESTAMP * TICK_ARCHIVE_BLOCK_RECORDS;
+            uint32_t kept = 0;
+            for (uint32_t i = 0; i < entry->record_count; i++) {
+                selected[kept] = (uint16_t)i;
+                kept += (uint64_t)timestamps[i] >= start_ns && (uint64_t)timestamps[i] < end_ns;
+            }
+            for (int column = 0; column < TICK_COLUMN_COUNT; column++) {
+                if (!view.columns[column]) continue;
+                int64_t* values = buffer + column * TICK_ARCHIVE_BLOCK_RECORDS;
+                for (uint32_t i = 0; i < kept; i++) {
+                    values[i] = values[selected[i]];
+                }
+            }
+            view.count = kept;
+            if (kept == 0) continue;
+        }
+
+        rows += view.count;
+        if (fn(&view, arg) != 0) break;
+    }
+
+    free(buffer);
+    free(selected);
+    return rows;
+}
@@ -0,0 +1,76 @@
+#include "common/tick_store.h"
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+_Static_assert(sizeof(TickRecord) == 64, "TickRecord must stay one cache line");
+_Static_assert(sizeof(TickFileHeader) % sizeof(TickRecord) == 0,
+               "Records must stay cache-line aligned after the header");
+
+int tick_file_path(char* buffer, size_t size, const char* dir, const char* symbol,
+                   uint32_t day, uint32_t segment) {
+    time_t seconds = (time_t)day * 86400;
+    struct tm date;
+    gmtime_r(&seconds, &date);
+
+    // Keep symbols from escaping the day directory
+    char name[MAX_SYMBOL_LENGTH];
+    size_t length = strnlen(symbol, MAX_SYMBOL_LENGTH - 1);
+    for (size_t i = 0; i < length; i++) {
+        name[i] = (symbol[i] == '/' || (i == 0 && symbol[i] == '.')) ? '_' : symbol[i];
+    }
+    name[length] = '\0';
+
+    int written = segment == 0 ?
+        snprintf(buffer, size, "%s/%04d%02d%02d/%s.ticks", dir,
+                 date.tm_year + 1900, date.tm_mon + 1, date.tm_mday, name) :
+        snprintf(buffer, size, "%s/%04d%02d%02d/%s.%u.ticks", dir,
+                 date.tm_year + 1900, date.tm_mon + 1, date.tm_mday, name, segment);
+    return written < 0 || (size_t)written >= size ? -1 : written;
+}
+
+int tick_file_open(TickFile* file, const char* path) {
+    if (!file || !path) return ERROR_INVALID_PARAM;
+    memset(file, 0, sizeof(*file));
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return ERROR_INVALID_PARAM;
+
+    struct stat st;
+    if (fstat(fd, &st) < 0 || (size_t)st.st_size < sizeof(TickFileHeader)) {
+        close(fd);
+        return ERROR_INVALID_STATE;
+    }
+
+    size_t size = (size_t)st.st_size;
+    void* data = mmap(NULL, size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) return ERROR_INVALID_STATE;
+
+    const TickFileHeader* header = data;
+    if (memcmp(header->magic, TICK_STORE_MAGIC, sizeof(header->magic)) != 0 ||
+        header->version != TICK_STORE_VERSION ||
+        header->record_size != sizeof(TickRecord) ||
+        sizeof(TickFileHeader) + header->capacity * sizeof(TickRecord) > size) {
+        munmap(data, size);
+        return ERROR_INVALID_STATE;
+    }
+
+    // Scans run front to back; let readahead stay well ahead of them
+    madvise(data, size, MADV_SEQUENTIAL);
+    madvise(data, size, MADV_WILLNEED);
+
+    file->header = header;
+    file->records = (const TickRecord*)(header + 1);
+    file->map_size = size;
+    return SUCCESS;
+}
+
+void tick_file_close(TickFile* file) {
+    if (!file || !file->header) return;
+    munmap((void*)file->header, file->map_size);
+    memset(file, 0, sizeof(*file));
+}
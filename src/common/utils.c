@@ -1,17 +1,24 @@
 #include "common/utils.h"
 #include "common/logger.h"
+#include "common/clock.h"
 #include <errno.h>
 #include <ctype.h>
 #include <math.h>
 
 // Time utilities
-time_t get_current_timestamp(void) {
-    return time(NULL);
+uint64_t get_current_timestamp(void) {
+    return clock_now_ns();
 }
 
-char* format_timestamp(time_t timestamp, char* buffer, size_t buffer_size) {
-    struct tm* tm_info = localtime(&timestamp);
-    strftime(buffer, buffer_size, "%Y-%m-%d %H:%M:%S", tm_info);
+char* format_timestamp(uint64_t timestamp_ns, char* buffer, size_t buffer_size) {
+    time_t seconds = (time_t)(timestamp_ns / NANOS_PER_SECOND);
+    struct tm tm_info;
+    localtime_r(&seconds, &tm_info);
+    size_t length = strftime(buffer, buffer_size, "%Y-%m-%d %H:%M:%S", &tm_info);
+    if (length > 0) {
+        snprintf(buffer + length, buffer_size - length, ".%09lu",
+                 (unsigned long)(timestamp_ns % NANOS_PER_SECOND));
+    }
     return buffer;
 }
 
@@ -127,7 +134,13 @@ int validate_order_fields(const Order* order) {
         LOG_ERROR("Invalid quantity %u for order ID=%lu", order->quantity, order->order_id);
         return ERROR_INVALID_ORDER;
     }
-    
+
+    if (order->display_quantity > order->quantity) {
+        LOG_ERROR("Display quantity %u above quantity %u for order ID=%lu",
+                  order->display_quantity, order->quantity, order->order_id);
+        return ERROR_INVALID_ORDER;
+    }
+
     if (!is_valid_order_type(order->type)) {
         LOG_ERROR("Invalid order type %d for order ID=%lu", order->type, order->order_id);
         return ERROR_INVALID_ORDER;
@@ -191,7 +204,7 @@ int validate_market_data(const MarketData* data) {
         return ERROR_MARKET_DATA;
     }
     
-    if (price_to_double(data->bid) >= price_to_double(data->ask)) {
+    if (compare_prices(&data->bid, &data->ask) >= 0) {
         LOG_ERROR("Invalid bid/ask spread for %s", data->symbol);
         return ERROR_MARKET_DATA;
     }
@@ -234,13 +247,23 @@ uint64_t hash_order(const Order* order) {
 // Price utilities
 int compare_prices(const Price* p1, const Price* p2) {
     if (!p1 || !p2) return 0;
-    
-    double price1 = price_to_double(*p1);
-    double price2 = price_to_double(*p2);
-    
-    if (price1 < price2) return -1;
-    if (price1 > price2) return 1;
-    return 0;
+
+    if (p1->exponent == p2->exponent) {
+        return (p1->mantissa > p2->mantissa) - (p1->mantissa < p2->mantissa);
+    }
+
+    // Rescale the coarser price to the finer exponent and compare integers
+    const Price* coarse = p1->exponent > p2->exponent ? p1 : p2;
+    const Price* fine = (coarse == p1) ? p2 : p1;
+    int64_t scaled;
+    int result;
+    if (price_to_ticks(*coarse, fine->exponent, &scaled) < 0) {
+        // Out of int64 range after rescaling, so it dominates by its sign
+        result = coarse->mantissa > 0 ? 1 : -1;
+    } else {
+        result = (scaled > fine->mantissa) - (scaled < fine->mantissa);
+    }
+    return (coarse == p1) ? result : -result;
 }
 
 void normalize_price(Price* price) {
@@ -252,10 +275,153 @@ void normalize_price(Price* price) {
     }
 }
 
+// "00" "01" ... "99", two digits per lookup halves the divisions
+static const char DIGIT_PAIRS[201] =
+    "00010203040506070809"
+    "10111213141516171819"
+    "20212223242526272829"
+    "30313233343536373839"
+    "40414243444546474849"
+    "50515253545556575859"
+    "60616263646566676869"
+    "70717273747576777879"
+    "80818283848586878889"
+    "90919293949596979899";
+
+// Write the decimal digits of value so they end at end; returns the first digit
+static char* write_digits_backward(uint64_t value, char* end) {
+    while (value >= 100) {
+        unsigned int pair = (unsigned int)(value % 100) * 2;
+        value /= 100;
+        *--end = DIGIT_PAIRS[pair + 1];
+        *--end = DIGIT_PAIRS[pair];
+    }
+    if (value >= 10) {
+        unsigned int pair = (unsigned int)value * 2;
+        *--end = DIGIT_PAIRS[pair + 1];
+        *--end = DIGIT_PAIRS[pair];
+    } else {
+        *--end = (char)('0' + value);
+    }
+    return end;
+}
+
+size_t format_price(const Price* price, char* buffer, size_t buffer_size) {
+    if (!price || !buffer) return 0;
+
+    char digits[20];
+    char* digits_end = digits + sizeof(digits);
+    int negative = price->mantissa < 0;
+    uint64_t magnitude = negative ? 0 - (uint64_t)price->mantissa : (uint64_t)price->mantissa;
+    char* digits_start = write_digits_backward(magnitude, digits_end);
+    size_t num_digits = (size_t)(digits_end - digits_start);
+
+    int64_t exponent = price->exponent;
+    if (magnitude == 0 && exponent > 0) {
+        exponent = 0;
+    }
+
+    // Work out the exact length first so the copy below never checks bounds
+    uint64_t fraction_digits = exponent < 0 ? (uint64_t)-exponent : 0;
+    uint64_t length = (uint64_t)negative;
+    if (exponent >= 0) {
+        length += num_digits + (uint64_t)exponent;
+    } else if (num_digits > fraction_digits) {
+        length += num_digits + 1;
+    } else {
+        length += 2 + fraction_digits;
+    }
+    if (length + 1 > buffer_size) return 0;
+
+    char* out = buffer;
+    *out = '-';
+    out += negative;
+
+    if (exponent >= 0) {
+        memcpy(out, digits_start, num_digits);
+        out += num_digits;
+        memset(out, '0', (size_t)exponent);
+        out += exponent;
+    } else if (num_digits > fraction_digits) {
+        size_t integer_digits = num_digits - (size_t)fraction_digits;
+        memcpy(out, digits_start, integer_digits);
+        out += integer_digits;
+        *out++ = '.';
+        memcpy(out, digits_start + integer_digits, (size_t)fraction_digits);
+        out += fraction_digits;
+    } else {
+        size_t leading_zeros = (size_t)fraction_digits - num_digits;
+        *out++ = '0';
+        *out++ = '.';
+        memset(out, '0', leading_zeros);
+        out += leading_zeros;
+        memcpy(out, digits_start, num_digits);
+        out += num_digits;
+    }
+    *out = '\0';
+
+    return (size_t)(out - buffer);
+}
+
 char* price_to_string(const Price* price, char* buffer, size_t buffer_size) {
     if (!price || !buffer || buffer_size == 0) return NULL;
-    
-    double value = price_to_double(*price);
-    snprintf(buffer, buffer_size, "%.6f", value);
-    return buffer;
+
+    return format_price(price, buffer, buffer_size) > 0 ? buffer : NULL;
+}
+
+int parse_price_string(const char* str, Price* price) {
+    if (!str || !price) return ERROR_INVALID_PARAM;
+
+    const char* p = str;
+    int negative = (*p == '-');
+    p += (*p == '-' || *p == '+');
+
+    // Up to 19 significant digits always fit in a uint64_t
+    uint64_t mantissa = 0;
+    int significant_digits = 0;
+    int total_digits = 0;
+    int64_t exponent = 0;
+
+    for (unsigned int digit; (digit = (unsigned int)(*p - '0')) < 10; p++) {
+        mantissa = mantissa * 10 + digit;
+        significant_digits += (mantissa != 0);
+        total_digits++;
+        if (significant_digits > 19) return ERROR_INVALID_PARAM;
+    }
+    if (*p == '.') {
+        p++;
+        for (unsigned int digit; (digit = (unsigned int)(*p - '0')) < 10; p++) {
+            mantissa = mantissa * 10 + digit;
+            significant_digits += (mantissa != 0);
+            total_digits++;
+            exponent--;
+            if (significant_digits > 19) return ERROR_INVALID_PARAM;
+        }
+    }
+    if (total_digits == 0) return ERROR_INVALID_PARAM;
+
+    // Optional scientific suffix, e.g. "15025e-2"
+    if (*p == 'e' || *p == 'E') {
+        p++;
+        int exponent_negative = (*p == '-');
+        p += (*p == '-' || *p == '+');
+        int64_t suffix = 0;
+        int suffix_digits = 0;
+        for (unsigned int digit; (digit = (unsigned int)(*p - '0')) < 10; p++) {
+            suffix = suffix * 10 + digit;
+            if (++suffix_digits > 10) return ERROR_INVALID_PARAM;
+        }
+        if (suffix_digits == 0) return ERROR_INVALID_PARAM;
+        exponent += exponent_negative ? -suffix : suffix;
+    }
+    if (*p != '\0') return ERROR_INVALID_PARAM;
+
+    if (mantissa > (uint64_t)INT64_MAX + (uint64_t)negative ||
+        exponent < INT32_MIN || exponent > INT32_MAX) {
+        return ERROR_INVALID_PARAM;
+    }
+
+    price->mantissa = negative ? (int64_t)(0 - mantissa) : (int64_t)mantissa;
+    price->exponent = (int32_t)exponent;
+    return SUCCESS;
 }
@@ -11,6 +11,8 @@ int serialize_message(const Message* msg, uint8_t* buffer, size_t buffer_size) {
         .message_size = 0,
         .type = msg->type,
         .payload_size = 0,
+        .sequence_num = msg->sequence_num,
+        .timestamp = msg->timestamp,
         .checksum = 0
     };
 
@@ -18,6 +20,7 @@ int serialize_message(const Message* msg, uint8_t* buffer, size_t buffer_size) {
         case MSG_ORDER_NEW:
         case MSG_ORDER_MODIFY:
         case MSG_ORDER_CANCEL:
+        case MSG_ORDER_STATUS:
             header.payload_size = sizeof(Order);
             if (pos + sizeof(MessageHeader) + header.payload_size > buffer_size) {
                 return SERIAL_ERROR_BUFFER_OVERFLOW;
@@ -41,6 +44,25 @@ int serialize_message(const Message* msg, uint8_t* buffer, size_t buffer_size) {
             memcpy(buffer + pos + sizeof(MessageHeader), &msg->data.trade, sizeof(TradeExecution));
             break;
 
+        case MSG_PNL:
+            header.payload_size = sizeof(PnlReport);
+            if (pos + sizeof(MessageHeader) + header.payload_size > buffer_size) {
+                return SERIAL_ERROR_BUFFER_OVERFLOW;
+            }
+            memcpy(buffer + pos + sizeof(MessageHeader), &msg->data.pnl, sizeof(PnlReport));
+            break;
+
+        case MSG_ERROR:
+            header.payload_size = sizeof(msg->data.error);
+            if (pos + sizeof(MessageHeader) + header.payload_size > buffer_size) {
+                return SERIAL_ERROR_BUFFER_OVERFLOW;
+            }
+            memcpy(buffer + pos + sizeof(MessageHeader), &msg->data.error, sizeof(msg->data.error));
+            break;
+
+        case MSG_HEARTBEAT:
+            break;
+
         default:
             return SERIAL_ERROR_INVALID_TYPE;
     }
@@ -65,6 +87,10 @@ int deserialize_message(const uint8_t* buffer, size_t buffer_size, Message* msg)
         return SERIAL_ERROR_INVALID_MESSAGE;
     }
 
+    if (header.message_size != sizeof(MessageHeader) + header.payload_size) {
+        return SERIAL_ERROR_INVALID_MESSAGE;
+    }
+
     if (buffer_size < header.message_size) {
         return SERIAL_ERROR_INCOMPLETE;
     }
@@ -75,12 +101,15 @@ int deserialize_message(const uint8_t* buffer, size_t buffer_size, Message* msg)
     }
 
     msg->type = header.type;
+    msg->sequence_num = header.sequence_num;
+    msg->timestamp = header.timestamp;
     const uint8_t* payload = buffer + sizeof(MessageHeader);
 
     switch (msg->type) {
         case MSG_ORDER_NEW:
         case MSG_ORDER_MODIFY:
         case MSG_ORDER_CANCEL:
+        case MSG_ORDER_STATUS:
             if (header.payload_size != sizeof(Order)) {
                 return SERIAL_ERROR_INVALID_MESSAGE;
             }
@@ -101,11 +130,31 @@ int deserialize_message(const uint8_t* buffer, size_t buffer_size, Message* msg)
             memcpy(&msg->data.trade, payload, sizeof(TradeExecution));
             break;
 
+        case MSG_PNL:
+            if (header.payload_size != sizeof(PnlReport)) {
+                return SERIAL_ERROR_INVALID_MESSAGE;
+            }
+            memcpy(&msg->data.pnl, payload, sizeof(PnlReport));
+            break;
+
+        case MSG_ERROR:
+            if (header.payload_size != sizeof(msg->data.error)) {
+                return SERIAL_ERROR_INVALID_MESSAGE;
+            }
+            memcpy(&msg->data.error, payload, sizeof(msg->data.error));
+            break;
+
+        case MSG_HEARTBEAT:
+            if (header.payload_size != 0) {
+                return SERIAL_ERROR_INVALID_MESSAGE;
+            }
+            break;
+
         default:
             return SERIAL_ERROR_INVALID_TYPE;
     }
 
-    return SERIAL_SUCCESS;
+    return (int)header.message_size;
 }
 
 uint32_t calculate_checksum(const uint8_t* data, size_t size) {
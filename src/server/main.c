@@ -6,19 +6,143 @@ static void print_usage(const char* program_name) {
     printf("Options:\n");
     printf("  -p, --port PORT       Server port (default: %d)\n", DEFAULT_PORT);
     printf("  -c, --clients MAX     Maximum clients (default: %d)\n", DEFAULT_MAX_CLIENTS);
-    printf("  -t, --timeout SECS    Socket timeout (default: %d)\n", DEFAULT_SOCKET_TIMEOUT);
+    printf("  -t, --timeout SECS    Drop sessions silent for SECS (default: %d, 0 = never)\n", DEFAULT_SOCKET_TIMEOUT);
     printf("  -l, --log-level LVL   Log level (0-5, default: 2)\n");
     printf("  -f, --log-file FILE   Log file path\n");
+    printf("  -b, --binary-log      Write a binary log (decode with tradesynth_logcat)\n");
+    printf("  -j, --journal FILE    Journal orders and trades to FILE\n");
+    printf("      --journal-sync-us N      fdatasync within N us of a write (default: %d, 0 = off)\n",
+           JOURNAL_DEFAULT_SYNC_INTERVAL_US);
+    printf("      --journal-sync-events N  fdatasync every N events (default: %d, 0 = off)\n",
+           JOURNAL_DEFAULT_SYNC_EVENTS);
+    printf("  -s, --snapshot-dir DIR       Snapshot books into DIR and restore from it\n");
+    printf("      --snapshot-interval SECS Seconds between snapshots (default: %d, 0 = shutdown only)\n",
+           DEFAULT_SNAPSHOT_INTERVAL);
+    printf("  -d, --tick-dir DIR           Capture market data and trades into tick files under DIR\n");
+    printf("      --tick-records N         Records preallocated per tick file (default: %u)\n",
+           TICK_STORE_DEFAULT_RECORDS);
+    printf("  -m, --metrics NAME           Shared-memory stats segment (default: /tradesynth-PORT, \"\" = off)\n");
+    printf("      --metrics-interval MS    Stats publish interval (default: %d)\n",
+           METRICS_DEFAULT_INTERVAL_MS);
+    printf("      --metrics-http PORT      Serve stats on http://127.0.0.1:PORT/metrics (default: off)\n");
+    printf("      --position-limit N       Max long or short shares per client and symbol (default: %d)\n",
+           DEFAULT_POSITION_LIMIT);
+    printf("      --max-accounts N         Client ids tracked for positions (default: %d)\n",
+           DEFAULT_MAX_ACCOUNTS);
+    printf("      --risk-limits FILE       Per-symbol and per-client risk limits, reread on SIGHUP\n");
+    printf("      --session-msg-rate R[:B] Messages per second per session, burst B (default: off)\n");
+    printf("      --session-order-rate R[:B]  Orders per second per session\n");
+    printf("      --client-msg-rate R[:B]  Messages per second per client id, over all its sessions\n");
+    printf("      --client-order-rate R[:B]   Orders per second per client id\n");
+    printf("      --day-end HH:MM          Expire DAY orders at this time UTC each day (default: never)\n");
+    printf("      --auction-open HH:MM     Collect orders from the day end until HH:MM UTC, then uncross\n");
+    printf("      --auction-close HH:MM    Collect orders from HH:MM UTC, uncross at the day end\n");
+    printf("      --match SYM:POLICY[:MIN[:PCT]]  Match SYM price-time, pro-rata or hybrid; MIN is the\n");
+    printf("                               smallest pro-rata share (default: 1), PCT the hybrid's\n");
+    printf("                               part filled oldest first (default: %d); repeatable\n",
+           DEFAULT_HYBRID_FIFO_PERCENT);
+    printf("      --symbols SYM[,SYM...]   Symbols to trade; orders for any other are refused. Symbols\n");
+    printf("                               in --match and the risk limits file count too; repeatable\n");
     printf("  -h, --help            Show this help message\n");
 }
 
+// RATE or RATE:BURST, messages per second
+static int parse_throttle(const char* text, ThrottleLimit* limit) {
+    char* end;
+    unsigned long rate = strtoul(text, &end, 10);
+    unsigned long burst = 0;
+    if (end != text && *end == ':') {
+        const char* burst_text = end + 1;
+        burst = strtoul(burst_text, &end, 10);
+        if (end == burst_text) return -1;
+    }
+    if (end == text || *end != '\0' || rate > UINT32_MAX || burst > UINT32_MAX) return -1;
+
+    limit->rate = (uint32_t)rate;
+    limit->burst = (uint32_t)burst;
+    return 0;
+}
+
+// HH:MM UTC as seconds after midnight, 24:00 for midnight
+static int parse_time_of_day(const char* text, uint32_t* seconds) {
+    unsigned hours, minutes;
+    char tail;
+    if (sscanf(text, "%2u:%2u%c", &hours, &minutes, &tail) != 2 || minutes > 59 ||
+        hours * 60 + minutes == 0 || hours * 60 + minutes > 24 * 60) {
+        return -1;
+    }
+    *seconds = (hours * 60 + minutes) * 60;
+    return 0;
+}
+
+// SYMBOL:POLICY[:MIN[:PCT]]
+static int parse_match_policy(const char* text, SymbolMatchPolicy* match) {
+    static const char* const names[MATCH_POLICY_COUNT] = { "price-time", "pro-rata", "hybrid" };
+    const char* colon = strchr(text, ':');
+    if (!colon || colon == text || colon - text >= MAX_SYMBOL_LENGTH) return -1;
+
+    memset(match, 0, sizeof(*match));
+    memcpy(match->symbol, text, (size_t)(colon - text));
+    const char* name = colon + 1;
+    size_t length = strcspn(name, ":");
+    match->policy = MATCH_POLICY_COUNT;
+    for (int i = 0; i < MATCH_POLICY_COUNT; i++) {
+        if (strlen(names[i]) == length && strncmp(name, names[i], length) == 0) {
+            match->policy = (MatchPolicy)i;
+        }
+    }
+    if (match->policy == MATCH_POLICY_COUNT) return -1;
+
+    unsigned long minimum = 1, percent = DEFAULT_HYBRID_FIFO_PERCENT;
+    char* end = (char*)name + length;
+    if (*end == ':') {
+        const char* minimum_text = end + 1;
+        minimum = strtoul(minimum_text, &end, 10);
+        if (end == minimum_text) return -1;
+    }
+    if (*end == ':') {
+        const char* percent_text = end + 1;
+        percent = strtoul(percent_text, &end, 10);
+        if (end == percent_text) return -1;
+    }
+    if (*end != '\0' || minimum > UINT32_MAX || percent > 100) return -1;
+
+    match->min_allocation = (uint32_t)minimum;
+    match->fifo_percent = match->policy == MATCH_HYBRID ? (uint32_t)percent : 0;
+    return 0;
+}
+
+// SYM[,SYM...], appended to the configured symbols
+static int parse_symbols(const char* text, ServerConfig* config) {
+    while (*text) {
+        size_t length = strcspn(text, ",");
+        if (length == 0 || length >= MAX_SYMBOL_LENGTH ||
+            config->symbol_count == MAX_CONFIGURED_SYMBOLS) {
+            return -1;
+        }
+        char* symbol = config->symbols[config->symbol_count++];
+        memcpy(symbol, text, length);
+        symbol[length] = '\0';
+        text += length;
+        if (*text == ',') text++;
+    }
+    return 0;
+}
+
 int main(int argc, char *argv[]) {
     ServerConfig config = {
         .port = DEFAULT_PORT,
         .max_clients = DEFAULT_MAX_CLIENTS,
         .socket_timeout = DEFAULT_SOCKET_TIMEOUT,
-        .log_level = LOG_INFO
+        .log_level = LOG_INFO,
+        .journal_sync_interval_us = JOURNAL_DEFAULT_SYNC_INTERVAL_US,
+        .journal_sync_events = JOURNAL_DEFAULT_SYNC_EVENTS,
+        .snapshot_interval = DEFAULT_SNAPSHOT_INTERVAL,
+        .tick_records_per_file = TICK_STORE_DEFAULT_RECORDS,
+        .metrics_interval_ms = METRICS_DEFAULT_INTERVAL_MS
     };
+    int binary_log = 0;
+    int metrics_named = 0;
     strncpy(config.bind_address, "0.0.0.0", sizeof(config.bind_address));
     strncpy(config.log_file, "./server.log", sizeof(config.log_file));
 
@@ -29,12 +153,35 @@ int main(int argc, char *argv[]) {
         {"timeout",   required_argument, 0, 't'},
         {"log-level", required_argument, 0, 'l'},
         {"log-file",  required_argument, 0, 'f'},
+        {"binary-log", no_argument,      0, 'b'},
+        {"journal",   required_argument, 0, 'j'},
+        {"journal-sync-us",     required_argument, 0, 'S'},
+        {"journal-sync-events", required_argument, 0, 'E'},
+        {"snapshot-dir",        required_argument, 0, 's'},
+        {"snapshot-interval",   required_argument, 0, 'I'},
+        {"tick-dir",            required_argument, 0, 'd'},
+        {"tick-records",        required_argument, 0, 'R'},
+        {"metrics",             required_argument, 0, 'm'},
+        {"metrics-interval",    required_argument, 0, 'M'},
+        {"metrics-http",        required_argument, 0, 'H'},
+        {"position-limit",      required_argument, 0, 'P'},
+        {"max-accounts",        required_argument, 0, 'A'},
+        {"risk-limits",         required_argument, 0, 'L'},
+        {"session-msg-rate",    required_argument, 0, 'G'},
+        {"session-order-rate",  required_argument, 0, 'O'},
+        {"client-msg-rate",     required_argument, 0, 'U'},
+        {"client-order-rate",   required_argument, 0, 'V'},
+        {"day-end",             required_argument, 0, 'D'},
+        {"auction-open",        required_argument, 0, 'N'},
+        {"auction-close",       required_argument, 0, 'C'},
+        {"match",               required_argument, 0, 'X'},
+        {"symbols",             required_argument, 0, 'Y'},
         {"help",      no_argument,       0, 'h'},
         {0, 0, 0, 0}
     };
 
     int opt;
-    while ((opt = getopt_long(argc, argv, "p:c:t:l:f:h", long_options, NULL)) != -1) {
+    while ((opt = getopt_long(argc, argv, "p:c:t:l:f:bj:s:d:m:h", long_options, NULL)) != -1) {
         switch (opt) {
             case 'p':
                 config.port = atoi(optarg);
@@ -51,6 +198,93 @@ int main(int argc, char *argv[]) {
             case 'f':
                 strncpy(config.log_file, optarg, sizeof(config.log_file) - 1);
                 break;
+            case 'b':
+                binary_log = 1;
+                break;
+            case 'j':
+                strncpy(config.journal_file, optarg, sizeof(config.journal_file) - 1);
+                break;
+            case 'S':
+                config.journal_sync_interval_us = (uint32_t)atoi(optarg);
+                break;
+            case 'E':
+                config.journal_sync_events = (uint32_t)atoi(optarg);
+                break;
+            case 's':
+                strncpy(config.snapshot_dir, optarg, sizeof(config.snapshot_dir) - 1);
+                break;
+            case 'I':
+                config.snapshot_interval = (uint32_t)atoi(optarg);
+                break;
+            case 'd':
+                strncpy(config.tick_dir, optarg, sizeof(config.tick_dir) - 1);
+                break;
+            case 'R':
+                config.tick_records_per_file = strtoull(optarg, NULL, 10);
+                break;
+            case 'm':
+                strncpy(config.metrics_name, optarg, sizeof(config.metrics_name) - 1);
+                metrics_named = 1;
+                break;
+            case 'M':
+                config.metrics_interval_ms = (uint32_t)atoi(optarg);
+                break;
+            case 'H':
+                config.metrics_http_port = atoi(optarg);
+                break;
+            case 'P':
+                config.position_limit = (uint32_t)atoi(optarg);
+                break;
+            case 'A':
+                config.max_accounts = (uint32_t)atoi(optarg);
+                break;
+            case 'L':
+                strncpy(config.risk_limits_file, optarg, sizeof(config.risk_limits_file) - 1);
+                break;
+            case 'G':
+            case 'O':
+            case 'U':
+            case 'V': {
+                ThrottleKind kind = opt == 'G' ? THROTTLE_SESSION_MESSAGES :
+                                    opt == 'O' ? THROTTLE_SESSION_ORDERS :
+                                    opt == 'U' ? THROTTLE_CLIENT_MESSAGES : THROTTLE_CLIENT_ORDERS;
+                if (parse_throttle(optarg, &config.throttle[kind]) != 0) {
+                    fprintf(stderr, "Invalid rate '%s', expected RATE or RATE:BURST\n", optarg);
+                    return EXIT_FAILURE;
+                }
+                break;
+            }
+            case 'D':
+                if (parse_time_of_day(optarg, &config.day_end) != 0) {
+                    fprintf(stderr, "Invalid day end '%s', expected HH:MM between 00:01 and 24:00\n", optarg);
+                    return EXIT_FAILURE;
+                }
+                break;
+            case 'N':
+            case 'C':
+                if (parse_time_of_day(optarg, opt == 'N' ? &config.auction_open : &config.auction_close) != 0) {
+                    fprintf(stderr, "Invalid auction time '%s', expected HH:MM between 00:01 and 24:00\n", optarg);
+                    return EXIT_FAILURE;
+                }
+                break;
+            case 'X':
+                if (config.match_policy_count == MAX_MATCH_POLICIES) {
+                    fprintf(stderr, "At most %d --match options\n", MAX_MATCH_POLICIES);
+                    return EXIT_FAILURE;
+                }
+                if (parse_match_policy(optarg, &config.match_policies[config.match_policy_count]) != 0) {
+                    fprintf(stderr, "Invalid match policy '%s', expected SYMBOL:POLICY[:MIN[:PCT]]\n", optarg);
+                    return EXIT_FAILURE;
+                }
+                config.match_policy_count++;
+                break;
+            case 'Y':
+                if (parse_symbols(optarg, &config) != 0) {
+                    fprintf(stderr, "Invalid symbols '%s', expected at most %d names of under %d characters\n",
+                            optarg, MAX_CONFIGURED_SYMBOLS, MAX_SYMBOL_LENGTH);
+                    return EXIT_FAILURE;
+                }
+                break;
             case 'h':
                 print_usage(argv[0]);
                 return EXIT_SUCCESS;
@@ -60,9 +294,27 @@ int main(int argc, char *argv[]) {
         }
     }
 
+    // One segment per server, so tradesynth_top -p PORT finds it
+    if (!metrics_named) {
+        snprintf(config.metrics_name, sizeof(config.metrics_name), "/tradesynth-%d", config.port);
+    }
+
     // Initialize logging
-    init_logger(config.log_file, config.log_level);
+    LoggerConfig log_config = {
+        .log_file_path = config.log_file,
+        .min_level = config.log_level,
+        .overflow_policy = LOG_OVERFLOW_DROP,
+        .ring_capacity = LOG_DEFAULT_RING_CAPACITY,
+        .flush_interval_us = LOG_DEFAULT_FLUSH_INTERVAL_US,
+        .console_output = 1,
+        .format = binary_log ? LOG_FORMAT_BINARY : LOG_FORMAT_TEXT
+    };
+    init_logger_with_config(&log_config);
     LOG_INFO("TradeSynth Server Starting...");
+    if (!validate_server_config(&config)) {
+        close_logger();
+        return EXIT_FAILURE;
+    }
 
     // Initialize server
     ServerContext* context = initialize_server_context(&config);
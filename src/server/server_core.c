@@ -5,8 +5,22 @@
 #include <unistd.h>
 
 volatile sig_atomic_t server_running = 1;
+volatile sig_atomic_t latency_dump_requested = 0;
+volatile sig_atomic_t risk_reload_requested = 0;
+
+// Every context gets a new epoch so id blocks cached by a thread for an
+// earlier context (tests create several per process) are never reused
+static atomic_uint_least64_t id_epochs;
 
 void signal_handler(int signum) {
+    if (signum == SIGUSR1) {
+        latency_dump_requested = 1;
+        return;
+    }
+    if (signum == SIGHUP) {
+        risk_reload_requested = 1;
+        return;
+    }
     LOG_INFO("Received signal %d, initiating shutdown", signum);
     server_running = 0;
 }
@@ -29,18 +43,45 @@ int validate_server_config(const ServerConfig* config) {
         return 0;
     }
 
+    if (config->day_end > NANOS_PER_DAY / NANOS_PER_SECOND) {
+        LOG_ERROR("Invalid day end: %u seconds after midnight", config->day_end);
+        return 0;
+    }
+
+    // The opening call runs from the day end (or midnight), the closing call up to it
+    uint32_t day = NANOS_PER_DAY / NANOS_PER_SECOND;
+    if (config->auction_open &&
+        (config->auction_open > day || config->auction_open % day == config->day_end % day)) {
+        LOG_ERROR("Invalid opening auction: %u seconds after midnight", config->auction_open);
+        return 0;
+    }
+    if (config->auction_close &&
+        (config->auction_close >= config->day_end ||
+         (config->auction_open && config->auction_open % day >= config->auction_close))) {
+        LOG_ERROR("Invalid closing auction: %u seconds after midnight, needs a later day end",
+                  config->auction_close);
+        return 0;
+    }
+
     return 1;
 }
 
 ServerContext* initialize_server_context(const ServerConfig* config) {
-    ServerContext* context = calloc(1, sizeof(ServerContext));
+    // Aligned so the id counters really get a cache line each
+    ServerContext* context = aligned_alloc(_Alignof(ServerContext), sizeof(ServerContext));
     if (!context) {
         LOG_ERROR("Failed to allocate server context");
         return NULL;
     }
+    memset(context, 0, sizeof(*context));
     
     context->state = SERVER_STATE_INIT;
-    atomic_init(&context->sequence_num, 1);
+    context->id_epoch = atomic_fetch_add(&id_epochs, 1) + 1;
+    atomic_init(&context->next_order_id, 1);
+    atomic_init(&context->next_trade_id, 1);
+
+    // Calibrate the tick counter up front so latency recording never has to
+    clock_ticks_per_second();
     context->config = *config;
     
     context->clients = calloc(config->max_clients, sizeof(ClientConnection));
@@ -60,6 +101,112 @@ ServerContext* initialize_server_context(const ServerConfig* config) {
         free(context);
         return NULL;
     }
+    for (int i = 0; i < config->max_clients; i++) {
+        pthread_mutex_init(&context->clients[i].lock, NULL);
+        context->clients[i].account_id = UINT32_MAX;
+    }
+    timers_init(context);
+
+    if (initialize_symbol_table(context) != SUCCESS) {
+        free(context->clients);
+        free(context);
+        return NULL;
+    }
+
+    // Sized by max_symbols, so after the symbol table
+    if (initialize_position_table(context) != SUCCESS) {
+        cleanup_symbol_table(context);
+        free(context->clients);
+        free(context);
+        return NULL;
+    }
+    if (throttle_init(context) != SUCCESS) {
+        cleanup_position_table(context);
+        cleanup_symbol_table(context);
+        free(context->clients);
+        free(context);
+        return NULL;
+    }
+
+    if (config->journal_file[0] != '\0') {
+        context->journal = journal_open(config->journal_file,
+                                        config->journal_sync_interval_us,
+                                        config->journal_sync_events,
+                                        &context->stats);
+        if (!context->journal) {
+            throttle_cleanup(context);
+            cleanup_position_table(context);
+            cleanup_symbol_table(context);
+            free(context->clients);
+            free(context);
+            return NULL;
+        }
+    }
+
+    // Rebuild books from the last snapshot and the journal written since
+    if ((config->journal_file[0] != '\0' || config->snapshot_dir[0] != '\0') &&
+        snapshot_restore(context) != SUCCESS) {
+        LOG_ERROR("Failed to restore server state");
+        journal_close(context->journal);
+        throttle_cleanup(context);
+        cleanup_position_table(context);
+        cleanup_symbol_table(context);
+        free(context->clients);
+        free(context);
+        return NULL;
+    }
+
+    // After the restore, which may reset the books, and before the rules index them
+    if (register_configured_symbols(context) != SUCCESS) {
+        journal_close(context->journal);
+        throttle_cleanup(context);
+        cleanup_position_table(context);
+        cleanup_symbol_table(context);
+        free(context->clients);
+        free(context);
+        return NULL;
+    }
+
+    // Rules index books and accounts by id, so after the restore has settled them
+    if (risk_load_limits(context) != SUCCESS) {
+        LOG_ERROR("Failed to load risk limits");
+        journal_close(context->journal);
+        throttle_cleanup(context);
+        cleanup_position_table(context);
+        cleanup_symbol_table(context);
+        free(context->clients);
+        free(context);
+        return NULL;
+    }
+
+    // Opened after the restore so replayed trades are not captured twice
+    if (config->tick_dir[0] != '\0') {
+        context->tick_store = tick_store_open(config->tick_dir, context->config.max_symbols,
+                                              config->tick_records_per_file, &context->stats);
+        if (!context->tick_store) {
+            journal_close(context->journal);
+            risk_cleanup(context);
+            throttle_cleanup(context);
+            cleanup_position_table(context);
+            cleanup_symbol_table(context);
+            free(context->clients);
+            free(context);
+            return NULL;
+        }
+    }
+
+    if (metrics_start(context) != SUCCESS) {
+        LOG_ERROR("Failed to start metrics");
+        tick_store_close(context->tick_store);
+        journal_close(context->journal);
+        risk_cleanup(context);
+        throttle_cleanup(context);
+        cleanup_position_table(context);
+        cleanup_symbol_table(context);
+        free(context->clients);
+        free(context);
+        return NULL;
+    }
     
     return context;
 }
@@ -79,6 +226,9 @@ int start_server(ServerContext* context) {
     sa.sa_flags = 0;
     sigaction(SIGINT, &sa, NULL);
     sigaction(SIGTERM, &sa, NULL);
+    sigaction(SIGUSR1, &sa, NULL);
+    sigaction(SIGHUP, &sa, NULL);
+    metrics_thread_name("main");
 
     context->server_socket = setup_socket(context);
     if (context->server_socket < 0) {
@@ -93,20 +243,39 @@ int start_server(ServerContext* context) {
     context->state = SERVER_RUNNING;
     LOG_INFO("Server started successfully");
 
+    int snapshots_enabled = context->config.snapshot_dir[0] != '\0';
+    uint64_t snapshot_interval_ns = (uint64_t)context->config.snapshot_interval * NANOS_PER_SECOND;
+    uint64_t last_snapshot = clock_monotonic_raw_ns();
+
     // Main server loop
     while (server_running) {
         LOG_DEBUG("Server running: %d", server_running);
+        if (latency_dump_requested) {
+            latency_dump_requested = 0;
+            latency_log_summary();
+        }
+        if (risk_reload_requested) {
+            risk_reload_requested = 0;
+            risk_load_limits(context);
+        }
+        timers_tick(context, clock_now_ns());
+        if (snapshots_enabled && snapshot_interval_ns > 0 &&
+            clock_monotonic_raw_ns() - last_snapshot >= snapshot_interval_ns) {
+            snapshot_write(context);
+            last_snapshot = clock_monotonic_raw_ns();
+        }
+        // Waits up to ACCEPT_POLL_TIMEOUT_MS, so the checks and timers above stay timely
         int result = accept_client(context);
-        if (result < 0) {
-            if (errno == EAGAIN || errno == EWOULDBLOCK) {
-                usleep(9000000); // Sleep briefly to avoid busy looping
-            } else {
-                LOG_ERROR("Failed to accept client connection: %s", strerror(errno));
-            }
+        if (result < 0 && result != ERROR_TIMEOUT && result != ERROR_MAX_CLIENTS) {
+            LOG_ERROR("Failed to accept client connection: %s", strerror(errno));
         }
     }
 
+    latency_log_summary();
     stop_server(context);
+    if (snapshots_enabled) {
+        snapshot_write(context);
+    }
     return SUCCESS;
 }
 
@@ -121,15 +290,20 @@ void stop_server(ServerContext* context) {
         context->server_socket = -1;
     }
 
+    // Wake the detached handlers blocked in recv and wait for them to leave
     pthread_mutex_lock(&context->clients_mutex);
-    for (int i = 0; i < context->client_count; i++) {
+    for (int i = 0; i < context->config.max_clients; i++) {
         if (context->clients[i].active) {
-            pthread_join(context->clients[i].thread, NULL);
-            context->clients[i].active = 0;
+            shutdown(context->clients[i].socket, SHUT_RDWR);
         }
-        close(context->clients[i].socket);
     }
-    context->client_count = 0;
+    pthread_mutex_unlock(&context->clients_mutex);
+
+    while (atomic_load(&context->client_count) > 0) {
+        usleep(1000);
+    }
+    // The last handler may still be releasing the mutex
+    pthread_mutex_lock(&context->clients_mutex);
     pthread_mutex_unlock(&context->clients_mutex);
 
     context->state = SERVER_STOPPED;
@@ -140,10 +314,23 @@ void cleanup_server(ServerContext* context) {
     if (!context) return;
 
     stop_server(context);
+    // Publishes the final counters, so it runs before anything is freed
+    metrics_stop(context);
 
     pthread_mutex_destroy(&context->stats_mutex);
     pthread_mutex_destroy(&context->clients_mutex);
+    for (int i = 0; i < context->config.max_clients; i++) {
+        pthread_mutex_destroy(&context->clients[i].lock);
+    }
 
+    journal_close(context->journal);
+    context->journal = NULL;
+    tick_store_close(context->tick_store);
+    context->tick_store = NULL;
+    risk_cleanup(context);
+    throttle_cleanup(context);
+    cleanup_position_table(context);
+    cleanup_symbol_table(context);
     free(context->clients);
     free(context);
 
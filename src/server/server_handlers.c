@@ -1,52 +1,63 @@
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include "server/server_handlers.h"
+#include "server/server_symbols.h"
+#include "server/server_positions.h"
+#include "server/server_risk.h"
+#include "server/server_orderbook.h"
+#include "server/server_journal.h"
+#include "server/server_timers.h"
+#include "server/server_metrics.h"
 #include "common/logger.h"
+#include "common/utils.h"
+#include "common/latency.h"
 #include "serialization/serialization.h"
 
-static int find_client_socket(ServerContext* context, const char* client_id);
-static uint32_t get_client_position(ServerContext* context, const char* client_id, const char* symbol);
-static MarketData* get_market_data(ServerContext* context, const char* symbol);
+static ClientConnection* find_client(ServerContext* context, const char* client_id);
+static int send_to_client(ClientConnection* client, const Message* msg);
 
-int handle_message(ServerContext* context, int client_socket, const Message* msg) {
+int handle_message(ServerContext* context, ClientConnection* client, const Message* msg) {
     LOG_INFO("Handling message type: %d", msg->type);
     
     switch (msg->type) {
         case MSG_HEARTBEAT:
-            return handle_heartbeat(context, client_socket, msg);
+            return handle_heartbeat(context, client, msg);
         case MSG_ORDER_NEW:
         case MSG_ORDER_CANCEL:
         case MSG_ORDER_MODIFY:
         case MSG_ORDER_STATUS:
-            return handle_order_message(context, client_socket, msg);
+            return handle_order_message(context, client, msg);
         case MSG_MARKET_DATA:
-            return handle_market_data(context, client_socket, msg);
+            return handle_market_data(context, client, msg);
         case MSG_TRADE_EXEC:
-            return handle_trade_exec(context, client_socket, msg);
+            return handle_trade_exec(context, client, msg);
         case MSG_ERROR:
-            return handle_error(context, client_socket, msg);
+            return handle_error(context, client, msg);
+        case MSG_PNL:
+            return process_pnl_query(context, client, &msg->data.pnl);
         default:
             LOG_ERROR("Unknown message type: %d", msg->type);
             return ERROR_INVALID_MESSAGE;
     }
 }
 
-int handle_heartbeat(ServerContext* context __attribute__((unused)), 
-                    int client_socket,
+int handle_heartbeat(ServerContext* context __attribute__((unused)),
+                    ClientConnection* client,
                     const Message* msg) {
-    LOG_DEBUG("Received heartbeat, sequence: %lu", msg->sequence_num);
+    LOG_DEBUG("Received heartbeat, sequence: %lu, timestamp: %lu", msg->sequence_num, msg->timestamp);
     
     Message response = {
         .type = MSG_HEARTBEAT,
-        .sequence_num = msg->sequence_num + 1,
-        .timestamp = time(NULL)
+        .timestamp = clock_frame_time()
     };
     
-    return send_response_message(client_socket, &response);
+    // Heartbeats take the session's next sequence number like any other reply
+    return send_to_client(client, &response);
 }
 
 int handle_order_message(ServerContext* context,
-                        int client_socket __attribute__((unused)),
+                        ClientConnection* client __attribute__((unused)),
                         const Message* msg) {
     const Order* order = &msg->data.order;
     LOG_INFO("Processing order:");
@@ -58,59 +69,538 @@ int handle_order_message(ServerContext* context,
     LOG_INFO("  Side: %d", order->side);
     LOG_INFO("  Price: %.6f", price_to_double(order->price));
     LOG_INFO("  Quantity: %u", order->quantity);
+    LOG_INFO("  Timestamp: %lu", msg->timestamp);
     
-    return process_order(context, order);
+    return process_order_message(context, msg);
+}
+
+int process_order_message(ServerContext* context, const Message* msg) {
+    switch (msg->type) {
+        case MSG_ORDER_NEW:
+            return process_order(context, &msg->data.order);
+        case MSG_ORDER_CANCEL:
+            return process_cancel_order(context, &msg->data.order);
+        case MSG_ORDER_MODIFY:
+            return process_modify_order(context, &msg->data.order);
+        case MSG_ORDER_STATUS:
+            return process_order_status(context, &msg->data.order);
+        default:
+            return ERROR_INVALID_MESSAGE;
+    }
+}
+
+// Trades, and statuses of released stops and expired orders, produced while
+// a book is locked, sent once it is released. A batch starts on the stack
+// and moves to the heap when a sweep or an uncross outgrows it.
+#define TRADE_BATCH_SIZE 64
+
+typedef struct {
+    ServerContext* context;
+    uint32_t count;
+    uint32_t capacity;
+    uint32_t released_count;
+    uint32_t released_capacity;
+    int repriced;                 // Some fill was away from the book's mark
+    int64_t last_price;           // Of the last fill, in ticks
+    TradeExecution* trades;
+    Order* released;
+    TradeExecution inline_trades[TRADE_BATCH_SIZE];
+    Order inline_released[TRADE_BATCH_SIZE];
+} TradeBatch;
+
+// Filled rows were valued at their own fill prices; everyone else holding
+// the symbol only needs revaluing when the mark moved
+static void mark_after_trades(ServerContext* context, OrderBook* book, const TradeBatch* batch) {
+    if (batch->repriced) {
+        position_mark(context, book, batch->last_price);
+    }
+}
+
+// Only the header is set up; zeroing the arrays would cost more than matching
+static inline void start_batch(TradeBatch* batch, ServerContext* context) {
+    batch->context = context;
+    batch->count = 0;
+    batch->capacity = TRADE_BATCH_SIZE;
+    batch->released_count = 0;
+    batch->released_capacity = TRADE_BATCH_SIZE;
+    batch->repriced = 0;
+    batch->last_price = 0;
+    batch->trades = batch->inline_trades;
+    batch->released = batch->inline_released;
+}
+
+// Double a full array, copying it off the stack the first time; NULL if out of memory
+static void* grow_batch(void* items, const void* inline_items, uint32_t* capacity, size_t size) {
+    void* grown = items == inline_items ? malloc(*capacity * 2 * size) : realloc(items, *capacity * 2 * size);
+    if (!grown) return NULL;
+    if (items == inline_items) {
+        memcpy(grown, inline_items, *capacity * size);
+    }
+    *capacity *= 2;
+    return grown;
+}
+
+static int send_order_status(ServerContext* context, const Order* order);
+
+static void publish_trade(ServerContext* context, const TradeExecution* trade);
+
+static void flush_trades(TradeBatch* batch) {
+    for (uint32_t i = 0; i < batch->count; i++) {
+        publish_trade(batch->context, &batch->trades[i]);
+    }
+    for (uint32_t i = 0; i < batch->released_count; i++) {
+        send_order_status(batch->context, &batch->released[i]);
+    }
+    if (batch->trades != batch->inline_trades) {
+        free(batch->trades);
+    }
+    if (batch->released != batch->inline_released) {
+        free(batch->released);
+    }
+    start_batch(batch, batch->context);
+}
+
+static void collect_fill(OrderBook* book, const OrderFill* fill, void* arg) {
+    TradeBatch* batch = arg;
+    position_apply_fill(batch->context, book, fill);
+    if (fill->price != atomic_load_explicit(&book->mark, memory_order_relaxed)) {
+        batch->repriced = 1;
+    }
+    batch->last_price = fill->price;
+
+    // Only a sweep through more than a batch of resting orders gets here.
+    // Out of memory, sending under the book lock beats losing the trades.
+    if (batch->count == batch->capacity) {
+        TradeExecution* grown = grow_batch(batch->trades, batch->inline_trades, &batch->capacity,
+                                           sizeof(*grown));
+        if (grown) {
+            batch->trades = grown;
+        } else {
+            LOG_ERROR("Failed to grow trade batch for %s", book->symbol);
+            flush_trades(batch);
+        }
+    }
+
+    const Order* buyer = fill->aggressor->side == ORDER_SIDE_BUY ? fill->aggressor : fill->resting;
+    const Order* seller = fill->aggressor->side == ORDER_SIDE_BUY ? fill->resting : fill->aggressor;
+
+    TradeExecution* trade = &batch->trades[batch->count++];
+    memset(trade, 0, sizeof(*trade));
+    trade->trade_id = generate_trade_id(batch->context);
+    trade->order_id = fill->aggressor->order_id;
+    trade->client_order_id = fill->aggressor->client_order_id;
+    memcpy(trade->symbol, book->symbol, MAX_SYMBOL_LENGTH);
+    trade->price = price_from_ticks(fill->price, book->tick_exponent);
+    trade->quantity = fill->quantity;
+    trade->timestamp = clock_frame_time();
+    memcpy(trade->buyer_id, buyer->client_id, MAX_CLIENT_ID_LENGTH);
+    memcpy(trade->seller_id, seller->client_id, MAX_CLIENT_ID_LENGTH);
+
+    // Journaled and priced into the market data under the book lock, so a
+    // snapshot's market data holds exactly the trades up to its sequence
+    uint64_t sequence = journal_append_trade(batch->context->journal, trade);
+    if (sequence > 0) {
+        book->last_journal_sequence = sequence;
+    }
+    update_symbol_last_trade(batch->context, trade);
+}
+
+static void queue_status(TradeBatch* batch, const Order* order) {
+    if (batch->released_count == batch->released_capacity) {
+        Order* grown = grow_batch(batch->released, batch->inline_released, &batch->released_capacity,
+                                  sizeof(*grown));
+        if (grown) {
+            batch->released = grown;
+        } else {
+            LOG_ERROR("Failed to grow order status batch");
+            flush_trades(batch);
+        }
+    }
+    batch->released[batch->released_count] = *order;
+    batch->released[batch->released_count++].modification_time = clock_frame_time();
+}
+
+// A triggered stop now rests like any order, and its owner hears it triggered
+static void collect_release(OrderBook* book, const Order* order, void* arg) {
+    TradeBatch* batch = arg;
+    const OrderBookEntry* rested = orderbook_find_order(book, order->order_id);
+    if (rested) {
+        position_add_open(batch->context, book, &rested->order, rested->order.remaining_quantity);
+    }
+    queue_status(batch, order);
+}
+
+
+static int send_order_status(ServerContext* context, const Order* order) {
+    Message response = {
+        .type = MSG_ORDER_STATUS,
+        .timestamp = clock_frame_time(),
+        .data.order = *order
+    };
+
+    ClientConnection* client = find_client(context, order->client_id);
+    return client ? send_to_client(client, &response) : ERROR_INVALID_STATE;
+}
+
+// Journal an accepted event under the book lock so file order is book order
+static void journal_book_event(ServerContext* context, OrderBook* book,
+                               JournalEventType type, const Order* order) {
+    uint64_t sequence = journal_append_order(context->journal, type, order);
+    if (sequence > 0) {
+        book->last_journal_sequence = sequence;
+    }
+}
+
+// Auction phase changes carry only the symbol, and for a call its uncross time
+static void journal_phase(ServerContext* context, OrderBook* book, JournalEventType type,
+                          uint64_t call_ends) {
+    Order event;
+    memset(&event, 0, sizeof(event));
+    memcpy(event.symbol, book->symbol, MAX_SYMBOL_LENGTH);
+    event.expiration_time = call_ends;
+    journal_book_event(context, book, type, &event);
+}
+
+/**
+ * Bring a book's auction phase up to now, under its write lock: uncross a
+ * call whose time has come, then start one if the schedule is in a call.
+ * Both are journaled and stops the uncross triggers are released straight
+ * after it, so a replay does the same at the same point of the order flow.
+ */
+static void sync_phase(ServerContext* context, OrderBook* book, uint64_t now, TradeBatch* batch) {
+    if (book->phase == BOOK_PHASE_CALL && book->call_ends != 0 && now >= book->call_ends) {
+        journal_phase(context, book, JOURNAL_AUCTION_UNCROSS, 0);
+        uint64_t volume = orderbook_uncross(book, collect_fill, batch);
+        book->phase = BOOK_PHASE_CONTINUOUS;
+        book->call_ends = 0;
+        orderbook_release_stops(book, collect_fill, collect_release, batch);
+        LOG_INFO("Uncrossed %s: %lu traded", book->symbol, volume);
+    }
+
+    uint64_t call_ends, next;
+    if (timers_auction_phase(&context->config, now, &call_ends, &next) == BOOK_PHASE_CALL &&
+        book->phase != BOOK_PHASE_CALL) {
+        journal_phase(context, book, JOURNAL_AUCTION_CALL, call_ends);
+        book->phase = BOOK_PHASE_CALL;
+        book->call_ends = call_ends;
+        LOG_INFO("%s is in a call auction", book->symbol);
+    }
+    if (book->phase == BOOK_PHASE_CALL && book->call_ends != 0 && book->call_ends < next) {
+        next = book->call_ends;
+    }
+    atomic_store_explicit(&book->phase_due, next, memory_order_relaxed);
+}
+
+// Reference prices come from the engine's own trades and quotes, read
+// without locks; market data a client sends in moves neither
+static inline int64_t book_last_trade(const OrderBook* book) {
+    return atomic_load_explicit(&book->mark, memory_order_relaxed);
+}
+
+static int64_t book_best_ask(const OrderBook* book) {
+    BookStats stats;
+    return orderbook_read_stats(book, &stats) == SUCCESS ? stats.best_ask : 0;
 }
 
 int process_order(ServerContext* context, const Order* order) {
+    uint64_t stage_start = clock_ticks();
+
     // Create a working copy of the order
     Order processed_order = *order;
     
-    // Validate order parameters
-    if (processed_order.quantity == 0 || processed_order.quantity > 1000000) {
-        LOG_ERROR("Invalid order quantity: %u", processed_order.quantity);
+    // Well-formed fields only; size and price limits are the risk gate's
+    if (validate_order_fields(&processed_order) != SUCCESS) {
+        return ERROR_INVALID_ORDER;
+    }
+    if (processed_order.expiration_time != 0 && processed_order.expiration_time <= clock_frame_time()) {
+        LOG_ERROR("Order %lu expired before it arrived", processed_order.order_id);
         return ERROR_INVALID_ORDER;
     }
 
-    // Position limit checks
-    uint32_t total_position = get_client_position(context,
-                                               processed_order.client_id,
-                                               processed_order.symbol);
-    if (processed_order.side == ORDER_SIDE_BUY &&
-        total_position + processed_order.quantity > 1000000) { // Example limit
-        LOG_ERROR("Position limit exceeded for %s", processed_order.client_id);
+    OrderBook* book = find_order_book(context, processed_order.symbol);
+    if (!book) {
+        LOG_WARN("Order for unknown symbol: %s", processed_order.symbol);
+        return ERROR_SYMBOL_NOT_FOUND;
+    }
+
+    // Limit prices must sit on the symbol's tick grid
+    int64_t price_ticks = 0;
+    if (processed_order.type == ORDER_TYPE_LIMIT &&
+        price_to_ticks(processed_order.price, book->tick_exponent, &price_ticks) < 0) {
+        LOG_ERROR("Price not on tick grid (1e%d) for %s", book->tick_exponent, book->symbol);
         return ERROR_INVALID_ORDER;
     }
 
-    // Price improvement for limit orders
+    // Ids are the server's alone, so one can never collide with another
+    // client's; the client's own reference travels in client_order_id
+    processed_order.order_id = generate_order_id(context);
+
+    // Price improvement: one tick towards the book's ask for buys below it.
+    // Before the risk gate, so limits see the price that trades.
     if (processed_order.type == ORDER_TYPE_LIMIT) {
-        MarketData* market_data = get_market_data(context, processed_order.symbol);
-        if (market_data) {
-            if (processed_order.side == ORDER_SIDE_BUY &&
-                price_to_double(processed_order.price) < price_to_double(market_data->ask)) {
-                processed_order.price = double_to_price(
-                    price_to_double(processed_order.price) + 0.01);
-            }
+        int64_t best_ask = book_best_ask(book);
+        if (processed_order.side == ORDER_SIDE_BUY && best_ask > 0 && price_ticks < best_ask) {
+            price_ticks++;
         }
+        processed_order.price = price_from_ticks(price_ticks, book->tick_exponent);
     }
 
-    // Update status and send message
-    processed_order.status = ORDER_STATUS_NEW;
-    processed_order.modification_time = time(NULL);
-    
-    Message response = {
-        .type = MSG_ORDER_STATUS,
-        .sequence_num = atomic_fetch_add(&context->sequence_num, 1),
-        .timestamp = time(NULL),
-        .data.order = processed_order
-    };
+    // An order the journal can no longer record could not be recovered
+    if (journal_failed(context->journal)) {
+        processed_order.status = ORDER_STATUS_REJECTED;
+        send_order_status(context, &processed_order);
+        return ERROR_JOURNAL_FAILED;
+    }
+
+    // Lock-free reads of the limits and the client's rows; fills racing
+    // with it are caught on the next order
+    int risk = risk_check_order(context, book, &processed_order, book_last_trade(book), NULL);
+    stage_start = latency_record_since(STAGE_RISK, stage_start);
+    if (risk != SUCCESS) {
+        processed_order.status = ORDER_STATUS_REJECTED;
+        send_order_status(context, &processed_order);
+        return risk;
+    }
+
+    processed_order.modification_time = clock_frame_time();
+
+    TradeBatch trades;
+    start_batch(&trades, context);
+    pthread_rwlock_wrlock(&book->lock);
+    if (processed_order.modification_time >= atomic_load_explicit(&book->phase_due, memory_order_relaxed)) {
+        sync_phase(context, book, processed_order.modification_time, &trades);
+    }
+    journal_book_event(context, book, JOURNAL_ORDER_NEW, &processed_order);
+    int result = orderbook_add_order(book, &processed_order, collect_fill, &trades);
+    if (result != ERROR_INVALID_ORDER) {
+        book->order_count++;
+        // IOC, FOK and market orders are done once matched; nothing to look up
+        const OrderBookEntry* rested = order_can_rest(&processed_order) ?
+                                       orderbook_find_order(book, processed_order.order_id) : NULL;
+        if (rested) {
+            position_add_open(context, book, &rested->order, rested->order.remaining_quantity);
+        }
+        orderbook_release_stops(book, collect_fill, collect_release, &trades);
+    }
+    mark_after_trades(context, book, &trades);
+    orderbook_publish_stats(book);
+    pthread_rwlock_unlock(&book->lock);
+    latency_record_since(STAGE_MATCH, stage_start);
+
+    if (result == ERROR_INVALID_ORDER) {
+        LOG_ERROR("Order %lu rejected by %s book", processed_order.order_id, book->symbol);
+        processed_order.status = ORDER_STATUS_REJECTED;
+    }
+
+    send_order_status(context, &processed_order);
+    flush_trades(&trades);
+    return result;
+}
+
+int process_cancel_order(ServerContext* context, const Order* order) {
+    uint64_t stage_start = clock_ticks();
+
+    OrderBook* book = find_order_book(context, order->symbol);
+    if (!book) {
+        LOG_ERROR("Cancel for unknown symbol: %s", order->symbol);
+        return ERROR_SYMBOL_NOT_FOUND;
+    }
+
+    Order cancelled;
+    int result = ERROR_ORDER_NOT_FOUND;
+    pthread_rwlock_wrlock(&book->lock);
+    const OrderBookEntry* entry = orderbook_find_order(book, order->order_id);
+    if (entry && strncmp(entry->order.client_id, order->client_id, MAX_CLIENT_ID_LENGTH) == 0) {
+        journal_book_event(context, book, JOURNAL_ORDER_CANCEL, order);
+        result = orderbook_cancel_order(book, order->order_id, &cancelled);
+        if (result == SUCCESS) {
+            position_add_open(context, book, &cancelled, -(int64_t)cancelled.remaining_quantity);
+            orderbook_publish_stats(book);
+        }
+    }
+    pthread_rwlock_unlock(&book->lock);
+    latency_record_since(STAGE_MATCH, stage_start);
+
+    if (result != SUCCESS) {
+        LOG_WARN("Cancel of unknown order %lu from %s", order->order_id, order->client_id);
+        return result;
+    }
+
+    cancelled.modification_time = clock_frame_time();
+    send_order_status(context, &cancelled);
+    return SUCCESS;
+}
+
+// Journaled as a cancel, so a replay takes the order out at the same point
+static void collect_expiry(OrderBook* book, const Order* order, void* arg) {
+    TradeBatch* batch = arg;
+    journal_book_event(batch->context, book, JOURNAL_ORDER_CANCEL, order);
+    position_add_open(batch->context, book, order, -(int64_t)order->remaining_quantity);
+    queue_status(batch, order);
+}
+
+uint32_t expire_orders(ServerContext* context, OrderBook* book, uint64_t now) {
+    TradeBatch expired;
+    start_batch(&expired, context);
+    pthread_rwlock_wrlock(&book->lock);
+    uint32_t count = orderbook_expire(book, now, collect_expiry, &expired);
+    if (count > 0) {
+        orderbook_publish_stats(book);
+    }
+    pthread_rwlock_unlock(&book->lock);
+
+    if (count > 0) {
+        atomic_fetch_add_explicit(&context->stats.orders_expired, count, memory_order_relaxed);
+        LOG_INFO("Expired %u orders in %s", count, book->symbol);
+    }
+    flush_trades(&expired);
+    return count;
+}
+
+void advance_auction(ServerContext* context, OrderBook* book, uint64_t now) {
+    TradeBatch trades;
+    start_batch(&trades, context);
+    pthread_rwlock_wrlock(&book->lock);
+    sync_phase(context, book, now, &trades);
+    mark_after_trades(context, book, &trades);
+    orderbook_publish_stats(book);
+    pthread_rwlock_unlock(&book->lock);
+    flush_trades(&trades);
+}
+
+int publish_indicative(ServerContext* context, OrderBook* book) {
+    AuctionQuote quote = { 0 };
+    int changed = 0;
+    pthread_rwlock_rdlock(&book->lock);
+    int in_call = book->phase == BOOK_PHASE_CALL;
+    if (in_call ? !book->quoting || book->revision != book->quoted_revision : book->quoting) {
+        if (in_call) {
+            orderbook_auction_quote(book, &quote);
+        }
+        book->quoting = (uint32_t)in_call;
+        book->quoted_revision = book->revision;
+        changed = 1;
+    }
+    pthread_rwlock_unlock(&book->lock);
+    if (!changed) return 0;
+
+    // The rest of the quote is the symbol's latest market data
+    MarketData data;
+    get_symbol_market_data(context, book, &data);
+    memcpy(data.symbol, book->symbol, MAX_SYMBOL_LENGTH);
+    data.indicative_price = price_from_ticks(quote.price, book->tick_exponent);
+    data.indicative_volume = quote.volume;
+    data.timestamp = clock_frame_time();
+    broadcast_market_data(context, &data);
+    return 1;
+}
+
+int process_modify_order(ServerContext* context, const Order* order) {
+    uint64_t stage_start = clock_ticks();
+
+    OrderBook* book = find_order_book(context, order->symbol);
+    if (!book) {
+        LOG_ERROR("Modify for unknown symbol: %s", order->symbol);
+        return ERROR_SYMBOL_NOT_FOUND;
+    }
+
+    int64_t price_ticks;
+    if (price_to_ticks(order->price, book->tick_exponent, &price_ticks) < 0) {
+        LOG_ERROR("Price not on tick grid (1e%d) for %s", book->tick_exponent, book->symbol);
+        return ERROR_INVALID_ORDER;
+    }
+
+    // Risk sees the order as it rests now, outside the write lock; fills
+    // racing with the modify only shrink what it gives back
+    Order resting;
+    int found = 0;
+    pthread_rwlock_rdlock(&book->lock);
+    const OrderBookEntry* current = orderbook_find_order(book, order->order_id);
+    if (current && strncmp(current->order.client_id, order->client_id, MAX_CLIENT_ID_LENGTH) == 0) {
+        resting = current->order;
+        found = 1;
+    }
+    pthread_rwlock_unlock(&book->lock);
+
+    Order modified = *order;
+    modified.modification_time = clock_frame_time();
 
-    return send_response_message(find_client_socket(context, processed_order.client_id),
-                              &response);
+    if (found && journal_failed(context->journal)) {
+        modified.status = ORDER_STATUS_REJECTED;
+        send_order_status(context, &modified);
+        return ERROR_JOURNAL_FAILED;
+    }
+    if (found) {
+        Order terms = resting;
+        terms.quantity = order->quantity;
+        if (terms.type == ORDER_TYPE_LIMIT || terms.type == ORDER_TYPE_STOP_LIMIT) {
+            terms.price = order->price;
+        }
+        int risk = risk_check_modify(context, book, &terms, &resting, book_last_trade(book), NULL);
+        stage_start = latency_record_since(STAGE_RISK, stage_start);
+        if (risk != SUCCESS) {
+            modified.status = ORDER_STATUS_REJECTED;
+            send_order_status(context, &modified);
+            return risk;
+        }
+    }
+
+    TradeBatch trades;
+    start_batch(&trades, context);
+    int result = ERROR_ORDER_NOT_FOUND;
+    pthread_rwlock_wrlock(&book->lock);
+    if (modified.modification_time >= atomic_load_explicit(&book->phase_due, memory_order_relaxed)) {
+        sync_phase(context, book, modified.modification_time, &trades);
+    }
+    const OrderBookEntry* entry = orderbook_find_order(book, order->order_id);
+    if (entry && strncmp(entry->order.client_id, order->client_id, MAX_CLIENT_ID_LENGTH) == 0) {
+        journal_book_event(context, book, JOURNAL_ORDER_MODIFY, &modified);
+        Order before = entry->order;
+        result = orderbook_modify_order(book, &modified, collect_fill, &trades);
+
+        // Swap the old resting quantity for whatever rests now
+        position_add_open(context, book, &before, -(int64_t)before.remaining_quantity);
+        const OrderBookEntry* rested = orderbook_find_order(book, order->order_id);
+        if (rested) {
+            position_add_open(context, book, &rested->order, rested->order.remaining_quantity);
+        }
+        orderbook_release_stops(book, collect_fill, collect_release, &trades);
+    }
+    mark_after_trades(context, book, &trades);
+    orderbook_publish_stats(book);
+    pthread_rwlock_unlock(&book->lock);
+    latency_record_since(STAGE_MATCH, stage_start);
+
+    if (result == ERROR_ORDER_NOT_FOUND) {
+        LOG_WARN("Modify of unknown order %lu from %s", order->order_id, order->client_id);
+        flush_trades(&trades);   // An uncross this modify ran may still have traded
+        return result;
+    }
+
+    send_order_status(context, &modified);
+    flush_trades(&trades);
+    return result;
+}
+
+int process_order_status(ServerContext* context, const Order* order) {
+    OrderBook* book = find_order_book(context, order->symbol);
+    if (!book) return ERROR_SYMBOL_NOT_FOUND;
+
+    Order current;
+    int result = ERROR_ORDER_NOT_FOUND;
+    pthread_rwlock_rdlock(&book->lock);
+    const OrderBookEntry* entry = orderbook_find_order(book, order->order_id);
+    if (entry && strncmp(entry->order.client_id, order->client_id, MAX_CLIENT_ID_LENGTH) == 0) {
+        current = entry->order;
+        result = SUCCESS;
+    }
+    pthread_rwlock_unlock(&book->lock);
+
+    return result == SUCCESS ? send_order_status(context, &current) : result;
 }
 
 int handle_market_data(ServerContext* context,
-                      int client_socket __attribute__((unused)),
+                      ClientConnection* client __attribute__((unused)),
                       const Message* msg) {
     const MarketData* mkt_data = &msg->data.market_data;
     LOG_INFO("Received market data:");
@@ -124,16 +614,20 @@ int handle_market_data(ServerContext* context,
 }
 
 int broadcast_market_data(ServerContext* context, const MarketData* market_data) {
+    if (update_symbol_market_data(context, market_data) == ERROR_SYMBOL_NOT_FOUND) {
+        LOG_WARN("Market data for unknown symbol: %s", market_data->symbol);
+        return ERROR_SYMBOL_NOT_FOUND;
+    }
+
     Message msg = {
         .type = MSG_MARKET_DATA,
-        .sequence_num = atomic_fetch_add(&context->sequence_num, 1),
-        .timestamp = time(NULL),
+        .timestamp = clock_frame_time(),
         .data.market_data = *market_data
     };
     
-    for (int i = 0; i < MAX_CLIENTS; i++) {
-        if (context->clients[i].socket > 0) {
-            send_response_message(context->clients[i].socket, &msg);
+    for (int i = 0; i < context->config.max_clients; i++) {
+        if (context->clients[i].active) {
+            send_to_client(&context->clients[i], &msg);
         }
     }
     
@@ -141,44 +635,63 @@ int broadcast_market_data(ServerContext* context, const MarketData* market_data)
 }
 
 int handle_trade_exec(ServerContext* context,
-                     int client_socket __attribute__((unused)),
+                     ClientConnection* client __attribute__((unused)),
                      const Message* msg) {
-    const TradeExecution* trade = &msg->data.trade;
-    LOG_INFO("Processing trade execution:");
-    LOG_INFO("  Trade ID: %lu", trade->trade_id);
-    LOG_INFO("  Order ID: %lu", trade->order_id);
-    LOG_INFO("  Symbol: %s", trade->symbol);
-    LOG_INFO("  Price: %.6f", price_to_double(trade->price));
-    LOG_INFO("  Quantity: %u", trade->quantity);
-    LOG_INFO("  Buyer: %s", trade->buyer_id);
-    LOG_INFO("  Seller: %s", trade->seller_id);
-    
-    return process_trade_execution(context, trade);
+    // Trades come out of matching only; one sent in is never journaled,
+    // priced into the market data or passed on
+    LOG_WARN("Refused trade execution %lu for %s from a client", msg->data.trade.trade_id,
+             msg->data.trade.symbol);
+    atomic_fetch_add(&context->stats.errors_encountered, 1);
+    return ERROR_INVALID_MESSAGE;
 }
 
-int process_trade_execution(ServerContext* context, const TradeExecution* trade) {
+// Tell both sides of an engine trade, journaled when it was matched
+static void publish_trade(ServerContext* context, const TradeExecution* trade) {
     Message msg = {
         .type = MSG_TRADE_EXEC,
-        .sequence_num = atomic_fetch_add(&context->sequence_num, 1),
-        .timestamp = time(NULL),
+        .timestamp = clock_frame_time(),
         .data.trade = *trade
     };
     
-    int buyer_socket = find_client_socket(context, trade->buyer_id);
-    int seller_socket = find_client_socket(context, trade->seller_id);
+    ClientConnection* buyer = find_client(context, trade->buyer_id);
+    ClientConnection* seller = find_client(context, trade->seller_id);
     
-    if (buyer_socket > 0) {
-        send_response_message(buyer_socket, &msg);
+    if (buyer) {
+        send_to_client(buyer, &msg);
     }
-    if (seller_socket > 0) {
-        send_response_message(seller_socket, &msg);
+    if (seller && seller != buyer) {
+        send_to_client(seller, &msg);
     }
-    
-    return SUCCESS;
+}
+
+int process_pnl_query(ServerContext* context, ClientConnection* client, const PnlReport* query) {
+    // A session sees only its own client's PnL
+    if (strncmp(query->client_id, client->id, MAX_CLIENT_ID_LENGTH) != 0) {
+        return send_error(client, ERROR_INVALID_MESSAGE, "PnL query for another client");
+    }
+
+    const OrderBook* book = NULL;
+    if (query->symbol[0] != '\0') {
+        book = find_order_book(context, query->symbol);
+        if (!book) return send_error(client, ERROR_INVALID_MESSAGE, "PnL query for unknown symbol");
+    }
+
+    Message response = {
+        .type = MSG_PNL,
+        .timestamp = clock_frame_time()
+    };
+    if (position_report(context, client->id, book, &response.data.pnl) != SUCCESS) {
+        // No fills and nothing resting yet: all zero
+        memset(&response.data.pnl, 0, sizeof(response.data.pnl));
+        memcpy(response.data.pnl.client_id, client->id, MAX_CLIENT_ID_LENGTH);
+        memcpy(response.data.pnl.symbol, query->symbol, MAX_SYMBOL_LENGTH);
+        response.data.pnl.timestamp = response.timestamp;
+    }
+    return send_to_client(client, &response);
 }
 
 int handle_error(ServerContext* context __attribute__((unused)),
-                int client_socket __attribute__((unused)),
+                ClientConnection* client __attribute__((unused)),
                 const Message* msg) {
     LOG_ERROR("Received error message: [%d] %s",
               msg->data.error.code,
@@ -188,49 +701,87 @@ int handle_error(ServerContext* context __attribute__((unused)),
 
 int send_response_message(int client_socket, const Message* response) {
     uint8_t buffer[BUFFER_SIZE];
+    uint64_t stage_start = clock_ticks();
     ssize_t serialized_size = serialize_message(response, buffer, BUFFER_SIZE);
     
     if (serialized_size < 0) {
         LOG_ERROR("Failed to serialize response message");
         return ERROR_SERIALIZATION;
     }
+    stage_start = latency_record_since(STAGE_ENCODE, stage_start);
     
-    if (send(client_socket, buffer, serialized_size, 0) != serialized_size) {
+    if (send(client_socket, buffer, serialized_size, MSG_NOSIGNAL) != serialized_size) {
         LOG_ERROR("Failed to send response message");
         return ERROR_SOCKET_CONNECT;
     }
+    latency_record_since(STAGE_SEND, stage_start);
+    metrics_thread_add(THREAD_MESSAGES_SENT, 1);
+    metrics_thread_add(THREAD_BYTES_SENT, (uint64_t)serialized_size);
     
     return SUCCESS;
 }
 
-static int find_client_socket(ServerContext* context, const char* client_id) {
-    for (int i = 0; i < MAX_CLIENTS; i++) {
-        if (context->clients[i].socket > 0 &&
-            strcmp(context->clients[i].id, client_id) == 0) {
-            return context->clients[i].socket;
+static ClientConnection* find_client(ServerContext* context, const char* client_id) {
+    for (int i = 0; i < context->config.max_clients; i++) {
+        if (context->clients[i].active &&
+            strncmp(context->clients[i].id, client_id, MAX_CLIENT_ID_LENGTH) == 0) {
+            return &context->clients[i];
         }
     }
-    return -1;
+    return NULL;
 }
 
-static uint32_t get_client_position(ServerContext* context __attribute__((unused)),
-                                  const char* client_id __attribute__((unused)),
-                                  const char* symbol __attribute__((unused))) {
-    // Placeholder implementation
-    return 0;
+// Stamp the session's next sequence number and send under the connection
+// lock, so numbers reach the client in order and a gap means a lost message
+static int send_to_client(ClientConnection* client, const Message* msg) {
+    Message stamped = *msg;
+    pthread_mutex_lock(&client->lock);
+    stamped.sequence_num = client->outbound_sequence + 1;
+    int result = send_response_message(client->socket, &stamped);
+    if (result == SUCCESS) {
+        client->outbound_sequence++;
+    }
+    pthread_mutex_unlock(&client->lock);
+
+    if (result == SUCCESS) {
+        atomic_fetch_add_explicit(&client->messages_sent, 1, memory_order_relaxed);
+    }
+    return result;
+}
+
+int send_error(ClientConnection* client, ErrorCode code, const char* text) {
+    Message msg = {
+        .type = MSG_ERROR,
+        .timestamp = clock_frame_time(),
+        .data.error.code = code
+    };
+    strncpy(msg.data.error.message, text, MAX_ERROR_MSG_LENGTH - 1);
+    return send_to_client(client, &msg);
 }
 
-static MarketData* get_market_data(ServerContext* context __attribute__((unused)),
-                                 const char* symbol __attribute__((unused))) {
-    // Placeholder implementation
-    static MarketData dummy_data;
-    return &dummy_data;
+// A run of ids one thread reserved from one of the context's id spaces
+typedef struct {
+    uint64_t next;
+    uint64_t end;
+    uint64_t epoch;               // ServerContext.id_epoch the block belongs to
+} IdBlock;
+
+static __thread IdBlock order_ids;
+static __thread IdBlock trade_ids;
+
+static uint64_t next_id(ServerContext* context, atomic_uint_least64_t* space, IdBlock* block) {
+    if (block->next == block->end || block->epoch != context->id_epoch) {
+        block->next = atomic_fetch_add_explicit(space, ID_BLOCK_SIZE, memory_order_relaxed);
+        block->end = block->next + ID_BLOCK_SIZE;
+        block->epoch = context->id_epoch;
+    }
+    return block->next++;
 }
 
 uint64_t generate_order_id(ServerContext* context) {
-    return atomic_fetch_add(&context->sequence_num, 1);
+    return next_id(context, &context->next_order_id, &order_ids);
 }
 
 uint64_t generate_trade_id(ServerContext* context) {
-    return atomic_fetch_add(&context->sequence_num, 1);
+    return next_id(context, &context->next_trade_id, &trade_ids);
 }
@@ -0,0 +1,422 @@
+#include "server/server.h"
+#include "server/server_journal.h"
+#include <fcntl.h>
+#include <stddef.h>
+#include <sys/stat.h>
+#include <sched.h>
+#include <time.h>
+
+#define JOURNAL_WRITE_BATCH 256
+#define JOURNAL_REPLAY_BATCH 4096
+#define JOURNAL_IDLE_SLEEP_US 50
+
+// Bounded MPSC ring: a slot's turn equals its position when free and
+// position + 1 once the record in it is published.
+typedef struct {
+    atomic_uint_least64_t turn;
+    JournalRecord record;
+} JournalSlot;
+
+struct Journal {
+    int fd;
+    char path[256];
+    JournalSlot* slots;
+    uint64_t mask;
+    uint64_t base_sequence;             // Last sequence already on disk at open
+    uint32_t sync_interval_us;
+    uint32_t sync_events;
+    ServerStats* stats;
+    pthread_t thread;
+    atomic_int running;
+    atomic_int failed;                  // A write or sync failed; set once, never cleared
+
+    // Producers and the consumer touch different cache lines
+    _Alignas(64) atomic_uint_least64_t tail;
+    _Alignas(64) uint64_t head;
+};
+
+// Word-at-a-time FNV-1a variant; records are a multiple of 8 bytes
+static uint32_t record_checksum(const JournalRecord* record) {
+    _Static_assert(sizeof(JournalRecord) % sizeof(uint64_t) == 0, "Record size must be word aligned");
+    const uint64_t* words = (const uint64_t*)record;
+    uint64_t hash = 0xcbf29ce484222325ULL;
+
+    for (size_t i = 0; i < sizeof(JournalRecord) / sizeof(uint64_t); i++) {
+        // The checksum shares a word with the type, so hash the type alone there
+        uint64_t word = (i == offsetof(JournalRecord, type) / sizeof(uint64_t)) ? record->type : words[i];
+        hash = (hash ^ word) * 0x100000001b3ULL;
+    }
+    return (uint32_t)(hash ^ (hash >> 32));
+}
+
+static int write_all(int fd, const void* data, size_t size) {
+    const uint8_t* bytes = data;
+    while (size > 0) {
+        ssize_t written = write(fd, bytes, size);
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        bytes += written;
+        size -= (size_t)written;
+    }
+    return 0;
+}
+
+/**
+ * Validate an existing journal and find its last good record. A short,
+ * corrupt or out-of-sequence tail is cut off.
+ */
+static int recover_journal_file(Journal* journal) {
+    JournalFileHeader header;
+    ssize_t header_size = pread(journal->fd, &header, sizeof(header), 0);
+
+    if (header_size == 0) {
+        memset(&header, 0, sizeof(header));
+        memcpy(header.magic, JOURNAL_MAGIC, sizeof(header.magic));
+        header.version = JOURNAL_VERSION;
+        header.record_size = sizeof(JournalRecord);
+        header.created_ns = clock_now_ns();
+        if (write_all(journal->fd, &header, sizeof(header)) < 0 || fdatasync(journal->fd) < 0) {
+            LOG_ERROR("Failed to write journal header to %s: %s", journal->path, strerror(errno));
+            return ERROR_INVALID_STATE;
+        }
+        journal->base_sequence = 0;
+        return SUCCESS;
+    }
+
+    if (header_size != (ssize_t)sizeof(header) ||
+        memcmp(header.magic, JOURNAL_MAGIC, sizeof(header.magic)) != 0 ||
+        header.version != JOURNAL_VERSION ||
+        header.record_size != sizeof(JournalRecord)) {
+        LOG_ERROR("%s is not a compatible journal file", journal->path);
+        return ERROR_INVALID_STATE;
+    }
+
+    // Writes are sequential, so a crash can only leave a torn tail: walk back
+    // from the end to the last record that is intact and in sequence
+    off_t file_size = lseek(journal->fd, 0, SEEK_END);
+    uint64_t last_sequence = ((uint64_t)file_size - sizeof(header)) / sizeof(JournalRecord);
+    JournalRecord record;
+    while (last_sequence > 0) {
+        off_t position = (off_t)(sizeof(header) + (last_sequence - 1) * sizeof(JournalRecord));
+        if (pread(journal->fd, &record, sizeof(record), position) == (ssize_t)sizeof(record) &&
+            record.sequence == last_sequence &&
+            record_checksum(&record) == record.checksum) {
+            break;
+        }
+        last_sequence--;
+    }
+    off_t offset = (off_t)(sizeof(header) + last_sequence * sizeof(JournalRecord));
+
+    if (file_size > offset) {
+        LOG_WARN("Truncating %ld bytes of torn journal tail in %s",
+                 (long)(file_size - offset), journal->path);
+        if (ftruncate(journal->fd, offset) < 0) {
+            LOG_ERROR("Failed to truncate journal %s: %s", journal->path, strerror(errno));
+            return ERROR_INVALID_STATE;
+        }
+    }
+    lseek(journal->fd, offset, SEEK_SET);
+
+    journal->base_sequence = last_sequence;
+    LOG_INFO("Journal %s holds %lu events", journal->path, last_sequence);
+    return SUCCESS;
+}
+
+// Move published records into batch, returns how many were taken
+static size_t drain_queue(Journal* journal, JournalRecord* batch, size_t max_records) {
+    size_t count = 0;
+
+    while (count < max_records) {
+        JournalSlot* slot = &journal->slots[journal->head & journal->mask];
+        if (atomic_load_explicit(&slot->turn, memory_order_acquire) != journal->head + 1) {
+            break;
+        }
+        batch[count++] = slot->record;
+        atomic_store_explicit(&slot->turn, journal->head + journal->mask + 1, memory_order_release);
+        journal->head++;
+    }
+    return count;
+}
+
+// Nothing is written after a failure: a record past a gap or an unsynced
+// tail would replay events whose predecessors were lost
+static void fail_journal(Journal* journal, const char* what) {
+    LOG_ERROR("%s failed on journal %s: %s; refusing new orders", what, journal->path, strerror(errno));
+    atomic_store_explicit(&journal->failed, 1, memory_order_release);
+}
+
+static void sync_journal(Journal* journal) {
+    uint64_t start = clock_ticks();
+    if (fdatasync(journal->fd) < 0) {
+        fail_journal(journal, "fdatasync");
+        return;
+    }
+    uint64_t elapsed = clock_ticks_to_ns(clock_ticks() - start);
+
+    if (journal->stats) {
+        ServerStats* stats = journal->stats;
+        atomic_fetch_add_explicit(&stats->journal_syncs, 1, memory_order_relaxed);
+        latency_histogram_record(&stats->journal_sync_latency, elapsed);
+        if (elapsed > atomic_load_explicit(&stats->journal_sync_max_ns, memory_order_relaxed)) {
+            atomic_store_explicit(&stats->journal_sync_max_ns, elapsed, memory_order_relaxed);
+        }
+    }
+}
+
+static void* journal_writer_main(void* arg) {
+    Journal* journal = arg;
+    metrics_thread_name("journal");
+    JournalRecord* batch = malloc(JOURNAL_WRITE_BATCH * sizeof(JournalRecord));
+    if (!batch) {
+        LOG_ERROR("Failed to allocate journal write batch");
+        return NULL;
+    }
+
+    uint64_t sync_interval_ns = (uint64_t)journal->sync_interval_us * NANOS_PER_MICRO;
+    uint64_t unsynced_events = 0;
+    uint64_t first_unsynced_ticks = 0;
+    struct timespec idle = { .tv_sec = 0, .tv_nsec = JOURNAL_IDLE_SLEEP_US * 1000 };
+
+    for (;;) {
+        int running = atomic_load_explicit(&journal->running, memory_order_acquire);
+        size_t count = drain_queue(journal, batch, JOURNAL_WRITE_BATCH);
+
+        // A failed journal still drains the ring so producers never stall
+        int failed = atomic_load_explicit(&journal->failed, memory_order_relaxed);
+        if (count > 0 && !failed) {
+            size_t bytes = count * sizeof(JournalRecord);
+            if (write_all(journal->fd, batch, bytes) < 0) {
+                fail_journal(journal, "write");
+            } else if (journal->stats) {
+                atomic_fetch_add_explicit(&journal->stats->journal_events, count, memory_order_relaxed);
+                atomic_fetch_add_explicit(&journal->stats->journal_bytes, bytes, memory_order_relaxed);
+            }
+            if (unsynced_events == 0) {
+                first_unsynced_ticks = clock_ticks();
+            }
+            unsynced_events += count;
+        }
+
+        // Group commit: one fdatasync covers everything written since the last
+        if (unsynced_events > 0) {
+            int due = (journal->sync_events > 0 && unsynced_events >= journal->sync_events) ||
+                      (sync_interval_ns > 0 &&
+                       clock_ticks_to_ns(clock_ticks() - first_unsynced_ticks) >= sync_interval_ns) ||
+                      (!running && count == 0);
+            if (due) {
+                if ((journal->sync_events > 0 || sync_interval_ns > 0) &&
+                    !atomic_load_explicit(&journal->failed, memory_order_relaxed)) {
+                    sync_journal(journal);
+                }
+                unsynced_events = 0;
+            }
+        }
+
+        if (count == 0) {
+            if (!running && unsynced_events == 0) break;
+            nanosleep(&idle, NULL);
+        }
+    }
+
+    free(batch);
+    return NULL;
+}
+
+Journal* journal_open(const char* path, uint32_t sync_interval_us, uint32_t sync_events,
+                      ServerStats* stats) {
+    if (!path || path[0] == '\0') return NULL;
+
+    Journal* journal = calloc(1, sizeof(Journal));
+    if (!journal) {
+        LOG_ERROR("Failed to allocate journal");
+        return NULL;
+    }
+
+    strncpy(journal->path, path, sizeof(journal->path) - 1);
+    journal->sync_interval_us = sync_interval_us;
+    journal->sync_events = sync_events;
+    journal->stats = stats;
+    journal->mask = JOURNAL_QUEUE_CAPACITY - 1;
+
+    journal->fd = open(path, O_RDWR | O_CREAT, 0644);
+    if (journal->fd < 0) {
+        LOG_ERROR("Failed to open journal %s: %s", path, strerror(errno));
+        free(journal);
+        return NULL;
+    }
+
+    if (recover_journal_file(journal) != SUCCESS) {
+        close(journal->fd);
+        free(journal);
+        return NULL;
+    }
+
+    journal->slots = calloc(JOURNAL_QUEUE_CAPACITY, sizeof(JournalSlot));
+    if (!journal->slots) {
+        LOG_ERROR("Failed to allocate journal queue");
+        close(journal->fd);
+        free(journal);
+        return NULL;
+    }
+    for (uint64_t i = 0; i < JOURNAL_QUEUE_CAPACITY; i++) {
+        atomic_init(&journal->slots[i].turn, i);
+    }
+    atomic_init(&journal->tail, 0);
+    atomic_init(&journal->failed, 0);
+    journal->head = 0;
+
+    if (stats) {
+        latency_histogram_reset(&stats->journal_sync_latency);
+    }
+
+    atomic_store(&journal->running, 1);
+    if (pthread_create(&journal->thread, NULL, journal_writer_main, journal) != 0) {
+        LOG_ERROR("Failed to start journal writer thread");
+        free(journal->slots);
+        close(journal->fd);
+        free(journal);
+        return NULL;
+    }
+
+    LOG_INFO("Journal %s opened (sync every %u us / %u events)", path, sync_interval_us, sync_events);
+    return journal;
+}
+
+void journal_close(Journal* journal) {
+    if (!journal) return;
+
+    // The writer drains the ring and syncs before it exits
+    atomic_store_explicit(&journal->running, 0, memory_order_release);
+    pthread_join(journal->thread, NULL);
+
+    if (journal->stats) {
+        ServerStats* stats = journal->stats;
+        LOG_INFO("Journal closed: %lu events, %lu bytes, %lu syncs, sync p99 %lu ns, max %lu ns",
+                 atomic_load(&stats->journal_events),
+                 atomic_load(&stats->journal_bytes),
+                 atomic_load(&stats->journal_syncs),
+                 latency_histogram_percentile(&stats->journal_sync_latency, 99.0),
+                 atomic_load(&stats->journal_sync_max_ns));
+    }
+
+    close(journal->fd);
+    free(journal->slots);
+    free(journal);
+}
+
+static uint64_t journal_append(Journal* journal, JournalEventType type, const void* data, size_t size) {
+    uint64_t position = atomic_fetch_add_explicit(&journal->tail, 1, memory_order_relaxed);
+    JournalSlot* slot = &journal->slots[position & journal->mask];
+
+    // Wait for the writer to free the slot if the ring has wrapped
+    if (atomic_load_explicit(&slot->turn, memory_order_acquire) != position) {
+        if (journal->stats) {
+            atomic_fetch_add_explicit(&journal->stats->journal_queue_full, 1, memory_order_relaxed);
+        }
+        while (atomic_load_explicit(&slot->turn, memory_order_acquire) != position) {
+            sched_yield();
+        }
+    }
+
+    JournalRecord* record = &slot->record;
+    memset(record, 0, sizeof(*record));
+    record->sequence = journal->base_sequence + position + 1;
+    record->timestamp = clock_frame_time();
+    record->type = type;
+    memcpy(&record->data, data, size);
+    record->checksum = record_checksum(record);
+
+    uint64_t sequence = record->sequence;
+    atomic_store_explicit(&slot->turn, position + 1, memory_order_release);
+    return sequence;
+}
+
+uint64_t journal_append_order(Journal* journal, JournalEventType type, const Order* order) {
+    if (!journal || !order) return 0;
+    return journal_append(journal, type, order, sizeof(*order));
+}
+
+uint64_t journal_append_trade(Journal* journal, const TradeExecution* trade) {
+    if (!journal || !trade) return 0;
+    return journal_append(journal, JOURNAL_TRADE, trade, sizeof(*trade));
+}
+
+int journal_failed(Journal* journal) {
+    return journal && atomic_load_explicit(&journal->failed, memory_order_acquire);
+}
+
+uint64_t journal_last_sequence(Journal* journal) {
+    if (!journal) return 0;
+    return journal->base_sequence + atomic_load_explicit(&journal->tail, memory_order_acquire);
+}
+
+int64_t journal_replay(const char* path, uint64_t after_sequence, JournalReplayFn fn, void* arg) {
+    if (!path || !fn) return ERROR_INVALID_PARAM;
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        if (errno == ENOENT) return 0;
+        LOG_ERROR("Failed to open journal %s: %s", path, strerror(errno));
+        return ERROR_INVALID_STATE;
+    }
+
+    JournalFileHeader header;
+    ssize_t header_size = pread(fd, &header, sizeof(header), 0);
+    if (header_size == 0) {
+        close(fd);
+        return 0;
+    }
+    if (header_size != (ssize_t)sizeof(header) ||
+        memcmp(header.magic, JOURNAL_MAGIC, sizeof(header.magic)) != 0 ||
+        header.version != JOURNAL_VERSION ||
+        header.record_size != sizeof(JournalRecord)) {
+        LOG_ERROR("%s is not a compatible journal file", path);
+        close(fd);
+        return ERROR_INVALID_STATE;
+    }
+
+    // Read the tail in large sequential chunks; only records after the
+    // snapshot are ever touched
+    JournalRecord* batch = malloc(JOURNAL_REPLAY_BATCH * sizeof(JournalRecord));
+    if (!batch) {
+        close(fd);
+        return ERROR_MEMORY_ALLOC;
+    }
+    posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+
+    uint64_t sequence = after_sequence;
+    int64_t replayed = 0;
+    int done = 0;
+
+    while (!done) {
+        off_t offset = (off_t)(sizeof(header) + sequence * sizeof(JournalRecord));
+        ssize_t bytes = pread(fd, batch, JOURNAL_REPLAY_BATCH * sizeof(JournalRecord), offset);
+        if (bytes < 0) {
+            LOG_ERROR("Failed to read journal %s: %s", path, strerror(errno));
+            break;
+        }
+        size_t count = (size_t)bytes / sizeof(JournalRecord);
+        if (count == 0) break;
+
+        for (size_t i = 0; i < count; i++) {
+            const JournalRecord* record = &batch[i];
+            if (record->sequence != sequence + 1 || record_checksum(record) != record->checksum) {
+                LOG_WARN("Journal %s ends at invalid record %lu", path, sequence + 1);
+                done = 1;
+                break;
+            }
+            if (fn(record, arg) != 0) {
+                done = 1;
+                break;
+            }
+            sequence++;
+            replayed++;
+        }
+    }
+
+    free(batch);
+    close(fd);
+    return replayed;
+}
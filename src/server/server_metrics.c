@@ -0,0 +1,506 @@
+#include "server/server.h"
+#include <fcntl.h>
+#include <poll.h>
+#include <time.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+
+// Longest the metrics thread sleeps, so metrics_stop is prompt
+#define METRICS_POLL_MAX_MS 100
+#define METRICS_HTTP_BACKLOG 16
+#define METRICS_HTTP_REQUEST_SIZE 2048
+#define METRICS_HTTP_TIMEOUT_MS 200
+
+struct Metrics {
+    ServerContext* context;
+    MetricsHeader* segment;         // Shared mapping, written only by the publisher
+    MetricsHeader* staging;         // Gathered here first to keep the seqlock window short
+    size_t segment_size;
+    char name[64];                  // Empty for an anonymous segment
+    uint32_t interval_ms;
+    int http_socket;
+    atomic_int running;
+    pthread_t thread;
+    pthread_mutex_t publish_mutex;  // Tests publish while the thread runs
+};
+
+// Per-thread counters. Only the owning thread writes its slot; the
+// publisher reads with relaxed loads under thread_mutex, which also keeps
+// the slot's thread alive while its CPU clock is read.
+typedef struct {
+    atomic_uint_least64_t counters[THREAD_COUNTER_COUNT];
+    char name[METRICS_THREAD_NAME_LENGTH];
+    pid_t tid;
+    clockid_t cpu_clock;
+    int in_use;
+} __attribute__((aligned(64))) ThreadSlot;
+
+static ThreadSlot thread_slots[METRICS_MAX_THREADS];
+static uint64_t retired_counters[THREAD_COUNTER_COUNT];
+static pthread_mutex_t thread_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_key_t thread_key;
+static pthread_once_t thread_key_once = PTHREAD_ONCE_INIT;
+static __thread ThreadSlot* thread_slot = NULL;
+static __thread int thread_slot_unavailable = 0;
+
+// Fold an exiting thread's counters into the retired totals and free its slot
+static void retire_thread_slot(void* arg) {
+    ThreadSlot* slot = arg;
+    if (!slot) return;
+
+    pthread_mutex_lock(&thread_mutex);
+    for (int i = 0; i < THREAD_COUNTER_COUNT; i++) {
+        retired_counters[i] += atomic_load_explicit(&slot->counters[i], memory_order_relaxed);
+    }
+    slot->in_use = 0;
+    pthread_mutex_unlock(&thread_mutex);
+}
+
+static void create_thread_key(void) {
+    pthread_key_create(&thread_key, retire_thread_slot);
+}
+
+static ThreadSlot* get_thread_slot(void) {
+    if (thread_slot) return thread_slot;
+    if (thread_slot_unavailable) return NULL;
+
+    pthread_once(&thread_key_once, create_thread_key);
+
+    pthread_mutex_lock(&thread_mutex);
+    ThreadSlot* slot = NULL;
+    for (int i = 0; i < METRICS_MAX_THREADS; i++) {
+        if (!thread_slots[i].in_use) {
+            slot = &thread_slots[i];
+            break;
+        }
+    }
+    if (slot) {
+        for (int i = 0; i < THREAD_COUNTER_COUNT; i++) {
+            atomic_store_explicit(&slot->counters[i], 0, memory_order_relaxed);
+        }
+        strncpy(slot->name, "thread", METRICS_THREAD_NAME_LENGTH);
+        slot->tid = (pid_t)syscall(SYS_gettid);
+        if (pthread_getcpuclockid(pthread_self(), &slot->cpu_clock) != 0) {
+            slot->cpu_clock = (clockid_t)-1;
+        }
+        slot->in_use = 1;
+    }
+    pthread_mutex_unlock(&thread_mutex);
+
+    if (!slot) {
+        // Counted in no row; the table only fills with far more threads than clients
+        thread_slot_unavailable = 1;
+        return NULL;
+    }
+    pthread_setspecific(thread_key, slot);
+    thread_slot = slot;
+    return slot;
+}
+
+void metrics_thread_name(const char* name) {
+    ThreadSlot* slot = get_thread_slot();
+    if (!slot || !name) return;
+
+    pthread_mutex_lock(&thread_mutex);
+    strncpy(slot->name, name, METRICS_THREAD_NAME_LENGTH - 1);
+    slot->name[METRICS_THREAD_NAME_LENGTH - 1] = '\0';
+    pthread_mutex_unlock(&thread_mutex);
+}
+
+void metrics_thread_add(ThreadCounter counter, uint64_t amount) {
+    ThreadSlot* slot = get_thread_slot();
+    if (!slot || counter >= THREAD_COUNTER_COUNT) return;
+
+    atomic_uint_least64_t* value = &slot->counters[counter];
+    atomic_store_explicit(value, atomic_load_explicit(value, memory_order_relaxed) + amount,
+                          memory_order_relaxed);
+}
+
+// Thread rows, plus totals over live and exited threads
+static void gather_threads(MetricsHeader* staging, uint64_t totals[THREAD_COUNTER_COUNT]) {
+    MetricsThread* rows = metrics_threads(staging);
+
+    pthread_mutex_lock(&thread_mutex);
+    memcpy(totals, retired_counters, sizeof(retired_counters));
+    for (uint32_t i = 0; i < staging->thread_capacity && i < METRICS_MAX_THREADS; i++) {
+        ThreadSlot* slot = &thread_slots[i];
+        MetricsThread* row = &rows[i];
+        row->active = (uint32_t)slot->in_use;
+        if (!slot->in_use) continue;
+
+        uint64_t counters[THREAD_COUNTER_COUNT];
+        for (int c = 0; c < THREAD_COUNTER_COUNT; c++) {
+            counters[c] = atomic_load_explicit(&slot->counters[c], memory_order_relaxed);
+            totals[c] += counters[c];
+        }
+
+        memcpy(row->name, slot->name, METRICS_THREAD_NAME_LENGTH);
+        row->tid = (uint32_t)slot->tid;
+        struct timespec cpu_time;
+        if (slot->cpu_clock != (clockid_t)-1 && clock_gettime(slot->cpu_clock, &cpu_time) == 0) {
+            row->cpu_ns = (uint64_t)cpu_time.tv_sec * NANOS_PER_SECOND + (uint64_t)cpu_time.tv_nsec;
+        }
+        row->messages_processed = counters[THREAD_MESSAGES_PROCESSED];
+        row->messages_sent = counters[THREAD_MESSAGES_SENT];
+        row->bytes_received = counters[THREAD_BYTES_RECEIVED];
+        row->bytes_sent = counters[THREAD_BYTES_SENT];
+        row->errors = counters[THREAD_ERRORS];
+    }
+    pthread_mutex_unlock(&thread_mutex);
+}
+
+static void gather_connections(ServerContext* context, MetricsHeader* staging) {
+    MetricsConnection* rows = metrics_connections(staging);
+
+    // Only accept and disconnect take this lock, never the message path
+    pthread_mutex_lock(&context->clients_mutex);
+    for (uint32_t i = 0; i < staging->connection_capacity; i++) {
+        const ClientConnection* client = &context->clients[i];
+        MetricsConnection* row = &rows[i];
+        row->active = client->active ? 1 : 0;
+        if (!row->active) continue;
+
+        memcpy(row->client_id, client->id, MAX_CLIENT_ID_LENGTH);
+        char host[INET_ADDRSTRLEN] = "";
+        inet_ntop(AF_INET, &client->address.sin_addr, host, sizeof(host));
+        snprintf(row->address, METRICS_ADDRESS_LENGTH, "%s:%u", host,
+                 (unsigned)ntohs(client->address.sin_port));
+        row->connect_time = client->connect_time;
+        row->last_heartbeat = client->last_heartbeat;
+        row->messages_received = atomic_load_explicit(&client->messages_received, memory_order_relaxed);
+        row->messages_sent = atomic_load_explicit(&client->messages_sent, memory_order_relaxed);
+        row->bytes_received = atomic_load_explicit(&client->bytes_received, memory_order_relaxed);
+    }
+    pthread_mutex_unlock(&context->clients_mutex);
+}
+
+static int64_t book_ticks(Price price, int32_t tick_exponent) {
+    int64_t ticks;
+    return price_to_ticks(price, tick_exponent, &ticks) < 0 ? 0 : ticks;
+}
+
+static void gather_symbols(ServerContext* context, MetricsHeader* staging) {
+    MetricsSymbol* rows = metrics_symbols(staging);
+
+    pthread_rwlock_rdlock(&context->order_book_lock);
+    uint32_t count = context->symbol_count;
+    pthread_rwlock_unlock(&context->order_book_lock);
+    if (count > staging->symbol_capacity) count = staging->symbol_capacity;
+
+    // Each book's own stats slot, so matching never waits on a publish; a
+    // row a publish kept racing keeps the last interval's values
+    for (uint32_t i = 0; i < count; i++) {
+        const OrderBook* book = &context->order_books[i];
+        MetricsSymbol* row = &rows[i];
+        BookStats stats;
+        memcpy(row->symbol, book->symbol, MAX_SYMBOL_LENGTH);
+        if (orderbook_read_stats(book, &stats) != SUCCESS) continue;
+
+        row->price_exponent = stats.tick_exponent;
+        row->bid_orders = stats.bid_orders;
+        row->ask_orders = stats.ask_orders;
+        row->best_bid = stats.best_bid;
+        row->best_ask = stats.best_ask;
+        row->best_bid_size = stats.best_bid_size;
+        row->best_ask_size = stats.best_ask_size;
+        row->orders = stats.orders;
+        row->trades = stats.trades;
+        row->volume = stats.volume;
+    }
+
+    pthread_rwlock_rdlock(&context->market_data_lock);
+    for (uint32_t i = 0; i < count; i++) {
+        rows[i].last_price = book_ticks(context->market_data_cache[i].last_price, rows[i].price_exponent);
+    }
+    pthread_rwlock_unlock(&context->market_data_lock);
+    staging->symbol_count = count;
+}
+
+void metrics_publish(ServerContext* context) {
+    if (!context || !context->metrics) return;
+    Metrics* metrics = context->metrics;
+    MetricsHeader* staging = metrics->staging;
+
+    pthread_mutex_lock(&metrics->publish_mutex);
+
+    uint64_t thread_totals[THREAD_COUNTER_COUNT];
+    gather_threads(staging, thread_totals);
+    gather_connections(context, staging);
+    gather_symbols(context, staging);
+
+    ServerStats* stats = &context->stats;
+    atomic_store_explicit(&stats->bytes_sent, thread_totals[THREAD_BYTES_SENT], memory_order_relaxed);
+
+    MetricsTotals* totals = &staging->totals;
+    totals->total_connections = atomic_load_explicit(&stats->total_connections, memory_order_relaxed);
+    totals->active_connections = atomic_load_explicit(&stats->active_connections, memory_order_relaxed);
+    totals->messages_processed = atomic_load_explicit(&stats->messages_processed, memory_order_relaxed);
+    totals->messages_sent = thread_totals[THREAD_MESSAGES_SENT];
+    totals->errors_encountered = atomic_load_explicit(&stats->errors_encountered, memory_order_relaxed);
+    totals->bytes_received = atomic_load_explicit(&stats->bytes_received, memory_order_relaxed);
+    totals->bytes_sent = thread_totals[THREAD_BYTES_SENT];
+    totals->journal_events = atomic_load_explicit(&stats->journal_events, memory_order_relaxed);
+    totals->journal_bytes = atomic_load_explicit(&stats->journal_bytes, memory_order_relaxed);
+    totals->journal_syncs = atomic_load_explicit(&stats->journal_syncs, memory_order_relaxed);
+    totals->journal_queue_full = atomic_load_explicit(&stats->journal_queue_full, memory_order_relaxed);
+    totals->ticks_captured = atomic_load_explicit(&stats->ticks_captured, memory_order_relaxed);
+    totals->ticks_dropped = atomic_load_explicit(&stats->ticks_dropped, memory_order_relaxed);
+    totals->risk_rejects = 0;
+    for (int check = 0; check < RISK_CHECK_COUNT; check++) {
+        totals->risk_rejects += atomic_load_explicit(&stats->risk_rejects[check], memory_order_relaxed);
+    }
+    totals->throttled = 0;
+    for (int kind = 0; kind < THROTTLE_COUNT; kind++) {
+        totals->throttled += atomic_load_explicit(&stats->throttled[kind], memory_order_relaxed);
+    }
+    totals->orders_expired = atomic_load_explicit(&stats->orders_expired, memory_order_relaxed);
+    totals->sessions_timed_out = atomic_load_explicit(&stats->sessions_timed_out, memory_order_relaxed);
+
+    for (int stage = 0; stage < STAGE_COUNT; stage++) {
+        latency_snapshot((LatencyStage)stage, &staging->histograms[stage]);
+    }
+    // Written by the journal thread alone; a copy may straddle one sync
+    if (context->journal) {
+        staging->histograms[METRICS_HISTOGRAM_JOURNAL_SYNC] = stats->journal_sync_latency;
+    }
+    staging->publish_time = clock_now_ns();
+
+    // Everything after the seqlock word; the fields before it never change
+    size_t offset = offsetof(MetricsHeader, publish_time);
+    metrics_publish_begin(metrics->segment);
+    memcpy((char*)metrics->segment + offset, (const char*)staging + offset,
+           metrics->segment_size - offset);
+    metrics_publish_end(metrics->segment);
+
+    pthread_mutex_unlock(&metrics->publish_mutex);
+}
+
+const MetricsHeader* metrics_segment(const ServerContext* context) {
+    return context && context->metrics ? context->metrics->segment : NULL;
+}
+
+static int send_all(int socket, const char* data, size_t size) {
+    while (size > 0) {
+        ssize_t sent = send(socket, data, size, MSG_NOSIGNAL);
+        if (sent <= 0) return ERROR_SOCKET_CONNECT;
+        data += sent;
+        size -= (size_t)sent;
+    }
+    return SUCCESS;
+}
+
+static void send_http_response(int socket, const char* status, const char* body, size_t length) {
+    char header[256];
+    int header_length = snprintf(header, sizeof(header),
+                                 "HTTP/1.1 %s\r\n"
+                                 "Content-Type: text/plain; version=0.0.4; charset=utf-8\r\n"
+                                 "Content-Length: %zu\r\n"
+                                 "Connection: close\r\n\r\n", status, length);
+    if (send_all(socket, header, (size_t)header_length) == SUCCESS) {
+        send_all(socket, body, length);
+    }
+}
+
+// Serve one scrape from the segment; runs on the metrics thread, which is
+// the segment's only writer, so no copy is needed
+static void serve_http(Metrics* metrics) {
+    int client_socket = accept(metrics->http_socket, NULL, NULL);
+    if (client_socket < 0) return;
+
+    struct timeval timeout = { .tv_sec = 0, .tv_usec = METRICS_HTTP_TIMEOUT_MS * 1000 };
+    setsockopt(client_socket, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    setsockopt(client_socket, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+
+    // Only the request line matters; stop at the end of the headers
+    char request[METRICS_HTTP_REQUEST_SIZE];
+    size_t received = 0;
+    while (received < sizeof(request) - 1) {
+        ssize_t bytes = recv(client_socket, request + received, sizeof(request) - 1 - received, 0);
+        if (bytes <= 0) break;
+        received += (size_t)bytes;
+        request[received] = '\0';
+        if (strstr(request, "\r\n\r\n") || strstr(request, "\n\n")) break;
+    }
+    request[received] = '\0';
+
+    if (strncmp(request, "GET ", 4) != 0) {
+        static const char body[] = "Method not allowed\n";
+        send_http_response(client_socket, "405 Method Not Allowed", body, sizeof(body) - 1);
+    } else if (strncmp(request + 4, "/metrics ", 9) != 0 && strncmp(request + 4, "/ ", 2) != 0) {
+        static const char body[] = "Not found, try /metrics\n";
+        send_http_response(client_socket, "404 Not Found", body, sizeof(body) - 1);
+    } else {
+        char* body = NULL;
+        size_t length = 0;
+        FILE* stream = open_memstream(&body, &length);
+        if (stream) {
+            int result = metrics_write_prometheus(metrics->segment, stream);
+            fclose(stream);
+            if (result == SUCCESS) {
+                send_http_response(client_socket, "200 OK", body, length);
+            }
+            free(body);
+        }
+    }
+    close(client_socket);
+}
+
+static void* metrics_main(void* arg) {
+    ServerContext* context = arg;
+    Metrics* metrics = context->metrics;
+    metrics_thread_name("metrics");
+
+    uint64_t interval_ns = (uint64_t)metrics->interval_ms * NANOS_PER_MILLI;
+    uint64_t next_publish = clock_monotonic_raw_ns();
+
+    while (atomic_load_explicit(&metrics->running, memory_order_acquire)) {
+        uint64_t now = clock_monotonic_raw_ns();
+        if (now >= next_publish) {
+            metrics_publish(context);
+            next_publish = now + interval_ns;
+            now = clock_monotonic_raw_ns();
+        }
+
+        uint64_t wait_ms = next_publish > now ? (next_publish - now) / NANOS_PER_MILLI + 1 : 0;
+        if (wait_ms > METRICS_POLL_MAX_MS) wait_ms = METRICS_POLL_MAX_MS;
+
+        struct pollfd listener = { .fd = metrics->http_socket, .events = POLLIN };
+        if (poll(&listener, metrics->http_socket >= 0 ? 1 : 0, (int)wait_ms) > 0) {
+            serve_http(metrics);
+        }
+    }
+    return NULL;
+}
+
+static int open_http_socket(int port) {
+    int http_socket = socket(AF_INET, SOCK_STREAM, 0);
+    if (http_socket < 0) {
+        LOG_ERROR("Failed to create metrics socket: %s", strerror(errno));
+        return ERROR_SOCKET_CREATE;
+    }
+
+    int opt = 1;
+    setsockopt(http_socket, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
+
+    // Local scrapes only; the endpoint has no authentication
+    struct sockaddr_in address = {
+        .sin_family = AF_INET,
+        .sin_port = htons((uint16_t)port),
+        .sin_addr.s_addr = htonl(INADDR_LOOPBACK)
+    };
+    if (bind(http_socket, (struct sockaddr*)&address, sizeof(address)) < 0 ||
+        listen(http_socket, METRICS_HTTP_BACKLOG) < 0) {
+        LOG_ERROR("Failed to listen for metrics on 127.0.0.1:%d: %s", port, strerror(errno));
+        close(http_socket);
+        return ERROR_SOCKET_BIND;
+    }
+    return http_socket;
+}
+
+static MetricsHeader* map_segment(const char* name, size_t size) {
+    if (name[0] == '\0') {
+        void* data = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        return data == MAP_FAILED ? NULL : data;
+    }
+
+    // A segment left by a crashed server is replaced, not reused
+    shm_unlink(name);
+    int fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0644);
+    if (fd < 0) {
+        LOG_ERROR("Failed to create metrics segment %s: %s", name, strerror(errno));
+        return NULL;
+    }
+    if (ftruncate(fd, (off_t)size) < 0) {
+        LOG_ERROR("Failed to size metrics segment %s: %s", name, strerror(errno));
+        close(fd);
+        shm_unlink(name);
+        return NULL;
+    }
+
+    void* data = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        LOG_ERROR("Failed to map metrics segment %s: %s", name, strerror(errno));
+        shm_unlink(name);
+        return NULL;
+    }
+    return data;
+}
+
+static void release_metrics(Metrics* metrics) {
+    if (metrics->http_socket >= 0) close(metrics->http_socket);
+    if (metrics->segment) munmap(metrics->segment, metrics->segment_size);
+    if (metrics->name[0] != '\0') shm_unlink(metrics->name);
+    pthread_mutex_destroy(&metrics->publish_mutex);
+    free(metrics->staging);
+    free(metrics);
+}
+
+int metrics_start(ServerContext* context) {
+    if (!context) return ERROR_INVALID_PARAM;
+    const ServerConfig* config = &context->config;
+    if (config->metrics_name[0] == '\0' && config->metrics_http_port <= 0) return SUCCESS;
+
+    Metrics* metrics = calloc(1, sizeof(Metrics));
+    if (!metrics) return ERROR_MEMORY_ALLOC;
+    metrics->context = context;
+    metrics->http_socket = -1;
+    metrics->interval_ms = config->metrics_interval_ms > 0 ?
+                           config->metrics_interval_ms : METRICS_DEFAULT_INTERVAL_MS;
+    snprintf(metrics->name, sizeof(metrics->name), "%s", config->metrics_name);
+    pthread_mutex_init(&metrics->publish_mutex, NULL);
+
+    uint32_t connections = (uint32_t)config->max_clients;
+    uint32_t symbols = config->max_symbols > 0 ? config->max_symbols : MAX_SYMBOLS;
+    metrics->segment_size = metrics_segment_size(connections, symbols, METRICS_MAX_THREADS);
+    metrics->staging = calloc(1, metrics->segment_size);
+    metrics->segment = map_segment(metrics->name, metrics->segment_size);
+    if (!metrics->staging || !metrics->segment) {
+        int result = metrics->staging ? ERROR_INVALID_STATE : ERROR_MEMORY_ALLOC;
+        release_metrics(metrics);
+        return result;
+    }
+    metrics_segment_init(metrics->staging, connections, symbols, METRICS_MAX_THREADS,
+                         metrics->interval_ms);
+    memcpy(metrics->segment, metrics->staging, metrics->segment_size);
+
+    if (config->metrics_http_port > 0) {
+        metrics->http_socket = open_http_socket(config->metrics_http_port);
+        if (metrics->http_socket < 0) {
+            int result = metrics->http_socket;
+            release_metrics(metrics);
+            return result;
+        }
+    }
+
+    context->metrics = metrics;
+    atomic_store(&metrics->running, 1);
+    if (pthread_create(&metrics->thread, NULL, metrics_main, context) != 0) {
+        LOG_ERROR("Failed to start metrics thread");
+        context->metrics = NULL;
+        release_metrics(metrics);
+        return ERROR_THREAD_CREATE;
+    }
+
+    if (metrics->name[0] != '\0') {
+        LOG_INFO("Publishing metrics to %s every %u ms", metrics->name, metrics->interval_ms);
+    }
+    if (metrics->http_socket >= 0) {
+        LOG_INFO("Serving metrics on http://127.0.0.1:%d/metrics", config->metrics_http_port);
+    }
+    return SUCCESS;
+}
+
+void metrics_stop(ServerContext* context) {
+    if (!context || !context->metrics) return;
+    Metrics* metrics = context->metrics;
+
+    atomic_store_explicit(&metrics->running, 0, memory_order_release);
+    pthread_join(metrics->thread, NULL);
+
+    // Readers still holding the mapping see the final counters
+    metrics_publish(context);
+    context->metrics = NULL;
+    release_metrics(metrics);
+}
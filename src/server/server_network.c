@@ -1,4 +1,44 @@
 #include "server/server.h"
+#include <poll.h>
+#include <netinet/tcp.h>
+
+// How long accept_client waits for a connection before returning
+#define ACCEPT_POLL_TIMEOUT_MS 10
+
+/**
+ * Receive from a client socket and record the kernel-to-user latency of the
+ * data, using the software receive timestamp enabled by SO_TIMESTAMPNS.
+ */
+static ssize_t receive_frame(int socket, char* buffer, size_t size) {
+    char control[CMSG_SPACE(sizeof(struct timespec))];
+    struct iovec iov = { .iov_base = buffer, .iov_len = size };
+    struct msghdr header = {
+        .msg_iov = &iov,
+        .msg_iovlen = 1,
+        .msg_control = control,
+        .msg_controllen = sizeof(control)
+    };
+
+    ssize_t bytes_received = recvmsg(socket, &header, 0);
+    if (bytes_received <= 0) return bytes_received;
+
+    for (struct cmsghdr* cmsg = CMSG_FIRSTHDR(&header); cmsg; cmsg = CMSG_NXTHDR(&header, cmsg)) {
+        if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_TIMESTAMPNS) {
+            struct timespec kernel_time;
+            struct timespec now;
+            memcpy(&kernel_time, CMSG_DATA(cmsg), sizeof(kernel_time));
+            clock_gettime(CLOCK_REALTIME, &now);
+
+            int64_t elapsed = (int64_t)(now.tv_sec - kernel_time.tv_sec) * 1000000000LL +
+                              (now.tv_nsec - kernel_time.tv_nsec);
+            if (elapsed >= 0) {
+                latency_record(STAGE_RECV, (uint64_t)elapsed);
+            }
+            break;
+        }
+    }
+    return bytes_received;
+}
 
 int setup_socket(ServerContext* context) {
     int server_socket = socket(AF_INET, SOCK_STREAM, 0);
@@ -39,6 +79,13 @@ int setup_socket(ServerContext* context) {
 int accept_client(ServerContext* context) {
     if (!context) return ERROR_INVALID_PARAM;
 
+    // Wait briefly for a connection instead of sleeping a fixed interval,
+    // so the main loop stays responsive without spinning
+    struct pollfd listener = { .fd = context->server_socket, .events = POLLIN };
+    if (poll(&listener, 1, ACCEPT_POLL_TIMEOUT_MS) <= 0) {
+        return ERROR_TIMEOUT;
+    }
+
     struct sockaddr_in client_addr;
     socklen_t client_len = sizeof(client_addr);
 
@@ -46,50 +93,163 @@ int accept_client(ServerContext* context) {
 
     if (client_socket < 0) {
         if (errno == EAGAIN || errno == EWOULDBLOCK) {
-            // No pending connections, this is normal in non-blocking mode
-            usleep(10000); // Sleep for 10ms to avoid busy looping
             return ERROR_TIMEOUT;
-        } else {
-            // Log unexpected errors
-            LOG_ERROR("Failed to accept client connection: %s", strerror(errno));
-            return ERROR_SOCKET_ACCEPT;
         }
+        LOG_ERROR("Failed to accept client connection: %s", strerror(errno));
+        return ERROR_SOCKET_ACCEPT;
     }
 
     // Process the new client connection
     LOG_INFO("Accepted new client connection from %s:%d",
              inet_ntoa(client_addr.sin_addr), ntohs(client_addr.sin_port));
 
-    // Add the client to the context's clients array
+    // Claim a free slot; slots never move, so handler threads keep their pointer
     pthread_mutex_lock(&context->clients_mutex);
-    if (context->client_count >= context->config.max_clients) {
+    ClientConnection* client = NULL;
+    for (int i = 0; i < context->config.max_clients; i++) {
+        if (!context->clients[i].active) {
+            client = &context->clients[i];
+            break;
+        }
+    }
+    if (!client) {
         LOG_ERROR("Maximum client limit reached, rejecting connection");
         close(client_socket);
         pthread_mutex_unlock(&context->clients_mutex);
-        return ERROR_INVALID_STATE;
+        return ERROR_MAX_CLIENTS;
     }
 
-    ClientConnection* client = &context->clients[context->client_count++];
+    // Ask the kernel to timestamp received data for the recv stage histogram
+    int enable_timestamps = 1;
+    setsockopt(client_socket, SOL_SOCKET, SO_TIMESTAMPNS, &enable_timestamps, sizeof(enable_timestamps));
+
+    // Acks are small and latency bound, never hold them back for coalescing
+    int no_delay = 1;
+    setsockopt(client_socket, IPPROTO_TCP, TCP_NODELAY, &no_delay, sizeof(no_delay));
+
     client->socket = client_socket;
     client->address = client_addr;
-    client->connect_time = time(NULL);
-    client->last_heartbeat = time(NULL);
+    client->id[0] = '\0';
+    client->connect_time = clock_now_ns();
+    client->last_heartbeat = client->connect_time;
     client->context = context;
+    atomic_store(&client->messages_sent, 0);
+    atomic_store(&client->messages_received, 0);
+    atomic_store(&client->bytes_received, 0);
+    pthread_mutex_lock(&client->lock);
+    client->outbound_sequence = 0;
+    pthread_mutex_unlock(&client->lock);
+    atomic_store(&client->message_bucket.full_at, 0);
+    atomic_store(&client->order_bucket.full_at, 0);
+    client->account_id = UINT32_MAX;
+    client->throttle_suppressed = 0;
+    client->throttle_notice_due = 0;
+    client->active = 1;
+
+    pthread_attr_t attributes;
+    pthread_attr_init(&attributes);
+    pthread_attr_setdetachstate(&attributes, PTHREAD_CREATE_DETACHED);
+    int result = pthread_create(&client->thread, &attributes, handle_client, client);
+    pthread_attr_destroy(&attributes);
+    if (result != 0) {
+        LOG_ERROR("Failed to start client handler: %s", strerror(result));
+        client->active = 0;
+        client->socket = -1;
+        close(client_socket);
+        pthread_mutex_unlock(&context->clients_mutex);
+        return ERROR_THREAD_CREATE;
+    }
 
+    timers_watch_session(context, client);
+    context->client_count++;
+    atomic_fetch_add(&context->stats.total_connections, 1);
+    atomic_fetch_add(&context->stats.active_connections, 1);
     pthread_mutex_unlock(&context->clients_mutex);
     return SUCCESS;
 }
 
+// Responses are routed by client id, learnt from the first message naming one
+static void learn_client_id(ServerContext* context, ClientConnection* client, const char* client_id) {
+    if (client->id[0] != '\0') return;
+
+    pthread_mutex_lock(&context->clients_mutex);
+    memcpy(client->id, client_id, MAX_CLIENT_ID_LENGTH);
+    client->id[MAX_CLIENT_ID_LENGTH - 1] = '\0';
+    pthread_mutex_unlock(&context->clients_mutex);
+    // From here on the session also draws on its client id's rate limits
+    client->account_id = get_or_create_account(context, client->id);
+}
+
+// A session acts for one client id, the first it names; risk limits, order
+// ownership and PnL all key on the id in the message, so any other is refused
+static int speaks_for(ServerContext* context, ClientConnection* client, const char* client_id) {
+    learn_client_id(context, client, client_id);
+    if (strncmp(client_id, client->id, MAX_CLIENT_ID_LENGTH) == 0) return 1;
+
+    LOG_WARN("Session of %s sent a message for client %.*s", client->id, MAX_CLIENT_ID_LENGTH, client_id);
+    atomic_fetch_add(&context->stats.errors_encountered, 1);
+    send_error(client, ERROR_INVALID_MESSAGE, "Message for another client id");
+    return 0;
+}
+
+static void dispatch_message(ServerContext* context, ClientConnection* client, Message* msg) {
+    switch (msg->type) {
+        case MSG_ORDER_NEW:
+        case MSG_ORDER_MODIFY:
+        case MSG_ORDER_CANCEL:
+        case MSG_ORDER_STATUS:
+            if (!speaks_for(context, client, msg->data.order.client_id)) break;
+            LOG_INFO("Processing order type %d from client %s", msg->type, client->id);
+            if (process_order_message(context, msg) == ERROR_SYMBOL_NOT_FOUND) {
+                send_error(client, ERROR_INVALID_MESSAGE, "Unknown symbol");
+            }
+            break;
+
+        case MSG_MARKET_DATA:
+            LOG_DEBUG("Market data update for %s", msg->data.market_data.symbol);
+            if (broadcast_market_data(context, &msg->data.market_data) == ERROR_SYMBOL_NOT_FOUND) {
+                send_error(client, ERROR_INVALID_MESSAGE, "Unknown symbol");
+            }
+            break;
+
+        case MSG_TRADE_EXEC:
+            if (handle_trade_exec(context, client, msg) != SUCCESS) {
+                send_error(client, ERROR_INVALID_MESSAGE, "Trades are reported by the server, not to it");
+            }
+            break;
+
+        case MSG_HEARTBEAT:
+            handle_heartbeat(context, client, msg);
+            break;
+
+        case MSG_PNL:
+            if (!speaks_for(context, client, msg->data.pnl.client_id)) break;
+            process_pnl_query(context, client, &msg->data.pnl);
+            break;
+
+        default:
+            LOG_WARN("Unknown message type %d from client %s", msg->type, client->id);
+    }
+}
+
 void* handle_client(void* arg) {
     ClientConnection* client = (ClientConnection*)arg;
     char buffer[BUFFER_SIZE];
+    size_t buffered = 0;
     Message msg;
     ServerContext* context = (ServerContext*)client->context;
 
-    LOG_INFO("Handling new client connection: %s", client->id);
+    LOG_INFO("Handling new client connection from %s:%d",
+             inet_ntoa(client->address.sin_addr), ntohs(client->address.sin_port));
+
+    char thread_name[METRICS_THREAD_NAME_LENGTH];
+    snprintf(thread_name, sizeof(thread_name), "client-%d", (int)(client - context->clients));
+    metrics_thread_name(thread_name);
 
     while (server_running) {
-        ssize_t bytes_received = recv(client->socket, buffer, BUFFER_SIZE, 0);
+        ssize_t bytes_received = receive_frame(client->socket, buffer + buffered,
+                                               BUFFER_SIZE - buffered);
+        clock_frame_end();
         if (bytes_received <= 0) {
             if (bytes_received == 0) {
                 LOG_INFO("Client %s disconnected", client->id);
@@ -99,36 +259,70 @@ void* handle_client(void* arg) {
             }
             break;
         }
+        atomic_fetch_add(&context->stats.bytes_received, (uint64_t)bytes_received);
+        atomic_fetch_add_explicit(&client->bytes_received, (uint64_t)bytes_received,
+                                  memory_order_relaxed);
+        metrics_thread_add(THREAD_BYTES_RECEIVED, (uint64_t)bytes_received);
 
-        if (deserialize_message((const uint8_t*)buffer, bytes_received, &msg) != SUCCESS) {
-            LOG_ERROR("Failed to deserialize message from client %s", client->id);
-            continue;
-        }
-
-        client->messages_received++;
-        client->last_heartbeat = time(NULL);
-
-        switch (msg.type) {
-            case MSG_ORDER_NEW:
-            case MSG_ORDER_MODIFY:
-            case MSG_ORDER_CANCEL:
-                LOG_INFO("Processing order type %d from client %s", msg.type, client->id);
-                process_order(context, &msg.data.order);
-                break;
+        // One timestamp per inbound frame, reused by every message in it
+        uint64_t frame_time = clock_frame_begin();
+        buffered += (size_t)bytes_received;
+        size_t offset = 0;
+        uint64_t processed = 0;
+        uint64_t throttled = 0;
+        while (offset < buffered) {
+            // Rate limits need only the header, so a flood is shed undecoded
+            MessageHeader header;
+            if (context->throttle_active && buffered - offset >= sizeof(header)) {
+                memcpy(&header, buffer + offset, sizeof(header));
+                if (validate_message_header(&header) == SERIAL_SUCCESS &&
+                    header.message_size <= buffered - offset) {
+                    ThrottleKind refused = throttle_admit(context, client, header.type, frame_time);
+                    if (refused != THROTTLE_COUNT) {
+                        throttle_reject(context, client, refused, &header,
+                                        (const uint8_t*)buffer + offset + sizeof(header), frame_time);
+                        offset += header.message_size;
+                        throttled++;
+                        continue;
+                    }
+                }
+            }
 
-            case MSG_MARKET_DATA:
-                LOG_DEBUG("Market data update for %s", msg.data.market_data.symbol);
-                broadcast_market_data(context, &msg.data.market_data);
+            uint64_t decode_start = clock_ticks();
+            int consumed = deserialize_message((const uint8_t*)buffer + offset,
+                                               buffered - offset, &msg);
+            if (consumed == SERIAL_ERROR_INCOMPLETE) break;
+            if (consumed < 0) {
+                // The stream cannot be resynchronised past a corrupt header
+                LOG_ERROR("Failed to deserialize message from client %s", client->id);
+                atomic_fetch_add(&context->stats.errors_encountered, 1);
+                metrics_thread_add(THREAD_ERRORS, 1);
+                offset = buffered;
                 break;
+            }
+            latency_record_since(STAGE_DECODE, decode_start);
+            offset += (size_t)consumed;
 
-            case MSG_TRADE_EXEC:
-                LOG_INFO("Trade execution for %s", msg.data.trade.symbol);
-                process_trade_execution(context, &msg.data.trade);
-                break;
+            processed++;
+            client->last_heartbeat = frame_time;
+            dispatch_message(context, client, &msg);
+        }
 
-            default:
-                LOG_WARN("Unknown message type %d from client %s", msg.type, client->id);
+        // Counted once per frame rather than per message; throttled
+        // messages were received but never processed
+        if (processed + throttled > 0) {
+            atomic_fetch_add_explicit(&client->messages_received, processed + throttled,
+                                      memory_order_relaxed);
         }
+        if (processed > 0) {
+            atomic_fetch_add_explicit(&context->stats.messages_processed, processed,
+                                      memory_order_relaxed);
+            metrics_thread_add(THREAD_MESSAGES_PROCESSED, processed);
+        }
+
+        // Keep a partial message for the next read
+        buffered -= offset;
+        memmove(buffer, buffer + offset, buffered);
     }
 
     disconnect_client(context, client);
@@ -136,21 +330,15 @@ void* handle_client(void* arg) {
 }
 
 void disconnect_client(ServerContext* context, ClientConnection* client) {
-    pthread_mutex_lock(&context->clients_mutex);
-    
-    for (int i = 0; i < context->client_count; i++) {
-        if (strcmp(context->clients[i].id, client->id) == 0) {
-            if (i < context->client_count - 1) {
-                memmove(&context->clients[i], &context->clients[i + 1], 
-                        (context->client_count - i - 1) * sizeof(ClientConnection));
-            }
-            context->client_count--;
-            break;
-        }
-    }
-    
-    pthread_mutex_unlock(&context->clients_mutex);
+    LOG_INFO("Client %s disconnected and cleaned up", client->id);
 
+    pthread_mutex_lock(&context->clients_mutex);
     close(client->socket);
-    LOG_INFO("Client %s disconnected and cleaned up", client->id);
+    client->socket = -1;
+    client->id[0] = '\0';
+    client->active = 0;
+    atomic_fetch_sub(&context->stats.active_connections, 1);
+    // Last: stop_server waits for the count to drain before freeing slots
+    context->client_count--;
+    pthread_mutex_unlock(&context->clients_mutex);
 }
@@ -0,0 +1,1031 @@
+#include "server/server.h"
+#include "server/server_orderbook.h"
+#include <sys/mman.h>
+
+// Bids sort ascending and asks descending, so the best level is always last
+static inline int64_t level_key(OrderSide side, int64_t price) {
+    return side == ORDER_SIDE_BUY ? price : -price;
+}
+
+static inline BookSide* book_side(OrderBook* book, OrderSide side) {
+    return side == ORDER_SIDE_BUY ? &book->bids : &book->asks;
+}
+
+static inline int is_stop_type(OrderType type) {
+    return type == ORDER_TYPE_STOP || type == ORDER_TYPE_STOP_LIMIT;
+}
+
+/**
+ * Where an entry for an order lives, and the side whose sort order that
+ * array uses. Buy stops fire as the price rises, so the lowest trigger is
+ * nearest and they sort like asks; sell stops sort like bids.
+ */
+static inline BookSide* resting_side(OrderBook* book, const Order* order, OrderSide* key_side) {
+    if (is_stop_type(order->type)) {
+        *key_side = order->side == ORDER_SIDE_BUY ? ORDER_SIDE_SELL : ORDER_SIDE_BUY;
+        return order->side == ORDER_SIDE_BUY ? &book->buy_stops : &book->sell_stops;
+    }
+    *key_side = order->side;
+    return book_side(book, order->side);
+}
+
+static inline int stop_triggered(const OrderBook* book, OrderSide side, int64_t trigger) {
+    if (book->last_trade == 0) return 0;
+    return side == ORDER_SIDE_BUY ? book->last_trade >= trigger : book->last_trade <= trigger;
+}
+
+// A triggered stop becomes the order it stood for
+static inline void trigger_order(Order* order) {
+    order->type = order->type == ORDER_TYPE_STOP ? ORDER_TYPE_MARKET : ORDER_TYPE_LIMIT;
+}
+
+static inline uint32_t index_slot(const OrderBook* book, uint64_t order_id) {
+    return (uint32_t)((order_id * 0x9E3779B97F4A7C15ULL) >> 32) & book->order_index_mask;
+}
+
+// Entry pools and indexes are large and touched at random, so they are mapped
+// prefaulted rather than paying a page fault per first touch on the hot path
+static void* map_populated(size_t size) {
+    void* memory = mmap(NULL, size, PROT_READ | PROT_WRITE,
+                        MAP_PRIVATE | MAP_ANONYMOUS | MAP_POPULATE, -1, 0);
+    return memory == MAP_FAILED ? NULL : memory;
+}
+
+int orderbook_init(OrderBook* book, uint32_t max_orders) {
+    if (!book || max_orders == 0) return ERROR_INVALID_PARAM;
+
+    uint32_t index_capacity = 16;
+    while (index_capacity < max_orders * 2) {
+        index_capacity <<= 1;
+    }
+
+    book->max_orders = max_orders;
+    book->order_index_mask = index_capacity - 1;
+    book->entries = map_populated((size_t)max_orders * sizeof(OrderBookEntry));
+    book->order_index = map_populated((size_t)index_capacity * sizeof(OrderIndexSlot));
+    book->bids.levels = calloc(ORDERBOOK_INITIAL_LEVELS, sizeof(PriceLevel));
+    book->asks.levels = calloc(ORDERBOOK_INITIAL_LEVELS, sizeof(PriceLevel));
+    book->buy_stops.levels = calloc(ORDERBOOK_INITIAL_LEVELS, sizeof(PriceLevel));
+    book->sell_stops.levels = calloc(ORDERBOOK_INITIAL_LEVELS, sizeof(PriceLevel));
+    if (!book->entries || !book->order_index || !book->bids.levels || !book->asks.levels ||
+        !book->buy_stops.levels || !book->sell_stops.levels) {
+        LOG_ERROR("Failed to allocate order book for %s", book->symbol);
+        orderbook_destroy(book);
+        return ERROR_MEMORY_ALLOC;
+    }
+
+    book->bids.level_capacity = ORDERBOOK_INITIAL_LEVELS;
+    book->asks.level_capacity = ORDERBOOK_INITIAL_LEVELS;
+    book->buy_stops.level_capacity = ORDERBOOK_INITIAL_LEVELS;
+    book->sell_stops.level_capacity = ORDERBOOK_INITIAL_LEVELS;
+
+    book->free_entries = NULL;
+    for (uint32_t i = max_orders; i > 0; i--) {
+        book->entries[i - 1].next = book->free_entries;
+        book->free_entries = &book->entries[i - 1];
+    }
+
+    book->best_bid = create_price(0, book->tick_exponent);
+    book->best_ask = create_price(0, book->tick_exponent);
+    timer_wheel_init(&book->expiries, clock_now_ns());
+    atomic_store_explicit(&book->next_expiry, UINT64_MAX, memory_order_relaxed);
+    return SUCCESS;
+}
+
+void orderbook_destroy(OrderBook* book) {
+    if (!book) return;
+
+    if (book->entries) {
+        munmap(book->entries, (size_t)book->max_orders * sizeof(OrderBookEntry));
+    }
+    if (book->order_index) {
+        munmap(book->order_index, ((size_t)book->order_index_mask + 1) * sizeof(OrderIndexSlot));
+    }
+    free(book->bids.levels);
+    free(book->asks.levels);
+    free(book->buy_stops.levels);
+    free(book->sell_stops.levels);
+    free(book->triggered);
+    free(book->share_entries);
+    free(book->shares);
+    book->entries = NULL;
+    book->order_index = NULL;
+    book->bids.levels = NULL;
+    book->asks.levels = NULL;
+    book->buy_stops.levels = NULL;
+    book->sell_stops.levels = NULL;
+    book->triggered = NULL;
+    book->triggered_capacity = 0;
+    book->share_entries = NULL;
+    book->shares = NULL;
+    book->free_entries = NULL;
+}
+
+// Open-addressed order id index with linear probing and backward-shift deletion
+static OrderIndexSlot* index_find(const OrderBook* book, uint64_t order_id) {
+    uint32_t slot = index_slot(book, order_id);
+    while (book->order_index[slot].order_id) {
+        if (book->order_index[slot].order_id == order_id) {
+            return &book->order_index[slot];
+        }
+        slot = (slot + 1) & book->order_index_mask;
+    }
+    return NULL;
+}
+
+static void index_insert(OrderBook* book, OrderBookEntry* entry) {
+    uint32_t slot = index_slot(book, entry->order.order_id);
+    while (book->order_index[slot].order_id) {
+        slot = (slot + 1) & book->order_index_mask;
+    }
+    book->order_index[slot].order_id = entry->order.order_id;
+    book->order_index[slot].entry = entry;
+}
+
+static void index_remove(OrderBook* book, uint64_t order_id) {
+    OrderIndexSlot* found = index_find(book, order_id);
+    if (!found) return;
+
+    uint32_t hole = (uint32_t)(found - book->order_index);
+    uint32_t slot = hole;
+    book->order_index[hole].order_id = 0;
+
+    // Pull later members of the probe chain back over the hole
+    for (;;) {
+        slot = (slot + 1) & book->order_index_mask;
+        OrderIndexSlot* candidate = &book->order_index[slot];
+        if (!candidate->order_id) break;
+
+        uint32_t home = index_slot(book, candidate->order_id);
+        if (((slot - home) & book->order_index_mask) >= ((slot - hole) & book->order_index_mask)) {
+            book->order_index[hole] = *candidate;
+            candidate->order_id = 0;
+            hole = slot;
+        }
+    }
+}
+
+// Binary search for price; returns its position or where it would be inserted
+static uint32_t find_level(const BookSide* side, OrderSide order_side, int64_t price, int* found) {
+    int64_t key = level_key(order_side, price);
+    uint32_t low = 0;
+    uint32_t high = side->level_count;
+
+    while (low < high) {
+        uint32_t mid = low + (high - low) / 2;
+        int64_t mid_key = level_key(order_side, side->levels[mid].price);
+        if (mid_key < key) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    *found = low < side->level_count && side->levels[low].price == price;
+    return low;
+}
+
+static PriceLevel* get_or_insert_level(BookSide* side, OrderSide order_side, int64_t price) {
+    int found;
+    uint32_t position = find_level(side, order_side, price, &found);
+    if (found) return &side->levels[position];
+
+    if (side->level_count == side->level_capacity) {
+        uint32_t capacity = side->level_capacity * 2;
+        PriceLevel* levels = realloc(side->levels, capacity * sizeof(PriceLevel));
+        if (!levels) return NULL;
+        side->levels = levels;
+        side->level_capacity = capacity;
+    }
+
+    // Most inserts land near the top of book, so this move is short
+    memmove(&side->levels[position + 1], &side->levels[position],
+            (side->level_count - position) * sizeof(PriceLevel));
+    side->level_count++;
+
+    PriceLevel* level = &side->levels[position];
+    memset(level, 0, sizeof(*level));
+    level->price = price;
+    return level;
+}
+
+static void remove_level(BookSide* side, uint32_t position) {
+    memmove(&side->levels[position], &side->levels[position + 1],
+            (side->level_count - position - 1) * sizeof(PriceLevel));
+    side->level_count--;
+}
+
+static void update_best_prices(OrderBook* book) {
+    book->best_bid = create_price(book->bids.level_count ?
+                                  book->bids.levels[book->bids.level_count - 1].price : 0,
+                                  book->tick_exponent);
+    book->best_ask = create_price(book->asks.level_count ?
+                                  book->asks.levels[book->asks.level_count - 1].price : 0,
+                                  book->tick_exponent);
+}
+
+static void append_entry(PriceLevel* level, OrderBookEntry* entry) {
+    entry->next = NULL;
+    entry->prev = level->tail;
+    if (level->tail) level->tail->next = entry;
+    else level->head = entry;
+    level->tail = entry;
+}
+
+static void detach_entry(PriceLevel* level, OrderBookEntry* entry) {
+    if (entry->prev) entry->prev->next = entry->next;
+    else level->head = entry->next;
+    if (entry->next) entry->next->prev = entry->prev;
+    else level->tail = entry->prev;
+}
+
+static void unlink_entry(PriceLevel* level, OrderBookEntry* entry) {
+    detach_entry(level, entry);
+    level->order_count--;
+    level->total_quantity -= entry->order.remaining_quantity;
+    level->visible_quantity -= entry->order.visible_quantity;
+}
+
+// The next slice of an iceberg: its display quantity, or what is left if less
+static inline uint32_t next_slice(const Order* order) {
+    uint32_t display = order->display_quantity;
+    return display && display < order->remaining_quantity ? display : order->remaining_quantity;
+}
+
+/**
+ * Show an iceberg's next slice once the last one has filled. The refill
+ * is a new display, so it loses time priority and goes to the back of
+ * the level; moving it is a relink of the entry, nothing is allocated.
+ */
+static void refill_entry(PriceLevel* level, OrderBookEntry* entry) {
+    entry->order.visible_quantity = next_slice(&entry->order);
+    level->visible_quantity += entry->order.visible_quantity;
+    if (entry != level->tail) {
+        detach_entry(level, entry);
+        append_entry(level, entry);
+    }
+}
+
+static void release_entry(OrderBook* book, OrderBookEntry* entry) {
+    index_remove(book, entry->order.order_id);
+    timer_cancel(&book->expiries, &entry->expiry);
+    if (is_stop_type(entry->order.type)) book->stop_count--;
+    else if (entry->order.side == ORDER_SIDE_BUY) book->bid_count--;
+    else book->ask_count--;
+    entry->next = book->free_entries;
+    book->free_entries = entry;
+}
+
+/**
+ * When a resting order lapses, 0 for never: its expiration time, or for a
+ * DAY order the first day end after it was entered if that comes sooner.
+ * The day end is cached, since orders of one day all share it.
+ */
+static uint64_t order_deadline(OrderBook* book, const Order* order, uint64_t now) {
+    uint64_t deadline = order->expiration_time;
+    if (order->time_in_force != TIF_DAY || book->day_end_seconds == 0) return deadline;
+
+    uint64_t entered = order->modification_time ? order->modification_time : now;
+    if (entered >= book->day_end || entered + NANOS_PER_DAY < book->day_end) {
+        book->day_end = timers_next_day_end(book->day_end_seconds, entered);
+    }
+    return deadline && deadline < book->day_end ? deadline : book->day_end;
+}
+
+static int rest_order(OrderBook* book, const Order* order, int64_t price_ticks) {
+    if (!book->free_entries) {
+        LOG_ERROR("Order book for %s is full (%u orders)", book->symbol, book->max_orders);
+        return ERROR_ORDERBOOK_FULL;
+    }
+
+    OrderSide key_side;
+    BookSide* side = resting_side(book, order, &key_side);
+    PriceLevel* level = get_or_insert_level(side, key_side, price_ticks);
+    if (!level) {
+        LOG_ERROR("Failed to grow price levels for %s", book->symbol);
+        return ERROR_MEMORY_ALLOC;
+    }
+
+    OrderBookEntry* entry = book->free_entries;
+    book->free_entries = entry->next;
+
+    entry->order = *order;
+    if (order->visible_quantity == 0 || order->visible_quantity > order->remaining_quantity) {
+        entry->order.visible_quantity = next_slice(order);
+    }
+    entry->price_ticks = price_ticks;
+    entry->entry_time = clock_frame_time();
+    uint64_t deadline = order_deadline(book, order, entry->entry_time);
+    if (deadline) {
+        timer_arm(&book->expiries, &entry->expiry, deadline);
+        atomic_store_explicit(&book->next_expiry, timer_wheel_due(&book->expiries), memory_order_relaxed);
+    }
+    entry->sequence = is_stop_type(order->type) ? ++book->stop_sequence : 0;
+    append_entry(level, entry);
+    level->order_count++;
+    level->total_quantity += order->remaining_quantity;
+    level->visible_quantity += entry->order.visible_quantity;
+
+    if (is_stop_type(order->type)) book->stop_count++;
+    else if (order->side == ORDER_SIDE_BUY) book->bid_count++;
+    else book->ask_count++;
+    index_insert(book, entry);
+    return SUCCESS;
+}
+
+// Whether the opposite side holds the whole quantity within the limit,
+// summing level totals best first and stopping as soon as it does. Hidden
+// reserve counts: matching keeps taking refilled slices until it is done.
+static int liquidity_covers(const OrderBook* book, const Order* order, int64_t price_ticks) {
+    const BookSide* side = order->side == ORDER_SIDE_BUY ? &book->asks : &book->bids;
+    int is_limit = order->type != ORDER_TYPE_MARKET;
+    uint64_t available = 0;
+
+    for (uint32_t i = side->level_count; i > 0; i--) {
+        const PriceLevel* level = &side->levels[i - 1];
+        if (is_limit && level_key(order->side, price_ticks) < level_key(order->side, level->price)) {
+            break;
+        }
+        available += level->total_quantity;
+        if (available >= order->remaining_quantity) return 1;
+    }
+    return 0;
+}
+
+/**
+ * Take a fill off a resting entry: an uncross may take more than the
+ * visible slice, the hidden part coming straight off the reserve. A filled
+ * entry leaves the level; an iceberg whose slice is used up refills.
+ */
+static void fill_entry(OrderBook* book, PriceLevel* level, OrderBookEntry* entry, uint32_t quantity) {
+    uint32_t shown = quantity < entry->order.visible_quantity ? quantity : entry->order.visible_quantity;
+    entry->order.filled_quantity += quantity;
+    entry->order.remaining_quantity -= quantity;
+    entry->order.visible_quantity -= shown;
+    level->total_quantity -= quantity;
+    level->visible_quantity -= shown;
+
+    if (entry->order.remaining_quantity == 0) {
+        entry->order.status = ORDER_STATUS_FILLED;
+        unlink_entry(level, entry);
+        release_entry(book, entry);
+    } else {
+        entry->order.status = ORDER_STATUS_PARTIAL;
+        if (entry->order.visible_quantity == 0) {
+            refill_entry(level, entry);
+        }
+    }
+}
+
+// One fill of an incoming order against a resting one, at the level's price
+static inline void trade_entry(OrderBook* book, PriceLevel* level, OrderBookEntry* entry, Order* order,
+                               uint32_t quantity, OrderFillCallback on_fill, void* arg) {
+    if (on_fill) {
+        OrderFill fill = {
+            .aggressor = order,
+            .resting = &entry->order,
+            .price = level->price,
+            .quantity = quantity
+        };
+        on_fill(book, &fill, arg);
+    }
+
+    order->filled_quantity += quantity;
+    order->remaining_quantity -= quantity;
+    book->total_volume += quantity;
+    book->trade_count++;
+    book->last_trade = level->price;
+    fill_entry(book, level, entry, quantity);
+}
+
+// Fill up to quantity from the level oldest first, refilled iceberg slices
+// included as they come round again
+static inline void take_in_time_order(OrderBook* book, PriceLevel* level, Order* order, uint32_t quantity,
+                                      OrderFillCallback on_fill, void* arg) {
+    OrderBookEntry* entry = level->head;
+    while (entry && quantity > 0) {
+        OrderBookEntry* next = entry->next;
+        uint32_t take = quantity < entry->order.visible_quantity ? quantity : entry->order.visible_quantity;
+        trade_entry(book, level, entry, order, take, on_fill, arg);
+        quantity -= take;
+        entry = next;
+    }
+}
+
+/**
+ * Share quantity, less than the level shows, among its orders in
+ * proportion to their visible quantities. The orders are gathered into
+ * a contiguous array of quantities, one pass over it turns each into its
+ * rounded-down share, zero below the book's minimum allocation, and what
+ * rounding and the minimum leave over goes oldest first. The arrays hold
+ * every order the book can, so matching never allocates.
+ */
+static void take_pro_rata(OrderBook* book, PriceLevel* level, Order* order, uint32_t quantity,
+                          OrderFillCallback on_fill, void* arg) {
+    OrderBookEntry** entries = book->share_entries;
+    uint32_t* shares = book->shares;
+    uint32_t n = 0;
+    for (OrderBookEntry* entry = level->head; entry; entry = entry->next) {
+        entries[n] = entry;
+        shares[n++] = entry->order.visible_quantity;
+    }
+
+    uint64_t total = level->visible_quantity;
+    uint32_t minimum = book->min_allocation;
+    uint32_t allocated = 0;
+    for (uint32_t i = 0; i < n; i++) {
+        uint32_t share = (uint32_t)((uint64_t)quantity * shares[i] / total);
+        shares[i] = share < minimum ? 0 : share;
+        allocated += shares[i];
+    }
+    for (uint32_t i = 0, left = quantity - allocated; i < n && left > 0; i++) {
+        uint32_t room = entries[i]->order.visible_quantity - shares[i];
+        uint32_t extra = left < room ? left : room;
+        shares[i] += extra;
+        left -= extra;
+    }
+
+    for (uint32_t i = 0; i < n; i++) {
+        if (shares[i] > 0) {
+            trade_entry(book, level, entries[i], order, shares[i], on_fill, arg);
+        }
+    }
+}
+
+/**
+ * Walk the opposite side best price first. The policy is a constant in
+ * each instance below, so the compiler drops the branches the others
+ * need: price-time matching compiles to the plain time-order loop. An
+ * order for at least what a level shows takes all of it in time order
+ * under every policy.
+ */
+static inline __attribute__((always_inline)) void match_levels(OrderBook* book, Order* order, int64_t price_ticks,
+                                                               OrderFillCallback on_fill, void* arg,
+                                                               const MatchPolicy policy) {
+    OrderSide contra = order->side == ORDER_SIDE_BUY ? ORDER_SIDE_SELL : ORDER_SIDE_BUY;
+    BookSide* side = book_side(book, contra);
+    int is_limit = order->type != ORDER_TYPE_MARKET;
+
+    while (order->remaining_quantity > 0 && side->level_count > 0) {
+        PriceLevel* level = &side->levels[side->level_count - 1];
+        if (is_limit && level_key(order->side, price_ticks) < level_key(order->side, level->price)) {
+            break;
+        }
+
+        uint32_t quantity = order->remaining_quantity;
+        if (policy == MATCH_PRICE_TIME || quantity >= level->visible_quantity) {
+            take_in_time_order(book, level, order, quantity, on_fill, arg);
+        } else {
+            if (policy == MATCH_HYBRID) {
+                uint32_t first = (uint32_t)((uint64_t)quantity * book->fifo_percent / 100);
+                take_in_time_order(book, level, order, first, on_fill, arg);
+                quantity -= first;
+            }
+            take_pro_rata(book, level, order, quantity, on_fill, arg);
+        }
+
+        if (level->order_count == 0) {
+            side->level_count--;
+        }
+    }
+}
+
+typedef void (*MatchFunction)(OrderBook* book, Order* order, int64_t price_ticks,
+                              OrderFillCallback on_fill, void* arg);
+
+static void match_price_time(OrderBook* book, Order* order, int64_t price_ticks,
+                             OrderFillCallback on_fill, void* arg) {
+    match_levels(book, order, price_ticks, on_fill, arg, MATCH_PRICE_TIME);
+}
+
+static void match_pro_rata(OrderBook* book, Order* order, int64_t price_ticks,
+                           OrderFillCallback on_fill, void* arg) {
+    match_levels(book, order, price_ticks, on_fill, arg, MATCH_PRO_RATA);
+}
+
+static void match_hybrid(OrderBook* book, Order* order, int64_t price_ticks,
+                         OrderFillCallback on_fill, void* arg) {
+    match_levels(book, order, price_ticks, on_fill, arg, MATCH_HYBRID);
+}
+
+static const MatchFunction match_functions[MATCH_POLICY_COUNT] = {
+    [MATCH_PRICE_TIME] = match_price_time,
+    [MATCH_PRO_RATA] = match_pro_rata,
+    [MATCH_HYBRID] = match_hybrid
+};
+
+// Price-time books call their instance directly; only the others go through the table
+static inline void match_order(OrderBook* book, Order* order, int64_t price_ticks,
+                               OrderFillCallback on_fill, void* arg) {
+    if (book->match_policy == MATCH_PRICE_TIME) {
+        match_price_time(book, order, price_ticks, on_fill, arg);
+    } else {
+        match_functions[book->match_policy](book, order, price_ticks, on_fill, arg);
+    }
+}
+
+/**
+ * Enter an order that may already carry fills: a replacement keeps the
+ * original size and what it has filled, and only the rest is matched and
+ * rests.
+ */
+static int enter_order(OrderBook* book, Order* order, OrderFillCallback on_fill, void* arg) {
+    int64_t price_ticks = 0;
+    int64_t stop_ticks = 0;
+    int is_stop = is_stop_type(order->type);
+    if (order->type != ORDER_TYPE_MARKET && order->type != ORDER_TYPE_STOP &&
+        price_to_ticks(order->price, book->tick_exponent, &price_ticks) < 0) {
+        return ERROR_INVALID_ORDER;
+    }
+    if (is_stop && (price_to_ticks(order->stop_price, book->tick_exponent, &stop_ticks) < 0 ||
+                    stop_ticks <= 0)) {
+        return ERROR_INVALID_ORDER;
+    }
+    if (order->order_id == 0 || index_find(book, order->order_id) ||
+        order->display_quantity > order->quantity) {
+        return ERROR_INVALID_ORDER;
+    }
+
+    // A call only collects orders that can wait for the uncross
+    int collecting = book->phase == BOOK_PHASE_CALL;
+    if (collecting && !is_stop && !order_can_rest(order)) {
+        return ERROR_INVALID_ORDER;
+    }
+
+    order->remaining_quantity = order->quantity - order->filled_quantity;
+    order->visible_quantity = 0;
+    order->status = order->filled_quantity > 0 ? ORDER_STATUS_PARTIAL : ORDER_STATUS_NEW;
+    book->revision++;
+
+    // A stop waits for its trigger unless the last trade has already reached
+    // it; in a call it waits regardless, to be released after the uncross
+    if (is_stop) {
+        if (collecting || !stop_triggered(book, order->side, stop_ticks)) {
+            order->stop_price = price_from_ticks(stop_ticks, book->tick_exponent);
+            if (order->type == ORDER_TYPE_STOP_LIMIT) {
+                order->price = price_from_ticks(price_ticks, book->tick_exponent);
+            }
+            int result = rest_order(book, order, stop_ticks);
+            if (result != SUCCESS) {
+                order->status = ORDER_STATUS_CANCELLED;
+            }
+            return result;
+        }
+        trigger_order(order);
+    }
+
+    if (order->time_in_force == TIF_FOK && !liquidity_covers(book, order, price_ticks)) {
+        order->status = ORDER_STATUS_CANCELLED;
+        return SUCCESS;
+    }
+
+    if (!collecting) {
+        match_order(book, order, price_ticks, on_fill, arg);
+    }
+
+    int result = SUCCESS;
+    if (order->remaining_quantity == 0) {
+        order->status = ORDER_STATUS_FILLED;
+    } else {
+        if (order->filled_quantity > 0) {
+            order->status = ORDER_STATUS_PARTIAL;
+        }
+        if (!order_can_rest(order)) {
+            order->status = ORDER_STATUS_CANCELLED;
+        } else {
+            order->price = price_from_ticks(price_ticks, book->tick_exponent);
+            result = rest_order(book, order, price_ticks);
+            if (result != SUCCESS) {
+                order->status = ORDER_STATUS_CANCELLED;
+            }
+        }
+    }
+
+    update_best_prices(book);
+    return result;
+}
+
+int orderbook_add_order(OrderBook* book, Order* order, OrderFillCallback on_fill, void* arg) {
+    if (!book || !order) return ERROR_INVALID_PARAM;
+
+    order->filled_quantity = 0;
+    return enter_order(book, order, on_fill, arg);
+}
+
+// Take a resting order or pending stop out of its level, as cancelled
+static void remove_entry(OrderBook* book, OrderBookEntry* entry, Order* cancelled) {
+    OrderSide key_side;
+    BookSide* side = resting_side(book, &entry->order, &key_side);
+    int level_found;
+    uint32_t position = find_level(side, key_side, entry->price_ticks, &level_found);
+    PriceLevel* level = &side->levels[position];
+
+    unlink_entry(level, entry);
+    if (level->order_count == 0) {
+        remove_level(side, position);
+    }
+
+    entry->order.status = ORDER_STATUS_CANCELLED;
+    if (cancelled) {
+        *cancelled = entry->order;
+    }
+    release_entry(book, entry);
+}
+
+int orderbook_cancel_order(OrderBook* book, uint64_t order_id, Order* cancelled) {
+    if (!book) return ERROR_INVALID_PARAM;
+
+    OrderIndexSlot* found = index_find(book, order_id);
+    if (!found) return ERROR_ORDER_NOT_FOUND;
+    remove_entry(book, found->entry, cancelled);
+    update_best_prices(book);
+    book->revision++;
+    return SUCCESS;
+}
+
+int orderbook_modify_order(OrderBook* book, Order* order, OrderFillCallback on_fill, void* arg) {
+    if (!book || !order) return ERROR_INVALID_PARAM;
+
+    OrderIndexSlot* found = index_find(book, order->order_id);
+    if (!found) return ERROR_ORDER_NOT_FOUND;
+    OrderBookEntry* entry = found->entry;
+
+    // A pending stop has no queue place to keep; it is entered again on the
+    // new terms, and may trigger straight away
+    if (is_stop_type(entry->order.type)) {
+        Order replacement = entry->order;
+        if (order->stop_price.mantissa != 0) replacement.stop_price = order->stop_price;
+        if (replacement.type == ORDER_TYPE_STOP_LIMIT) replacement.price = order->price;
+        replacement.quantity = order->quantity;
+        replacement.modification_time = order->modification_time;
+        if (replacement.display_quantity > replacement.quantity) replacement.display_quantity = 0;
+        orderbook_cancel_order(book, order->order_id, NULL);
+        int result = orderbook_add_order(book, &replacement, on_fill, arg);
+        *order = replacement;
+        return result;
+    }
+
+    int64_t price_ticks;
+    if (price_to_ticks(order->price, book->tick_exponent, &price_ticks) < 0) {
+        return ERROR_INVALID_ORDER;
+    }
+
+    uint32_t filled = entry->order.filled_quantity;
+    if (order->quantity <= filled) {
+        return orderbook_cancel_order(book, order->order_id, order);
+    }
+
+    // Shrinking at the same price keeps the order's place in the queue; an
+    // iceberg gives up hidden reserve before any of its visible slice
+    if (price_ticks == entry->price_ticks && order->quantity <= entry->order.quantity) {
+        BookSide* side = book_side(book, entry->order.side);
+        int level_found;
+        uint32_t position = find_level(side, entry->order.side, price_ticks, &level_found);
+        PriceLevel* level = &side->levels[position];
+        uint32_t remaining = order->quantity - filled;
+        uint32_t visible = entry->order.visible_quantity < remaining ? entry->order.visible_quantity : remaining;
+
+        level->total_quantity -= entry->order.remaining_quantity - remaining;
+        level->visible_quantity -= entry->order.visible_quantity - visible;
+        entry->order.quantity = order->quantity;
+        entry->order.remaining_quantity = remaining;
+        entry->order.visible_quantity = visible;
+        entry->order.modification_time = order->modification_time;
+        *order = entry->order;
+        book->revision++;
+        return SUCCESS;
+    }
+
+    Order replacement = entry->order;
+    orderbook_cancel_order(book, order->order_id, NULL);
+
+    // The replacement keeps its size and fills, so a later modify and the
+    // shrink check above still measure against the whole order
+    replacement.price = order->price;
+    replacement.quantity = order->quantity;
+    replacement.modification_time = order->modification_time;
+    if (replacement.display_quantity > replacement.quantity) replacement.display_quantity = 0;
+    int result = enter_order(book, &replacement, on_fill, arg);
+    *order = replacement;
+    return result;
+}
+
+int orderbook_restore_order(OrderBook* book, const Order* order) {
+    if (!book || !order || order->remaining_quantity == 0) return ERROR_INVALID_PARAM;
+
+    int64_t price_ticks;
+    Price at = is_stop_type(order->type) ? order->stop_price : order->price;
+    if (price_to_ticks(at, book->tick_exponent, &price_ticks) < 0 ||
+        order->order_id == 0 || index_find(book, order->order_id)) {
+        return ERROR_INVALID_ORDER;
+    }
+
+    int result = rest_order(book, order, price_ticks);
+    update_best_prices(book);
+    book->revision++;
+    return result;
+}
+
+static int by_arrival(const void* a, const void* b) {
+    uint64_t left = (*(OrderBookEntry* const*)a)->sequence;
+    uint64_t right = (*(OrderBookEntry* const*)b)->sequence;
+    return (left > right) - (left < right);
+}
+
+// Detach every stop level the last trade has reached, appending its entries
+// to book->triggered; only the nearest level of a side is ever looked at
+// without being taken
+static uint32_t take_triggered(OrderBook* book, BookSide* side, OrderSide order_side, uint32_t count) {
+    while (side->level_count > 0) {
+        PriceLevel* level = &side->levels[side->level_count - 1];
+        if (!stop_triggered(book, order_side, level->price)) break;
+
+        if (count + level->order_count > book->triggered_capacity) {
+            uint32_t capacity = book->triggered_capacity ? book->triggered_capacity : 16;
+            while (capacity < count + level->order_count) capacity <<= 1;
+            OrderBookEntry** grown = realloc(book->triggered, capacity * sizeof(*grown));
+            if (!grown) {
+                LOG_ERROR("Failed to grow stop triggers for %s", book->symbol);
+                break;
+            }
+            book->triggered = grown;
+            book->triggered_capacity = capacity;
+        }
+        for (OrderBookEntry* entry = level->head; entry; entry = entry->next) {
+            book->triggered[count++] = entry;
+        }
+        side->level_count--;
+    }
+    return count;
+}
+
+uint32_t orderbook_release_stops(OrderBook* book, OrderFillCallback on_fill,
+                                 OrderReleaseCallback on_release, void* arg) {
+    if (!book || book->phase == BOOK_PHASE_CALL) return 0;
+
+    uint32_t released = 0;
+    while (book->stop_count > 0) {
+        uint32_t count = take_triggered(book, &book->buy_stops, ORDER_SIDE_BUY, 0);
+        count = take_triggered(book, &book->sell_stops, ORDER_SIDE_SELL, count);
+        if (count == 0) break;
+
+        // Stops triggered by the same trade go in the order they arrived;
+        // trades they make may trigger more, taken on the next pass
+        qsort(book->triggered, count, sizeof(*book->triggered), by_arrival);
+        for (uint32_t i = 0; i < count; i++) {
+            Order order = book->triggered[i]->order;
+            release_entry(book, book->triggered[i]);
+            trigger_order(&order);
+            orderbook_add_order(book, &order, on_fill, arg);
+            if (on_release) {
+                on_release(book, &order, arg);
+            }
+        }
+        released += count;
+    }
+    return released;
+}
+
+typedef struct {
+    OrderBook* book;
+    OrderReleaseCallback on_expire;
+    void* arg;
+} ExpirySweep;
+
+static void entry_due(TimerNode* node, void* arg) {
+    ExpirySweep* sweep = arg;
+    OrderBookEntry* entry = (OrderBookEntry*)((char*)node - offsetof(OrderBookEntry, expiry));
+    Order expired;
+    remove_entry(sweep->book, entry, &expired);
+    if (sweep->on_expire) {
+        sweep->on_expire(sweep->book, &expired, sweep->arg);
+    }
+}
+
+uint32_t orderbook_expire(OrderBook* book, uint64_t now, OrderReleaseCallback on_expire, void* arg) {
+    if (!book) return 0;
+
+    ExpirySweep sweep = { .book = book, .on_expire = on_expire, .arg = arg };
+    uint32_t expired = timer_wheel_advance(&book->expiries, now, entry_due, &sweep);
+    if (expired > 0) {
+        update_best_prices(book);
+        book->revision++;
+    }
+    atomic_store_explicit(&book->next_expiry, timer_wheel_due(&book->expiries), memory_order_relaxed);
+    return expired;
+}
+
+const OrderBookEntry* orderbook_find_order(const OrderBook* book, uint64_t order_id) {
+    if (!book) return NULL;
+
+    OrderIndexSlot* found = index_find(book, order_id);
+    return found ? found->entry : NULL;
+}
+
+void orderbook_for_each(const OrderBook* book, OrderBookVisitor visit, void* arg) {
+    if (!book || !visit) return;
+
+    const BookSide* sides[4] = { &book->bids, &book->asks, &book->buy_stops, &book->sell_stops };
+    for (int s = 0; s < 4; s++) {
+        for (uint32_t i = sides[s]->level_count; i > 0; i--) {
+            for (const OrderBookEntry* entry = sides[s]->levels[i - 1].head; entry; entry = entry->next) {
+                visit(entry, arg);
+            }
+        }
+    }
+}
+
+int orderbook_set_match_policy(OrderBook* book, MatchPolicy policy, uint32_t min_allocation,
+                               uint32_t fifo_percent) {
+    if (!book || policy >= MATCH_POLICY_COUNT || fifo_percent > 100) return ERROR_INVALID_PARAM;
+
+    // A level holds at most every order in the book
+    if (policy != MATCH_PRICE_TIME && !book->share_entries) {
+        book->share_entries = malloc((size_t)book->max_orders * sizeof(*book->share_entries));
+        book->shares = malloc((size_t)book->max_orders * sizeof(*book->shares));
+        if (!book->share_entries || !book->shares) {
+            LOG_ERROR("Failed to allocate pro-rata allocation for %s", book->symbol);
+            free(book->share_entries);
+            free(book->shares);
+            book->share_entries = NULL;
+            book->shares = NULL;
+            return ERROR_MEMORY_ALLOC;
+        }
+    }
+
+    book->match_policy = policy;
+    book->min_allocation = min_allocation;
+    book->fifo_percent = policy == MATCH_HYBRID ? fifo_percent : 0;
+    return SUCCESS;
+}
+
+#define BOOK_STATS_READ_ATTEMPTS 64
+
+static int64_t best_ticks(const BookSide* side) {
+    return side->level_count ? side->levels[side->level_count - 1].price : 0;
+}
+
+static uint64_t best_visible(const BookSide* side) {
+    return side->level_count ? side->levels[side->level_count - 1].visible_quantity : 0;
+}
+
+void orderbook_publish_stats(OrderBook* book) {
+    BookStats* stats = &book->stats;
+    __atomic_store_n(&stats->generation, stats->generation + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+
+    stats->tick_exponent = book->tick_exponent;
+    stats->bid_orders = book->bid_count;
+    stats->ask_orders = book->ask_count;
+    stats->best_bid = best_ticks(&book->bids);
+    stats->best_ask = best_ticks(&book->asks);
+    stats->best_bid_size = best_visible(&book->bids);
+    stats->best_ask_size = best_visible(&book->asks);
+    stats->orders = book->order_count;
+    stats->trades = book->trade_count;
+    stats->volume = book->total_volume;
+
+    __atomic_store_n(&stats->generation, stats->generation + 1, __ATOMIC_RELEASE);
+}
+
+int orderbook_read_stats(const OrderBook* book, BookStats* stats) {
+    // A publish is a few stores, so retry at once rather than back off
+    for (int attempt = 0; attempt < BOOK_STATS_READ_ATTEMPTS; attempt++) {
+        uint64_t before = __atomic_load_n(&book->stats.generation, __ATOMIC_ACQUIRE);
+        if (before & 1) continue;
+
+        memcpy(stats, &book->stats, sizeof(*stats));
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        if (__atomic_load_n(&book->stats.generation, __ATOMIC_RELAXED) == before) {
+            return SUCCESS;
+        }
+    }
+    return ERROR_TIMEOUT;
+}
+
+uint32_t orderbook_depth(const OrderBook* book, OrderSide side, BookDepthLevel* levels, uint32_t count) {
+    if (!book || !levels) return 0;
+
+    const BookSide* book_levels = side == ORDER_SIDE_BUY ? &book->bids : &book->asks;
+    uint32_t filled = 0;
+    for (uint32_t i = book_levels->level_count; i > 0 && filled < count; i--) {
+        const PriceLevel* level = &book_levels->levels[i - 1];
+        levels[filled].price = level->price;
+        levels[filled].quantity = level->visible_quantity;
+        levels[filled].order_count = level->order_count;
+        filled++;
+    }
+    return filled;
+}
+
+/**
+ * One pass up the crossed band, lowest price first. Demand at a price is
+ * every bid at or above it and supply every ask at or below it, so moving
+ * up a price adds that price's asks to supply and, once it has been
+ * scored, drops its bids from demand. Each price a level sits at is
+ * scored once: the executable volume, then the smaller imbalance, then
+ * the price nearest the last trade, then the lower price wins.
+ */
+int orderbook_auction_quote(const OrderBook* book, AuctionQuote* quote) {
+    if (!book || !quote) return ERROR_INVALID_PARAM;
+
+    memset(quote, 0, sizeof(*quote));
+    const BookSide* bids = &book->bids;
+    const BookSide* asks = &book->asks;
+    if (bids->level_count == 0 || asks->level_count == 0) return SUCCESS;
+
+    int64_t high = bids->levels[bids->level_count - 1].price;
+    int64_t low = asks->levels[asks->level_count - 1].price;
+    if (high < low) return SUCCESS;
+
+    // Bids below the best ask never trade; the rest start out as demand
+    uint32_t bid = bids->level_count;
+    uint64_t demand = 0;
+    while (bid > 0 && bids->levels[bid - 1].price >= low) {
+        demand += bids->levels[--bid].total_quantity;
+    }
+
+    uint32_t ask = asks->level_count;
+    uint64_t supply = 0;
+    uint64_t best_distance = UINT64_MAX;
+    uint64_t best_surplus = UINT64_MAX;
+    for (;;) {
+        int have_bid = bid < bids->level_count;
+        int have_ask = ask > 0 && asks->levels[ask - 1].price <= high;
+        if (!have_bid && !have_ask) break;
+
+        int64_t price = have_ask && (!have_bid || asks->levels[ask - 1].price <= bids->levels[bid].price) ?
+                        asks->levels[ask - 1].price : bids->levels[bid].price;
+        if (have_ask && asks->levels[ask - 1].price == price) {
+            supply += asks->levels[--ask].total_quantity;
+        }
+
+        uint64_t volume = demand < supply ? demand : supply;
+        uint64_t surplus = demand > supply ? demand - supply : supply - demand;
+        uint64_t distance = book->last_trade == 0 ? 0 :
+                            (uint64_t)(price > book->last_trade ? price - book->last_trade : book->last_trade - price);
+        if (volume > quote->volume ||
+            (volume == quote->volume && volume > 0 &&
+             (surplus < best_surplus || (surplus == best_surplus && distance < best_distance)))) {
+            quote->price = price;
+            quote->volume = volume;
+            quote->imbalance = (int64_t)demand - (int64_t)supply;
+            best_surplus = surplus;
+            best_distance = distance;
+        }
+
+        if (have_bid && bids->levels[bid].price == price) {
+            demand -= bids->levels[bid++].total_quantity;
+        }
+    }
+    return SUCCESS;
+}
+
+/**
+ * Both sides are resting orders, so neither is the aggressor: the best
+ * bid and best ask queues are walked head to head, in price then time
+ * priority, each fill reported with the buy as the aggressor and the
+ * uncross flag set. Whatever does not trade stays, uncrossed.
+ */
+uint64_t orderbook_uncross(OrderBook* book, OrderFillCallback on_fill, void* arg) {
+    if (!book) return 0;
+
+    AuctionQuote quote;
+    orderbook_auction_quote(book, &quote);
+    uint64_t remaining = quote.volume;
+    while (remaining > 0) {
+        PriceLevel* bid_level = &book->bids.levels[book->bids.level_count - 1];
+        PriceLevel* ask_level = &book->asks.levels[book->asks.level_count - 1];
+        OrderBookEntry* buy = bid_level->head;
+        OrderBookEntry* sell = ask_level->head;
+        uint32_t quantity = buy->order.remaining_quantity < sell->order.remaining_quantity ?
+                            buy->order.remaining_quantity : sell->order.remaining_quantity;
+        if (quantity > remaining) quantity = (uint32_t)remaining;
+
+        if (on_fill) {
+            OrderFill fill = {
+                .aggressor = &buy->order,
+                .resting = &sell->order,
+                .price = quote.price,
+                .quantity = quantity,
+                .uncross = 1
+            };
+            on_fill(book, &fill, arg);
+        }
+
+        fill_entry(book, bid_level, buy, quantity);
+        fill_entry(book, ask_level, sell, quantity);
+        book->total_volume += quantity;
+        book->trade_count++;
+        remaining -= quantity;
+
+        if (bid_level->order_count == 0) book->bids.level_count--;
+        if (ask_level->order_count == 0) book->asks.level_count--;
+    }
+
+    if (quote.volume > 0) {
+        book->last_trade = quote.price;
+        update_best_prices(book);
+        book->revision++;
+    }
+    return quote.volume;
+}
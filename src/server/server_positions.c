@@ -0,0 +1,344 @@
+#include "server/server.h"
+#include "common/utils.h"
+
+// Twice max_accounts rounded up to a power of two keeps probe chains short
+static uint32_t account_index_capacity(uint32_t max_accounts) {
+    uint32_t capacity = 16;
+    while (capacity < max_accounts * 2) {
+        capacity <<= 1;
+    }
+    return capacity;
+}
+
+int initialize_position_table(ServerContext* context) {
+    if (!context) return ERROR_INVALID_PARAM;
+
+    if (context->config.max_accounts == 0) {
+        context->config.max_accounts = DEFAULT_MAX_ACCOUNTS;
+    }
+    if (context->config.position_limit == 0) {
+        context->config.position_limit = DEFAULT_POSITION_LIMIT;
+    }
+    uint32_t max_accounts = context->config.max_accounts;
+    uint32_t capacity = account_index_capacity(max_accounts);
+
+    // Untouched rows stay unbacked zero pages, so the full grid costs little
+    context->positions = calloc((size_t)max_accounts * context->config.max_symbols,
+                                sizeof(ClientPosition));
+    context->holders = calloc((size_t)context->config.max_symbols * max_accounts, sizeof(uint32_t));
+    context->holder_counts = calloc(context->config.max_symbols, sizeof(uint32_t));
+    context->account_ids = calloc(max_accounts, MAX_CLIENT_ID_LENGTH);
+    context->account_index = calloc(capacity, sizeof(atomic_uint_least32_t));
+    context->exposures = aligned_alloc(_Alignof(AccountExposure), max_accounts * sizeof(AccountExposure));
+    if (context->exposures) {
+        memset(context->exposures, 0, max_accounts * sizeof(AccountExposure));
+    }
+    if (!context->positions || !context->account_ids || !context->account_index || !context->exposures ||
+        !context->holders || !context->holder_counts) {
+        LOG_ERROR("Failed to allocate positions for %u accounts", max_accounts);
+        cleanup_position_table(context);
+        return ERROR_MEMORY_ALLOC;
+    }
+
+    context->account_index_mask = capacity - 1;
+    context->account_count = 0;
+    return SUCCESS;
+}
+
+void cleanup_position_table(ServerContext* context) {
+    if (!context) return;
+
+    free(context->positions);
+    free(context->holders);
+    free(context->holder_counts);
+    free(context->exposures);
+    free(context->account_ids);
+    free(context->account_index);
+    context->positions = NULL;
+    context->holders = NULL;
+    context->holder_counts = NULL;
+    context->exposures = NULL;
+    context->account_ids = NULL;
+    context->account_index = NULL;
+    context->account_count = 0;
+}
+
+// Probe for a client; returns the slot holding it or the empty slot ending the chain
+static uint32_t probe_account(ServerContext* context, const char* client_id, uint32_t* account_id) {
+    uint32_t slot = (uint32_t)hash_string(client_id) & context->account_index_mask;
+
+    for (;;) {
+        uint32_t entry = atomic_load_explicit(&context->account_index[slot], memory_order_acquire);
+        if (entry == 0) {
+            *account_id = UINT32_MAX;
+            return slot;
+        }
+        if (strncmp(context->account_ids[entry - 1], client_id, MAX_CLIENT_ID_LENGTH) == 0) {
+            *account_id = entry - 1;
+            return slot;
+        }
+        slot = (slot + 1) & context->account_index_mask;
+    }
+}
+
+uint32_t get_or_create_account(ServerContext* context, const char* client_id) {
+    if (!context || !client_id || !context->account_index) return UINT32_MAX;
+
+    uint32_t account_id;
+    probe_account(context, client_id, &account_id);
+    if (account_id != UINT32_MAX) return account_id;
+
+    pthread_rwlock_wrlock(&context->position_lock);
+
+    // Another thread may have registered it while we waited for the lock
+    uint32_t slot = probe_account(context, client_id, &account_id);
+    if (account_id == UINT32_MAX && context->account_count < context->config.max_accounts) {
+        account_id = context->account_count++;
+        strncpy(context->account_ids[account_id], client_id, MAX_CLIENT_ID_LENGTH - 1);
+        // Publish only once the id is in place
+        atomic_store_explicit(&context->account_index[slot], account_id + 1, memory_order_release);
+    } else if (account_id == UINT32_MAX) {
+        LOG_ERROR("Account table full, cannot track positions for %s", client_id);
+    }
+    pthread_rwlock_unlock(&context->position_lock);
+
+    return account_id;
+}
+
+uint32_t find_account(ServerContext* context, const char* client_id) {
+    if (!context || !client_id || !context->account_index) return UINT32_MAX;
+
+    uint32_t account_id;
+    probe_account(context, client_id, &account_id);
+    return account_id;
+}
+
+ClientPosition* find_position(ServerContext* context, const char* client_id, uint32_t symbol_id) {
+    if (!context || !client_id || !context->account_index) return NULL;
+
+    uint32_t account_id = find_account(context, client_id);
+    return account_id == UINT32_MAX ? NULL : position_row(context, account_id, symbol_id);
+}
+
+static inline uint64_t load(const atomic_uint_least64_t* value) {
+    return atomic_load_explicit(value, memory_order_relaxed);
+}
+
+// Rows have a single writer at a time (the book lock holder), so no locked add
+static inline void bump(atomic_uint_least64_t* value, int64_t amount) {
+    atomic_store_explicit(value, load(value) + (uint64_t)amount, memory_order_relaxed);
+}
+
+static inline int64_t positive(int64_t value) {
+    return value > 0 ? value : 0;
+}
+
+static inline int64_t absolute(int64_t value) {
+    return value < 0 ? -value : value;
+}
+
+// Fold a row's cost change into its account's totals
+static void update_exposure(ServerContext* context, uint32_t account_id, int64_t old_cost, int64_t new_cost) {
+    AccountExposure* exposure = &context->exposures[account_id];
+    atomic_fetch_add_explicit(&exposure->net, new_cost - old_cost, memory_order_relaxed);
+    atomic_fetch_add_explicit(&exposure->gross, absolute(new_cost) - absolute(old_cost),
+                              memory_order_relaxed);
+    atomic_fetch_add_explicit(&exposure->long_cost, positive(new_cost) - positive(old_cost),
+                              memory_order_relaxed);
+}
+
+static void add_open_notional(ServerContext* context, uint32_t account_id, OrderSide side, int64_t notional) {
+    AccountExposure* exposure = &context->exposures[account_id];
+    atomic_fetch_add_explicit(side == ORDER_SIDE_BUY ? &exposure->open_buy : &exposure->open_sell,
+                              notional, memory_order_relaxed);
+}
+
+// Average cost: adding keeps the running cost, reducing keeps the average
+// price, and a flip through flat starts again at the fill price
+static int64_t cost_after_fill(int64_t old_position, int64_t old_cost, int64_t traded,
+                               int64_t fill_cost, int64_t new_position, int64_t fill_price_cost) {
+    if (old_position == 0 || (old_position > 0) == (traded > 0)) {
+        return old_cost + fill_cost;
+    }
+    if (new_position == 0) return 0;
+    if ((new_position > 0) == (old_position > 0)) {
+        return (int64_t)((__int128)old_cost * new_position / old_position);
+    }
+    return new_position > 0 ? fill_price_cost : -fill_price_cost;
+}
+
+static inline uint32_t* symbol_holders(ServerContext* context, uint32_t symbol_id) {
+    return &context->holders[(size_t)symbol_id * context->config.max_accounts];
+}
+
+// Keep a row in its symbol's holder list exactly while its position is open
+static void update_holders(ServerContext* context, uint32_t account_id, uint32_t symbol_id,
+                           ClientPosition* row, int64_t position) {
+    uint32_t* holders = symbol_holders(context, symbol_id);
+    uint32_t* count = &context->holder_counts[symbol_id];
+
+    if (position != 0 && row->holder_slot == 0) {
+        holders[*count] = account_id;
+        row->holder_slot = ++*count;
+    } else if (position == 0 && row->holder_slot != 0) {
+        // Swap the last holder into the freed place
+        uint32_t moved = holders[--*count];
+        holders[row->holder_slot - 1] = moved;
+        position_row(context, moved, symbol_id)->holder_slot = row->holder_slot;
+        row->holder_slot = 0;
+    }
+}
+
+static inline void add_pnl(atomic_int_least64_t* total, int64_t amount) {
+    atomic_fetch_add_explicit(total, amount, memory_order_relaxed);
+}
+
+// Value a row at a price in ticks and fold the change into its account's total
+static void mark_row(ServerContext* context, const OrderBook* book, uint32_t account_id,
+                     ClientPosition* row, int64_t price) {
+    int64_t position = atomic_load_explicit(&row->position, memory_order_relaxed);
+    int64_t value = position_notional(price, (uint64_t)absolute(position), book->tick_exponent);
+    int64_t unrealized = (position < 0 ? -value : value) -
+                         atomic_load_explicit(&row->cost, memory_order_relaxed);
+    int64_t old = atomic_load_explicit(&row->unrealized_pnl, memory_order_relaxed);
+    if (unrealized == old) return;
+
+    atomic_store_explicit(&row->unrealized_pnl, unrealized, memory_order_relaxed);
+    add_pnl(&context->exposures[account_id].unrealized_pnl, unrealized - old);
+}
+
+// Profit of the part of a position a fill closed: what it traded for less what it cost
+static int64_t realized_on_fill(int64_t old_position, int64_t old_cost, int64_t new_position,
+                                int64_t new_cost, int64_t price, uint32_t quantity,
+                                int32_t tick_exponent) {
+    int64_t closed = absolute(old_position) < quantity ? absolute(old_position) : quantity;
+    int64_t value = position_notional(price, (uint64_t)closed, tick_exponent);
+    int reduced_only = new_position != 0 && (new_position > 0) == (old_position > 0);
+    int64_t closed_cost = reduced_only ? old_cost - new_cost : old_cost;
+    return (old_position > 0 ? value : -value) - closed_cost;
+}
+
+static void apply_fill_side(ServerContext* context, const OrderBook* book, const Order* order,
+                            int64_t price, uint32_t quantity, int resting) {
+    uint32_t account_id = get_or_create_account(context, order->client_id);
+    if (account_id == UINT32_MAX) return;
+
+    ClientPosition* row = position_row(context, account_id, book->symbol_id);
+    int64_t traded = order->side == ORDER_SIDE_BUY ? quantity : -(int64_t)quantity;
+    int64_t fill_notional = position_notional(price, quantity, book->tick_exponent);
+    int64_t old_position = atomic_load_explicit(&row->position, memory_order_relaxed);
+    int64_t old_cost = atomic_load_explicit(&row->cost, memory_order_relaxed);
+    int64_t new_position = old_position + traded;
+    int64_t new_cost = cost_after_fill(old_position, old_cost, traded,
+                                       traded > 0 ? fill_notional : -fill_notional, new_position,
+                                       position_notional(price, (uint64_t)absolute(new_position),
+                                                         book->tick_exponent));
+
+    atomic_store_explicit(&row->position, new_position, memory_order_relaxed);
+    atomic_store_explicit(&row->cost, new_cost, memory_order_relaxed);
+    bump(&row->total_volume, quantity);
+    update_exposure(context, account_id, old_cost, new_cost);
+
+    if (old_position != 0 && (old_position > 0) != (traded > 0)) {
+        int64_t realized = realized_on_fill(old_position, old_cost, new_position, new_cost,
+                                            price, quantity, book->tick_exponent);
+        atomic_store_explicit(&row->realized_pnl,
+                              atomic_load_explicit(&row->realized_pnl, memory_order_relaxed) + realized,
+                              memory_order_relaxed);
+        add_pnl(&context->exposures[account_id].realized_pnl, realized);
+    }
+
+    // The row is valued at its own fill; the caller re-marks the symbol if the
+    // batch traded away from the previous mark
+    update_holders(context, account_id, book->symbol_id, row, new_position);
+    mark_row(context, book, account_id, row, price);
+
+    // A resting order was added to the open totals at its limit price: the
+    // fill price, except in an uncross
+    int64_t limit;
+    if (resting && price_to_ticks(order->price, book->tick_exponent, &limit) == 0) {
+        bump(order->side == ORDER_SIDE_BUY ? &row->open_buy : &row->open_sell, -(int64_t)quantity);
+        add_open_notional(context, account_id, order->side,
+                          limit == price ? -fill_notional : -position_notional(limit, quantity, book->tick_exponent));
+    }
+}
+
+void position_apply_fill(ServerContext* context, const OrderBook* book, const OrderFill* fill) {
+    apply_fill_side(context, book, fill->aggressor, fill->price, fill->quantity, fill->uncross);
+    apply_fill_side(context, book, fill->resting, fill->price, fill->quantity, 1);
+}
+
+void position_mark(ServerContext* context, OrderBook* book, int64_t price) {
+    atomic_store_explicit(&book->mark, price, memory_order_relaxed);
+
+    const uint32_t* holders = symbol_holders(context, book->symbol_id);
+    uint32_t count = context->holder_counts[book->symbol_id];
+    for (uint32_t i = 0; i < count; i++) {
+        mark_row(context, book, holders[i], position_row(context, holders[i], book->symbol_id), price);
+    }
+}
+
+void position_add_open(ServerContext* context, const OrderBook* book, const Order* order,
+                       int64_t quantity) {
+    // A pending stop is not open interest until it triggers
+    if (quantity == 0 || order->type == ORDER_TYPE_STOP || order->type == ORDER_TYPE_STOP_LIMIT) return;
+
+    uint32_t account_id = get_or_create_account(context, order->client_id);
+    if (account_id == UINT32_MAX) return;
+
+    ClientPosition* row = position_row(context, account_id, book->symbol_id);
+    bump(order->side == ORDER_SIDE_BUY ? &row->open_buy : &row->open_sell, quantity);
+
+    int64_t price_ticks;
+    if (price_to_ticks(order->price, book->tick_exponent, &price_ticks) == 0) {
+        int64_t notional = position_notional(price_ticks, (uint64_t)absolute(quantity), book->tick_exponent);
+        add_open_notional(context, account_id, order->side, quantity > 0 ? notional : -notional);
+    }
+}
+
+void position_restore(ServerContext* context, uint32_t account_id, uint32_t symbol_id,
+                      int64_t position, int64_t cost, int64_t realized_pnl, uint64_t total_volume) {
+    ClientPosition* row = position_row(context, account_id, symbol_id);
+    int64_t old_cost = atomic_load_explicit(&row->cost, memory_order_relaxed);
+    int64_t old_realized = atomic_load_explicit(&row->realized_pnl, memory_order_relaxed);
+    atomic_store_explicit(&row->position, position, memory_order_relaxed);
+    atomic_store_explicit(&row->cost, cost, memory_order_relaxed);
+    atomic_store_explicit(&row->total_volume, total_volume, memory_order_relaxed);
+    atomic_store_explicit(&row->realized_pnl, realized_pnl, memory_order_relaxed);
+    update_exposure(context, account_id, old_cost, cost);
+    add_pnl(&context->exposures[account_id].realized_pnl, realized_pnl - old_realized);
+    update_holders(context, account_id, symbol_id, row, position);
+}
+
+int position_report(ServerContext* context, const char* client_id, const OrderBook* book,
+                    PnlReport* report) {
+    if (!context || !client_id || !report) return ERROR_INVALID_PARAM;
+
+    uint32_t account_id = find_account(context, client_id);
+    if (account_id == UINT32_MAX) return ERROR_ACCOUNT_NOT_FOUND;
+
+    memset(report, 0, sizeof(*report));
+    strncpy(report->client_id, client_id, MAX_CLIENT_ID_LENGTH - 1);
+    report->timestamp = clock_frame_time();
+    const atomic_int_least64_t* realized = &context->exposures[account_id].realized_pnl;
+    const atomic_int_least64_t* unrealized = &context->exposures[account_id].unrealized_pnl;
+
+    if (book) {
+        const ClientPosition* row = position_row(context, account_id, book->symbol_id);
+        int64_t position = atomic_load_explicit(&row->position, memory_order_relaxed);
+        int64_t cost = atomic_load_explicit(&row->cost, memory_order_relaxed);
+        memcpy(report->symbol, book->symbol, MAX_SYMBOL_LENGTH);
+        report->position = position;
+        report->mark = price_from_ticks(atomic_load_explicit(&book->mark, memory_order_relaxed),
+                                        book->tick_exponent);
+        if (position != 0) {
+            __int128 scaled = (__int128)absolute(cost) * PRICE_POW10[NOTIONAL_EXPONENT - AVERAGE_PRICE_EXPONENT];
+            report->average_price = create_price((int64_t)(scaled / absolute(position)), AVERAGE_PRICE_EXPONENT);
+        }
+        realized = &row->realized_pnl;
+        unrealized = &row->unrealized_pnl;
+    }
+    report->realized_pnl = create_price(atomic_load_explicit(realized, memory_order_relaxed), NOTIONAL_EXPONENT);
+    report->unrealized_pnl = create_price(atomic_load_explicit(unrealized, memory_order_relaxed), NOTIONAL_EXPONENT);
+    return SUCCESS;
+}
@@ -0,0 +1,299 @@
+#include "server/server.h"
+#include <math.h>
+
+#define RISK_MAX_LINE 512
+
+static const char* const check_names[RISK_CHECK_COUNT] = {
+    [RISK_CHECK_QUANTITY] = "quantity",
+    [RISK_CHECK_NOTIONAL] = "notional",
+    [RISK_CHECK_COLLAR] = "collar",
+    [RISK_CHECK_POSITION] = "position",
+    [RISK_CHECK_NET] = "net",
+    [RISK_CHECK_GROSS] = "gross",
+    [RISK_CHECK_CREDIT] = "credit"
+};
+
+const char* risk_check_name(RiskCheck check) {
+    return check < RISK_CHECK_COUNT ? check_names[check] : "unknown";
+}
+
+// Header and both row arrays in one block, so a table is freed in one go
+static RiskLimits* allocate_limits(uint32_t symbol_rows, uint32_t client_rows) {
+    size_t size = sizeof(RiskLimits) + symbol_rows * sizeof(SymbolRiskLimits) +
+                  client_rows * sizeof(ClientRiskLimits);
+    RiskLimits* limits = calloc(1, size);
+    if (!limits) return NULL;
+
+    limits->symbol_rows = symbol_rows;
+    limits->client_rows = client_rows;
+    limits->symbols = (SymbolRiskLimits*)(limits + 1);
+    limits->clients = (ClientRiskLimits*)(limits->symbols + symbol_rows);
+    return limits;
+}
+
+static int parse_count(const char* value, uint32_t* out) {
+    char* end;
+    unsigned long parsed = strtoul(value, &end, 10);
+    if (*value == '\0' || *end != '\0' || parsed > UINT32_MAX) return ERROR_CONFIG_INVALID;
+    *out = (uint32_t)parsed;
+    return SUCCESS;
+}
+
+// Decimal currency amount to NOTIONAL_EXPONENT units
+static int parse_notional(const char* value, int64_t* out) {
+    char* end;
+    double parsed = strtod(value, &end);
+    double scaled = parsed * (double)PRICE_POW10[-NOTIONAL_EXPONENT];
+    if (*value == '\0' || *end != '\0' || !(scaled >= 0) || scaled >= (double)INT64_MAX) {
+        return ERROR_CONFIG_INVALID;
+    }
+    *out = llround(scaled);
+    return SUCCESS;
+}
+
+static int apply_symbol_field(SymbolRiskLimits* row, const char* key, const char* value) {
+    if (strcmp(key, "max_qty") == 0) return parse_count(value, &row->max_order_quantity);
+    if (strcmp(key, "collar_bps") == 0) return parse_count(value, &row->collar_bps);
+    if (strcmp(key, "max_notional") == 0) return parse_notional(value, &row->max_order_notional);
+    return ERROR_CONFIG_INVALID;
+}
+
+static int apply_client_field(ClientRiskLimits* row, const char* key, const char* value) {
+    if (strcmp(key, "max_qty") == 0) return parse_count(value, &row->max_order_quantity);
+    if (strcmp(key, "position") == 0) return parse_count(value, &row->position_limit);
+    if (strcmp(key, "max_notional") == 0) return parse_notional(value, &row->max_order_notional);
+    if (strcmp(key, "net") == 0) return parse_notional(value, &row->max_net_exposure);
+    if (strcmp(key, "gross") == 0) return parse_notional(value, &row->max_gross_exposure);
+    if (strcmp(key, "credit") == 0) return parse_notional(value, &row->credit_limit);
+    return ERROR_CONFIG_INVALID;
+}
+
+/**
+ * Apply one rule line. Pass 0 applies only '*' rules to the defaults, pass
+ * 1 only named rules to rows already holding the defaults, so a named rule
+ * overrides just the fields it lists wherever it appears in the file.
+ */
+static int apply_rule(ServerContext* context, RiskLimits* limits, char* line, int pass) {
+    char* comment = strchr(line, '#');
+    if (comment) *comment = '\0';
+
+    char* save = NULL;
+    char* scope = strtok_r(line, " \t\r\n", &save);
+    if (!scope) return SUCCESS;
+    char* name = strtok_r(NULL, " \t\r\n", &save);
+    if (!name) return ERROR_CONFIG_INVALID;
+
+    int is_symbol = strcmp(scope, "symbol") == 0;
+    if (!is_symbol && strcmp(scope, "client") != 0) return ERROR_CONFIG_INVALID;
+    int is_default = strcmp(name, "*") == 0;
+    if (is_default != (pass == 0)) return SUCCESS;
+
+    SymbolRiskLimits* symbol_row = NULL;
+    ClientRiskLimits* client_row = NULL;
+    if (is_symbol) {
+        OrderBook* book = is_default ? NULL : get_or_create_order_book(context, name);
+        if (!is_default && (!book || book->symbol_id >= limits->symbol_rows)) return ERROR_CONFIG_INVALID;
+        symbol_row = is_default ? &limits->symbol_default : &limits->symbols[book->symbol_id];
+    } else {
+        uint32_t account_id = is_default ? 0 : get_or_create_account(context, name);
+        if (!is_default && account_id >= limits->client_rows) return ERROR_CONFIG_INVALID;
+        client_row = is_default ? &limits->client_default : &limits->clients[account_id];
+    }
+
+    char* field;
+    while ((field = strtok_r(NULL, " \t\r\n", &save)) != NULL) {
+        char* value = strchr(field, '=');
+        if (!value) return ERROR_CONFIG_INVALID;
+        *value++ = '\0';
+        int result = is_symbol ? apply_symbol_field(symbol_row, field, value)
+                               : apply_client_field(client_row, field, value);
+        if (result != SUCCESS) return result;
+    }
+    return SUCCESS;
+}
+
+static int read_rules(ServerContext* context, RiskLimits* limits, const char* path) {
+    FILE* file = fopen(path, "r");
+    if (!file) {
+        LOG_ERROR("Cannot open risk limits %s: %s", path, strerror(errno));
+        return ERROR_INVALID_PARAM;
+    }
+
+    char line[RISK_MAX_LINE];
+    int result = SUCCESS;
+    for (int pass = 0; pass < 2 && result == SUCCESS; pass++) {
+        if (pass == 1) {
+            // Every row starts from the defaults the first pass settled
+            for (uint32_t i = 0; i < limits->symbol_rows; i++) limits->symbols[i] = limits->symbol_default;
+            for (uint32_t i = 0; i < limits->client_rows; i++) limits->clients[i] = limits->client_default;
+            rewind(file);
+        }
+        for (int number = 1; fgets(line, sizeof(line), file); number++) {
+            if (apply_rule(context, limits, line, pass) != SUCCESS) {
+                LOG_ERROR("Invalid risk rule at %s:%d", path, number);
+                result = ERROR_CONFIG_INVALID;
+                break;
+            }
+        }
+    }
+    fclose(file);
+    return result;
+}
+
+int risk_load_limits(ServerContext* context) {
+    if (!context) return ERROR_INVALID_PARAM;
+
+    RiskLimits* limits = allocate_limits(context->config.max_symbols, context->config.max_accounts);
+    if (!limits) return ERROR_MEMORY_ALLOC;
+    limits->symbol_default.max_order_quantity = DEFAULT_MAX_ORDER_QUANTITY;
+    limits->client_default.position_limit = context->config.position_limit;
+
+    const char* path = context->config.risk_limits_file;
+    if (path[0] != '\0') {
+        int result = read_rules(context, limits, path);
+        if (result != SUCCESS) {
+            free(limits);
+            return result;
+        }
+    } else {
+        for (uint32_t i = 0; i < limits->symbol_rows; i++) limits->symbols[i] = limits->symbol_default;
+        for (uint32_t i = 0; i < limits->client_rows; i++) limits->clients[i] = limits->client_default;
+    }
+
+    // Readers may still hold the old table, so it is retired rather than freed
+    limits->retired = atomic_exchange_explicit(&context->risk_limits, limits, memory_order_acq_rel);
+    LOG_INFO("Risk limits loaded from %s", path[0] != '\0' ? path : "defaults");
+    return SUCCESS;
+}
+
+void risk_cleanup(ServerContext* context) {
+    if (!context) return;
+
+    RiskLimits* limits = atomic_exchange(&context->risk_limits, NULL);
+    while (limits) {
+        RiskLimits* retired = limits->retired;
+        free(limits);
+        limits = retired;
+    }
+}
+
+static inline int over(int64_t amount, int64_t limit) {
+    return limit > 0 && amount > limit;
+}
+
+static inline int64_t total(int64_t a, int64_t b) {
+    int64_t sum;
+    return __builtin_add_overflow(a, b, &sum) ? INT64_MAX : sum;
+}
+
+// A modify (replaces set) is checked on its whole new size per order, and
+// on what it adds over what the resting order has open for the exposures
+static RiskCheck first_failure(ServerContext* context, const OrderBook* book, const Order* order,
+                               const Order* replaces, int64_t last_price) {
+    const RiskLimits* limits = atomic_load_explicit(&context->risk_limits, memory_order_acquire);
+    const SymbolRiskLimits* symbol = book->symbol_id < limits->symbol_rows ?
+                                     &limits->symbols[book->symbol_id] : &limits->symbol_default;
+    uint32_t account_id = find_account(context, order->client_id);
+    const ClientRiskLimits* client = account_id < limits->client_rows ?
+                                     &limits->clients[account_id] : &limits->client_default;
+    int buy = order->side == ORDER_SIDE_BUY;
+
+    if (over(order->quantity, symbol->max_order_quantity) ||
+        over(order->quantity, client->max_order_quantity)) {
+        return RISK_CHECK_QUANTITY;
+    }
+
+    // Market orders are valued at the last trade, and pass unvalued before the first
+    int64_t price = last_price;
+    int limit_priced = order->type == ORDER_TYPE_LIMIT || order->type == ORDER_TYPE_STOP_LIMIT;
+    if (limit_priced && price_to_ticks(order->price, book->tick_exponent, &price) < 0) {
+        price = last_price;
+    }
+    int64_t notional = position_notional(price, order->quantity, book->tick_exponent);
+    if (over(notional, symbol->max_order_notional) || over(notional, client->max_order_notional)) {
+        return RISK_CHECK_NOTIONAL;
+    }
+
+    if (limit_priced && symbol->collar_bps > 0 && last_price > 0) {
+        __int128 distance = price > last_price ? price - last_price : last_price - price;
+        if (distance * 10000 > (__int128)last_price * symbol->collar_bps) {
+            return RISK_CHECK_COLLAR;
+        }
+    }
+
+    // What a modify leaves open after the resting order's fills replaces
+    // what it has open now; a pending stop has nothing open to give back
+    int64_t adding = order->quantity, adding_notional = notional;
+    int64_t released = 0, released_notional = 0;
+    if (replaces) {
+        adding = order->quantity > replaces->filled_quantity ?
+                 order->quantity - replaces->filled_quantity : 0;
+        adding_notional = position_notional(price, adding, book->tick_exponent);
+        int64_t resting_price;
+        if (replaces->type != ORDER_TYPE_STOP && replaces->type != ORDER_TYPE_STOP_LIMIT &&
+            price_to_ticks(replaces->price, book->tick_exponent, &resting_price) == 0) {
+            released = replaces->remaining_quantity;
+            released_notional = position_notional(resting_price, released, book->tick_exponent);
+        }
+        // Shrinking or repricing inward never adds exposure
+        if (adding <= released && adding_notional <= released_notional) return RISK_CHECK_COUNT;
+    }
+
+    // A client without an account has no position and nothing resting
+    int64_t position = 0, open = 0;
+    int64_t net = 0, gross = 0, long_cost = 0, open_buy = 0, open_sell = 0;
+    if (account_id != UINT32_MAX) {
+        const ClientPosition* row = position_row(context, account_id, book->symbol_id);
+        position = atomic_load_explicit(&row->position, memory_order_relaxed);
+        open = (int64_t)atomic_load_explicit(buy ? &row->open_buy : &row->open_sell, memory_order_relaxed);
+
+        const AccountExposure* exposure = &context->exposures[account_id];
+        net = atomic_load_explicit(&exposure->net, memory_order_relaxed);
+        gross = atomic_load_explicit(&exposure->gross, memory_order_relaxed);
+        long_cost = atomic_load_explicit(&exposure->long_cost, memory_order_relaxed);
+        open_buy = atomic_load_explicit(&exposure->open_buy, memory_order_relaxed);
+        open_sell = atomic_load_explicit(&exposure->open_sell, memory_order_relaxed);
+    }
+
+    open -= released;
+    if (buy) open_buy -= released_notional;
+    else open_sell -= released_notional;
+    notional = adding_notional;
+
+    // Every resting order on the order's side is counted as if it filled
+    if (over((buy ? position : -position) + open + adding, client->position_limit)) {
+        return RISK_CHECK_POSITION;
+    }
+    if (over(total(buy ? net + open_buy : open_sell - net, notional), client->max_net_exposure)) {
+        return RISK_CHECK_NET;
+    }
+    if (over(total(gross + open_buy + open_sell, notional), client->max_gross_exposure)) {
+        return RISK_CHECK_GROSS;
+    }
+    if (buy && over(total(long_cost + open_buy, notional), client->credit_limit)) {
+        return RISK_CHECK_CREDIT;
+    }
+    return RISK_CHECK_COUNT;
+}
+
+static int finish_check(ServerContext* context, const Order* order, RiskCheck check,
+                        RiskCheck* failed) {
+    if (failed) *failed = check;
+    if (check == RISK_CHECK_COUNT) return SUCCESS;
+
+    atomic_fetch_add_explicit(&context->stats.risk_rejects[check], 1, memory_order_relaxed);
+    LOG_WARN("Order %lu from %s in %s failed the %s check",
+             order->order_id, order->client_id, order->symbol, risk_check_name(check));
+    return check == RISK_CHECK_POSITION ? ERROR_POSITION_LIMIT : ERROR_RISK_LIMIT;
+}
+
+int risk_check_order(ServerContext* context, const OrderBook* book, const Order* order,
+                     int64_t last_price, RiskCheck* failed) {
+    return finish_check(context, order, first_failure(context, book, order, NULL, last_price), failed);
+}
+
+int risk_check_modify(ServerContext* context, const OrderBook* book, const Order* terms,
+                      const Order* resting, int64_t last_price, RiskCheck* failed) {
+    return finish_check(context, terms,
+                        first_failure(context, book, terms, resting, last_price), failed);
+}
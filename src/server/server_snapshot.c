@@ -0,0 +1,460 @@
+#include "server/server.h"
+#include "server/server_snapshot.h"
+#include <dirent.h>
+#include <fcntl.h>
+
+#define SNAPSHOT_PREFIX "snapshot-"
+#define SNAPSHOT_SUFFIX ".bin"
+#define SNAPSHOT_IO_BUFFER (1 << 20)
+
+typedef struct {
+    Order* orders;
+    uint32_t count;
+    uint32_t capacity;
+} OrderCopy;
+
+static void copy_entry(const OrderBookEntry* entry, void* arg) {
+    OrderCopy* copy = arg;
+    copy->orders[copy->count++] = entry->order;
+}
+
+// Non-flat positions of every account in one symbol; the caller holds its book lock
+static uint32_t copy_positions(ServerContext* context, const OrderBook* book,
+                               uint32_t account_count, SnapshotPosition* positions) {
+    uint32_t count = 0;
+    for (uint32_t account_id = 0; account_id < account_count; account_id++) {
+        const ClientPosition* row = find_position(context, context->account_ids[account_id],
+                                                  book->symbol_id);
+        int64_t position = atomic_load_explicit(&row->position, memory_order_relaxed);
+        uint64_t volume = atomic_load_explicit(&row->total_volume, memory_order_relaxed);
+        if (position == 0 && volume == 0) continue;
+
+        memcpy(positions[count].client_id, context->account_ids[account_id], MAX_CLIENT_ID_LENGTH);
+        positions[count].position = position;
+        positions[count].cost = atomic_load_explicit(&row->cost, memory_order_relaxed);
+        positions[count].realized_pnl = atomic_load_explicit(&row->realized_pnl, memory_order_relaxed);
+        positions[count].total_volume = volume;
+        count++;
+    }
+    return count;
+}
+
+static int is_snapshot_name(const char* name) {
+    size_t length = strlen(name);
+    size_t prefix = strlen(SNAPSHOT_PREFIX);
+    size_t suffix = strlen(SNAPSHOT_SUFFIX);
+    return length > prefix + suffix &&
+           strncmp(name, SNAPSHOT_PREFIX, prefix) == 0 &&
+           strcmp(name + length - suffix, SNAPSHOT_SUFFIX) == 0;
+}
+
+static int compare_names_descending(const void* a, const void* b) {
+    return -strcmp(*(char* const*)a, *(char* const*)b);
+}
+
+// Snapshot file names, newest first; names are zero-padded so they sort by sequence
+static char** list_snapshots(const char* directory, size_t* count) {
+    *count = 0;
+    DIR* dir = opendir(directory);
+    if (!dir) return NULL;
+
+    char** names = NULL;
+    size_t capacity = 0;
+    struct dirent* entry;
+    while ((entry = readdir(dir)) != NULL) {
+        if (!is_snapshot_name(entry->d_name)) continue;
+        if (*count == capacity) {
+            capacity = capacity ? capacity * 2 : 8;
+            char** grown = realloc(names, capacity * sizeof(char*));
+            if (!grown) break;
+            names = grown;
+        }
+        names[(*count)++] = strdup(entry->d_name);
+    }
+    closedir(dir);
+
+    if (names) {
+        qsort(names, *count, sizeof(char*), compare_names_descending);
+    }
+    return names;
+}
+
+static void free_names(char** names, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        free(names[i]);
+    }
+    free(names);
+}
+
+static void prune_snapshots(const char* directory) {
+    size_t count;
+    char** names = list_snapshots(directory, &count);
+    char path[512];
+
+    for (size_t i = SNAPSHOT_RETAIN; i < count; i++) {
+        snprintf(path, sizeof(path), "%s/%s", directory, names[i]);
+        unlink(path);
+    }
+    free_names(names, count);
+}
+
+static void sync_directory(const char* directory) {
+    int fd = open(directory, O_RDONLY | O_DIRECTORY);
+    if (fd >= 0) {
+        fsync(fd);
+        close(fd);
+    }
+}
+
+int snapshot_write(ServerContext* context) {
+    if (!context || context->config.snapshot_dir[0] == '\0') return ERROR_INVALID_PARAM;
+
+    const char* directory = context->config.snapshot_dir;
+    uint64_t start = clock_ticks();
+    char temp_path[512];
+    char final_path[512];
+    snprintf(temp_path, sizeof(temp_path), "%s/snapshot.tmp", directory);
+
+    FILE* file = fopen(temp_path, "wb");
+    if (!file) {
+        LOG_ERROR("Failed to create snapshot %s: %s", temp_path, strerror(errno));
+        return ERROR_INVALID_STATE;
+    }
+    setvbuf(file, NULL, _IOFBF, SNAPSHOT_IO_BUFFER);
+
+    // Every event up to here is in the copies below; later ones may be too,
+    // which restore detects from each book's own journal position
+    SnapshotFileHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic));
+    header.version = SNAPSHOT_VERSION;
+    header.created_ns = clock_now_ns();
+    header.journal_sequence = journal_last_sequence(context->journal);
+    header.next_order_id = atomic_load(&context->next_order_id);
+    header.next_trade_id = atomic_load(&context->next_trade_id);
+
+    pthread_rwlock_rdlock(&context->order_book_lock);
+    header.book_count = context->symbol_count;
+    pthread_rwlock_unlock(&context->order_book_lock);
+
+    fwrite(&header, sizeof(header), 1, file);
+
+    OrderCopy copy = { .orders = NULL, .count = 0, .capacity = 0 };
+    int result = SUCCESS;
+
+    // Accounts registered after this point have not traded in any copied book
+    pthread_rwlock_rdlock(&context->position_lock);
+    uint32_t account_count = context->account_count;
+    pthread_rwlock_unlock(&context->position_lock);
+    SnapshotPosition* positions = malloc((account_count ? account_count : 1) * sizeof(SnapshotPosition));
+    if (!positions) {
+        result = ERROR_MEMORY_ALLOC;
+    }
+
+    for (uint32_t i = 0; i < header.book_count && result == SUCCESS; i++) {
+        OrderBook* book = &context->order_books[i];
+        SnapshotBookHeader book_header;
+        memset(&book_header, 0, sizeof(book_header));
+
+        // Quiesce only this book, and only for a memcpy of its orders
+        pthread_rwlock_rdlock(&book->lock);
+        uint32_t resting = book->bid_count + book->ask_count + book->stop_count;
+        if (resting > copy.capacity) {
+            Order* grown = realloc(copy.orders, resting * sizeof(Order));
+            if (!grown) {
+                pthread_rwlock_unlock(&book->lock);
+                result = ERROR_MEMORY_ALLOC;
+                break;
+            }
+            copy.orders = grown;
+            copy.capacity = resting;
+        }
+        copy.count = 0;
+        orderbook_for_each(book, copy_entry, &copy);
+        memcpy(book_header.symbol, book->symbol, MAX_SYMBOL_LENGTH);
+        book_header.tick_exponent = book->tick_exponent;
+        book_header.last_journal_sequence = book->last_journal_sequence;
+        book_header.total_volume = book->total_volume;
+        book_header.last_trade = book->last_trade;
+        book_header.phase = book->phase;
+        book_header.call_ends = book->call_ends;
+        book_header.position_count = copy_positions(context, book, account_count, positions);
+        // Trades reach the market data under the book lock, so this holds
+        // those up to last_journal_sequence and no later ones
+        get_symbol_market_data(context, book, &book_header.market_data);
+        pthread_rwlock_unlock(&book->lock);
+
+        book_header.order_count = copy.count;
+        header.order_count += copy.count;
+
+        fwrite(&book_header, sizeof(book_header), 1, file);
+        fwrite(copy.orders, sizeof(Order), copy.count, file);
+        fwrite(positions, sizeof(SnapshotPosition), book_header.position_count, file);
+    }
+    free(copy.orders);
+    free(positions);
+
+    SnapshotFileTrailer trailer;
+    memcpy(trailer.magic, SNAPSHOT_END_MAGIC, sizeof(trailer.magic));
+    trailer.order_count = header.order_count;
+    fwrite(&trailer, sizeof(trailer), 1, file);
+
+    // Rewrite the header now that the counts are known
+    fseek(file, 0, SEEK_SET);
+    fwrite(&header, sizeof(header), 1, file);
+
+    if (result == SUCCESS && (fflush(file) != 0 || ferror(file) || fsync(fileno(file)) != 0)) {
+        LOG_ERROR("Failed to write snapshot %s: %s", temp_path, strerror(errno));
+        result = ERROR_INVALID_STATE;
+    }
+    fclose(file);
+
+    if (result != SUCCESS) {
+        unlink(temp_path);
+        return result;
+    }
+
+    snprintf(final_path, sizeof(final_path), "%s/" SNAPSHOT_PREFIX "%020lu" SNAPSHOT_SUFFIX,
+             directory, header.journal_sequence);
+    if (rename(temp_path, final_path) != 0) {
+        LOG_ERROR("Failed to publish snapshot %s: %s", final_path, strerror(errno));
+        unlink(temp_path);
+        return ERROR_INVALID_STATE;
+    }
+    sync_directory(directory);
+    prune_snapshots(directory);
+
+    uint64_t elapsed_us = clock_ticks_to_ns(clock_ticks() - start) / NANOS_PER_MICRO;
+    LOG_INFO("Snapshot %s: %u books, %lu orders in %lu us", final_path, header.book_count,
+             header.order_count, elapsed_us);
+    return SUCCESS;
+}
+
+static int load_snapshot(ServerContext* context, const char* path, SnapshotFileHeader* header) {
+    FILE* file = fopen(path, "rb");
+    if (!file) return ERROR_INVALID_STATE;
+    setvbuf(file, NULL, _IOFBF, SNAPSHOT_IO_BUFFER);
+
+    int result = SUCCESS;
+    if (fread(header, sizeof(*header), 1, file) != 1 ||
+        memcmp(header->magic, SNAPSHOT_MAGIC, sizeof(header->magic)) != 0 ||
+        header->version != SNAPSHOT_VERSION) {
+        fclose(file);
+        return ERROR_INVALID_STATE;
+    }
+
+    Order order;
+    for (uint32_t i = 0; i < header->book_count && result == SUCCESS; i++) {
+        SnapshotBookHeader book_header;
+        if (fread(&book_header, sizeof(book_header), 1, file) != 1) {
+            result = ERROR_INVALID_STATE;
+            break;
+        }
+
+        book_header.symbol[MAX_SYMBOL_LENGTH - 1] = '\0';
+        if (set_symbol_tick_exponent(context, book_header.symbol, book_header.tick_exponent) != SUCCESS) {
+            result = ERROR_INVALID_STATE;
+            break;
+        }
+        OrderBook* book = find_order_book(context, book_header.symbol);
+
+        for (uint32_t j = 0; j < book_header.order_count; j++) {
+            if (fread(&order, sizeof(order), 1, file) != 1 ||
+                orderbook_restore_order(book, &order) != SUCCESS) {
+                result = ERROR_INVALID_STATE;
+                break;
+            }
+            position_add_open(context, book, &order, order.remaining_quantity);
+        }
+
+        SnapshotPosition saved;
+        for (uint32_t j = 0; j < book_header.position_count && result == SUCCESS; j++) {
+            if (fread(&saved, sizeof(saved), 1, file) != 1) {
+                result = ERROR_INVALID_STATE;
+                break;
+            }
+            saved.client_id[MAX_CLIENT_ID_LENGTH - 1] = '\0';
+            uint32_t account_id = get_or_create_account(context, saved.client_id);
+            if (account_id != UINT32_MAX) {
+                position_restore(context, account_id, book->symbol_id, saved.position,
+                                 saved.cost, saved.realized_pnl, saved.total_volume);
+            }
+        }
+
+        book->last_journal_sequence = book_header.last_journal_sequence;
+        book->total_volume = book_header.total_volume;
+        book->last_trade = book_header.last_trade;
+        book->phase = book_header.phase == BOOK_PHASE_CALL ? BOOK_PHASE_CALL : BOOK_PHASE_CONTINUOUS;
+        book->call_ends = book_header.call_ends;
+        pthread_rwlock_wrlock(&context->market_data_lock);
+        context->market_data_cache[book->symbol_id] = book_header.market_data;
+        pthread_rwlock_unlock(&context->market_data_lock);
+    }
+
+    SnapshotFileTrailer trailer;
+    if (result == SUCCESS &&
+        (fread(&trailer, sizeof(trailer), 1, file) != 1 ||
+         memcmp(trailer.magic, SNAPSHOT_END_MAGIC, sizeof(trailer.magic)) != 0 ||
+         trailer.order_count != header->order_count)) {
+        result = ERROR_INVALID_STATE;
+    }
+    fclose(file);
+    return result;
+}
+
+// Drop everything loaded so far so a fallback snapshot starts clean
+static void reset_books(ServerContext* context) {
+    cleanup_position_table(context);
+    cleanup_symbol_table(context);
+    initialize_symbol_table(context);
+    initialize_position_table(context);
+}
+
+typedef struct {
+    ServerContext* context;
+    uint64_t max_order_id;
+    uint64_t max_trade_id;
+    uint64_t applied;
+} ReplayState;
+
+static void replay_fill(OrderBook* book, const OrderFill* fill, void* arg) {
+    position_apply_fill(arg, book, fill);
+}
+
+static void replay_release(OrderBook* book, const Order* order, void* arg) {
+    const OrderBookEntry* rested = orderbook_find_order(book, order->order_id);
+    if (rested) {
+        position_add_open(arg, book, &rested->order, rested->order.remaining_quantity);
+    }
+}
+
+static int replay_record(const JournalRecord* record, void* arg) {
+    ReplayState* state = arg;
+    ServerContext* context = state->context;
+
+    if (record->type == JOURNAL_TRADE) {
+        const TradeExecution* trade = &record->data.trade;
+        if (trade->trade_id > state->max_trade_id) state->max_trade_id = trade->trade_id;
+
+        // The snapshot's market data already counts trades up to its sequence
+        OrderBook* book = find_order_book(context, trade->symbol);
+        if (book && record->sequence > book->last_journal_sequence) {
+            update_symbol_last_trade(context, trade);
+            book->last_journal_sequence = record->sequence;
+        }
+        return 0;
+    }
+
+    Order order = record->data.order;
+    if (order.order_id > state->max_order_id) state->max_order_id = order.order_id;
+
+    OrderBook* book = get_or_create_order_book(context, order.symbol);
+    if (!book) return 0;
+    if (record->sequence <= book->last_journal_sequence) return 0;
+
+    // Positions follow the replayed matching exactly as they did the live one
+    const OrderBookEntry* entry = orderbook_find_order(book, order.order_id);
+    Order before;
+    switch (record->type) {
+        case JOURNAL_ORDER_NEW:
+            if (orderbook_add_order(book, &order, replay_fill, context) != ERROR_INVALID_ORDER &&
+                (entry = orderbook_find_order(book, order.order_id)) != NULL) {
+                position_add_open(context, book, &entry->order, entry->order.remaining_quantity);
+            }
+            break;
+        case JOURNAL_ORDER_CANCEL:
+            if (orderbook_cancel_order(book, order.order_id, &before) == SUCCESS) {
+                position_add_open(context, book, &before, -(int64_t)before.remaining_quantity);
+            }
+            break;
+        case JOURNAL_ORDER_MODIFY:
+            if (!entry) break;
+            before = entry->order;
+            orderbook_modify_order(book, &order, replay_fill, context);
+            position_add_open(context, book, &before, -(int64_t)before.remaining_quantity);
+            entry = orderbook_find_order(book, order.order_id);
+            if (entry) {
+                position_add_open(context, book, &entry->order, entry->order.remaining_quantity);
+            }
+            break;
+        case JOURNAL_AUCTION_CALL:
+            book->phase = BOOK_PHASE_CALL;
+            book->call_ends = order.expiration_time;
+            break;
+        case JOURNAL_AUCTION_UNCROSS:
+            orderbook_uncross(book, replay_fill, context);
+            book->phase = BOOK_PHASE_CONTINUOUS;
+            book->call_ends = 0;
+            break;
+        default:
+            LOG_WARN("Unknown journal event type %u at %lu", record->type, record->sequence);
+            return 0;
+    }
+    orderbook_release_stops(book, replay_fill, replay_release, context);
+    book->last_journal_sequence = record->sequence;
+    state->applied++;
+    return 0;
+}
+
+static void raise_id_space(atomic_uint_least64_t* space, uint64_t saved, uint64_t replayed) {
+    uint64_t next = saved > replayed ? saved : replayed;
+    if (next > atomic_load(space)) {
+        atomic_store(space, next);
+    }
+}
+
+int snapshot_restore(ServerContext* context) {
+    if (!context) return ERROR_INVALID_PARAM;
+
+    uint64_t start = clock_ticks();
+    SnapshotFileHeader header;
+    memset(&header, 0, sizeof(header));
+    const char* loaded = NULL;
+    char path[512];
+
+    size_t count = 0;
+    char** names = NULL;
+    if (context->config.snapshot_dir[0] != '\0') {
+        names = list_snapshots(context->config.snapshot_dir, &count);
+    }
+    for (size_t i = 0; i < count; i++) {
+        snprintf(path, sizeof(path), "%s/%s", context->config.snapshot_dir, names[i]);
+        if (load_snapshot(context, path, &header) == SUCCESS) {
+            loaded = path;
+            break;
+        }
+        LOG_WARN("Ignoring unreadable snapshot %s", path);
+        reset_books(context);
+        memset(&header, 0, sizeof(header));
+    }
+    free_names(names, count);
+
+    ReplayState state = { .context = context, .max_order_id = 0, .max_trade_id = 0, .applied = 0 };
+    int64_t replayed = 0;
+    if (context->config.journal_file[0] != '\0') {
+        replayed = journal_replay(context->config.journal_file, header.journal_sequence,
+                                  replay_record, &state);
+        if (replayed < 0) return (int)replayed;
+    }
+
+    // Value restored and replayed positions at each symbol's last trade,
+    // and show the metrics thread the rebuilt books
+    for (uint32_t i = 0; i < context->symbol_count; i++) {
+        OrderBook* book = &context->order_books[i];
+        if (book->last_trade > 0) {
+            position_mark(context, book, book->last_trade);
+        }
+        orderbook_publish_stats(book);
+    }
+
+    // Ids handed out before the restart must never be reused
+    raise_id_space(&context->next_order_id, header.next_order_id, state.max_order_id + 1);
+    raise_id_space(&context->next_trade_id, header.next_trade_id, state.max_trade_id + 1);
+
+    uint64_t elapsed_us = clock_ticks_to_ns(clock_ticks() - start) / NANOS_PER_MICRO;
+    LOG_INFO("Restored %u books (%lu orders) from %s and replayed %ld journal events "
+             "(%lu applied) in %lu us",
+             context->symbol_count, header.order_count, loaded ? loaded : "no snapshot",
+             replayed, state.applied, elapsed_us);
+    return SUCCESS;
+}
@@ -0,0 +1,293 @@
+#include "server/server.h"
+#include "common/utils.h"
+
+// Twice max_symbols rounded up to a power of two keeps probe chains short
+static uint32_t symbol_index_capacity(uint32_t max_symbols) {
+    uint32_t capacity = 16;
+    while (capacity < max_symbols * 2) {
+        capacity <<= 1;
+    }
+    return capacity;
+}
+
+int initialize_symbol_table(ServerContext* context) {
+    if (!context) return ERROR_INVALID_PARAM;
+
+    if (context->config.max_symbols == 0) {
+        context->config.max_symbols = MAX_SYMBOLS;
+    }
+    if (context->config.max_orders_per_symbol == 0) {
+        context->config.max_orders_per_symbol = MAX_ORDERS_PER_SYMBOL;
+    }
+    uint32_t max_symbols = context->config.max_symbols;
+    uint32_t capacity = symbol_index_capacity(max_symbols);
+
+    context->order_books = calloc(max_symbols, sizeof(OrderBook));
+    context->market_data_cache = calloc(max_symbols, sizeof(MarketData));
+    context->symbol_index = calloc(capacity, sizeof(atomic_uint_least32_t));
+    if (!context->order_books || !context->market_data_cache || !context->symbol_index) {
+        LOG_ERROR("Failed to allocate symbol table for %u symbols", max_symbols);
+        cleanup_symbol_table(context);
+        return ERROR_MEMORY_ALLOC;
+    }
+
+    context->symbol_index_mask = capacity - 1;
+    context->symbol_count = 0;
+    return SUCCESS;
+}
+
+void cleanup_symbol_table(ServerContext* context) {
+    if (!context) return;
+
+    if (context->order_books) {
+        for (uint32_t i = 0; i < context->symbol_count; i++) {
+            orderbook_destroy(&context->order_books[i]);
+            pthread_rwlock_destroy(&context->order_books[i].lock);
+        }
+    }
+
+    free(context->order_books);
+    free(context->market_data_cache);
+    free(context->symbol_index);
+    context->order_books = NULL;
+    context->market_data_cache = NULL;
+    context->symbol_index = NULL;
+    context->symbol_count = 0;
+}
+
+// Probe for a symbol; returns the slot holding it or the empty slot ending the chain
+static uint32_t probe_symbol(ServerContext* context, const char* symbol, uint32_t* symbol_id) {
+    uint32_t slot = (uint32_t)hash_string(symbol) & context->symbol_index_mask;
+
+    for (;;) {
+        uint32_t entry = atomic_load_explicit(&context->symbol_index[slot], memory_order_acquire);
+        if (entry == 0) {
+            *symbol_id = UINT32_MAX;
+            return slot;
+        }
+        if (strncmp(context->order_books[entry - 1].symbol, symbol, MAX_SYMBOL_LENGTH) == 0) {
+            *symbol_id = entry - 1;
+            return slot;
+        }
+        slot = (slot + 1) & context->symbol_index_mask;
+    }
+}
+
+OrderBook* find_order_book(ServerContext* context, const char* symbol) {
+    if (!context || !symbol || !context->symbol_index) return NULL;
+
+    uint32_t symbol_id;
+    probe_symbol(context, symbol, &symbol_id);
+    return symbol_id == UINT32_MAX ? NULL : &context->order_books[symbol_id];
+}
+
+OrderBook* get_or_create_order_book(ServerContext* context, const char* symbol) {
+    if (!context || !symbol || symbol[0] == '\0' || !context->symbol_index) return NULL;
+
+    OrderBook* book = find_order_book(context, symbol);
+    if (book) return book;
+
+    pthread_rwlock_wrlock(&context->order_book_lock);
+
+    // Another thread may have created it while we waited for the lock
+    uint32_t symbol_id;
+    uint32_t slot = probe_symbol(context, symbol, &symbol_id);
+    if (symbol_id != UINT32_MAX) {
+        pthread_rwlock_unlock(&context->order_book_lock);
+        return &context->order_books[symbol_id];
+    }
+
+    if (context->symbol_count >= context->config.max_symbols) {
+        pthread_rwlock_unlock(&context->order_book_lock);
+        LOG_ERROR("Symbol table full, cannot add %s", symbol);
+        return NULL;
+    }
+
+    symbol_id = context->symbol_count;
+    book = &context->order_books[symbol_id];
+    memset(book, 0, sizeof(*book));
+    strncpy(book->symbol, symbol, MAX_SYMBOL_LENGTH - 1);
+    book->symbol_id = symbol_id;
+    book->tick_exponent = DEFAULT_TICK_EXPONENT;
+    book->day_end_seconds = context->config.day_end;
+    // phase_due stays 0: the first order or timer tick puts the book on the auction schedule
+    if (orderbook_init(book, context->config.max_orders_per_symbol) != SUCCESS) {
+        pthread_rwlock_unlock(&context->order_book_lock);
+        return NULL;
+    }
+    // Before journal replay, which matches through the same policy
+    for (uint32_t i = 0; i < context->config.match_policy_count; i++) {
+        const SymbolMatchPolicy* match = &context->config.match_policies[i];
+        if (strcmp(match->symbol, book->symbol) == 0) {
+            if (orderbook_set_match_policy(book, match->policy, match->min_allocation,
+                                           match->fifo_percent) != SUCCESS) {
+                orderbook_destroy(book);
+                pthread_rwlock_unlock(&context->order_book_lock);
+                return NULL;
+            }
+            LOG_INFO("%s matches %s", symbol, match->policy == MATCH_PRO_RATA ? "pro-rata" :
+                     match->policy == MATCH_HYBRID ? "hybrid" : "price-time");
+            break;
+        }
+    }
+    pthread_rwlock_init(&book->lock, NULL);
+    orderbook_publish_stats(book);
+
+    MarketData* cached = &context->market_data_cache[symbol_id];
+    memset(cached, 0, sizeof(*cached));
+    strncpy(cached->symbol, symbol, MAX_SYMBOL_LENGTH - 1);
+
+    // Its first tick file, before the timer tick can see the book
+    tick_store_prepare(context->tick_store, book, clock_now_ns());
+    context->symbol_count++;
+
+    // Publish only once the book is fully initialized
+    atomic_store_explicit(&context->symbol_index[slot], symbol_id + 1, memory_order_release);
+    pthread_rwlock_unlock(&context->order_book_lock);
+
+    LOG_INFO("Registered symbol %s as id %u", symbol, symbol_id);
+    return book;
+}
+
+int register_configured_symbols(ServerContext* context) {
+    if (!context) return ERROR_INVALID_PARAM;
+
+    // A symbol given a match policy is as good as listed
+    const ServerConfig* config = &context->config;
+    for (uint32_t i = 0; i < config->symbol_count + config->match_policy_count; i++) {
+        const char* symbol = i < config->symbol_count ? config->symbols[i] :
+                             config->match_policies[i - config->symbol_count].symbol;
+        if (!get_or_create_order_book(context, symbol)) {
+            LOG_ERROR("Failed to register configured symbol %s", symbol);
+            return ERROR_CONFIG_INVALID;
+        }
+    }
+    if (context->symbol_count == 0) {
+        LOG_WARN("No symbols configured; orders are refused until one is registered");
+    }
+    return SUCCESS;
+}
+
+int set_symbol_tick_exponent(ServerContext* context, const char* symbol, int32_t tick_exponent) {
+    if (tick_exponent < -PRICE_MAX_EXPONENT || tick_exponent > PRICE_MAX_EXPONENT) {
+        LOG_ERROR("Invalid tick exponent %d for %s", tick_exponent, symbol ? symbol : "");
+        return ERROR_INVALID_PARAM;
+    }
+
+    OrderBook* book = get_or_create_order_book(context, symbol);
+    if (!book) return ERROR_SYMBOL_NOT_FOUND;
+
+    pthread_rwlock_wrlock(&book->lock);
+    if (book->bid_count + book->ask_count + book->stop_count > 0) {
+        pthread_rwlock_unlock(&book->lock);
+        LOG_ERROR("Cannot change tick size of %s with resting orders", symbol);
+        return ERROR_INVALID_PARAM;
+    }
+    book->tick_exponent = tick_exponent;
+    book->last_trade = 0;
+    book->best_bid = create_price(0, tick_exponent);
+    book->best_ask = create_price(0, tick_exponent);
+    orderbook_publish_stats(book);
+    pthread_rwlock_unlock(&book->lock);
+
+    return SUCCESS;
+}
+
+static int normalize_to_ticks(Price* price, int32_t tick_exponent) {
+    int64_t ticks;
+    if (price_to_ticks(*price, tick_exponent, &ticks) < 0) {
+        return ERROR_INVALID_PARAM;
+    }
+    price->mantissa = ticks;
+    price->exponent = tick_exponent;
+    return SUCCESS;
+}
+
+// Cached quotes predate any tick size change, so convert rather than assume
+static int64_t ticks_or_zero(Price price, int32_t tick_exponent) {
+    int64_t ticks;
+    return price_to_ticks(price, tick_exponent, &ticks) < 0 ? 0 : ticks;
+}
+
+int update_symbol_market_data(ServerContext* context, const MarketData* market_data) {
+    if (!context || !market_data) return ERROR_INVALID_PARAM;
+
+    OrderBook* book = find_order_book(context, market_data->symbol);
+    if (!book) return ERROR_SYMBOL_NOT_FOUND;
+
+    MarketData normalized = *market_data;
+    if (normalize_to_ticks(&normalized.last_price, book->tick_exponent) != SUCCESS ||
+        normalize_to_ticks(&normalized.bid, book->tick_exponent) != SUCCESS ||
+        normalize_to_ticks(&normalized.ask, book->tick_exponent) != SUCCESS) {
+        LOG_WARN("Market data for %s is not on the symbol's tick grid", market_data->symbol);
+        return ERROR_MARKET_DATA;
+    }
+
+    pthread_rwlock_wrlock(&context->market_data_lock);
+    context->market_data_cache[book->symbol_id] = normalized;
+    pthread_rwlock_unlock(&context->market_data_lock);
+
+    TickRecord tick = {
+        .timestamp = clock_frame_time(),
+        .type = TICK_MARKET_DATA,
+        .quantity = normalized.last_size,
+        .price = normalized.last_price.mantissa,
+        .bid = normalized.bid.mantissa,
+        .ask = normalized.ask.mantissa,
+        .bid_size = normalized.bid_size,
+        .ask_size = normalized.ask_size,
+        .volume = normalized.volume,
+        .id = normalized.num_trades
+    };
+    tick_store_append(context->tick_store, book, &tick);
+
+    return SUCCESS;
+}
+
+int update_symbol_last_trade(ServerContext* context, const TradeExecution* trade) {
+    if (!context || !trade) return ERROR_INVALID_PARAM;
+
+    OrderBook* book = find_order_book(context, trade->symbol);
+    if (!book) return ERROR_SYMBOL_NOT_FOUND;
+
+    Price last_price = trade->price;
+    if (normalize_to_ticks(&last_price, book->tick_exponent) != SUCCESS) {
+        return ERROR_MARKET_DATA;
+    }
+
+    TickRecord tick = {
+        .timestamp = clock_frame_time(),
+        .type = TICK_TRADE,
+        .quantity = trade->quantity,
+        .price = last_price.mantissa,
+        .id = trade->trade_id
+    };
+
+    pthread_rwlock_wrlock(&context->market_data_lock);
+    MarketData* cached = &context->market_data_cache[book->symbol_id];
+    cached->last_price = last_price;
+    cached->last_size = trade->quantity;
+    cached->volume += trade->quantity;
+    cached->num_trades++;
+    cached->timestamp = trade->timestamp;
+    tick.bid = ticks_or_zero(cached->bid, book->tick_exponent);
+    tick.ask = ticks_or_zero(cached->ask, book->tick_exponent);
+    tick.bid_size = cached->bid_size;
+    tick.ask_size = cached->ask_size;
+    tick.volume = cached->volume;
+    pthread_rwlock_unlock(&context->market_data_lock);
+
+    tick_store_append(context->tick_store, book, &tick);
+
+    return SUCCESS;
+}
+
+int get_symbol_market_data(ServerContext* context, const OrderBook* book, MarketData* market_data) {
+    if (!context || !book || !market_data) return ERROR_INVALID_PARAM;
+
+    pthread_rwlock_rdlock(&context->market_data_lock);
+    *market_data = context->market_data_cache[book->symbol_id];
+    pthread_rwlock_unlock(&context->market_data_lock);
+
+    return SUCCESS;
+}
@@ -0,0 +1,111 @@
+#include "server/server.h"
+
+static const char* const kind_names[THROTTLE_COUNT] = {
+    [THROTTLE_SESSION_MESSAGES] = "session messages",
+    [THROTTLE_SESSION_ORDERS] = "session orders",
+    [THROTTLE_CLIENT_MESSAGES] = "client messages",
+    [THROTTLE_CLIENT_ORDERS] = "client orders"
+};
+
+const char* throttle_kind_name(ThrottleKind kind) {
+    return kind < THROTTLE_COUNT ? kind_names[kind] : "unknown";
+}
+
+int throttle_init(ServerContext* context) {
+    if (!context) return ERROR_INVALID_PARAM;
+
+    context->throttle_active = 0;
+    for (int kind = 0; kind < THROTTLE_COUNT; kind++) {
+        const ThrottleLimit* limit = &context->config.throttle[kind];
+        uint64_t burst = limit->burst ? limit->burst : limit->rate;
+        context->throttle_interval_ns[kind] = limit->rate ? NANOS_PER_SECOND / limit->rate : 0;
+        context->throttle_window_ns[kind] = context->throttle_interval_ns[kind] * burst;
+        if (limit->rate) {
+            context->throttle_active = 1;
+            LOG_INFO("Throttling %s at %u/s, burst %lu", kind_names[kind], limit->rate, burst);
+        }
+    }
+
+    // Sized by max_accounts, so after the position table
+    uint32_t max_accounts = context->config.max_accounts;
+    context->client_throttles = aligned_alloc(_Alignof(ClientThrottle), max_accounts * sizeof(ClientThrottle));
+    if (!context->client_throttles) {
+        LOG_ERROR("Failed to allocate rate limits for %u accounts", max_accounts);
+        return ERROR_MEMORY_ALLOC;
+    }
+    memset(context->client_throttles, 0, max_accounts * sizeof(ClientThrottle));
+    return SUCCESS;
+}
+
+void throttle_cleanup(ServerContext* context) {
+    if (!context) return;
+
+    free(context->client_throttles);
+    context->client_throttles = NULL;
+}
+
+static inline int charge(ServerContext* context, ThrottleBucket* bucket, ThrottleKind kind, uint64_t now) {
+    uint64_t interval = context->throttle_interval_ns[kind];
+    return interval == 0 || throttle_take(bucket, interval, context->throttle_window_ns[kind], now);
+}
+
+ThrottleKind throttle_admit(ServerContext* context, ClientConnection* client, MessageType type,
+                            uint64_t now) {
+    if (!context->throttle_active || type == MSG_HEARTBEAT) return THROTTLE_COUNT;
+
+    int order = type == MSG_ORDER_NEW || type == MSG_ORDER_MODIFY;
+    if (!charge(context, &client->message_bucket, THROTTLE_SESSION_MESSAGES, now)) {
+        return THROTTLE_SESSION_MESSAGES;
+    }
+    if (order && !charge(context, &client->order_bucket, THROTTLE_SESSION_ORDERS, now)) {
+        return THROTTLE_SESSION_ORDERS;
+    }
+
+    // A session has no client id until its first order
+    if (client->account_id == UINT32_MAX) return THROTTLE_COUNT;
+    ClientThrottle* shared = &context->client_throttles[client->account_id];
+    if (!charge(context, &shared->messages, THROTTLE_CLIENT_MESSAGES, now)) {
+        return THROTTLE_CLIENT_MESSAGES;
+    }
+    if (order && !charge(context, &shared->orders, THROTTLE_CLIENT_ORDERS, now)) {
+        return THROTTLE_CLIENT_ORDERS;
+    }
+    return THROTTLE_COUNT;
+}
+
+void throttle_reject(ServerContext* context, ClientConnection* client, ThrottleKind kind,
+                     const MessageHeader* header, const uint8_t* payload, uint64_t now) {
+    atomic_fetch_add_explicit(&context->stats.throttled[kind], 1, memory_order_relaxed);
+
+    // Answering every message of a flood would double it on the way out:
+    // one error per refill of the refusing bucket, the rest only counted
+    if (now < client->throttle_notice_due) {
+        client->throttle_suppressed++;
+        return;
+    }
+    client->throttle_notice_due = now + context->throttle_interval_ns[kind];
+    uint32_t suppressed = client->throttle_suppressed;
+    client->throttle_suppressed = 0;
+
+    // Name the order when there is one, so the client can tie the error to it
+    char text[MAX_ERROR_MSG_LENGTH];
+    int length;
+    if (header->type >= MSG_ORDER_NEW && header->type <= MSG_ORDER_STATUS &&
+        header->payload_size == sizeof(Order)) {
+        // A new order has no server id yet, only the client's
+        uint64_t order_id;
+        size_t field = header->type == MSG_ORDER_NEW ? offsetof(Order, client_order_id) :
+                                                       offsetof(Order, order_id);
+        memcpy(&order_id, payload + field, sizeof(order_id));
+        length = snprintf(text, sizeof(text), "Order %lu throttled: %s rate exceeded",
+                          order_id, kind_names[kind]);
+    } else {
+        length = snprintf(text, sizeof(text), "Message throttled: %s rate exceeded", kind_names[kind]);
+    }
+    if (suppressed > 0 && length > 0 && (size_t)length < sizeof(text)) {
+        snprintf(text + length, sizeof(text) - (size_t)length,
+                 " (%u more throttled since the last error)", suppressed);
+    }
+    LOG_DEBUG("Client %s: %s", client->id, text);
+    send_error(client, ERROR_THROTTLED, text);
+}
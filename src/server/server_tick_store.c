@@ -0,0 +1,311 @@
+#include "server/server.h"
+#include "server/server_tick_store.h"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+// One mapped segment file
+typedef struct {
+    TickFileHeader* header;
+    size_t map_size;
+    uint32_t day;
+    uint32_t segment;
+} TickMapping;
+
+// The append path owns current; tick_store_prepare maps spare ahead of it
+// and unmaps retired after it, so a rollover is a swap under the lock
+typedef struct {
+    atomic_flag lock;
+    TickMapping current;
+    TickMapping spare;
+    TickMapping retired;
+    TickRecord* records;
+    uint64_t count;
+    uint32_t failed_day;        // Day + 1 of the last failed prepare, stops retries
+} TickPartition;
+
+struct TickStore {
+    char dir[256];
+    uint64_t records_per_file;
+    uint32_t max_symbols;
+    TickPartition* partitions;  // Indexed by symbol id
+    ServerStats* stats;
+};
+
+static void unmap_file(TickMapping* mapping) {
+    if (!mapping->header) return;
+    munmap(mapping->header, mapping->map_size);
+    memset(mapping, 0, sizeof(*mapping));
+}
+
+static int make_directory(const char* path) {
+    return mkdir(path, 0755) == 0 || errno == EEXIST ? 0 : -1;
+}
+
+/**
+ * Map one segment file, creating and preallocating it if needed. Returns
+ * 1 if the segment was mapped, 0 if it exists but cannot take records
+ * (full, or written at another tick size) and -1 on error.
+ */
+static int map_segment(TickStore* store, TickMapping* mapping, const OrderBook* book,
+                       uint32_t day, uint32_t segment) {
+    char path[512];
+    if (tick_file_path(path, sizeof(path), store->dir, book->symbol, day, segment) < 0) {
+        LOG_ERROR("Tick file path for %s is too long", book->symbol);
+        return -1;
+    }
+
+    int fd = open(path, O_RDWR | O_CREAT, 0644);
+    if (fd < 0) {
+        LOG_ERROR("Failed to open tick file %s: %s", path, strerror(errno));
+        return -1;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) < 0) {
+        close(fd);
+        return -1;
+    }
+
+    int created = st.st_size == 0;
+    uint64_t capacity = store->records_per_file;
+    if (!created) {
+        TickFileHeader existing;
+        if (pread(fd, &existing, sizeof(existing), 0) != (ssize_t)sizeof(existing) ||
+            memcmp(existing.magic, TICK_STORE_MAGIC, sizeof(existing.magic)) != 0 ||
+            existing.version != TICK_STORE_VERSION ||
+            existing.record_size != sizeof(TickRecord) ||
+            (size_t)st.st_size < sizeof(TickFileHeader) + existing.capacity * sizeof(TickRecord)) {
+            LOG_WARN("Skipping incompatible tick file %s", path);
+            close(fd);
+            return 0;
+        }
+        if (existing.record_count >= existing.capacity ||
+            existing.price_exponent != book->tick_exponent) {
+            close(fd);
+            return 0;
+        }
+        capacity = existing.capacity;
+    }
+
+    size_t size = sizeof(TickFileHeader) + capacity * sizeof(TickRecord);
+    int error = created ? posix_fallocate(fd, 0, (off_t)size) : 0;
+    if (error != 0) {
+        LOG_ERROR("Failed to preallocate tick file %s: %s", path, strerror(error));
+        close(fd);
+        unlink(path);
+        return -1;
+    }
+
+    void* data = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        LOG_ERROR("Failed to map tick file %s: %s", path, strerror(errno));
+        return -1;
+    }
+
+    TickFileHeader* header = data;
+    if (created) {
+        memcpy(header->magic, TICK_STORE_MAGIC, sizeof(header->magic));
+        header->version = TICK_STORE_VERSION;
+        header->record_size = sizeof(TickRecord);
+        memcpy(header->symbol, book->symbol, MAX_SYMBOL_LENGTH);
+        header->price_exponent = book->tick_exponent;
+        header->day = day;
+        header->capacity = capacity;
+        header->created_ns = clock_now_ns();
+        __atomic_store_n(&header->record_count, 0, __ATOMIC_RELEASE);
+    }
+
+    mapping->header = header;
+    mapping->map_size = size;
+    mapping->day = day;
+    mapping->segment = segment;
+
+    if (store->stats) {
+        atomic_fetch_add(&store->stats->tick_files, 1);
+    }
+    LOG_INFO("Prepared %s tick file %s", book->symbol, path);
+    return 1;
+}
+
+// Map the first segment from segment on that can take the book's records
+static int map_next_segment(TickStore* store, TickMapping* mapping, const OrderBook* book,
+                            uint32_t day, uint32_t segment) {
+    char path[512];
+    if (tick_file_path(path, sizeof(path), store->dir, book->symbol, day, 0) < 0) {
+        return ERROR_INVALID_STATE;
+    }
+    *strrchr(path, '/') = '\0';
+    if (make_directory(store->dir) < 0 || make_directory(path) < 0) {
+        LOG_ERROR("Failed to create tick directory %s: %s", path, strerror(errno));
+        return ERROR_INVALID_STATE;
+    }
+
+    for (;; segment++) {
+        int mapped = map_segment(store, mapping, book, day, segment);
+        if (mapped > 0) return SUCCESS;
+        if (mapped < 0) return ERROR_INVALID_STATE;
+    }
+}
+
+TickStore* tick_store_open(const char* dir, uint32_t max_symbols, uint64_t records_per_file,
+                           ServerStats* stats) {
+    if (!dir || dir[0] == '\0' || max_symbols == 0) return NULL;
+
+    TickStore* store = calloc(1, sizeof(TickStore));
+    if (!store) {
+        LOG_ERROR("Failed to allocate tick store");
+        return NULL;
+    }
+
+    store->partitions = calloc(max_symbols, sizeof(TickPartition));
+    if (!store->partitions) {
+        LOG_ERROR("Failed to allocate tick store partitions");
+        free(store);
+        return NULL;
+    }
+    for (uint32_t i = 0; i < max_symbols; i++) {
+        atomic_flag_clear(&store->partitions[i].lock);
+    }
+
+    strncpy(store->dir, dir, sizeof(store->dir) - 1);
+    store->records_per_file = records_per_file ? records_per_file : TICK_STORE_DEFAULT_RECORDS;
+    store->max_symbols = max_symbols;
+    store->stats = stats;
+
+    if (make_directory(store->dir) < 0) {
+        LOG_ERROR("Failed to create tick directory %s: %s", dir, strerror(errno));
+        free(store->partitions);
+        free(store);
+        return NULL;
+    }
+
+    LOG_INFO("Tick store %s opened (%lu records per file)", dir, store->records_per_file);
+    return store;
+}
+
+void tick_store_close(TickStore* store) {
+    if (!store) return;
+
+    for (uint32_t i = 0; i < store->max_symbols; i++) {
+        unmap_file(&store->partitions[i].current);
+        unmap_file(&store->partitions[i].spare);
+        unmap_file(&store->partitions[i].retired);
+    }
+
+    if (store->stats) {
+        LOG_INFO("Tick store %s closed: %lu ticks in %lu files, %lu dropped", store->dir,
+                 (uint64_t)atomic_load(&store->stats->ticks_captured),
+                 (uint64_t)atomic_load(&store->stats->tick_files),
+                 (uint64_t)atomic_load(&store->stats->ticks_dropped));
+    }
+    free(store->partitions);
+    free(store);
+}
+
+static inline void lock_partition(TickPartition* partition) {
+    while (atomic_flag_test_and_set_explicit(&partition->lock, memory_order_acquire)) {
+        // Held for a record copy or a pointer swap
+    }
+}
+
+static inline void unlock_partition(TickPartition* partition) {
+    atomic_flag_clear_explicit(&partition->lock, memory_order_release);
+}
+
+int tick_store_prepare(TickStore* store, const OrderBook* book, uint64_t now) {
+    if (!store) return SUCCESS;
+    if (!book || book->symbol_id >= store->max_symbols) return ERROR_INVALID_PARAM;
+
+    TickPartition* partition = &store->partitions[book->symbol_id];
+    uint32_t today = (uint32_t)(now / NANOS_PER_DAY);
+    int near_midnight = now % NANOS_PER_DAY >= NANOS_PER_DAY - TICK_STORE_PREPARE_LEAD_NS;
+
+    // The file the append path will want next: tomorrow's near midnight,
+    // today's if it has none, else today's next segment once the current
+    // one is half full or at another tick size
+    TickMapping retired, stale = { 0 };
+    uint32_t day = 0, segment = 0;
+    int wanted = 1;
+    lock_partition(partition);
+    retired = partition->retired;
+    memset(&partition->retired, 0, sizeof(partition->retired));
+    const TickMapping* current = &partition->current;
+    if (near_midnight && (!current->header || current->day <= today)) {
+        day = today + 1;
+    } else if (!current->header || current->day < today) {
+        day = today;
+    } else if (current->day == today &&
+               (partition->count >= current->header->capacity / 2 ||
+                current->header->price_exponent != book->tick_exponent)) {
+        day = today;
+        segment = current->segment + 1;
+    } else {
+        wanted = 0;
+    }
+    if (partition->spare.header) {
+        if (!wanted || (partition->spare.day == day && partition->spare.segment >= segment &&
+                        partition->spare.header->price_exponent == book->tick_exponent)) {
+            wanted = 0;
+        } else {
+            stale = partition->spare;
+            memset(&partition->spare, 0, sizeof(partition->spare));
+        }
+    }
+    unlock_partition(partition);
+
+    unmap_file(&retired);
+    unmap_file(&stale);
+    if (!wanted || partition->failed_day == day + 1) return SUCCESS;
+
+    TickMapping spare = { 0 };
+    if (map_next_segment(store, &spare, book, day, segment) != SUCCESS) {
+        partition->failed_day = day + 1;
+        return ERROR_INVALID_STATE;
+    }
+    partition->failed_day = 0;
+    lock_partition(partition);
+    partition->spare = spare;
+    unlock_partition(partition);
+    return SUCCESS;
+}
+
+int tick_store_append(TickStore* store, const OrderBook* book, const TickRecord* record) {
+    if (!store) return SUCCESS;
+    if (!book || !record || book->symbol_id >= store->max_symbols) return ERROR_INVALID_PARAM;
+
+    TickPartition* partition = &store->partitions[book->symbol_id];
+    uint32_t day = (uint32_t)(record->timestamp / NANOS_PER_DAY);
+
+    lock_partition(partition);
+    TickMapping* current = &partition->current;
+    if (__builtin_expect(!current->header || current->day != day ||
+                         partition->count == current->header->capacity ||
+                         current->header->price_exponent != book->tick_exponent, 0)) {
+        // Swap in the file prepared for this; the old one is unmapped by the next prepare
+        TickMapping* spare = &partition->spare;
+        if (!spare->header || spare->day != day || spare->header->price_exponent != book->tick_exponent) {
+            unlock_partition(partition);
+            if (store->stats) {
+                atomic_fetch_add(&store->stats->ticks_dropped, 1);
+            }
+            return ERROR_INVALID_STATE;
+        }
+        partition->retired = *current;
+        *current = *spare;
+        memset(spare, 0, sizeof(*spare));
+        partition->records = (TickRecord*)(current->header + 1);
+        partition->count = current->header->record_count;
+    }
+
+    partition->records[partition->count++] = *record;
+    __atomic_store_n(&current->header->record_count, partition->count, __ATOMIC_RELEASE);
+
+    unlock_partition(partition);
+
+    if (store->stats) {
+        atomic_fetch_add_explicit(&store->stats->ticks_captured, 1, memory_order_relaxed);
+    }
+    return SUCCESS;
+}
@@ -0,0 +1,294 @@
+#include "server/server.h"
+
+#define TIMER_OVERFLOW (TIMER_LEVELS * TIMER_SLOTS)
+#define TIMER_SLOT_MASK (TIMER_SLOTS - 1)
+#define TIMER_SPAN_BITS (TIMER_LEVELS * TIMER_SLOT_BITS)   // Ticks one top rotation covers, as a power of two
+
+static inline uint32_t group_of(uint64_t tick, int level) {
+    return (uint32_t)(tick >> (level * TIMER_SLOT_BITS)) & TIMER_SLOT_MASK;
+}
+
+// The tick a level's slot comes round at, within the current rotation of the level above
+static inline uint64_t slot_tick(const TimerWheel* wheel, int level, uint32_t group) {
+    int shift = level * TIMER_SLOT_BITS;
+    return (wheel->current >> (shift + TIMER_SLOT_BITS) << (shift + TIMER_SLOT_BITS)) |
+           ((uint64_t)group << shift);
+}
+
+static inline uint64_t next_rotation(const TimerWheel* wheel) {
+    return ((wheel->current >> TIMER_SPAN_BITS) + 1) << TIMER_SPAN_BITS;
+}
+
+// Link a node into the lowest level whose span reaches its tick; the
+// highest bit in which the tick differs from the current one picks it
+static void place(TimerWheel* wheel, TimerNode* node) {
+    uint64_t diff = node->expires ^ wheel->current;
+    int level = diff ? (63 - __builtin_clzll(diff)) / TIMER_SLOT_BITS : 0;
+
+    TimerNode** head;
+    if (level >= TIMER_LEVELS) {
+        node->slot = TIMER_OVERFLOW;
+        head = &wheel->overflow;
+    } else {
+        uint32_t group = group_of(node->expires, level);
+        node->slot = (uint32_t)level * TIMER_SLOTS + group;
+        head = &wheel->slots[node->slot];
+        wheel->occupied[level] |= 1ULL << group;
+    }
+
+    node->next = *head;
+    if (node->next) node->next->link = &node->next;
+    *head = node;
+    node->link = head;
+}
+
+static void unlink_node(TimerWheel* wheel, TimerNode* node) {
+    *node->link = node->next;
+    if (node->next) node->next->link = node->link;
+    node->link = NULL;
+    if (node->slot != TIMER_OVERFLOW && !wheel->slots[node->slot]) {
+        wheel->occupied[node->slot / TIMER_SLOTS] &= ~(1ULL << (node->slot % TIMER_SLOTS));
+    }
+}
+
+/**
+ * The next tick an advance has to stop at: the first occupied slot after
+ * the current one in the lowest level that has one. Anything in a higher
+ * level is due after the lower level's rotation ends, so the first level
+ * with a later slot decides; with none, the top wheel's next rotation.
+ */
+static uint64_t next_event(const TimerWheel* wheel) {
+    for (int level = 0; level < TIMER_LEVELS; level++) {
+        uint32_t group = group_of(wheel->current, level);
+        uint64_t later = group == TIMER_SLOT_MASK ? 0 : wheel->occupied[level] & (~0ULL << (group + 1));
+        if (later) {
+            return slot_tick(wheel, level, (uint32_t)__builtin_ctzll(later));
+        }
+    }
+    return next_rotation(wheel);
+}
+
+// Take a slot's list and place each node again against the current tick
+static void cascade(TimerWheel* wheel, uint32_t slot) {
+    TimerNode** head = slot == TIMER_OVERFLOW ? &wheel->overflow : &wheel->slots[slot];
+    TimerNode* node = *head;
+    *head = NULL;
+    if (slot != TIMER_OVERFLOW) {
+        wheel->occupied[slot / TIMER_SLOTS] &= ~(1ULL << (slot % TIMER_SLOTS));
+    }
+
+    while (node) {
+        TimerNode* next = node->next;
+        place(wheel, node);
+        node = next;
+    }
+}
+
+void timer_wheel_init(TimerWheel* wheel, uint64_t now) {
+    memset(wheel, 0, sizeof(*wheel));
+    wheel->current = now >> TIMER_TICK_SHIFT;
+    wheel->due = UINT64_MAX;
+}
+
+void timer_arm(TimerWheel* wheel, TimerNode* node, uint64_t deadline) {
+    if (node->link) {
+        unlink_node(wheel, node);
+    } else {
+        wheel->count++;
+    }
+
+    // Rounded up so a timer never fires early; the current tick has been processed
+    uint64_t tick = (deadline >> TIMER_TICK_SHIFT) + ((deadline & ((1ULL << TIMER_TICK_SHIFT) - 1)) != 0);
+    node->expires = tick > wheel->current ? tick : wheel->current + 1;
+    place(wheel, node);
+
+    uint64_t event = node->slot == TIMER_OVERFLOW ? next_rotation(wheel) :
+                     slot_tick(wheel, (int)(node->slot / TIMER_SLOTS), node->slot % TIMER_SLOTS);
+    if (event < wheel->due) {
+        wheel->due = event;
+    }
+}
+
+void timer_cancel(TimerWheel* wheel, TimerNode* node) {
+    if (!node->link) return;
+
+    unlink_node(wheel, node);
+    wheel->count--;
+}
+
+uint32_t timer_wheel_advance(TimerWheel* wheel, uint64_t now, TimerCallback fire, void* arg) {
+    uint64_t target = now >> TIMER_TICK_SHIFT;
+    uint32_t fired = 0;
+
+    while (wheel->current < target) {
+        uint64_t next = wheel->count ? next_event(wheel) : UINT64_MAX;
+        if (next > target) {
+            wheel->current = target;
+            break;
+        }
+        wheel->current = next;
+
+        // Top level first, so a timer moved down lands in a slot still to be cascaded
+        if ((next & ((1ULL << TIMER_SPAN_BITS) - 1)) == 0 && wheel->overflow) {
+            cascade(wheel, TIMER_OVERFLOW);
+        }
+        for (int level = TIMER_LEVELS - 1; level > 0; level--) {
+            if (next & ((1ULL << (level * TIMER_SLOT_BITS)) - 1)) continue;
+            uint32_t slot = (uint32_t)level * TIMER_SLOTS + group_of(next, level);
+            if (wheel->slots[slot]) {
+                cascade(wheel, slot);
+            }
+        }
+
+        // Detached first: a callback may arm or cancel any timer, pending ones included
+        uint32_t slot = group_of(next, 0);
+        TimerNode* pending = wheel->slots[slot];
+        if (!pending) continue;
+        wheel->slots[slot] = NULL;
+        wheel->occupied[0] &= ~(1ULL << slot);
+        pending->link = &pending;
+        while (pending) {
+            TimerNode* node = pending;
+            pending = node->next;
+            if (pending) pending->link = &pending;
+            node->link = NULL;
+            wheel->count--;
+            fired++;
+            fire(node, arg);
+        }
+    }
+
+    wheel->due = wheel->count ? next_event(wheel) : UINT64_MAX;
+    return fired;
+}
+
+uint64_t timers_next_day_end(uint32_t day_end_seconds, uint64_t now) {
+    uint64_t end = now - now % NANOS_PER_DAY + (uint64_t)day_end_seconds * NANOS_PER_SECOND;
+    return end > now ? end : end + NANOS_PER_DAY;
+}
+
+static inline int in_window(uint32_t time_of_day, uint32_t start, uint32_t end) {
+    return start < end ? time_of_day >= start && time_of_day < end : time_of_day >= start || time_of_day < end;
+}
+
+BookPhase timers_auction_phase(const ServerConfig* config, uint64_t now, uint64_t* call_ends, uint64_t* next) {
+    uint32_t time_of_day = (uint32_t)(now % NANOS_PER_DAY / NANOS_PER_SECOND);
+    uint32_t open_start = config->day_end % 86400;
+    BookPhase phase = BOOK_PHASE_CONTINUOUS;
+    *call_ends = 0;
+    if (config->auction_close && in_window(time_of_day, config->auction_close, config->day_end)) {
+        phase = BOOK_PHASE_CALL;
+        *call_ends = timers_next_day_end(config->day_end, now);
+    } else if (config->auction_open && in_window(time_of_day, open_start, config->auction_open)) {
+        phase = BOOK_PHASE_CALL;
+        *call_ends = timers_next_day_end(config->auction_open, now);
+    }
+
+    // Every boundary of either window; one that changes nothing costs a look
+    uint32_t boundaries[4];
+    uint32_t count = 0;
+    if (config->auction_open) {
+        boundaries[count++] = open_start;
+        boundaries[count++] = config->auction_open;
+    }
+    if (config->auction_close) {
+        boundaries[count++] = config->auction_close;
+        boundaries[count++] = config->day_end;
+    }
+    *next = UINT64_MAX;
+    for (uint32_t i = 0; i < count; i++) {
+        uint64_t at = timers_next_day_end(boundaries[i], now);
+        if (at < *next) *next = at;
+    }
+    return phase;
+}
+
+void timers_init(ServerContext* context) {
+    if (!context) return;
+
+    timer_wheel_init(&context->sessions, clock_now_ns());
+    context->session_timeout_ns = (uint64_t)context->config.socket_timeout * NANOS_PER_SECOND;
+    if (context->session_timeout_ns) {
+        LOG_INFO("Sessions time out after %d s without a message", context->config.socket_timeout);
+    }
+    if (context->config.day_end) {
+        LOG_INFO("DAY orders expire at %02u:%02u UTC",
+                 context->config.day_end / 3600 % 24, context->config.day_end / 60 % 60);
+    }
+    if (context->config.auction_open) {
+        LOG_INFO("Opening call auction uncrosses at %02u:%02u UTC",
+                 context->config.auction_open / 3600 % 24, context->config.auction_open / 60 % 60);
+    }
+    if (context->config.auction_close) {
+        LOG_INFO("Closing call auction from %02u:%02u UTC",
+                 context->config.auction_close / 3600 % 24, context->config.auction_close / 60 % 60);
+    }
+}
+
+void timers_watch_session(ServerContext* context, ClientConnection* client) {
+    if (context->session_timeout_ns) {
+        timer_arm(&context->sessions, &client->heartbeat_timer,
+                  client->connect_time + context->session_timeout_ns);
+    }
+}
+
+typedef struct {
+    ServerContext* context;
+    uint64_t now;
+} SessionSweep;
+
+// Messages only refresh last_heartbeat; the deadline is moved here, when the
+// old one comes due, so a busy session never touches the wheel
+static void session_due(TimerNode* node, void* arg) {
+    SessionSweep* sweep = arg;
+    ServerContext* context = sweep->context;
+    ClientConnection* client = (ClientConnection*)((char*)node - offsetof(ClientConnection, heartbeat_timer));
+    if (!client->active) return;
+
+    uint64_t deadline = client->last_heartbeat + context->session_timeout_ns;
+    if (deadline > sweep->now) {
+        timer_arm(&context->sessions, node, deadline);
+        return;
+    }
+
+    // The handler thread sees the shutdown and disconnects as usual
+    pthread_mutex_lock(&context->clients_mutex);
+    if (client->active) {
+        LOG_WARN("Client %s timed out after %d s without a message",
+                 client->id, context->config.socket_timeout);
+        shutdown(client->socket, SHUT_RDWR);
+        atomic_fetch_add_explicit(&context->stats.sessions_timed_out, 1, memory_order_relaxed);
+    }
+    pthread_mutex_unlock(&context->clients_mutex);
+}
+
+void timers_tick(ServerContext* context, uint64_t now) {
+    if (!context) return;
+
+    if (context->session_timeout_ns) {
+        SessionSweep sweep = { .context = context, .now = now };
+        timer_wheel_advance(&context->sessions, now, session_due, &sweep);
+    }
+
+    pthread_rwlock_rdlock(&context->order_book_lock);
+    uint32_t symbol_count = context->symbol_count;
+    pthread_rwlock_unlock(&context->order_book_lock);
+
+    // One relaxed load per book for each of its deadlines; only books with
+    // one passed are locked. An uncross due at the day end goes before
+    // DAY orders expire. Tick files are made here so appends never open one.
+    int auctions = context->config.auction_open || context->config.auction_close;
+    for (uint32_t i = 0; i < symbol_count; i++) {
+        OrderBook* book = &context->order_books[i];
+        if (atomic_load_explicit(&book->phase_due, memory_order_relaxed) <= now) {
+            advance_auction(context, book, now);
+        }
+        if (atomic_load_explicit(&book->next_expiry, memory_order_relaxed) <= now) {
+            expire_orders(context, book, now);
+        }
+        if (auctions) {
+            publish_indicative(context, book);
+        }
+        tick_store_prepare(context->tick_store, book, now);
+    }
+}
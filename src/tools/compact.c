@@ -0,0 +1,173 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <getopt.h>
+#include <sys/stat.h>
+#include "common/tick_archive.h"
+
+typedef struct {
+    const TickFile* files;
+    int file_count;
+    int file;
+    uint64_t record;
+    uint64_t mismatches;
+} VerifyState;
+
+static void print_usage(const char* program_name) {
+    printf("Usage: %s [options] FILE...\n", program_name);
+    printf("Compact one symbol-day of tick files (all segments, in order) into a\n");
+    printf("columnar archive.\n");
+    printf("Options:\n");
+    printf("  -o, --output FILE     Archive path (default: first input with .tca)\n");
+    printf("  -v, --verify          Decode the archive and compare it with the inputs\n");
+    printf("  -h, --help            Show this help message\n");
+}
+
+// SYMBOL.ticks and SYMBOL.N.ticks both become SYMBOL.tca
+static void default_output(const char* input, char* output, size_t size) {
+    snprintf(output, size, "%s", input);
+    char* extension = strstr(output, ".ticks");
+    if (extension) *extension = '\0';
+
+    char* segment = strrchr(output, '.');
+    char* slash = strrchr(output, '/');
+    if (segment && (!slash || segment > slash) && segment[1] != '\0' &&
+        strspn(segment + 1, "0123456789") == strlen(segment + 1)) {
+        *segment = '\0';
+    }
+    strncat(output, ".tca", size - strlen(output) - 1);
+}
+
+static int verify_block(const TickBlockView* view, void* arg) {
+    VerifyState* state = arg;
+
+    for (uint32_t i = 0; i < view->count; i++) {
+        while (state->file < state->file_count &&
+               state->record == tick_file_count(&state->files[state->file])) {
+            state->file++;
+            state->record = 0;
+        }
+        if (state->file == state->file_count) {
+            state->mismatches++;
+            return 1;
+        }
+
+        const TickRecord* record = &state->files[state->file].records[state->record++];
+        int64_t expected[TICK_COLUMN_COUNT] = {
+            [TICK_COLUMN_TIMESTAMP] = (int64_t)record->timestamp,
+            [TICK_COLUMN_TYPE] = record->type,
+            [TICK_COLUMN_QUANTITY] = record->quantity,
+            [TICK_COLUMN_PRICE] = record->price,
+            [TICK_COLUMN_BID] = record->bid,
+            [TICK_COLUMN_ASK] = record->ask,
+            [TICK_COLUMN_BID_SIZE] = record->bid_size,
+            [TICK_COLUMN_ASK_SIZE] = record->ask_size,
+            [TICK_COLUMN_VOLUME] = (int64_t)record->volume,
+            [TICK_COLUMN_ID] = (int64_t)record->id
+        };
+        for (int column = 0; column < TICK_COLUMN_COUNT; column++) {
+            if (view->columns[column][i] != expected[column]) {
+                state->mismatches++;
+                break;
+            }
+        }
+    }
+    return 0;
+}
+
+int main(int argc, char* argv[]) {
+    char output[512] = "";
+    int verify = 0;
+
+    static struct option long_options[] = {
+        {"output",    required_argument, 0, 'o'},
+        {"verify",    no_argument,       0, 'v'},
+        {"help",      no_argument,       0, 'h'},
+        {0, 0, 0, 0}
+    };
+
+    int opt;
+    while ((opt = getopt_long(argc, argv, "o:vh", long_options, NULL)) != -1) {
+        switch (opt) {
+            case 'o':
+                snprintf(output, sizeof(output), "%s", optarg);
+                break;
+            case 'v':
+                verify = 1;
+                break;
+            case 'h':
+                print_usage(argv[0]);
+                return EXIT_SUCCESS;
+            default:
+                print_usage(argv[0]);
+                return EXIT_FAILURE;
+        }
+    }
+
+    if (optind >= argc) {
+        print_usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+    if (output[0] == '\0') {
+        default_output(argv[optind], output, sizeof(output));
+    }
+
+    int file_count = argc - optind;
+    TickFile* files = calloc((size_t)file_count, sizeof(TickFile));
+    if (!files) return EXIT_FAILURE;
+
+    int result = EXIT_SUCCESS;
+    uint64_t input_bytes = 0;
+    uint64_t records = 0;
+    for (int i = 0; i < file_count; i++) {
+        if (tick_file_open(&files[i], argv[optind + i]) != SUCCESS) {
+            fprintf(stderr, "%s is not a readable tick file\n", argv[optind + i]);
+            result = EXIT_FAILURE;
+            file_count = i;
+            break;
+        }
+        records += tick_file_count(&files[i]);
+        input_bytes += sizeof(TickFileHeader) + tick_file_count(&files[i]) * sizeof(TickRecord);
+    }
+
+    if (result == EXIT_SUCCESS) {
+        int written = tick_archive_write(output, files, file_count);
+        if (written == ERROR_INVALID_PARAM) {
+            fprintf(stderr, "Inputs must share one symbol and tick size\n");
+            result = EXIT_FAILURE;
+        } else if (written != SUCCESS) {
+            fprintf(stderr, "Failed to write %s\n", output);
+            result = EXIT_FAILURE;
+        }
+    }
+
+    if (result == EXIT_SUCCESS) {
+        struct stat st;
+        uint64_t output_bytes = stat(output, &st) == 0 ? (uint64_t)st.st_size : 0;
+        printf("%s: %lu records, %lu -> %lu bytes (%.1fx)\n", output, records, input_bytes,
+               output_bytes, output_bytes ? (double)input_bytes / (double)output_bytes : 0.0);
+    }
+
+    if (result == EXIT_SUCCESS && verify) {
+        TickArchive archive;
+        VerifyState state = { .files = files, .file_count = file_count };
+        int64_t rows = -1;
+        if (tick_archive_open(&archive, output) == SUCCESS) {
+            rows = tick_archive_scan(&archive, 0, UINT64_MAX, TICK_COLUMNS_ALL, verify_block, &state);
+            tick_archive_close(&archive);
+        }
+        if (rows != (int64_t)records || state.mismatches > 0) {
+            fprintf(stderr, "Verification failed: %ld of %lu rows decoded, %lu mismatches\n",
+                    rows, records, state.mismatches);
+            result = EXIT_FAILURE;
+        } else {
+            printf("Verified %ld records\n", rows);
+        }
+    }
+
+    for (int i = 0; i < file_count; i++) {
+        tick_file_close(&files[i]);
+    }
+    free(files);
+    return result;
+}
@@ -0,0 +1,455 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <getopt.h>
+#include <math.h>
+#include <stdatomic.h>
+#include "client/client.h"
+#include "common/clock.h"
+#include "common/latency.h"
+#include "common/utils.h"
+
+#define LOADGEN_DEFAULT_SESSIONS 4
+#define LOADGEN_MAX_SESSIONS 64
+#define LOADGEN_DEFAULT_RATE 10000
+#define LOADGEN_DEFAULT_DURATION_S 10
+#define LOADGEN_DEFAULT_DRAIN_MS 2000
+// Client order ids: run start second << 28 | session << 22 | order number
+#define LOADGEN_SESSION_BITS 22
+#define LOADGEN_MAX_SESSION_ORDERS (1u << LOADGEN_SESSION_BITS)
+
+// Per-order flags, written by the session's receiver thread
+#define ORDER_ACKED 1
+#define ORDER_FILLED 2
+
+typedef struct {
+    ClientContext* client;
+    int index;
+    pthread_t thread;
+    uint64_t first_order_id;
+    uint32_t capacity;
+
+    // Intended send time of every order, the base of both latencies
+    uint64_t* intended_ns;
+    uint8_t* flags;
+    _Atomic uint32_t sent;
+    uint64_t max_lag_ns;
+    uint32_t send_failures;
+    uint64_t random_state;
+
+    // Receiver side, owned by the client library's receiver thread
+    LatencyHistogram ack_latency;
+    LatencyHistogram fill_latency;
+    _Atomic uint64_t acks;
+    _Atomic uint64_t fills;
+    _Atomic uint64_t rejects;
+    _Atomic uint64_t throttled;     // Refused by a server rate limit, never acked
+} LoadSession;
+
+typedef struct {
+    LoadSession sessions[LOADGEN_MAX_SESSIONS];
+    int session_count;
+    char symbol[MAX_SYMBOL_LENGTH];
+    int64_t mid_ticks;
+    int32_t tick_exponent;
+    double rate;                // Orders per second over all sessions
+    int poisson;
+    uint32_t cross_percent;
+    uint64_t start_ns;
+    uint64_t end_ns;
+} LoadGenerator;
+
+static void print_usage(const char* program_name) {
+    printf("Usage: %s [options]\n", program_name);
+    printf("Submit orders to a running server over N sessions on an open-loop\n");
+    printf("schedule and report order-to-ack and order-to-fill latency.\n");
+    printf("Options:\n");
+    printf("  -H, --host HOST       Server host (default: 127.0.0.1)\n");
+    printf("  -p, --port PORT       Server port (default: %d)\n", DEFAULT_PORT);
+    printf("  -n, --sessions N      Concurrent sessions (default: %d, max %d)\n",
+           LOADGEN_DEFAULT_SESSIONS, LOADGEN_MAX_SESSIONS);
+    printf("  -r, --rate N          Orders per second over all sessions (default: %d)\n",
+           LOADGEN_DEFAULT_RATE);
+    printf("  -D, --duration SECS   Length of the run (default: %d)\n", LOADGEN_DEFAULT_DURATION_S);
+    printf("  -s, --symbol SYMBOL   Symbol to trade (default: AAPL)\n");
+    printf("  -P, --price PRICE     Mid price orders are placed around (default: 100.00)\n");
+    printf("  -x, --cross PCT       Percentage of orders priced to trade (default: 30)\n");
+    printf("  -e, --poisson         Exponential inter-arrival times instead of a fixed interval\n");
+    printf("  -i, --interval MS     Throughput sample interval (default: 1000)\n");
+    printf("  -o, --hdr PREFIX      Write PREFIX-ack.hgrm and PREFIX-fill.hgrm\n");
+    printf("  -h, --help            Show this help message\n");
+}
+
+static inline uint64_t next_random(uint64_t* state) {
+    // xorshift64*
+    *state ^= *state >> 12;
+    *state ^= *state << 25;
+    *state ^= *state >> 27;
+    return *state * 0x2545F4914F6CDD1DULL;
+}
+
+static LoadSession* session_for_order(LoadSession* session, uint64_t order_id, uint32_t* number) {
+    if (order_id < session->first_order_id) return NULL;
+    uint64_t offset = order_id - session->first_order_id;
+    if (offset >= atomic_load_explicit(&session->sent, memory_order_acquire)) return NULL;
+    *number = (uint32_t)offset;
+    return session;
+}
+
+// Latency is measured from the intended send time, so a stalled sender
+// shows up as latency instead of silently lowering the offered load
+static void record_fill(LoadSession* session, uint32_t number, uint64_t now) {
+    if (session->flags[number] & ORDER_FILLED) return;
+    session->flags[number] |= ORDER_FILLED;
+    latency_histogram_record(&session->fill_latency, now - session->intended_ns[number]);
+    atomic_fetch_add_explicit(&session->fills, 1, memory_order_relaxed);
+}
+
+static void on_order_status(const Order* order, void* user_data) {
+    LoadSession* session = user_data;
+    uint64_t now = clock_monotonic_raw_ns();
+    uint32_t number;
+    if (!session_for_order(session, order->client_order_id, &number)) return;
+
+    if (!(session->flags[number] & ORDER_ACKED)) {
+        session->flags[number] |= ORDER_ACKED;
+        latency_histogram_record(&session->ack_latency, now - session->intended_ns[number]);
+        atomic_fetch_add_explicit(&session->acks, 1, memory_order_relaxed);
+        if (order->status == ORDER_STATUS_REJECTED) {
+            atomic_fetch_add_explicit(&session->rejects, 1, memory_order_relaxed);
+        }
+    }
+    if (order->status == ORDER_STATUS_FILLED || order->status == ORDER_STATUS_PARTIAL ||
+        order->filled_quantity > 0) {
+        record_fill(session, number, now);
+    }
+}
+
+// The server answers a flood with one error per bucket refill, naming how
+// many rejects it left unanswered since the last
+static void on_error(ErrorCode error, const char* message, void* user_data) {
+    LoadSession* session = user_data;
+    if (error == ERROR_THROTTLED) {
+        uint64_t rejects = 1;
+        const char* more = message ? strchr(message, '(') : NULL;
+        unsigned long unanswered;
+        if (more && sscanf(more, "(%lu more throttled", &unanswered) == 1) {
+            rejects += unanswered;
+        }
+        atomic_fetch_add_explicit(&session->throttled, rejects, memory_order_relaxed);
+    }
+}
+
+// Trades carry the aggressor's client order id; resting orders are not matched
+static void on_trade(const TradeExecution* trade, void* user_data) {
+    LoadSession* session = user_data;
+    uint32_t number;
+    if (session_for_order(session, trade->client_order_id, &number)) {
+        record_fill(session, number, clock_monotonic_raw_ns());
+    }
+}
+
+static void build_order(const LoadGenerator* generator, LoadSession* session, Order* order) {
+    uint64_t random = next_random(&session->random_state);
+    int buy = random & 1;
+    int cross = (random >> 1) % 100 < generator->cross_percent;
+    int64_t offset = 1 + (int64_t)((random >> 8) % (cross ? 3 : 10));
+
+    // Crossing orders reach through the mid, the rest rest behind it
+    int64_t ticks = generator->mid_ticks + (buy == cross ? offset : -offset);
+
+    memset(order, 0, sizeof(*order));
+    memcpy(order->symbol, generator->symbol, MAX_SYMBOL_LENGTH);
+    order->type = ORDER_TYPE_LIMIT;
+    order->side = buy ? ORDER_SIDE_BUY : ORDER_SIDE_SELL;
+    order->status = ORDER_STATUS_NEW;
+    order->time_in_force = TIF_DAY;
+    order->price = price_from_ticks(ticks, generator->tick_exponent);
+    order->quantity = 100 * (uint32_t)(1 + ((random >> 16) % 10));
+    order->remaining_quantity = order->quantity;
+}
+
+typedef struct {
+    LoadGenerator* generator;
+    LoadSession* session;
+} SenderArgs;
+
+/**
+ * Open loop: every order has a send time fixed in advance. A sender that
+ * falls behind sends immediately but keeps the original times, so a slow
+ * server cannot hide its queueing by slowing the generator down.
+ */
+static void* sender_thread(void* arg) {
+    SenderArgs* args = arg;
+    LoadGenerator* generator = args->generator;
+    LoadSession* session = args->session;
+    double interval_ns = (double)NANOS_PER_SECOND * generator->session_count / generator->rate;
+
+    // Stagger sessions across one interval so their sends interleave
+    double due = (double)generator->start_ns + interval_ns * session->index / generator->session_count;
+    for (uint32_t number = 0; number < session->capacity; number++) {
+        if (generator->poisson) {
+            double uniform = (double)(next_random(&session->random_state) >> 11) / 9007199254740992.0;
+            due += -log(1.0 - uniform) * interval_ns;
+        } else if (number > 0) {
+            due += interval_ns;
+        }
+        uint64_t intended = (uint64_t)due;
+        if (intended >= generator->end_ns) break;
+        clock_wait_until(intended);
+
+        Order order;
+        build_order(generator, session, &order);
+        order.client_order_id = session->first_order_id + number;
+        session->intended_ns[number] = intended;
+        atomic_store_explicit(&session->sent, number + 1, memory_order_release);
+
+        uint64_t now = clock_monotonic_raw_ns();
+        if (now - intended > session->max_lag_ns) session->max_lag_ns = now - intended;
+        if (send_order(session->client, &order) != SUCCESS) {
+            session->send_failures++;
+            break;
+        }
+    }
+    return NULL;
+}
+
+static void totals(const LoadGenerator* generator, uint64_t* sent, uint64_t* acks, uint64_t* fills) {
+    *sent = *acks = *fills = 0;
+    for (int s = 0; s < generator->session_count; s++) {
+        const LoadSession* session = &generator->sessions[s];
+        *sent += atomic_load_explicit(&session->sent, memory_order_relaxed);
+        *acks += atomic_load_explicit(&session->acks, memory_order_relaxed);
+        *fills += atomic_load_explicit(&session->fills, memory_order_relaxed);
+    }
+}
+
+static void print_latency(const char* name, const LatencyHistogram* h) {
+    if (h->total_count == 0) {
+        printf("%-14s no samples\n", name);
+        return;
+    }
+    printf("%-14s p50 %9.1f  p90 %9.1f  p99 %9.1f  p99.9 %9.1f  p99.99 %9.1f  max %9.1f us\n", name,
+           (double)latency_histogram_percentile(h, 50.0) / 1e3,
+           (double)latency_histogram_percentile(h, 90.0) / 1e3,
+           (double)latency_histogram_percentile(h, 99.0) / 1e3,
+           (double)latency_histogram_percentile(h, 99.9) / 1e3,
+           (double)latency_histogram_percentile(h, 99.99) / 1e3,
+           (double)h->max / 1e3);
+}
+
+static int write_hdr(const char* prefix, const char* name, const LatencyHistogram* histogram) {
+    char path[512];
+    snprintf(path, sizeof(path), "%s-%s.hgrm", prefix, name);
+    FILE* output = fopen(path, "w");
+    if (!output) {
+        fprintf(stderr, "Failed to write %s\n", path);
+        return ERROR_INVALID_PARAM;
+    }
+    latency_histogram_print_distribution(histogram, output, (double)NANOS_PER_MICRO);
+    fclose(output);
+    return SUCCESS;
+}
+
+int main(int argc, char* argv[]) {
+    ClientConfig config = {
+        .server_port = DEFAULT_PORT,
+        .socket_timeout = DEFAULT_SOCKET_TIMEOUT,
+        .log_level = LOG_WARN
+    };
+    snprintf(config.server_host, sizeof(config.server_host), "127.0.0.1");
+
+    LoadGenerator* generator = calloc(1, sizeof(LoadGenerator));
+    if (!generator) return EXIT_FAILURE;
+    generator->session_count = LOADGEN_DEFAULT_SESSIONS;
+    generator->rate = LOADGEN_DEFAULT_RATE;
+    generator->cross_percent = 30;
+    snprintf(generator->symbol, sizeof(generator->symbol), "AAPL");
+    const char* mid_price = "100.00";
+    const char* hdr_prefix = NULL;
+    double duration_s = LOADGEN_DEFAULT_DURATION_S;
+    uint64_t interval_ms = 1000;
+
+    static struct option long_options[] = {
+        {"host",      required_argument, 0, 'H'},
+        {"port",      required_argument, 0, 'p'},
+        {"sessions",  required_argument, 0, 'n'},
+        {"rate",      required_argument, 0, 'r'},
+        {"duration",  required_argument, 0, 'D'},
+        {"symbol",    required_argument, 0, 's'},
+        {"price",     required_argument, 0, 'P'},
+        {"cross",     required_argument, 0, 'x'},
+        {"poisson",   no_argument,       0, 'e'},
+        {"interval",  required_argument, 0, 'i'},
+        {"hdr",       required_argument, 0, 'o'},
+        {"help",      no_argument,       0, 'h'},
+        {0, 0, 0, 0}
+    };
+
+    int opt;
+    while ((opt = getopt_long(argc, argv, "H:p:n:r:D:s:P:x:ei:o:h", long_options, NULL)) != -1) {
+        switch (opt) {
+            case 'H':
+                snprintf(config.server_host, sizeof(config.server_host), "%s", optarg);
+                break;
+            case 'p':
+                config.server_port = atoi(optarg);
+                break;
+            case 'n':
+                generator->session_count = atoi(optarg);
+                break;
+            case 'r':
+                generator->rate = atof(optarg);
+                break;
+            case 'D':
+                duration_s = atof(optarg);
+                break;
+            case 's':
+                snprintf(generator->symbol, sizeof(generator->symbol), "%s", optarg);
+                break;
+            case 'P':
+                mid_price = optarg;
+                break;
+            case 'x':
+                generator->cross_percent = (uint32_t)atoi(optarg);
+                break;
+            case 'e':
+                generator->poisson = 1;
+                break;
+            case 'i':
+                interval_ms = strtoull(optarg, NULL, 10);
+                break;
+            case 'o':
+                hdr_prefix = optarg;
+                break;
+            case 'h':
+                print_usage(argv[0]);
+                free(generator);
+                return EXIT_SUCCESS;
+            default:
+                print_usage(argv[0]);
+                free(generator);
+                return EXIT_FAILURE;
+        }
+    }
+
+    Price mid;
+    if (generator->session_count < 1 || generator->session_count > LOADGEN_MAX_SESSIONS ||
+        generator->rate <= 0.0 || duration_s <= 0.0 || interval_ms == 0 ||
+        parse_price_string(mid_price, &mid) != SUCCESS ||
+        price_to_ticks(mid, DEFAULT_TICK_EXPONENT, &generator->mid_ticks) < 0) {
+        print_usage(argv[0]);
+        free(generator);
+        return EXIT_FAILURE;
+    }
+    generator->tick_exponent = DEFAULT_TICK_EXPONENT;
+
+    init_logger(NULL, config.log_level);
+    clock_ticks_per_second();
+
+    // Ids unique per run second, so reruns against one server never collide
+    uint64_t run_base = (clock_now_ns() / NANOS_PER_SECOND) << 28;
+    double per_session = generator->rate * duration_s / generator->session_count;
+    uint32_t capacity = per_session * (generator->poisson ? 1.2 : 1.0) + 1024 > LOADGEN_MAX_SESSION_ORDERS ?
+                        LOADGEN_MAX_SESSION_ORDERS :
+                        (uint32_t)(per_session * (generator->poisson ? 1.2 : 1.0)) + 1024;
+
+    int result = EXIT_SUCCESS;
+    SenderArgs args[LOADGEN_MAX_SESSIONS];
+    ClientCallbacks callbacks = { .on_order_status = on_order_status, .on_trade = on_trade,
+                                  .on_error = on_error };
+    for (int s = 0; s < generator->session_count && result == EXIT_SUCCESS; s++) {
+        LoadSession* session = &generator->sessions[s];
+        session->index = s;
+        session->capacity = capacity;
+        session->first_order_id = run_base | ((uint64_t)s << LOADGEN_SESSION_BITS);
+        session->random_state = 0x9E3779B97F4A7C15ULL * (uint64_t)(s + 1) ^ clock_now_ns();
+        session->intended_ns = calloc(capacity, sizeof(uint64_t));
+        session->flags = calloc(capacity, sizeof(uint8_t));
+        latency_histogram_reset(&session->ack_latency);
+        latency_histogram_reset(&session->fill_latency);
+
+        ClientConfig session_config = config;
+        snprintf(session_config.client_id, MAX_CLIENT_ID_LENGTH, "load-%d-%d", (int)getpid(), s);
+        session->client = initialize_client(&session_config, &callbacks, session);
+        if (!session->intended_ns || !session->flags || !session->client ||
+            connect_to_server(session->client) != SUCCESS) {
+            fprintf(stderr, "Failed to open session %d to %s:%d\n", s,
+                    config.server_host, config.server_port);
+            result = EXIT_FAILURE;
+        }
+    }
+
+    if (result == EXIT_SUCCESS) {
+        generator->start_ns = clock_monotonic_raw_ns() + 10 * NANOS_PER_MILLI;
+        generator->end_ns = generator->start_ns + (uint64_t)(duration_s * (double)NANOS_PER_SECOND);
+        for (int s = 0; s < generator->session_count; s++) {
+            args[s] = (SenderArgs){ .generator = generator, .session = &generator->sessions[s] };
+            if (pthread_create(&generator->sessions[s].thread, NULL, sender_thread, &args[s]) != 0) {
+                fprintf(stderr, "Failed to start session %d\n", s);
+                exit(EXIT_FAILURE);
+            }
+        }
+
+        // Throughput time series, one line per interval until the acks drain
+        printf("%8s %10s %10s %10s %10s\n", "time_s", "sent/s", "acked/s", "filled/s", "in_flight");
+        uint64_t interval_ns = interval_ms * NANOS_PER_MILLI;
+        uint64_t drain_end = generator->end_ns + LOADGEN_DEFAULT_DRAIN_MS * NANOS_PER_MILLI;
+        uint64_t last_sent = 0, last_acks = 0, last_fills = 0;
+        for (uint64_t tick = generator->start_ns + interval_ns; ; tick += interval_ns) {
+            clock_wait_until(tick);
+            uint64_t sent, acks, fills;
+            totals(generator, &sent, &acks, &fills);
+            double seconds = (double)interval_ns / (double)NANOS_PER_SECOND;
+            printf("%8.1f %10.0f %10.0f %10.0f %10lu\n",
+                   (double)(tick - generator->start_ns) / (double)NANOS_PER_SECOND,
+                   (double)(sent - last_sent) / seconds, (double)(acks - last_acks) / seconds,
+                   (double)(fills - last_fills) / seconds, sent - acks);
+            fflush(stdout);
+            last_sent = sent;
+            last_acks = acks;
+            last_fills = fills;
+            if (tick >= generator->end_ns && (acks >= sent || tick >= drain_end)) break;
+        }
+
+        LatencyHistogram ack_latency, fill_latency;
+        latency_histogram_reset(&ack_latency);
+        latency_histogram_reset(&fill_latency);
+        uint64_t max_lag = 0, rejects = 0, throttled = 0, failures = 0;
+        for (int s = 0; s < generator->session_count; s++) {
+            LoadSession* session = &generator->sessions[s];
+            pthread_join(session->thread, NULL);
+            disconnect_from_server(session->client);
+            latency_histogram_merge(&ack_latency, &session->ack_latency);
+            latency_histogram_merge(&fill_latency, &session->fill_latency);
+            if (session->max_lag_ns > max_lag) max_lag = session->max_lag_ns;
+            rejects += atomic_load(&session->rejects);
+            throttled += atomic_load(&session->throttled);
+            failures += session->send_failures;
+        }
+
+        uint64_t sent, acks, fills;
+        totals(generator, &sent, &acks, &fills);
+        printf("\nSent %lu orders at %.0f/s target over %d sessions (%s arrivals), %lu send failures\n",
+               sent, generator->rate, generator->session_count,
+               generator->poisson ? "poisson" : "uniform", failures);
+        printf("Acked %lu (%lu rejected), missing %lu (%lu throttled); filled %lu; max sender lag %.3f ms\n",
+               acks, rejects, sent - acks, throttled, fills, (double)max_lag / 1e6);
+        print_latency("order-to-ack", &ack_latency);
+        print_latency("order-to-fill", &fill_latency);
+
+        if (hdr_prefix && (write_hdr(hdr_prefix, "ack", &ack_latency) != SUCCESS ||
+                           write_hdr(hdr_prefix, "fill", &fill_latency) != SUCCESS)) {
+            result = EXIT_FAILURE;
+        }
+    }
+
+    for (int s = 0; s < generator->session_count; s++) {
+        cleanup_client(generator->sessions[s].client);
+        free(generator->sessions[s].intended_ns);
+        free(generator->sessions[s].flags);
+    }
+    free(generator);
+    close_logger();
+    return result;
+}
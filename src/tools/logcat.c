@@ -0,0 +1,226 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <getopt.h>
+#include "common/logger.h"
+#include "common/binary_log.h"
+
+// Decoded call-site table for the current header
+typedef struct {
+    uint32_t level;
+    uint32_t line;
+    char* file;
+    char* func;
+    char* format;
+} DecodedSite;
+
+typedef struct {
+    LogBinaryHeader header;
+    DecodedSite* sites;
+    uint32_t site_count;
+} DecodeState;
+
+static void print_usage(const char* program_name) {
+    printf("Usage: %s [options] FILE...\n", program_name);
+    printf("Decode binary TradeSynth logs to text.\n");
+    printf("Options:\n");
+    printf("  -l, --min-level LVL   Only print records at or above level (0-5)\n");
+    printf("  -r, --raw-ticks       Print raw tick counts instead of wall clock time\n");
+    printf("  -h, --help            Show this help message\n");
+}
+
+static char* read_string(FILE* input, size_t length) {
+    char* value = malloc(length + 1);
+    if (!value) return NULL;
+    if (fread(value, 1, length, input) != length) {
+        free(value);
+        return NULL;
+    }
+    value[length] = '\0';
+    return value;
+}
+
+static void free_sites(DecodeState* state) {
+    for (uint32_t i = 0; i < state->site_count; i++) {
+        free(state->sites[i].file);
+        free(state->sites[i].func);
+        free(state->sites[i].format);
+    }
+    free(state->sites);
+    state->sites = NULL;
+    state->site_count = 0;
+}
+
+/**
+ * Read a header and its site table; the magic has already been consumed.
+ */
+static int read_header(FILE* input, DecodeState* state) {
+    free_sites(state);
+
+    memcpy(state->header.magic, LOG_BINARY_MAGIC, LOG_BINARY_MAGIC_LENGTH);
+    size_t rest = sizeof(LogBinaryHeader) - LOG_BINARY_MAGIC_LENGTH;
+    if (fread((char*)&state->header + LOG_BINARY_MAGIC_LENGTH, 1, rest, input) != rest) {
+        return -1;
+    }
+    if (state->header.version != LOG_BINARY_VERSION) {
+        fprintf(stderr, "Unsupported binary log version %u\n", state->header.version);
+        return -1;
+    }
+
+    state->sites = calloc(state->header.site_count ? state->header.site_count : 1,
+                          sizeof(DecodedSite));
+    if (!state->sites) return -1;
+
+    for (uint32_t i = 0; i < state->header.site_count; i++) {
+        LogBinarySiteEntry entry;
+        if (fread(&entry, sizeof(entry), 1, input) != 1 || entry.id != i) return -1;
+
+        DecodedSite* site = &state->sites[i];
+        state->site_count = i + 1;
+        site->level = entry.level;
+        site->line = entry.line;
+        site->file = read_string(input, entry.file_length);
+        site->func = read_string(input, entry.func_length);
+        site->format = read_string(input, entry.format_length);
+        if (!site->file || !site->func || !site->format) return -1;
+    }
+    return 0;
+}
+
+static void print_line(const DecodeState* state, uint64_t ticks, uint32_t level,
+                       const char* file, uint32_t line, const char* func,
+                       const char* message, int raw_ticks) {
+    const LogBinaryHeader* header = &state->header;
+    char timestamp[48];
+
+    if (raw_ticks) {
+        snprintf(timestamp, sizeof(timestamp), "%lu", ticks);
+    } else {
+        double elapsed_ns = ((double)(int64_t)(ticks - header->base_ticks) * 1e9) /
+                            (double)header->ticks_per_second;
+        int64_t wall_ns = header->base_realtime_ns + (int64_t)elapsed_ns;
+        time_t seconds = (time_t)(wall_ns / 1000000000LL);
+        struct tm local_time;
+        localtime_r(&seconds, &local_time);
+        size_t length = strftime(timestamp, sizeof(timestamp), "%Y-%m-%d %H:%M:%S", &local_time);
+        snprintf(timestamp + length, sizeof(timestamp) - length, ".%09ld",
+                 (long)(wall_ns % 1000000000LL));
+    }
+
+    printf("%s [%-5s] (%s:%u - %s) %s\n", timestamp, log_level_to_string((LogLevel)level),
+           file, line, func, message);
+}
+
+static int decode_file(const char* path, LogLevel min_level, int raw_ticks) {
+    FILE* input = fopen(path, "rb");
+    if (!input) {
+        fprintf(stderr, "Failed to open %s\n", path);
+        return -1;
+    }
+
+    DecodeState state;
+    memset(&state, 0, sizeof(state));
+    uint8_t payload[65536 + 1];
+    char message[4096];
+    int have_header = 0;
+    int result = 0;
+
+    for (;;) {
+        LogBinaryRecordHeader record;
+        if (fread(&record, 1, LOG_BINARY_MAGIC_LENGTH, input) != LOG_BINARY_MAGIC_LENGTH) break;
+
+        if (memcmp(&record, LOG_BINARY_MAGIC, LOG_BINARY_MAGIC_LENGTH) == 0) {
+            if (read_header(input, &state) < 0) {
+                fprintf(stderr, "%s: corrupt header\n", path);
+                result = -1;
+                break;
+            }
+            have_header = 1;
+            continue;
+        }
+
+        size_t rest = sizeof(record) - LOG_BINARY_MAGIC_LENGTH;
+        if (!have_header ||
+            fread((uint8_t*)&record + LOG_BINARY_MAGIC_LENGTH, 1, rest, input) != rest ||
+            fread(payload, 1, record.payload_size, input) != record.payload_size) {
+            fprintf(stderr, "%s: truncated or corrupt record\n", path);
+            result = -1;
+            break;
+        }
+        if (record.level < (uint32_t)min_level) continue;
+
+        if (record.site_id == LOG_SITE_DYNAMIC) {
+            // uint32 line, file\0, func\0, message
+            payload[record.payload_size] = '\0';
+            uint32_t line = 0;
+            memcpy(&line, payload, sizeof(line));
+            const char* file = (const char*)payload + sizeof(line);
+            const char* func = file + strlen(file) + 1;
+            const char* text = func + strlen(func) + 1;
+            if (text > (const char*)payload + record.payload_size) text = "";
+            print_line(&state, record.ticks, record.level, file, line, func, text, raw_ticks);
+            continue;
+        }
+
+        if (record.site_id >= state.site_count) {
+            fprintf(stderr, "%s: unknown call site %u\n", path, record.site_id);
+            continue;
+        }
+
+        const DecodedSite* site = &state.sites[record.site_id];
+        if (format_log_payload(site->format, payload, record.payload_size,
+                               message, sizeof(message)) < 0) {
+            snprintf(message, sizeof(message), "<undecodable payload for \"%s\">", site->format);
+        }
+        print_line(&state, record.ticks, record.level, site->file, site->line,
+                   site->func, message, raw_ticks);
+    }
+
+    free_sites(&state);
+    fclose(input);
+    return result;
+}
+
+int main(int argc, char* argv[]) {
+    LogLevel min_level = LOG_TRACE;
+    int raw_ticks = 0;
+
+    static struct option long_options[] = {
+        {"min-level", required_argument, 0, 'l'},
+        {"raw-ticks", no_argument,       0, 'r'},
+        {"help",      no_argument,       0, 'h'},
+        {0, 0, 0, 0}
+    };
+
+    int opt;
+    while ((opt = getopt_long(argc, argv, "l:rh", long_options, NULL)) != -1) {
+        switch (opt) {
+            case 'l':
+                min_level = atoi(optarg);
+                break;
+            case 'r':
+                raw_ticks = 1;
+                break;
+            case 'h':
+                print_usage(argv[0]);
+                return EXIT_SUCCESS;
+            default:
+                print_usage(argv[0]);
+                return EXIT_FAILURE;
+        }
+    }
+
+    if (optind >= argc) {
+        print_usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    int result = EXIT_SUCCESS;
+    for (int i = optind; i < argc; i++) {
+        if (decode_file(argv[i], min_level, raw_ticks) < 0) {
+            result = EXIT_FAILURE;
+        }
+    }
+    return result;
+}
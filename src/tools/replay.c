@@ -0,0 +1,788 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <getopt.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sched.h>
+#include <netdb.h>
+#include <stdatomic.h>
+#include <sys/epoll.h>
+#include <netinet/tcp.h>
+#include "common/types.h"
+#include "common/clock.h"
+#include "common/latency.h"
+#include "common/utils.h"
+#include "common/tick_store.h"
+#include "server/server_journal.h"
+#include "serialization/serialization.h"
+
+#define REPLAY_DEFAULT_SESSIONS 8
+#define REPLAY_MAX_SESSIONS 64
+#define REPLAY_DEFAULT_DRAIN_MS 2000
+#define REPLAY_LINE_SIZE 1024
+#define REPLAY_NO_SERVER_ID UINT64_MAX
+
+typedef enum {
+    PACE_ORIGINAL,      // Capture timestamps, scaled by speed
+    PACE_RATE,          // Fixed messages per second
+    PACE_MAX            // As fast as the sessions can send
+} PaceMode;
+
+typedef struct {
+    uint64_t timestamp;         // Capture time, nanoseconds since the epoch
+    uint64_t due;               // Send time relative to the start
+    MessageType type;
+    uint32_t session;
+    uint32_t index;             // Input order, breaks timestamp ties
+    union {
+        Order order;
+        MarketData market_data;
+    } data;
+} ReplayEvent;
+
+// Loaded order id -> send time of the request awaiting its status. The
+// loaded id travels as the client order id; the server assigns its own,
+// learned from the first status, which later cancels and modifies name.
+// Keys are written while loading; the rest changes during the run.
+typedef struct {
+    uint64_t order_id;
+    _Atomic uint64_t sent_ns;
+    _Atomic uint64_t server_id;     // REPLAY_NO_SERVER_ID once the order is refused
+} PendingSlot;
+
+typedef struct {
+    int socket;
+    char client_id[MAX_CLIENT_ID_LENGTH];
+    pthread_t thread;
+    ReplayEvent** events;       // This session's share, in send order
+    uint32_t event_count;
+    uint32_t sent;
+    uint32_t unknown;           // Cancels and modifies of orders the server never acked
+    uint64_t max_lag_ns;
+    size_t buffered;
+    uint8_t buffer[BUFFER_SIZE];
+} ReplaySession;
+
+typedef struct {
+    ReplayEvent* events;
+    uint32_t event_count;
+    uint32_t event_capacity;
+    char (*clients)[MAX_CLIENT_ID_LENGTH];
+    uint32_t client_count;
+    uint32_t client_capacity;
+    uint32_t next_order_id;
+
+    PendingSlot* pending;
+    uint64_t pending_mask;
+
+    ReplaySession sessions[REPLAY_MAX_SESSIONS];
+    int session_count;
+    uint64_t start_ns;
+    uint64_t senders_done_ns;
+    uint64_t drain_ns;
+    atomic_int senders_running;
+
+    // Receiver results
+    LatencyHistogram ack_latency;
+    uint64_t acks;
+    uint64_t rejects;
+    uint64_t trades;
+    uint64_t quotes_received;
+} Replay;
+
+static void print_usage(const char* program_name) {
+    printf("Usage: %s [options] FILE...\n", program_name);
+    printf("Replay orders and market data into a running server and report\n");
+    printf("throughput and order-to-ack latency. FILE is an order journal, a tick\n");
+    printf("file or a JSONL order file; several inputs are merged by timestamp.\n");
+    printf("Options:\n");
+    printf("  -H, --host HOST       Server host (default: 127.0.0.1)\n");
+    printf("  -p, --port PORT       Server port (default: 8080)\n");
+    printf("  -n, --sessions N      Concurrent sessions (default: %d, max %d)\n",
+           REPLAY_DEFAULT_SESSIONS, REPLAY_MAX_SESSIONS);
+    printf("  -x, --speed N         Replay at N times the captured pace (default: 1)\n");
+    printf("  -r, --rate N          Send N messages per second, ignoring capture times\n");
+    printf("  -m, --max-rate        Send as fast as possible\n");
+    printf("  -d, --drain MS        Wait up to MS for outstanding acks (default: %d)\n",
+           REPLAY_DEFAULT_DRAIN_MS);
+    printf("  -h, --help            Show this help message\n");
+    printf("\nJSONL fields: time (ns), type (new|cancel|modify|quote), order_id,\n");
+    printf("client_id, symbol, side (buy|sell), order_type (limit|market), price,\n");
+    printf("quantity, display (iceberg slice), tif (day|ioc|fok|gtc); quotes use\n");
+    printf("bid, ask, bid_size, ask_size, last, last_size and volume.\n");
+}
+
+static ReplayEvent* append_event(Replay* replay, uint64_t timestamp, MessageType type) {
+    if (replay->event_count == replay->event_capacity) {
+        uint32_t capacity = replay->event_capacity ? replay->event_capacity * 2 : 4096;
+        ReplayEvent* events = realloc(replay->events, capacity * sizeof(ReplayEvent));
+        if (!events) return NULL;
+        replay->events = events;
+        replay->event_capacity = capacity;
+    }
+
+    ReplayEvent* event = &replay->events[replay->event_count];
+    memset(event, 0, sizeof(*event));
+    event->timestamp = timestamp;
+    event->type = type;
+    event->index = replay->event_count++;
+    return event;
+}
+
+/**
+ * Find "key" in a flat JSON object and copy its value, unquoted, into
+ * value. Enough for one-order-per-line files; nested objects and string
+ * escapes other than \" are not supported.
+ */
+static int json_field(const char* line, const char* key, char* value, size_t size) {
+    char pattern[64];
+    snprintf(pattern, sizeof(pattern), "\"%s\"", key);
+
+    const char* p = strstr(line, pattern);
+    if (!p) return 0;
+    p += strlen(pattern);
+    while (*p == ' ' || *p == '\t') p++;
+    if (*p++ != ':') return 0;
+    while (*p == ' ' || *p == '\t') p++;
+
+    size_t length = 0;
+    if (*p == '"') {
+        p++;
+        while (*p && *p != '"' && length + 1 < size) {
+            if (*p == '\\' && p[1]) p++;
+            value[length++] = *p++;
+        }
+    } else {
+        while (*p && *p != ',' && *p != '}' && *p != ' ' && *p != '\n' && length + 1 < size) {
+            value[length++] = *p++;
+        }
+    }
+    value[length] = '\0';
+    return length > 0;
+}
+
+static uint64_t json_u64(const char* line, const char* key, uint64_t fallback) {
+    char value[32];
+    return json_field(line, key, value, sizeof(value)) ? strtoull(value, NULL, 10) : fallback;
+}
+
+static int json_price(const char* line, const char* key, Price* price) {
+    char value[48];
+    *price = create_price(0, DEFAULT_PRICE_EXPONENT);
+    return json_field(line, key, value, sizeof(value)) ? parse_price_string(value, price) : SUCCESS;
+}
+
+static int parse_jsonl_line(Replay* replay, const char* line) {
+    char type[16] = "new";
+    char value[MAX_CLIENT_ID_LENGTH];
+    json_field(line, "type", type, sizeof(type));
+
+    uint64_t timestamp = json_u64(line, "time", json_u64(line, "timestamp", 0));
+    char symbol[MAX_SYMBOL_LENGTH] = "";
+    if (!json_field(line, "symbol", symbol, sizeof(symbol))) return ERROR_INVALID_MESSAGE;
+
+    if (strcmp(type, "quote") == 0) {
+        ReplayEvent* event = append_event(replay, timestamp, MSG_MARKET_DATA);
+        if (!event) return ERROR_MEMORY_ALLOC;
+        MarketData* data = &event->data.market_data;
+        memcpy(data->symbol, symbol, MAX_SYMBOL_LENGTH);
+        if (json_price(line, "bid", &data->bid) != SUCCESS ||
+            json_price(line, "ask", &data->ask) != SUCCESS ||
+            json_price(line, "last", &data->last_price) != SUCCESS) {
+            return ERROR_INVALID_MESSAGE;
+        }
+        data->bid_size = (uint32_t)json_u64(line, "bid_size", 0);
+        data->ask_size = (uint32_t)json_u64(line, "ask_size", 0);
+        data->last_size = (uint32_t)json_u64(line, "last_size", 0);
+        data->volume = json_u64(line, "volume", 0);
+        data->timestamp = timestamp;
+        return SUCCESS;
+    }
+
+    MessageType message_type = strcmp(type, "new") == 0 ? MSG_ORDER_NEW :
+                               strcmp(type, "cancel") == 0 ? MSG_ORDER_CANCEL :
+                               strcmp(type, "modify") == 0 ? MSG_ORDER_MODIFY : MSG_NONE;
+    if (message_type == MSG_NONE) return ERROR_INVALID_MESSAGE;
+
+    ReplayEvent* event = append_event(replay, timestamp, message_type);
+    if (!event) return ERROR_MEMORY_ALLOC;
+    Order* order = &event->data.order;
+    memcpy(order->symbol, symbol, MAX_SYMBOL_LENGTH);
+    snprintf(order->client_id, MAX_CLIENT_ID_LENGTH, "replay");
+    if (json_field(line, "client_id", value, sizeof(value))) {
+        memcpy(order->client_id, value, MAX_CLIENT_ID_LENGTH);
+    }
+
+    // Orders without an id get one, so their acks can still be matched
+    order->order_id = json_u64(line, "order_id", 0);
+    if (order->order_id == 0) {
+        if (message_type != MSG_ORDER_NEW) return ERROR_INVALID_ORDER;
+        order->order_id = ++replay->next_order_id;
+    }
+
+    order->side = json_field(line, "side", value, sizeof(value)) && strcmp(value, "sell") == 0 ?
+                  ORDER_SIDE_SELL : ORDER_SIDE_BUY;
+    if (json_price(line, "price", &order->price) != SUCCESS) return ERROR_INVALID_ORDER;
+    order->type = order->price.mantissa > 0 ? ORDER_TYPE_LIMIT : ORDER_TYPE_MARKET;
+    if (json_field(line, "order_type", value, sizeof(value))) {
+        order->type = strcmp(value, "market") == 0 ? ORDER_TYPE_MARKET : ORDER_TYPE_LIMIT;
+    }
+
+    order->time_in_force = TIF_DAY;
+    if (json_field(line, "tif", value, sizeof(value))) {
+        order->time_in_force = strcmp(value, "ioc") == 0 ? TIF_IOC :
+                               strcmp(value, "fok") == 0 ? TIF_FOK :
+                               strcmp(value, "gtc") == 0 ? TIF_GTC : TIF_DAY;
+    }
+    order->status = ORDER_STATUS_NEW;
+    order->quantity = (uint32_t)json_u64(line, "quantity", 0);
+    order->remaining_quantity = order->quantity;
+    order->display_quantity = (uint32_t)json_u64(line, "display", 0);
+    order->creation_time = timestamp;
+    return SUCCESS;
+}
+
+static int load_jsonl(Replay* replay, const char* path) {
+    FILE* file = fopen(path, "r");
+    if (!file) return ERROR_INVALID_PARAM;
+
+    char line[REPLAY_LINE_SIZE];
+    int line_number = 0;
+    int result = SUCCESS;
+    while (fgets(line, sizeof(line), file)) {
+        line_number++;
+        char* text = trim_whitespace(line);
+        if (text[0] == '\0' || text[0] == '#') continue;
+
+        result = parse_jsonl_line(replay, text);
+        if (result != SUCCESS) {
+            fprintf(stderr, "%s:%d: invalid record\n", path, line_number);
+            break;
+        }
+    }
+    fclose(file);
+    return result;
+}
+
+// Inbound order events of a journal; trades are the server's own output
+static int load_journal(Replay* replay, FILE* file) {
+    JournalFileHeader header;
+    if (fread(&header, sizeof(header), 1, file) != 1 ||
+        header.version != JOURNAL_VERSION || header.record_size != sizeof(JournalRecord)) {
+        return ERROR_INVALID_STATE;
+    }
+
+    JournalRecord record;
+    uint64_t expected = 0;
+    while (fread(&record, sizeof(record), 1, file) == 1) {
+        // Sequences are dense; a gap means a torn or foreign tail
+        if (expected && record.sequence != expected) break;
+        expected = record.sequence + 1;
+
+        MessageType type = record.type == JOURNAL_ORDER_NEW ? MSG_ORDER_NEW :
+                           record.type == JOURNAL_ORDER_CANCEL ? MSG_ORDER_CANCEL :
+                           record.type == JOURNAL_ORDER_MODIFY ? MSG_ORDER_MODIFY : MSG_NONE;
+        if (type == MSG_NONE) continue;
+
+        ReplayEvent* event = append_event(replay, record.timestamp, type);
+        if (!event) return ERROR_MEMORY_ALLOC;
+        event->data.order = record.data.order;
+    }
+    return SUCCESS;
+}
+
+// Quotes of a tick file; trade ticks are produced by matching the orders
+static int load_ticks(Replay* replay, const char* path) {
+    TickFile file;
+    if (tick_file_open(&file, path) != SUCCESS) return ERROR_INVALID_STATE;
+
+    uint64_t count = tick_file_count(&file);
+    for (uint64_t i = 0; i < count; i++) {
+        const TickRecord* tick = &file.records[i];
+        if (tick->type != TICK_MARKET_DATA) continue;
+
+        ReplayEvent* event = append_event(replay, tick->timestamp, MSG_MARKET_DATA);
+        if (!event) {
+            tick_file_close(&file);
+            return ERROR_MEMORY_ALLOC;
+        }
+        MarketData* data = &event->data.market_data;
+        memcpy(data->symbol, file.header->symbol, MAX_SYMBOL_LENGTH);
+        data->last_price = tick_price(&file, tick->price);
+        data->last_size = tick->quantity;
+        data->bid = tick_price(&file, tick->bid);
+        data->ask = tick_price(&file, tick->ask);
+        data->bid_size = tick->bid_size;
+        data->ask_size = tick->ask_size;
+        data->volume = tick->volume;
+        data->timestamp = tick->timestamp;
+    }
+    tick_file_close(&file);
+    return SUCCESS;
+}
+
+static int load_input(Replay* replay, const char* path) {
+    FILE* file = fopen(path, "rb");
+    if (!file) return ERROR_INVALID_PARAM;
+
+    char magic[8] = {0};
+    size_t magic_size = fread(magic, 1, sizeof(magic), file);
+    rewind(file);
+
+    int result;
+    if (magic_size == sizeof(magic) && memcmp(magic, JOURNAL_MAGIC, sizeof(magic)) == 0) {
+        result = load_journal(replay, file);
+        fclose(file);
+    } else if (magic_size == sizeof(magic) && memcmp(magic, TICK_STORE_MAGIC, sizeof(magic)) == 0) {
+        fclose(file);
+        result = load_ticks(replay, path);
+    } else {
+        fclose(file);
+        result = load_jsonl(replay, path);
+    }
+    return result;
+}
+
+static int compare_events(const void* a, const void* b) {
+    const ReplayEvent* left = a;
+    const ReplayEvent* right = b;
+    if (left->timestamp != right->timestamp) return left->timestamp < right->timestamp ? -1 : 1;
+    return left->index < right->index ? -1 : left->index > right->index;
+}
+
+static uint32_t client_index(Replay* replay, const char* client_id) {
+    for (uint32_t i = 0; i < replay->client_count; i++) {
+        if (strncmp(replay->clients[i], client_id, MAX_CLIENT_ID_LENGTH) == 0) return i;
+    }
+    if (replay->client_count == replay->client_capacity) {
+        uint32_t capacity = replay->client_capacity ? replay->client_capacity * 2 : 64;
+        void* clients = realloc(replay->clients, (size_t)capacity * MAX_CLIENT_ID_LENGTH);
+        if (!clients) return UINT32_MAX;
+        replay->clients = clients;
+        replay->client_capacity = capacity;
+    }
+    memcpy(replay->clients[replay->client_count], client_id, MAX_CLIENT_ID_LENGTH);
+    return replay->client_count++;
+}
+
+static PendingSlot* find_pending(const Replay* replay, uint64_t order_id) {
+    uint64_t slot = (order_id * 0x9E3779B97F4A7C15ULL) & replay->pending_mask;
+    while (replay->pending[slot].order_id != 0) {
+        if (replay->pending[slot].order_id == order_id) return &replay->pending[slot];
+        slot = (slot + 1) & replay->pending_mask;
+    }
+    return NULL;
+}
+
+/**
+ * Order the events, compute send times and split them over the sessions.
+ * Each original client stays on one session so its requests arrive in
+ * order; the server routes acks by client id, so orders carry the id of
+ * the session that sends them.
+ */
+static int plan_replay(Replay* replay, PaceMode mode, double speed, double rate) {
+    qsort(replay->events, replay->event_count, sizeof(ReplayEvent), compare_events);
+
+    uint64_t pending_size = 16;
+    while (pending_size < (uint64_t)replay->event_count * 2) pending_size <<= 1;
+    replay->pending = calloc(pending_size, sizeof(PendingSlot));
+    if (!replay->pending) return ERROR_MEMORY_ALLOC;
+    replay->pending_mask = pending_size - 1;
+
+    uint32_t counts[REPLAY_MAX_SESSIONS] = {0};
+    uint64_t first = replay->event_count ? replay->events[0].timestamp : 0;
+    for (uint32_t i = 0; i < replay->event_count; i++) {
+        ReplayEvent* event = &replay->events[i];
+        switch (mode) {
+            case PACE_ORIGINAL:
+                event->due = (uint64_t)((double)(event->timestamp - first) / speed);
+                break;
+            case PACE_RATE:
+                event->due = (uint64_t)((double)i * (double)NANOS_PER_SECOND / rate);
+                break;
+            case PACE_MAX:
+                event->due = 0;
+                break;
+        }
+
+        if (event->type == MSG_MARKET_DATA) {
+            event->session = i % (uint32_t)replay->session_count;
+        } else {
+            uint32_t client = client_index(replay, event->data.order.client_id);
+            if (client == UINT32_MAX) return ERROR_MEMORY_ALLOC;
+            event->session = client % (uint32_t)replay->session_count;
+
+            Order* order = &event->data.order;
+            order->client_order_id = order->order_id;
+            order->order_id = 0;
+            memcpy(order->client_id, replay->sessions[event->session].client_id, MAX_CLIENT_ID_LENGTH);
+            if (!find_pending(replay, order->client_order_id)) {
+                uint64_t slot = (order->client_order_id * 0x9E3779B97F4A7C15ULL) & replay->pending_mask;
+                while (replay->pending[slot].order_id != 0) {
+                    slot = (slot + 1) & replay->pending_mask;
+                }
+                replay->pending[slot].order_id = order->client_order_id;
+            }
+        }
+        counts[event->session]++;
+    }
+
+    for (int s = 0; s < replay->session_count; s++) {
+        replay->sessions[s].events = malloc(((size_t)counts[s] + 1) * sizeof(ReplayEvent*));
+        if (!replay->sessions[s].events) return ERROR_MEMORY_ALLOC;
+    }
+    for (uint32_t i = 0; i < replay->event_count; i++) {
+        ReplaySession* session = &replay->sessions[replay->events[i].session];
+        session->events[session->event_count++] = &replay->events[i];
+    }
+    return SUCCESS;
+}
+
+static int connect_session(ReplaySession* session, const char* host, int port) {
+    char service[16];
+    snprintf(service, sizeof(service), "%d", port);
+
+    struct addrinfo hints = { .ai_family = AF_INET, .ai_socktype = SOCK_STREAM };
+    struct addrinfo* address;
+    if (getaddrinfo(host, service, &hints, &address) != 0) return ERROR_SOCKET_CONNECT;
+
+    session->socket = socket(AF_INET, SOCK_STREAM, 0);
+    int result = session->socket >= 0 &&
+                 connect(session->socket, address->ai_addr, address->ai_addrlen) == 0 ?
+                 SUCCESS : ERROR_SOCKET_CONNECT;
+    freeaddrinfo(address);
+    if (result != SUCCESS) return result;
+
+    int no_delay = 1;
+    setsockopt(session->socket, IPPROTO_TCP, TCP_NODELAY, &no_delay, sizeof(no_delay));
+    return SUCCESS;
+}
+
+typedef struct {
+    Replay* replay;
+    ReplaySession* session;
+} SenderArgs;
+
+/**
+ * Wait for the server's id of an earlier order, up to the drain timeout.
+ * Returns 0 if the order was refused or never acked.
+ */
+static uint64_t await_server_id(const Replay* replay, PendingSlot* pending) {
+    uint64_t deadline = clock_monotonic_raw_ns() + replay->drain_ns;
+    uint64_t server_id;
+    while ((server_id = atomic_load_explicit(&pending->server_id, memory_order_acquire)) == 0) {
+        if (clock_monotonic_raw_ns() > deadline) return 0;
+        sched_yield();
+    }
+    return server_id == REPLAY_NO_SERVER_ID ? 0 : server_id;
+}
+
+static void* sender_thread(void* arg) {
+    SenderArgs* args = arg;
+    Replay* replay = args->replay;
+    ReplaySession* session = args->session;
+    uint8_t buffer[BUFFER_SIZE];
+    uint64_t sequence = 1;
+
+    for (uint32_t i = 0; i < session->event_count; i++) {
+        const ReplayEvent* event = session->events[i];
+        uint64_t due = replay->start_ns + event->due;
+        clock_wait_until(due);
+
+        Message msg = {
+            .type = event->type,
+            .sequence_num = sequence++,
+            .timestamp = clock_now_ns()
+        };
+        PendingSlot* pending = NULL;
+        if (event->type == MSG_MARKET_DATA) {
+            msg.data.market_data = event->data.market_data;
+        } else {
+            msg.data.order = event->data.order;
+            pending = find_pending(replay, event->data.order.client_order_id);
+            if (event->type != MSG_ORDER_NEW) {
+                msg.data.order.order_id = await_server_id(replay, pending);
+                if (msg.data.order.order_id == 0) {
+                    session->unknown++;
+                    continue;
+                }
+            }
+        }
+
+        int size = serialize_message(&msg, buffer, sizeof(buffer));
+        if (size < 0) continue;
+
+        uint64_t now = clock_monotonic_raw_ns();
+        if (now - due > session->max_lag_ns) session->max_lag_ns = now - due;
+        if (pending) {
+            atomic_store_explicit(&pending->sent_ns, now, memory_order_release);
+        }
+
+        if (send(session->socket, buffer, (size_t)size, MSG_NOSIGNAL) != size) {
+            fprintf(stderr, "Session %s: send failed: %s\n", session->client_id, strerror(errno));
+            break;
+        }
+        session->sent++;
+    }
+
+    atomic_fetch_sub(&replay->senders_running, 1);
+    return NULL;
+}
+
+static void handle_response(Replay* replay, const Message* msg, uint64_t now) {
+    switch (msg->type) {
+        case MSG_ORDER_STATUS: {
+            // Statuses echo the client order id, which is the loaded one
+            PendingSlot* pending = find_pending(replay, msg->data.order.client_order_id);
+            if (pending) {
+                uint64_t unset = 0;
+                uint64_t server_id = msg->data.order.order_id;
+                atomic_compare_exchange_strong_explicit(&pending->server_id, &unset,
+                                                        server_id ? server_id : REPLAY_NO_SERVER_ID,
+                                                        memory_order_release, memory_order_relaxed);
+            }
+            uint64_t sent = pending ? atomic_exchange(&pending->sent_ns, 0) : 0;
+            if (sent) {
+                latency_histogram_record(&replay->ack_latency, now - sent);
+                replay->acks++;
+                replay->rejects += msg->data.order.status == ORDER_STATUS_REJECTED;
+            }
+            break;
+        }
+        case MSG_TRADE_EXEC:
+            replay->trades++;
+            break;
+        case MSG_MARKET_DATA:
+            replay->quotes_received++;
+            break;
+        default:
+            break;
+    }
+}
+
+// Read whatever a session has buffered and decode every whole message
+static int drain_session(Replay* replay, ReplaySession* session) {
+    ssize_t received = recv(session->socket, session->buffer + session->buffered,
+                            sizeof(session->buffer) - session->buffered, MSG_DONTWAIT);
+    if (received <= 0) {
+        return received == 0 || (errno != EAGAIN && errno != EWOULDBLOCK) ? -1 : 0;
+    }
+    uint64_t now = clock_monotonic_raw_ns();
+
+    session->buffered += (size_t)received;
+    size_t offset = 0;
+    Message msg;
+    while (offset < session->buffered) {
+        int consumed = deserialize_message(session->buffer + offset, session->buffered - offset, &msg);
+        if (consumed == SERIAL_ERROR_INCOMPLETE) break;
+        if (consumed < 0) return -1;
+        offset += (size_t)consumed;
+        handle_response(replay, &msg, now);
+    }
+    session->buffered -= offset;
+    memmove(session->buffer, session->buffer + offset, session->buffered);
+    return 0;
+}
+
+/**
+ * Receive on every session until the senders finish and the acks are in,
+ * or the drain timeout passes after the last send.
+ */
+static void receive_responses(Replay* replay, uint64_t expected_acks, uint64_t drain_ns) {
+    int epoll_fd = epoll_create1(0);
+    if (epoll_fd < 0) return;
+    for (int s = 0; s < replay->session_count; s++) {
+        struct epoll_event interest = { .events = EPOLLIN, .data.u32 = (uint32_t)s };
+        epoll_ctl(epoll_fd, EPOLL_CTL_ADD, replay->sessions[s].socket, &interest);
+    }
+
+    uint64_t senders_done = 0;
+    int open_sessions = replay->session_count;
+    struct epoll_event ready[REPLAY_MAX_SESSIONS];
+    while (open_sessions > 0) {
+        if (!senders_done && atomic_load(&replay->senders_running) == 0) {
+            senders_done = clock_monotonic_raw_ns();
+            replay->senders_done_ns = senders_done;
+        }
+        if (senders_done && (replay->acks >= expected_acks ||
+                             clock_monotonic_raw_ns() - senders_done > drain_ns)) {
+            break;
+        }
+
+        int count = epoll_wait(epoll_fd, ready, REPLAY_MAX_SESSIONS, 10);
+        for (int i = 0; i < count; i++) {
+            ReplaySession* session = &replay->sessions[ready[i].data.u32];
+            if (drain_session(replay, session) < 0) {
+                epoll_ctl(epoll_fd, EPOLL_CTL_DEL, session->socket, NULL);
+                open_sessions--;
+            }
+        }
+    }
+    close(epoll_fd);
+}
+
+static void print_report(const Replay* replay, uint64_t orders) {
+    uint64_t sent = 0;
+    uint64_t max_lag = 0;
+    uint64_t unknown = 0;
+    for (int s = 0; s < replay->session_count; s++) {
+        sent += replay->sessions[s].sent;
+        unknown += replay->sessions[s].unknown;
+        if (replay->sessions[s].max_lag_ns > max_lag) max_lag = replay->sessions[s].max_lag_ns;
+    }
+
+    uint64_t elapsed_ns = replay->senders_done_ns > replay->start_ns ?
+                          replay->senders_done_ns - replay->start_ns : 0;
+    double seconds = (double)elapsed_ns / (double)NANOS_PER_SECOND;
+    printf("Sent %lu of %u messages (%lu orders, %lu quotes) over %d sessions in %.3f s\n",
+           sent, replay->event_count, orders, (uint64_t)replay->event_count - orders,
+           replay->session_count, seconds);
+    printf("Throughput: %.0f msg/s, max schedule lag %.3f ms\n",
+           seconds > 0 ? (double)sent / seconds : 0.0, (double)max_lag / 1e6);
+    printf("Acks: %lu (%lu rejected), missing %lu; trades %lu, quotes received %lu\n",
+           replay->acks, replay->rejects, orders > replay->acks ? orders - replay->acks : 0,
+           replay->trades, replay->quotes_received);
+    if (unknown) {
+        printf("Skipped %lu cancels and modifies of orders the server never acked\n", unknown);
+    }
+
+    const LatencyHistogram* h = &replay->ack_latency;
+    if (h->total_count == 0) return;
+    printf("Order-to-ack latency (us): min %.1f p50 %.1f p90 %.1f p99 %.1f p99.9 %.1f max %.1f mean %.1f\n",
+           (double)h->min / 1e3,
+           (double)latency_histogram_percentile(h, 50.0) / 1e3,
+           (double)latency_histogram_percentile(h, 90.0) / 1e3,
+           (double)latency_histogram_percentile(h, 99.0) / 1e3,
+           (double)latency_histogram_percentile(h, 99.9) / 1e3,
+           (double)h->max / 1e3,
+           latency_histogram_mean(h) / 1e3);
+}
+
+int main(int argc, char* argv[]) {
+    const char* host = "127.0.0.1";
+    int port = 8080;
+    int sessions = REPLAY_DEFAULT_SESSIONS;
+    PaceMode mode = PACE_ORIGINAL;
+    double speed = 1.0;
+    double rate = 0.0;
+    uint64_t drain_ms = REPLAY_DEFAULT_DRAIN_MS;
+
+    static struct option long_options[] = {
+        {"host",      required_argument, 0, 'H'},
+        {"port",      required_argument, 0, 'p'},
+        {"sessions",  required_argument, 0, 'n'},
+        {"speed",     required_argument, 0, 'x'},
+        {"rate",      required_argument, 0, 'r'},
+        {"max-rate",  no_argument,       0, 'm'},
+        {"drain",     required_argument, 0, 'd'},
+        {"help",      no_argument,       0, 'h'},
+        {0, 0, 0, 0}
+    };
+
+    int opt;
+    while ((opt = getopt_long(argc, argv, "H:p:n:x:r:md:h", long_options, NULL)) != -1) {
+        switch (opt) {
+            case 'H':
+                host = optarg;
+                break;
+            case 'p':
+                port = atoi(optarg);
+                break;
+            case 'n':
+                sessions = atoi(optarg);
+                break;
+            case 'x':
+                mode = PACE_ORIGINAL;
+                speed = atof(optarg);
+                break;
+            case 'r':
+                mode = PACE_RATE;
+                rate = atof(optarg);
+                break;
+            case 'm':
+                mode = PACE_MAX;
+                break;
+            case 'd':
+                drain_ms = strtoull(optarg, NULL, 10);
+                break;
+            case 'h':
+                print_usage(argv[0]);
+                return EXIT_SUCCESS;
+            default:
+                print_usage(argv[0]);
+                return EXIT_FAILURE;
+        }
+    }
+
+    if (optind >= argc || sessions < 1 || sessions > REPLAY_MAX_SESSIONS ||
+        (mode == PACE_ORIGINAL && speed <= 0.0) || (mode == PACE_RATE && rate <= 0.0)) {
+        print_usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    Replay* replay = calloc(1, sizeof(Replay));
+    if (!replay) return EXIT_FAILURE;
+    replay->session_count = sessions;
+    replay->drain_ns = drain_ms * NANOS_PER_MILLI;
+    latency_histogram_reset(&replay->ack_latency);
+    for (int s = 0; s < sessions; s++) {
+        replay->sessions[s].socket = -1;
+        snprintf(replay->sessions[s].client_id, MAX_CLIENT_ID_LENGTH, "replay-%d-%d", (int)getpid(), s);
+    }
+
+    int result = EXIT_SUCCESS;
+    for (int i = optind; i < argc && result == EXIT_SUCCESS; i++) {
+        if (load_input(replay, argv[i]) != SUCCESS) {
+            fprintf(stderr, "Failed to load %s\n", argv[i]);
+            result = EXIT_FAILURE;
+        }
+    }
+    if (result == EXIT_SUCCESS && plan_replay(replay, mode, speed, rate) != SUCCESS) {
+        fprintf(stderr, "Out of memory\n");
+        result = EXIT_FAILURE;
+    }
+
+    for (int s = 0; s < sessions && result == EXIT_SUCCESS; s++) {
+        if (connect_session(&replay->sessions[s], host, port) != SUCCESS) {
+            fprintf(stderr, "Failed to connect to %s:%d: %s\n", host, port, strerror(errno));
+            result = EXIT_FAILURE;
+        }
+    }
+
+    if (result == EXIT_SUCCESS) {
+        uint64_t orders = 0;
+        for (uint32_t i = 0; i < replay->event_count; i++) {
+            orders += replay->events[i].type != MSG_MARKET_DATA;
+        }
+
+        // Give every sender a moment to start before the first send time
+        SenderArgs args[REPLAY_MAX_SESSIONS];
+        replay->start_ns = clock_monotonic_raw_ns() + 10 * NANOS_PER_MILLI;
+        atomic_store(&replay->senders_running, sessions);
+        for (int s = 0; s < sessions; s++) {
+            args[s] = (SenderArgs){ .replay = replay, .session = &replay->sessions[s] };
+            if (pthread_create(&replay->sessions[s].thread, NULL, sender_thread, &args[s]) != 0) {
+                fprintf(stderr, "Failed to start session %d\n", s);
+                exit(EXIT_FAILURE);
+            }
+        }
+
+        receive_responses(replay, orders, replay->drain_ns);
+        for (int s = 0; s < sessions; s++) {
+            pthread_join(replay->sessions[s].thread, NULL);
+        }
+        if (replay->senders_done_ns == 0) replay->senders_done_ns = clock_monotonic_raw_ns();
+        print_report(replay, orders);
+    }
+
+    for (int s = 0; s < sessions; s++) {
+        if (replay->sessions[s].socket >= 0) close(replay->sessions[s].socket);
+        free(replay->sessions[s].events);
+    }
+    free(replay->pending);
+    free(replay->clients);
+    free(replay->events);
+    free(replay);
+    return result;
+}
@@ -0,0 +1,193 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <getopt.h>
+#include "common/tick_archive.h"
+#include "common/clock.h"
+#include "common/utils.h"
+
+static void print_usage(const char* program_name) {
+    printf("Usage: %s [options] FILE...\n", program_name);
+    printf("Print TradeSynth tick files or tick archives as CSV.\n");
+    printf("Options:\n");
+    printf("  -s, --summary         Print per-file counts and scan rate instead of records\n");
+    printf("  -f, --from NS         Only ticks at or after NS (nanoseconds since the epoch)\n");
+    printf("  -t, --to NS           Only ticks before NS\n");
+    printf("  -h, --help            Show this help message\n");
+}
+
+typedef struct {
+    const char* symbol;
+    int32_t price_exponent;
+    int summary;
+    uint64_t trades;
+    uint64_t quantity;
+} ArchiveDump;
+
+static const char* const CSV_HEADER =
+    "timestamp,symbol,type,price,quantity,bid,bid_size,ask,ask_size,volume,id\n";
+
+static void print_price(int32_t exponent, int64_t ticks, char* buffer, size_t size) {
+    Price price = price_from_ticks(ticks, exponent);
+    if (format_price(&price, buffer, size) == 0) {
+        buffer[0] = '\0';
+    }
+}
+
+static void print_tick(const char* symbol, int32_t exponent, uint64_t timestamp, uint32_t type,
+                       int64_t price_ticks, uint32_t quantity, int64_t bid_ticks, uint32_t bid_size,
+                       int64_t ask_ticks, uint32_t ask_size, uint64_t volume, uint64_t id) {
+    char price[32], bid[32], ask[32];
+    print_price(exponent, price_ticks, price, sizeof(price));
+    print_price(exponent, bid_ticks, bid, sizeof(bid));
+    print_price(exponent, ask_ticks, ask, sizeof(ask));
+    printf("%lu,%s,%s,%s,%u,%s,%u,%s,%u,%lu,%lu\n",
+           timestamp, symbol, type == TICK_TRADE ? "trade" : "quote",
+           price, quantity, bid, bid_size, ask, ask_size, volume, id);
+}
+
+static int dump_archive_block(const TickBlockView* view, void* arg) {
+    ArchiveDump* dump = arg;
+    const int64_t* const* columns = view->columns;
+
+    if (dump->summary) {
+        for (uint32_t i = 0; i < view->count; i++) {
+            int trade = columns[TICK_COLUMN_TYPE][i] == TICK_TRADE;
+            dump->trades += trade;
+            dump->quantity += trade ? (uint64_t)columns[TICK_COLUMN_QUANTITY][i] : 0;
+        }
+        return 0;
+    }
+
+    for (uint32_t i = 0; i < view->count; i++) {
+        print_tick(dump->symbol, dump->price_exponent,
+                   (uint64_t)columns[TICK_COLUMN_TIMESTAMP][i],
+                   (uint32_t)columns[TICK_COLUMN_TYPE][i],
+                   columns[TICK_COLUMN_PRICE][i], (uint32_t)columns[TICK_COLUMN_QUANTITY][i],
+                   columns[TICK_COLUMN_BID][i], (uint32_t)columns[TICK_COLUMN_BID_SIZE][i],
+                   columns[TICK_COLUMN_ASK][i], (uint32_t)columns[TICK_COLUMN_ASK_SIZE][i],
+                   (uint64_t)columns[TICK_COLUMN_VOLUME][i], (uint64_t)columns[TICK_COLUMN_ID][i]);
+    }
+    return 0;
+}
+
+static int dump_archive(const char* path, int summary, uint64_t from, uint64_t to) {
+    TickArchive archive;
+    if (tick_archive_open(&archive, path) != SUCCESS) {
+        fprintf(stderr, "%s is not a readable tick file or archive\n", path);
+        return -1;
+    }
+
+    ArchiveDump dump = {
+        .symbol = archive.header->symbol,
+        .price_exponent = archive.header->price_exponent,
+        .summary = summary
+    };
+    uint32_t columns = summary ?
+        TICK_COLUMN_BIT(TICK_COLUMN_TYPE) | TICK_COLUMN_BIT(TICK_COLUMN_QUANTITY) : TICK_COLUMNS_ALL;
+
+    if (!summary) printf("%s", CSV_HEADER);
+    uint64_t start = clock_monotonic_raw_ns();
+    int64_t rows = tick_archive_scan(&archive, from, to, columns, dump_archive_block, &dump);
+    uint64_t elapsed = clock_monotonic_raw_ns() - start;
+
+    if (summary && rows >= 0) {
+        double seconds = elapsed ? (double)elapsed / NANOS_PER_SECOND : 1e-9;
+        printf("%s: %s day %u, %ld of %lu records in range, %lu trades (%lu shares), "
+               "decoded at %.1f M records/s\n",
+               path, archive.header->symbol, archive.header->day, rows,
+               archive.header->record_count, dump.trades, dump.quantity,
+               (double)rows / seconds / 1e6);
+    }
+    tick_archive_close(&archive);
+    return rows < 0 ? -1 : 0;
+}
+
+static int dump_file(const char* path, int summary, uint64_t from, uint64_t to) {
+    TickFile file;
+    if (tick_file_open(&file, path) != SUCCESS) {
+        return dump_archive(path, summary, from, to);
+    }
+
+    uint64_t count = tick_file_count(&file);
+    if (summary) {
+        uint64_t trades = 0;
+        uint64_t quantity = 0;
+        uint64_t start = clock_monotonic_raw_ns();
+        for (uint64_t i = 0; i < count; i++) {
+            const TickRecord* record = &file.records[i];
+            int trade = record->type == TICK_TRADE && record->timestamp >= from && record->timestamp < to;
+            trades += trade;
+            quantity += trade ? record->quantity : 0;
+        }
+        uint64_t elapsed = clock_monotonic_raw_ns() - start;
+        double seconds = elapsed ? (double)elapsed / NANOS_PER_SECOND : 1e-9;
+
+        printf("%s: %s day %u, %lu/%lu records, %lu trades (%lu shares), "
+               "scanned at %.2f GB/s\n",
+               path, file.header->symbol, file.header->day, count, file.header->capacity,
+               trades, quantity, (double)(count * sizeof(TickRecord)) / seconds / 1e9);
+        tick_file_close(&file);
+        return 0;
+    }
+
+    printf("%s", CSV_HEADER);
+    for (uint64_t i = 0; i < count; i++) {
+        const TickRecord* record = &file.records[i];
+        if (record->timestamp < from || record->timestamp >= to) continue;
+        print_tick(file.header->symbol, file.header->price_exponent, record->timestamp,
+                   record->type, record->price, record->quantity, record->bid, record->bid_size,
+                   record->ask, record->ask_size, record->volume, record->id);
+    }
+
+    tick_file_close(&file);
+    return 0;
+}
+
+int main(int argc, char* argv[]) {
+    int summary = 0;
+    uint64_t from = 0;
+    uint64_t to = UINT64_MAX;
+
+    static struct option long_options[] = {
+        {"summary",   no_argument,       0, 's'},
+        {"from",      required_argument, 0, 'f'},
+        {"to",        required_argument, 0, 't'},
+        {"help",      no_argument,       0, 'h'},
+        {0, 0, 0, 0}
+    };
+
+    int opt;
+    while ((opt = getopt_long(argc, argv, "sf:t:h", long_options, NULL)) != -1) {
+        switch (opt) {
+            case 's':
+                summary = 1;
+                break;
+            case 'f':
+                from = strtoull(optarg, NULL, 10);
+                break;
+            case 't':
+                to = strtoull(optarg, NULL, 10);
+                break;
+            case 'h':
+                print_usage(argv[0]);
+                return EXIT_SUCCESS;
+            default:
+                print_usage(argv[0]);
+                return EXIT_FAILURE;
+        }
+    }
+
+    if (optind >= argc) {
+        print_usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    int result = EXIT_SUCCESS;
+    for (int i = optind; i < argc; i++) {
+        if (dump_file(argv[i], summary, from, to) < 0) {
+            result = EXIT_FAILURE;
+        }
+    }
+    return result;
+}
@@ -0,0 +1,410 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+#include <getopt.h>
+#include <unistd.h>
+#include "common/metrics.h"
+#include "common/clock.h"
+#include "common/utils.h"
+
+#define TOP_DEFAULT_PORT 8080
+#define TOP_DEFAULT_INTERVAL_MS 1000
+#define TOP_DEFAULT_ROWS 10
+
+static void print_usage(const char* program_name) {
+    printf("Usage: %s [options]\n", program_name);
+    printf("Live view of a running trading_server's stats segment.\n");
+    printf("Options:\n");
+    printf("  -p, --port PORT       Server port, selects /tradesynth-PORT (default: %d)\n",
+           TOP_DEFAULT_PORT);
+    printf("  -n, --name NAME       Stats segment name (overrides --port)\n");
+    printf("  -i, --interval MS     Refresh interval (default: %d)\n", TOP_DEFAULT_INTERVAL_MS);
+    printf("  -r, --rows N          Rows per table (default: %d)\n", TOP_DEFAULT_ROWS);
+    printf("  -o, --once            Print one report with totals since start and exit\n");
+    printf("  -P, --prometheus      Print the segment in Prometheus text format and exit\n");
+    printf("  -h, --help            Show this help message\n");
+}
+
+static volatile sig_atomic_t top_running = 1;
+
+static void handle_signal(int signum) {
+    (void)signum;
+    top_running = 0;
+}
+
+typedef struct {
+    const MetricsHeader* current;
+    const MetricsHeader* previous;  // NULL for totals since start
+    double elapsed;                 // Seconds between the two snapshots
+    int rows;
+} TopView;
+
+static double rate(const TopView* view, uint64_t now, uint64_t before) {
+    if (!view->previous || view->elapsed <= 0.0 || now < before) return 0.0;
+    return (double)(now - before) / view->elapsed;
+}
+
+static void format_rate(const TopView* view, double value, char* buffer, size_t size) {
+    if (!view->previous) snprintf(buffer, size, "-");
+    else if (value >= 1e6) snprintf(buffer, size, "%.2fM", value / 1e6);
+    else if (value >= 1e4) snprintf(buffer, size, "%.1fk", value / 1e3);
+    else snprintf(buffer, size, "%.0f", value);
+}
+
+static void format_bytes(double bytes, char* buffer, size_t size) {
+    static const char* units[] = { "B", "KB", "MB", "GB", "TB" };
+    int unit = 0;
+    while (bytes >= 1024.0 && unit < 4) {
+        bytes /= 1024.0;
+        unit++;
+    }
+    snprintf(buffer, size, unit == 0 ? "%.0f %s" : "%.1f %s", bytes, units[unit]);
+}
+
+static void format_price_ticks(int64_t ticks, int32_t exponent, char* buffer, size_t size) {
+    Price price = price_from_ticks(ticks, exponent);
+    if (ticks == 0 || format_price(&price, buffer, size) == 0) {
+        snprintf(buffer, size, "-");
+    }
+}
+
+static void print_summary(const TopView* view) {
+    const MetricsHeader* now = view->current;
+    const MetricsTotals* totals = &now->totals;
+    const MetricsTotals* before = view->previous ? &view->previous->totals : totals;
+    char in_rate[16], out_rate[16], journal_rate[16], bytes_in[16], bytes_out[16];
+    char bytes_in_rate[16], bytes_out_rate[16];
+
+    uint64_t uptime = (now->publish_time - now->start_time) / NANOS_PER_SECOND;
+    int64_t age_ms = ((int64_t)clock_now_ns() - (int64_t)now->publish_time) / (int64_t)NANOS_PER_MILLI;
+    printf("pid %u  up %lu:%02lu:%02lu  published every %u ms, last %ld ms ago\n\n",
+           now->pid, uptime / 3600, uptime / 60 % 60, uptime % 60, now->interval_ms, (long)age_ms);
+
+    format_rate(view, rate(view, totals->messages_processed, before->messages_processed), in_rate, sizeof(in_rate));
+    format_rate(view, rate(view, totals->messages_sent, before->messages_sent), out_rate, sizeof(out_rate));
+    printf("Connections %lu active, %lu total    Messages in %lu (%s/s), out %lu (%s/s)    "
+           "Errors %lu    Risk rejects %lu    Throttled %lu    Expired %lu    Timed out %lu\n",
+           totals->active_connections, totals->total_connections, totals->messages_processed, in_rate,
+           totals->messages_sent, out_rate, totals->errors_encountered, totals->risk_rejects,
+           totals->throttled, totals->orders_expired, totals->sessions_timed_out);
+
+    format_bytes((double)totals->bytes_received, bytes_in, sizeof(bytes_in));
+    format_bytes((double)totals->bytes_sent, bytes_out, sizeof(bytes_out));
+    format_bytes(rate(view, totals->bytes_received, before->bytes_received), bytes_in_rate, sizeof(bytes_in_rate));
+    format_bytes(rate(view, totals->bytes_sent, before->bytes_sent), bytes_out_rate, sizeof(bytes_out_rate));
+    printf("Bytes in %s (%s/s), out %s (%s/s)\n", bytes_in, view->previous ? bytes_in_rate : "-",
+           bytes_out, view->previous ? bytes_out_rate : "-");
+
+    format_rate(view, rate(view, totals->journal_events, before->journal_events), journal_rate, sizeof(journal_rate));
+    printf("Journal %lu events (%s/s), %lu syncs, %lu queue full    Ticks %lu captured, %lu dropped\n\n",
+           totals->journal_events, journal_rate, totals->journal_syncs, totals->journal_queue_full,
+           totals->ticks_captured, totals->ticks_dropped);
+}
+
+// Samples recorded between the two snapshots; the maximum stays cumulative
+static void interval_histogram(const LatencyHistogram* now, const LatencyHistogram* before,
+                               LatencyHistogram* out) {
+    *out = *now;
+    if (!before || before->total_count > now->total_count) return;
+    for (uint32_t i = 0; i < LATENCY_BUCKET_COUNT; i++) {
+        out->counts[i] -= before->counts[i];
+    }
+    out->total_count -= before->total_count;
+    out->sum -= before->sum;
+}
+
+static void print_stages(const TopView* view) {
+    static LatencyHistogram histogram;
+    printf("%-14s %12s %9s %9s %9s %9s %9s %9s  (us, %s)\n", "STAGE", "COUNT", "RATE/s", "MEAN", "P50",
+           "P99", "P99.9", "MAX", view->previous ? "this interval" : "since start");
+
+    for (int i = 0; i < METRICS_HISTOGRAM_COUNT; i++) {
+        const LatencyHistogram* now = &view->current->histograms[i];
+        const LatencyHistogram* before = view->previous ? &view->previous->histograms[i] : NULL;
+        interval_histogram(now, before, &histogram);
+
+        char stage_rate[16];
+        format_rate(view, rate(view, now->total_count, before ? before->total_count : 0),
+                    stage_rate, sizeof(stage_rate));
+        if (histogram.total_count == 0) {
+            printf("%-14s %12lu %9s %9s %9s %9s %9s %9s\n", metrics_histogram_name(i), now->total_count,
+                   stage_rate, "-", "-", "-", "-", "-");
+            continue;
+        }
+        printf("%-14s %12lu %9s %9.2f %9.2f %9.2f %9.2f %9.2f\n", metrics_histogram_name(i),
+               now->total_count, stage_rate,
+               latency_histogram_mean(&histogram) / 1e3,
+               (double)latency_histogram_percentile(&histogram, 50.0) / 1e3,
+               (double)latency_histogram_percentile(&histogram, 99.0) / 1e3,
+               (double)latency_histogram_percentile(&histogram, 99.9) / 1e3,
+               (double)now->max / 1e3);
+    }
+    printf("\n");
+}
+
+typedef struct {
+    uint32_t index;
+    double key;
+} RankedRow;
+
+static int compare_ranked(const void* a, const void* b) {
+    double left = ((const RankedRow*)a)->key;
+    double right = ((const RankedRow*)b)->key;
+    return (left < right) - (left > right);
+}
+
+static void print_connections(const TopView* view, RankedRow* ranked) {
+    const MetricsConnection* rows = metrics_connections(view->current);
+    const MetricsConnection* previous = view->previous ? metrics_connections(view->previous) : NULL;
+    uint32_t count = 0;
+    for (uint32_t i = 0; i < view->current->connection_capacity; i++) {
+        if (!rows[i].active) continue;
+        // A slot reused by a new connection starts its rates from scratch
+        int same = previous && previous[i].active && previous[i].connect_time == rows[i].connect_time;
+        ranked[count++] = (RankedRow){ i, rate(view, rows[i].messages_received,
+                                               same ? previous[i].messages_received : 0) +
+                                          (double)rows[i].messages_received * 1e-12 };
+    }
+    qsort(ranked, count, sizeof(RankedRow), compare_ranked);
+
+    printf("%-5s %-20s %-21s %10s %8s %10s %8s %10s %7s\n", "SLOT", "CLIENT", "ADDRESS", "IN", "IN/s",
+           "OUT", "OUT/s", "BYTES IN", "IDLE s");
+    uint64_t now_ns = view->current->publish_time;
+    for (uint32_t r = 0; r < count && r < (uint32_t)view->rows; r++) {
+        uint32_t i = ranked[r].index;
+        const MetricsConnection* row = &rows[i];
+        int same = previous && previous[i].active && previous[i].connect_time == row->connect_time;
+        char in_rate[16], out_rate[16], bytes[16];
+        format_rate(view, rate(view, row->messages_received, same ? previous[i].messages_received : 0),
+                    in_rate, sizeof(in_rate));
+        format_rate(view, rate(view, row->messages_sent, same ? previous[i].messages_sent : 0),
+                    out_rate, sizeof(out_rate));
+        format_bytes((double)row->bytes_received, bytes, sizeof(bytes));
+        double idle = now_ns > row->last_heartbeat ?
+                      (double)(now_ns - row->last_heartbeat) / NANOS_PER_SECOND : 0.0;
+        printf("%-5u %-20.20s %-21.21s %10lu %8s %10lu %8s %10s %7.1f\n", i,
+               row->client_id[0] ? row->client_id : "-", row->address, row->messages_received,
+               in_rate, row->messages_sent, out_rate, bytes, idle);
+    }
+    if (count > (uint32_t)view->rows) printf("... %u more\n", count - (uint32_t)view->rows);
+    printf("\n");
+}
+
+static void print_symbols(const TopView* view, RankedRow* ranked) {
+    const MetricsSymbol* rows = metrics_symbols(view->current);
+    const MetricsSymbol* previous = view->previous ? metrics_symbols(view->previous) : NULL;
+    uint32_t previous_count = view->previous ? view->previous->symbol_count : 0;
+    uint32_t count = view->current->symbol_count;
+
+    // Symbol ids are never reused, so rows line up across snapshots
+    for (uint32_t i = 0; i < count; i++) {
+        uint64_t before = i < previous_count ? previous[i].orders : 0;
+        ranked[i] = (RankedRow){ i, rate(view, rows[i].orders, before) + (double)rows[i].orders * 1e-12 };
+    }
+    qsort(ranked, count, sizeof(RankedRow), compare_ranked);
+
+    printf("%-16s %10s %8s %10s %8s %12s %6s %6s %12s %12s %12s\n", "SYMBOL", "ORDERS", "ORD/s", "TRADES",
+           "TRD/s", "VOLUME", "BIDS", "ASKS", "BID", "ASK", "LAST");
+    for (uint32_t r = 0; r < count && r < (uint32_t)view->rows; r++) {
+        uint32_t i = ranked[r].index;
+        const MetricsSymbol* row = &rows[i];
+        char order_rate[16], trade_rate[16], bid[32], ask[32], last[32];
+        format_rate(view, rate(view, row->orders, i < previous_count ? previous[i].orders : 0),
+                    order_rate, sizeof(order_rate));
+        format_rate(view, rate(view, row->trades, i < previous_count ? previous[i].trades : 0),
+                    trade_rate, sizeof(trade_rate));
+        format_price_ticks(row->best_bid, row->price_exponent, bid, sizeof(bid));
+        format_price_ticks(row->best_ask, row->price_exponent, ask, sizeof(ask));
+        format_price_ticks(row->last_price, row->price_exponent, last, sizeof(last));
+        printf("%-16.16s %10lu %8s %10lu %8s %12lu %6u %6u %12s %12s %12s\n", row->symbol, row->orders,
+               order_rate, row->trades, trade_rate, row->volume, row->bid_orders, row->ask_orders,
+               bid, ask, last);
+    }
+    if (count > (uint32_t)view->rows) printf("... %u more\n", count - (uint32_t)view->rows);
+    printf("\n");
+}
+
+static void print_threads(const TopView* view, RankedRow* ranked) {
+    const MetricsThread* rows = metrics_threads(view->current);
+    const MetricsThread* previous = view->previous ? metrics_threads(view->previous) : NULL;
+    uint64_t elapsed_ns = view->previous ? view->current->publish_time - view->previous->publish_time : 0;
+    uint32_t count = 0;
+
+    for (uint32_t i = 0; i < view->current->thread_capacity; i++) {
+        if (!rows[i].active) continue;
+        int same = previous && previous[i].active && previous[i].tid == rows[i].tid;
+        double cpu = same && elapsed_ns > 0 && rows[i].cpu_ns >= previous[i].cpu_ns ?
+                     100.0 * (double)(rows[i].cpu_ns - previous[i].cpu_ns) / (double)elapsed_ns :
+                     (double)rows[i].cpu_ns * 1e-12;
+        ranked[count++] = (RankedRow){ i, cpu };
+    }
+    qsort(ranked, count, sizeof(RankedRow), compare_ranked);
+
+    printf("%-8s %-16s %7s %10s %10s %10s %8s %10s %8s\n", "TID", "THREAD", "CPU%", "CPU s", "MSGS",
+           "MSG/s", "SENT", "SENT/s", "ERRORS");
+    for (uint32_t r = 0; r < count && r < (uint32_t)view->rows; r++) {
+        uint32_t i = ranked[r].index;
+        const MetricsThread* row = &rows[i];
+        int same = previous && previous[i].active && previous[i].tid == row->tid;
+        char cpu[16], message_rate[16], sent_rate[16];
+        if (same) snprintf(cpu, sizeof(cpu), "%.1f", ranked[r].key);
+        else snprintf(cpu, sizeof(cpu), "-");
+        format_rate(view, rate(view, row->messages_processed, same ? previous[i].messages_processed : 0),
+                    message_rate, sizeof(message_rate));
+        format_rate(view, rate(view, row->messages_sent, same ? previous[i].messages_sent : 0),
+                    sent_rate, sizeof(sent_rate));
+        printf("%-8u %-16.16s %7s %10.2f %10lu %10s %8lu %10s %8lu\n", row->tid, row->name, cpu,
+               (double)row->cpu_ns / NANOS_PER_SECOND, row->messages_processed, message_rate,
+               row->messages_sent, sent_rate, row->errors);
+    }
+    if (count > (uint32_t)view->rows) printf("... %u more\n", count - (uint32_t)view->rows);
+}
+
+static void print_report(const char* name, const TopView* view, RankedRow* ranked) {
+    printf("tradesynth_top - %s  ", name);
+    print_summary(view);
+    print_stages(view);
+    print_connections(view, ranked);
+    print_symbols(view, ranked);
+    print_threads(view, ranked);
+}
+
+static int server_alive(const MetricsHeader* header) {
+    return kill((pid_t)header->pid, 0) == 0 || errno != ESRCH;
+}
+
+int main(int argc, char* argv[]) {
+    char name[64] = "";
+    int port = TOP_DEFAULT_PORT;
+    int interval_ms = TOP_DEFAULT_INTERVAL_MS;
+    int rows = TOP_DEFAULT_ROWS;
+    int once = 0;
+    int prometheus = 0;
+
+    static struct option long_options[] = {
+        {"port",       required_argument, 0, 'p'},
+        {"name",       required_argument, 0, 'n'},
+        {"interval",   required_argument, 0, 'i'},
+        {"rows",       required_argument, 0, 'r'},
+        {"once",       no_argument,       0, 'o'},
+        {"prometheus", no_argument,       0, 'P'},
+        {"help",       no_argument,       0, 'h'},
+        {0, 0, 0, 0}
+    };
+
+    int opt;
+    while ((opt = getopt_long(argc, argv, "p:n:i:r:oPh", long_options, NULL)) != -1) {
+        switch (opt) {
+            case 'p':
+                port = atoi(optarg);
+                break;
+            case 'n':
+                snprintf(name, sizeof(name), "%s", optarg);
+                break;
+            case 'i':
+                interval_ms = atoi(optarg);
+                break;
+            case 'r':
+                rows = atoi(optarg);
+                break;
+            case 'o':
+                once = 1;
+                break;
+            case 'P':
+                prometheus = 1;
+                break;
+            case 'h':
+                print_usage(argv[0]);
+                return EXIT_SUCCESS;
+            default:
+                print_usage(argv[0]);
+                return EXIT_FAILURE;
+        }
+    }
+    if (interval_ms <= 0 || rows <= 0) {
+        print_usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+    if (name[0] == '\0') {
+        snprintf(name, sizeof(name), "/tradesynth-%d", port);
+    }
+
+    MetricsReader reader;
+    int result = metrics_reader_open(&reader, name);
+    if (once || prometheus) {
+        if (result != SUCCESS || metrics_reader_read(&reader) != SUCCESS) {
+            fprintf(stderr, "No stats segment %s (is trading_server running with metrics?)\n", name);
+            metrics_reader_close(&reader);
+            return EXIT_FAILURE;
+        }
+        if (prometheus) {
+            result = metrics_write_prometheus(reader.snapshot, stdout);
+        } else {
+            RankedRow* ranked = malloc(sizeof(RankedRow) *
+                                       (reader.snapshot->symbol_capacity + reader.snapshot->connection_capacity +
+                                        reader.snapshot->thread_capacity));
+            TopView view = { .current = reader.snapshot, .rows = rows };
+            if (ranked) print_report(name, &view, ranked);
+            free(ranked);
+        }
+        metrics_reader_close(&reader);
+        return result == SUCCESS ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+
+    signal(SIGINT, handle_signal);
+    signal(SIGTERM, handle_signal);
+
+    MetricsHeader* previous = NULL;
+    RankedRow* ranked = NULL;
+    uint64_t next_refresh = clock_monotonic_raw_ns();
+    while (top_running) {
+        if (!reader.segment && metrics_reader_open(&reader, name) != SUCCESS) {
+            printf("\033[H\033[2Jtradesynth_top - waiting for %s\n", name);
+            fflush(stdout);
+        } else if (metrics_reader_read(&reader) == SUCCESS) {
+            const MetricsHeader* current = reader.snapshot;
+            if (!previous) {
+                previous = malloc(current->segment_size);
+                ranked = malloc(sizeof(RankedRow) * (current->symbol_capacity +
+                                                     current->connection_capacity + current->thread_capacity));
+                if (!previous || !ranked) {
+                    fprintf(stderr, "Out of memory\n");
+                    break;
+                }
+                memcpy(previous, current, current->segment_size);
+            }
+
+            TopView view = {
+                .current = current,
+                .previous = previous,
+                .elapsed = (double)(current->publish_time - previous->publish_time) / NANOS_PER_SECOND,
+                .rows = rows
+            };
+            printf("\033[H\033[2J");
+            print_report(name, &view, ranked);
+            fflush(stdout);
+            memcpy(previous, current, current->segment_size);
+
+            // Pick up a restarted server's new segment
+            if (!server_alive(current)) {
+                metrics_reader_close(&reader);
+                free(previous);
+                free(ranked);
+                previous = NULL;
+                ranked = NULL;
+            }
+        }
+
+        next_refresh += (uint64_t)interval_ms * NANOS_PER_MILLI;
+        while (top_running && clock_monotonic_raw_ns() < next_refresh) {
+            usleep(10000);
+        }
+    }
+
+    free(previous);
+    free(ranked);
+    metrics_reader_close(&reader);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,188 @@
+// tests/bench/bench.h
+// Minimal harness shared by the bench_* programs: pins the benchmark thread,
+// warms up, repeats each case and writes the samples as JSON for
+// scripts/bench_compare.py. Header-only so every benchmark stays a single
+// source file under the Makefile's bench rule.
+#ifndef TRADESYNTH_BENCH_H
+#define TRADESYNTH_BENCH_H
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <sched.h>
+#include <pthread.h>
+#include <getopt.h>
+#include "common/clock.h"
+
+#define BENCH_DEFAULT_REPEATS 10
+#define BENCH_MAX_REPEATS 100
+#define BENCH_WARMUP_NS (100 * NANOS_PER_MILLI)
+#define BENCH_SAMPLE_NS (20 * NANOS_PER_MILLI)
+
+typedef struct {
+    const char* name;
+    void (*setup)(void* arg);   // Untimed, before every run() call; may be NULL
+    void (*run)(void* arg);     // Timed
+    void* arg;
+    uint64_t ops;               // Operations per run() call
+} BenchCase;
+
+typedef struct {
+    const char* suite;
+    const char* filter;         // Substring of case names to run
+    int cpu;
+    int repeats;
+    FILE* json;
+    int result_count;
+} BenchOptions;
+
+static volatile uint64_t bench_sink;
+
+static int bench_compare_doubles(const void* a, const void* b) {
+    double left = *(const double*)a;
+    double right = *(const double*)b;
+    return (left > right) - (left < right);
+}
+
+static void bench_usage(const char* program_name) {
+    printf("Usage: %s [options]\n", program_name);
+    printf("  -j, --json FILE       Write results as JSON\n");
+    printf("  -r, --repeats N       Timed samples per case (default: %d)\n", BENCH_DEFAULT_REPEATS);
+    printf("  -c, --cpu N           Pin the benchmark thread to CPU N (default: current)\n");
+    printf("  -f, --filter TEXT     Only run cases whose name contains TEXT\n");
+    printf("  -h, --help            Show this help message\n");
+}
+
+static int bench_pin_thread(int cpu) {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+}
+
+/**
+ * Parse the common options, pin the calling thread and open the JSON
+ * output. Returns non-zero if the program should exit.
+ */
+static int bench_init(BenchOptions* options, const char* suite, int argc, char** argv) {
+    memset(options, 0, sizeof(*options));
+    options->suite = suite;
+    options->repeats = BENCH_DEFAULT_REPEATS;
+    options->cpu = sched_getcpu();
+    const char* json_path = NULL;
+
+    static struct option long_options[] = {
+        {"json",    required_argument, 0, 'j'},
+        {"repeats", required_argument, 0, 'r'},
+        {"cpu",     required_argument, 0, 'c'},
+        {"filter",  required_argument, 0, 'f'},
+        {"help",    no_argument,       0, 'h'},
+        {0, 0, 0, 0}
+    };
+
+    int opt;
+    while ((opt = getopt_long(argc, argv, "j:r:c:f:h", long_options, NULL)) != -1) {
+        switch (opt) {
+            case 'j': json_path = optarg; break;
+            case 'r': options->repeats = atoi(optarg); break;
+            case 'c': options->cpu = atoi(optarg); break;
+            case 'f': options->filter = optarg; break;
+            case 'h': bench_usage(argv[0]); return 1;
+            default: bench_usage(argv[0]); return -1;
+        }
+    }
+    if (options->repeats < 1 || options->repeats > BENCH_MAX_REPEATS) {
+        bench_usage(argv[0]);
+        return -1;
+    }
+
+    clock_ticks_per_second();
+    if (options->cpu < 0 || bench_pin_thread(options->cpu) != 0) {
+        fprintf(stderr, "Failed to pin to CPU %d, running unpinned\n", options->cpu);
+        options->cpu = -1;
+    }
+
+    if (json_path) {
+        options->json = fopen(json_path, "w");
+        if (!options->json) {
+            fprintf(stderr, "Failed to open %s\n", json_path);
+            return -1;
+        }
+        fprintf(options->json, "{\n  \"suite\": \"%s\",\n  \"cpu\": %d,\n  \"repeats\": %d,\n  \"results\": [",
+                suite, options->cpu, options->repeats);
+    }
+    printf("%s (%d samples per case, cpu %d)\n", suite, options->repeats, options->cpu);
+    return 0;
+}
+
+// Time run() for about sample_ns, excluding setup(), and return ns per op
+static double bench_sample(const BenchCase* bench, uint64_t sample_ns) {
+    uint64_t timed_ns = 0;
+    uint64_t calls = 0;
+    while (timed_ns < sample_ns) {
+        if (bench->setup) bench->setup(bench->arg);
+        uint64_t start = clock_ticks();
+        bench->run(bench->arg);
+        timed_ns += clock_ticks_to_ns(clock_ticks() - start);
+        calls++;
+    }
+    return (double)timed_ns / ((double)calls * (double)bench->ops);
+}
+
+/**
+ * Warm up, take the configured number of samples and report the median.
+ * Cases not matching the filter are skipped and return 0.
+ */
+static double bench_run(BenchOptions* options, const BenchCase* bench) {
+    if (options->filter && !strstr(bench->name, options->filter)) return 0.0;
+
+    bench_sample(bench, BENCH_WARMUP_NS);
+
+    double samples[BENCH_MAX_REPEATS];
+    double sum = 0.0;
+    for (int i = 0; i < options->repeats; i++) {
+        samples[i] = bench_sample(bench, BENCH_SAMPLE_NS);
+        sum += samples[i];
+    }
+
+    double mean = sum / options->repeats;
+    double variance = 0.0;
+    for (int i = 0; i < options->repeats; i++) {
+        variance += (samples[i] - mean) * (samples[i] - mean);
+    }
+    double stddev = sqrt(variance / options->repeats);
+
+    double sorted[BENCH_MAX_REPEATS];
+    memcpy(sorted, samples, sizeof(double) * (size_t)options->repeats);
+    qsort(sorted, (size_t)options->repeats, sizeof(double), bench_compare_doubles);
+    double median = sorted[options->repeats / 2];
+    double min = sorted[0];
+    double max = sorted[options->repeats - 1];
+
+    printf("  %-24s %10.2f ns/op  (min %.2f, max %.2f, stddev %.1f%%)\n", bench->name, median,
+           min, max, mean > 0.0 ? 100.0 * stddev / mean : 0.0);
+
+    if (options->json) {
+        fprintf(options->json, "%s\n    {\"name\": \"%s\", \"ns_per_op\": %.3f, \"min\": %.3f, "
+                "\"max\": %.3f, \"stddev\": %.3f, \"samples\": [",
+                options->result_count++ ? "," : "", bench->name, median, min, max, stddev);
+        for (int i = 0; i < options->repeats; i++) {
+            fprintf(options->json, "%s%.3f", i ? ", " : "", samples[i]);
+        }
+        fprintf(options->json, "]}");
+    }
+    return median;
+}
+
+static int bench_finish(BenchOptions* options) {
+    if (options->json) {
+        fprintf(options->json, "\n  ]\n}\n");
+        if (fclose(options->json) != 0) return -1;
+        options->json = NULL;
+    }
+    return 0;
+}
+
+#endif // TRADESYNTH_BENCH_H
@@ -0,0 +1,490 @@
+// tests/bench/bench_core.c
+// Hot-path microbenchmarks: message encode/decode, checksums, logging,
+// symbol hashing, order book operations (including IOC, FOK, iceberg
+// refills and a call auction uncross), the timer wheel, the pre-trade risk gate and market data fan-out.
+#include "bench.h"
+#include <poll.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include "server/server.h"
+#include "common/utils.h"
+
+#define BATCH 1024
+#define BOOK_LEVELS 64
+#define FANOUT_CLIENTS 8
+
+static Message order_messages[BATCH];
+static uint8_t encoded[BATCH][256];
+static int encoded_size[BATCH];
+static uint8_t payload[4096];
+static char symbols[BATCH][MAX_SYMBOL_LENGTH];
+
+static Order make_order(uint64_t id, OrderSide side, int64_t ticks, uint32_t quantity) {
+    Order order = {
+        .order_id = id,
+        .type = ORDER_TYPE_LIMIT,
+        .side = side,
+        .status = ORDER_STATUS_NEW,
+        .time_in_force = TIF_GTC,
+        .price = create_price(ticks, -2),
+        .quantity = quantity,
+        .remaining_quantity = quantity
+    };
+    strcpy(order.symbol, "BENCH");
+    strcpy(order.client_id, "bench-client");
+    return order;
+}
+
+static void serialize_orders(void* arg) {
+    (void)arg;
+    uint8_t buffer[256];
+    for (int i = 0; i < BATCH; i++) {
+        bench_sink += (uint64_t)serialize_message(&order_messages[i], buffer, sizeof(buffer));
+    }
+}
+
+static void deserialize_orders(void* arg) {
+    (void)arg;
+    Message msg;
+    for (int i = 0; i < BATCH; i++) {
+        bench_sink += (uint64_t)deserialize_message(encoded[i], (size_t)encoded_size[i], &msg);
+    }
+}
+
+static void checksum_payload(void* arg) {
+    size_t size = (size_t)(uintptr_t)arg;
+    for (int i = 0; i < BATCH; i++) {
+        payload[0] = (uint8_t)i;
+        bench_sink += calculate_checksum(payload, size);
+    }
+}
+
+static void hash_symbols(void* arg) {
+    (void)arg;
+    for (int i = 0; i < BATCH; i++) {
+        bench_sink += hash_string(symbols[i]);
+    }
+}
+
+// Keep the per-thread ring from overflowing into the drop path
+static void drain_logger(void* arg) {
+    (void)arg;
+    flush_logger();
+}
+
+static void log_messages(void* arg) {
+    (void)arg;
+    for (int i = 0; i < BATCH; i++) {
+        log_message(LOG_INFO, __FILE__, __LINE__, __func__, "Order %d filled %u @ %ld", i, 100u, 10050L);
+    }
+}
+
+static void log_site_messages(void* arg) {
+    (void)arg;
+    for (int i = 0; i < BATCH; i++) {
+        LOG_INFO("Order %d filled %u @ %ld", i, 100u, 10050L);
+    }
+}
+
+// Book benchmarks: setup() brings the book to a known state untimed
+static OrderBook book;
+static uint64_t next_order_id = 1;
+static uint64_t resting_ids[BATCH];
+
+static void clear_book(void) {
+    Order cancelled;
+    for (int i = 0; i < BATCH; i++) {
+        if (resting_ids[i]) {
+            orderbook_cancel_order(&book, resting_ids[i], &cancelled);
+            resting_ids[i] = 0;
+        }
+    }
+}
+
+static void rest_orders(void) {
+    for (int i = 0; i < BATCH; i++) {
+        // Asks spread over BOOK_LEVELS levels above 100.00
+        Order order = make_order(next_order_id++, ORDER_SIDE_SELL, 10001 + i % BOOK_LEVELS, 100);
+        orderbook_add_order(&book, &order, NULL, NULL);
+        resting_ids[i] = order.order_id;
+    }
+}
+
+static void setup_empty_book(void* arg) {
+    (void)arg;
+    clear_book();
+}
+
+static void setup_full_book(void* arg) {
+    (void)arg;
+    clear_book();
+    rest_orders();
+}
+
+static void book_insert(void* arg) {
+    (void)arg;
+    rest_orders();
+}
+
+static void book_cancel(void* arg) {
+    (void)arg;
+    Order cancelled;
+    for (int i = 0; i < BATCH; i++) {
+        orderbook_cancel_order(&book, resting_ids[i], &cancelled);
+        resting_ids[i] = 0;
+    }
+}
+
+static void count_fill(OrderBook* b, const OrderFill* fill, void* arg) {
+    (void)b;
+    (void)arg;
+    bench_sink += fill->quantity;
+}
+
+// Every aggressor takes exactly the best resting order
+static void book_match(void* arg) {
+    (void)arg;
+    for (int i = 0; i < BATCH; i++) {
+        Order order = make_order(next_order_id++, ORDER_SIDE_BUY, 10001 + BOOK_LEVELS, 100);
+        orderbook_add_order(&book, &order, count_fill, NULL);
+    }
+    memset(resting_ids, 0, sizeof(resting_ids));
+}
+
+// IOC takes the best resting order and would drop any remainder
+static void book_match_ioc(void* arg) {
+    (void)arg;
+    for (int i = 0; i < BATCH; i++) {
+        Order order = make_order(next_order_id++, ORDER_SIDE_BUY, 10001 + BOOK_LEVELS, 100);
+        order.time_in_force = TIF_IOC;
+        orderbook_add_order(&book, &order, count_fill, NULL);
+    }
+    memset(resting_ids, 0, sizeof(resting_ids));
+}
+
+// FOK for more than the best level holds within its limit, killed unfilled
+static void book_fok_reject(void* arg) {
+    (void)arg;
+    for (int i = 0; i < BATCH; i++) {
+        Order order = make_order(next_order_id++, ORDER_SIDE_BUY, 10001, 100 * (BATCH / BOOK_LEVELS) + 1);
+        order.time_in_force = TIF_FOK;
+        orderbook_add_order(&book, &order, count_fill, NULL);
+        bench_sink += order.status;
+    }
+}
+
+// Icebergs queued at one price, each showing a slice of 10
+static void setup_icebergs(void* arg) {
+    (void)arg;
+    clear_book();
+    for (int i = 0; i < BOOK_LEVELS; i++) {
+        Order order = make_order(next_order_id++, ORDER_SIDE_SELL, 10001, 1000);
+        order.display_quantity = 10;
+        orderbook_add_order(&book, &order, NULL, NULL);
+        resting_ids[i] = order.order_id;
+    }
+}
+
+// Every aggressor takes the first slice, which refills at the back of the level
+static void book_iceberg_refill(void* arg) {
+    (void)arg;
+    for (int i = 0; i < BATCH; i++) {
+        Order order = make_order(next_order_id++, ORDER_SIDE_BUY, 10001, 10);
+        orderbook_add_order(&book, &order, count_fill, NULL);
+    }
+}
+
+// One price level of large orders matched pro-rata
+static void setup_pro_rata(void* arg) {
+    (void)arg;
+    clear_book();
+    orderbook_set_match_policy(&book, MATCH_PRO_RATA, 1, 0);
+    for (int i = 0; i < BOOK_LEVELS; i++) {
+        Order order = make_order(next_order_id++, ORDER_SIDE_SELL, 10001, 100000);
+        orderbook_add_order(&book, &order, NULL, NULL);
+        resting_ids[i] = order.order_id;
+    }
+}
+
+// Every aggressor is shared over all BOOK_LEVELS orders at the level
+static void book_match_pro_rata(void* arg) {
+    (void)arg;
+    for (int i = 0; i < BATCH; i++) {
+        Order order = make_order(next_order_id++, ORDER_SIDE_BUY, 10001, 1000);
+        orderbook_add_order(&book, &order, count_fill, NULL);
+    }
+    orderbook_set_match_policy(&book, MATCH_PRICE_TIME, 0, 0);
+}
+
+// A call auction book of AUCTION_ORDERS orders, half bids and half asks, over
+// AUCTION_LEVELS levels a side that cross for half of them
+#define AUCTION_ORDERS 100000
+#define AUCTION_LEVELS 500
+
+static OrderBook auction_book;
+static uint64_t auction_first_id;
+static uint64_t auction_last_id;
+
+static void setup_auction(void* arg) {
+    (void)arg;
+    for (uint64_t id = auction_first_id; id < auction_last_id; id++) {
+        orderbook_cancel_order(&auction_book, id, NULL);
+    }
+    auction_book.phase = BOOK_PHASE_CALL;
+    auction_first_id = next_order_id;
+    for (int i = 0; i < AUCTION_ORDERS; i++) {
+        int64_t level = i / 2 % AUCTION_LEVELS;
+        Order order = i & 1 ? make_order(next_order_id++, ORDER_SIDE_SELL, 10000 + AUCTION_LEVELS / 2 + level,
+                                         100 + (uint32_t)(i % 7) * 10) :
+                              make_order(next_order_id++, ORDER_SIDE_BUY, 10000 + level,
+                                         100 + (uint32_t)(i % 5) * 10);
+        orderbook_add_order(&auction_book, &order, NULL, NULL);
+    }
+    auction_last_id = next_order_id;
+}
+
+// One op is a whole uncross: price discovery plus every fill at that price
+static void book_uncross(void* arg) {
+    (void)arg;
+    bench_sink += orderbook_uncross(&auction_book, count_fill, NULL);
+    auction_book.phase = BOOK_PHASE_CONTINUOUS;
+}
+
+// Timer wheel with deadlines spread over a minute, as resting orders' might be
+static TimerWheel wheel;
+static TimerNode wheel_timers[BATCH];
+static uint64_t wheel_now;
+
+static void arm_timers(void) {
+    for (int i = 0; i < BATCH; i++) {
+        uint64_t offset = (uint64_t)(i * 7919 % BATCH) * 60 * NANOS_PER_SECOND / BATCH;
+        timer_arm(&wheel, &wheel_timers[i], wheel_now + offset + 1);
+    }
+}
+
+static void setup_timers(void* arg) {
+    (void)arg;
+    arm_timers();
+}
+
+// One arm and one cancel per op
+static void timer_arm_cancel(void* arg) {
+    (void)arg;
+    arm_timers();
+    for (int i = 0; i < BATCH; i++) {
+        timer_cancel(&wheel, &wheel_timers[i]);
+    }
+}
+
+static void count_timer(TimerNode* node, void* arg) {
+    (void)arg;
+    bench_sink += (uintptr_t)node & 1;
+}
+
+// Firing includes cascading each timer down from the level it was armed in
+static void timer_expire(void* arg) {
+    (void)arg;
+    wheel_now += 61 * NANOS_PER_SECOND;
+    bench_sink += timer_wheel_advance(&wheel, wheel_now, count_timer, NULL);
+}
+
+// Market data fan-out to connected sessions over socket pairs
+static ServerContext* fanout_context;
+static int fanout_readers[FANOUT_CLIENTS];
+static volatile int fanout_running = 1;
+static MarketData fanout_data;
+
+static void* drain_sessions(void* arg) {
+    (void)arg;
+    struct pollfd fds[FANOUT_CLIENTS];
+    for (int i = 0; i < FANOUT_CLIENTS; i++) {
+        fds[i] = (struct pollfd){ .fd = fanout_readers[i], .events = POLLIN };
+    }
+    char buffer[65536];
+    while (fanout_running) {
+        if (poll(fds, FANOUT_CLIENTS, 10) <= 0) continue;
+        for (int i = 0; i < FANOUT_CLIENTS; i++) {
+            if (fds[i].revents & POLLIN) {
+                bench_sink += (uint64_t)read(fds[i].fd, buffer, sizeof(buffer));
+            }
+        }
+    }
+    return NULL;
+}
+
+static void market_data_fanout(void* arg) {
+    (void)arg;
+    for (int i = 0; i < BATCH / FANOUT_CLIENTS; i++) {
+        fanout_data.volume++;
+        broadcast_market_data(fanout_context, &fanout_data);
+    }
+}
+
+// Every check enabled and passing, so none short-circuits
+static Order risk_orders[BATCH];
+static OrderBook* risk_book;
+
+static void risk_check(void* arg) {
+    (void)arg;
+    for (int i = 0; i < BATCH; i++) {
+        bench_sink += (uint64_t)risk_check_order(fanout_context, risk_book, &risk_orders[i], 10000, NULL);
+    }
+}
+
+static int setup_risk(void) {
+    risk_book = get_or_create_order_book(fanout_context, "BENCH");
+    if (!risk_book) return -1;
+
+    RiskLimits* limits = atomic_load(&fanout_context->risk_limits);
+    limits->symbols[risk_book->symbol_id] = (SymbolRiskLimits){
+        .max_order_quantity = 10000, .collar_bps = 1000, .max_order_notional = INT64_MAX / 2
+    };
+    for (int i = 0; i < BATCH; i++) {
+        risk_orders[i] = make_order((uint64_t)i + 1, i & 1 ? ORDER_SIDE_SELL : ORDER_SIDE_BUY,
+                                    10000 + i % 100, 100);
+        snprintf(risk_orders[i].client_id, MAX_CLIENT_ID_LENGTH, "risk-%d", i % 64);
+        uint32_t account_id = get_or_create_account(fanout_context, risk_orders[i].client_id);
+        if (account_id == UINT32_MAX) return -1;
+        limits->clients[account_id] = (ClientRiskLimits){
+            .max_order_quantity = 10000, .position_limit = 1000000,
+            .max_order_notional = INT64_MAX / 2, .max_net_exposure = INT64_MAX / 2,
+            .max_gross_exposure = INT64_MAX / 2, .credit_limit = INT64_MAX / 2
+        };
+    }
+    return 0;
+}
+
+static int setup_fanout(pthread_t* drainer) {
+    ServerConfig config = {
+        .port = DEFAULT_PORT,
+        .max_clients = FANOUT_CLIENTS,
+        .symbols = { "BENCH" },
+        .symbol_count = 1
+    };
+    fanout_context = initialize_server_context(&config);
+    if (!fanout_context) return -1;
+
+    for (int i = 0; i < FANOUT_CLIENTS; i++) {
+        int pair[2];
+        if (socketpair(AF_UNIX, SOCK_STREAM, 0, pair) != 0) return -1;
+        ClientConnection* client = &fanout_context->clients[i];
+        client->socket = pair[0];
+        client->active = 1;
+        snprintf(client->id, MAX_CLIENT_ID_LENGTH, "bench-%d", i);
+        fanout_readers[i] = pair[1];
+    }
+    fanout_context->client_count = FANOUT_CLIENTS;
+
+    strcpy(fanout_data.symbol, "BENCH");
+    fanout_data.bid = create_price(10000, -2);
+    fanout_data.ask = create_price(10001, -2);
+    fanout_data.bid_size = 500;
+    fanout_data.ask_size = 700;
+    return pthread_create(drainer, NULL, drain_sessions, NULL);
+}
+
+static void teardown_fanout(pthread_t drainer) {
+    fanout_running = 0;
+    pthread_join(drainer, NULL);
+    for (int i = 0; i < FANOUT_CLIENTS; i++) {
+        close(fanout_context->clients[i].socket);
+        close(fanout_readers[i]);
+        fanout_context->clients[i].active = 0;
+    }
+    fanout_context->client_count = 0;
+    cleanup_server(fanout_context);
+}
+
+int main(int argc, char* argv[]) {
+    BenchOptions options;
+    int status = bench_init(&options, "core", argc, argv);
+    if (status != 0) return status < 0 ? EXIT_FAILURE : EXIT_SUCCESS;
+
+    LoggerConfig log_config = {
+        .log_file_path = "/dev/null",
+        .min_level = LOG_INFO,
+        .overflow_policy = LOG_OVERFLOW_DROP,
+        .ring_capacity = 4 * BATCH,
+        .flush_interval_us = LOG_DEFAULT_FLUSH_INTERVAL_US
+    };
+    if (init_logger_with_config(&log_config) != SUCCESS) {
+        fprintf(stderr, "Failed to initialise the logger\n");
+        return EXIT_FAILURE;
+    }
+
+    for (int i = 0; i < BATCH; i++) {
+        order_messages[i] = (Message){
+            .type = MSG_ORDER_NEW,
+            .sequence_num = (uint64_t)i + 1,
+            .timestamp = clock_now_ns(),
+            .data.order = make_order((uint64_t)i + 1, i & 1 ? ORDER_SIDE_SELL : ORDER_SIDE_BUY,
+                                     10000 + i % 100, 100)
+        };
+        encoded_size[i] = serialize_message(&order_messages[i], encoded[i], sizeof(encoded[i]));
+        snprintf(symbols[i], MAX_SYMBOL_LENGTH, "SYM%04d", i % 500);
+    }
+    for (size_t i = 0; i < sizeof(payload); i++) {
+        payload[i] = (uint8_t)(i * 31);
+    }
+
+    memset(&book, 0, sizeof(book));
+    strcpy(book.symbol, "BENCH");
+    book.tick_exponent = -2;
+    if (orderbook_init(&book, 4 * BATCH) != SUCCESS) {
+        fprintf(stderr, "Failed to initialise the order book\n");
+        return EXIT_FAILURE;
+    }
+    memset(&auction_book, 0, sizeof(auction_book));
+    strcpy(auction_book.symbol, "AUCTION");
+    auction_book.tick_exponent = -2;
+    if (orderbook_init(&auction_book, AUCTION_ORDERS) != SUCCESS) {
+        fprintf(stderr, "Failed to initialise the auction book\n");
+        return EXIT_FAILURE;
+    }
+
+    wheel_now = clock_now_ns();
+    timer_wheel_init(&wheel, wheel_now);
+
+    pthread_t drainer;
+    if (setup_fanout(&drainer) != 0) {
+        fprintf(stderr, "Failed to set up market data fan-out\n");
+        return EXIT_FAILURE;
+    }
+    if (setup_risk() != 0) {
+        fprintf(stderr, "Failed to set up risk limits\n");
+        return EXIT_FAILURE;
+    }
+
+    const BenchCase cases[] = {
+        { .name = "serialize_order", .run = serialize_orders, .ops = BATCH },
+        { .name = "deserialize_order", .run = deserialize_orders, .ops = BATCH },
+        { .name = "checksum_order", .run = checksum_payload, .arg = (void*)(uintptr_t)sizeof(Order),
+          .ops = BATCH },
+        { .name = "checksum_4k", .run = checksum_payload, .arg = (void*)(uintptr_t)sizeof(payload),
+          .ops = BATCH },
+        { .name = "log_message", .setup = drain_logger, .run = log_messages, .ops = BATCH },
+        { .name = "log_site_message", .setup = drain_logger, .run = log_site_messages, .ops = BATCH },
+        { .name = "hash_string", .run = hash_symbols, .ops = BATCH },
+        { .name = "book_insert", .setup = setup_empty_book, .run = book_insert, .ops = BATCH },
+        { .name = "book_cancel", .setup = setup_full_book, .run = book_cancel, .ops = BATCH },
+        { .name = "book_match", .setup = setup_full_book, .run = book_match, .ops = BATCH },
+        { .name = "book_match_ioc", .setup = setup_full_book, .run = book_match_ioc, .ops = BATCH },
+        { .name = "book_fok_reject", .setup = setup_full_book, .run = book_fok_reject, .ops = BATCH },
+        { .name = "book_iceberg_refill", .setup = setup_icebergs, .run = book_iceberg_refill, .ops = BATCH },
+        { .name = "book_match_pro_rata", .setup = setup_pro_rata, .run = book_match_pro_rata, .ops = BATCH },
+        { .name = "book_uncross_100k", .setup = setup_auction, .run = book_uncross, .ops = 1 },
+        { .name = "timer_arm_cancel", .run = timer_arm_cancel, .ops = BATCH },
+        { .name = "timer_expire", .setup = setup_timers, .run = timer_expire, .ops = BATCH },
+        { .name = "risk_check", .run = risk_check, .ops = BATCH },
+        { .name = "market_data_fanout_8", .run = market_data_fanout, .ops = BATCH / FANOUT_CLIENTS }
+    };
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+        bench_run(&options, &cases[i]);
+    }
+
+    teardown_fanout(drainer);
+    orderbook_destroy(&book);
+    orderbook_destroy(&auction_book);
+    close_logger();
+    return bench_finish(&options) == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,76 @@
+// tests/bench/bench_price.c
+// Compare the integer price parse/format routines with the snprintf/strtod path.
+#include "bench.h"
+#include "common/types.h"
+#include "common/utils.h"
+
+#define NUM_PRICES 4096
+#define TEXT_LENGTH 32
+
+static Price prices[NUM_PRICES];
+static char texts[NUM_PRICES][TEXT_LENGTH];
+
+static void format_integer(void* arg) {
+    (void)arg;
+    char buffer[TEXT_LENGTH];
+    for (int i = 0; i < NUM_PRICES; i++) {
+        bench_sink += format_price(&prices[i], buffer, sizeof(buffer));
+    }
+}
+
+static void format_snprintf(void* arg) {
+    (void)arg;
+    char buffer[TEXT_LENGTH];
+    for (int i = 0; i < NUM_PRICES; i++) {
+        bench_sink += (uint64_t)snprintf(buffer, sizeof(buffer), "%.6f", price_to_double(prices[i]));
+    }
+}
+
+static void parse_integer(void* arg) {
+    (void)arg;
+    Price p;
+    for (int i = 0; i < NUM_PRICES; i++) {
+        parse_price_string(texts[i], &p);
+        bench_sink += (uint64_t)p.mantissa;
+    }
+}
+
+static void parse_strtod(void* arg) {
+    (void)arg;
+    for (int i = 0; i < NUM_PRICES; i++) {
+        Price p = double_to_price(strtod(texts[i], NULL));
+        bench_sink += (uint64_t)p.mantissa;
+    }
+}
+
+int main(int argc, char* argv[]) {
+    BenchOptions options;
+    int status = bench_init(&options, "price", argc, argv);
+    if (status != 0) return status < 0 ? EXIT_FAILURE : EXIT_SUCCESS;
+    srand(42);
+
+    // Typical equity prices: up to six decimals, a few hundred dollars
+    for (int i = 0; i < NUM_PRICES; i++) {
+        prices[i] = create_price((int64_t)(rand() % 500000000) + 1, -6);
+        format_price(&prices[i], texts[i], TEXT_LENGTH);
+    }
+
+    const BenchCase cases[] = {
+        { .name = "format_price", .run = format_integer, .ops = NUM_PRICES },
+        { .name = "format_snprintf", .run = format_snprintf, .ops = NUM_PRICES },
+        { .name = "parse_price_string", .run = parse_integer, .ops = NUM_PRICES },
+        { .name = "parse_strtod", .run = parse_strtod, .ops = NUM_PRICES }
+    };
+    double results[4];
+    for (int i = 0; i < 4; i++) {
+        results[i] = bench_run(&options, &cases[i]);
+    }
+    if (results[0] > 0.0 && results[1] > 0.0) {
+        printf("  format speedup %.2fx\n", results[1] / results[0]);
+    }
+    if (results[2] > 0.0 && results[3] > 0.0) {
+        printf("  parse speedup  %.2fx\n", results[3] / results[2]);
+    }
+
+    return bench_finish(&options) == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -7,7 +7,9 @@
 Test(integration, client_server_connection, .timeout = 5) {
     ServerConfig server_config = {
         .port = 8080,
-        .max_clients = 1
+        .max_clients = 1,
+        .symbols = { "AAPL" },
+        .symbol_count = 1
     };
     ServerContext* server = initialize_server_context(&server_config);
     cr_assert_not_null(server, "Server initialization failed");
@@ -38,7 +40,9 @@ Test(integration, client_server_connection, .timeout = 5) {
 Test(integration, message_exchange, .timeout = 5) {
     ServerConfig server_config = {
         .port = 8080,
-        .max_clients = 1
+        .max_clients = 1,
+        .symbols = { "AAPL" },
+        .symbol_count = 1
     };
     ServerContext* server = initialize_server_context(&server_config);
     cr_assert_not_null(server, "Server initialization failed");
@@ -59,7 +63,7 @@ Test(integration, message_exchange, .timeout = 5) {
 
     // Test order message
     Order order = {
-        .order_id = 12345,
+        .client_order_id = 12345,
         .type = ORDER_TYPE_LIMIT,
         .side = ORDER_SIDE_BUY,
         .price = double_to_price(100.50),
@@ -0,0 +1,55 @@
+// tests/unit/test_binary_log.c
+#include <criterion/criterion.h>
+#include <string.h>
+#include "../../include/common/binary_log.h"
+
+Test(binary_log, parse_format_arguments) {
+    uint8_t types[LOG_MAX_ARGS];
+    int count = parse_log_format("id=%lu sym=%s px=%.6f qty=%u w=%-*d %%", types, LOG_MAX_ARGS);
+
+    cr_assert_eq(count, 6, "Unexpected argument count");
+    cr_assert_eq(types[0], LOG_ARG_LONG, "%%lu should be captured as LONG");
+    cr_assert_eq(types[1], LOG_ARG_STRING, "%%s should be captured as STRING");
+    cr_assert_eq(types[2], LOG_ARG_DOUBLE, "%%f should be captured as DOUBLE");
+    cr_assert_eq(types[3], LOG_ARG_INT, "%%u should be captured as INT");
+    cr_assert_eq(types[4], LOG_ARG_INT, "'*' width should be captured as INT");
+    cr_assert_eq(types[5], LOG_ARG_INT, "%%d should be captured as INT");
+}
+
+Test(binary_log, parse_rejects_unsupported) {
+    uint8_t types[LOG_MAX_ARGS];
+    cr_assert_eq(parse_log_format("bad %n", types, LOG_MAX_ARGS), -1, "%%n must not be captured");
+    cr_assert_eq(parse_log_format("%d %d", types, 1), -1, "Too many arguments must be rejected");
+    cr_assert_eq(parse_log_format("px=%Lf", types, LOG_MAX_ARGS), -1, "%%Lf must not be captured");
+    cr_assert_eq(parse_log_format("name=%ls", types, LOG_MAX_ARGS), -1, "%%ls must not be captured");
+    cr_assert_eq(parse_log_format("ch=%lc", types, LOG_MAX_ARGS), -1, "%%lc must not be captured");
+    cr_assert_eq(parse_log_format("px=%lf", types, LOG_MAX_ARGS), 1, "%%lf is a plain double");
+}
+
+Test(binary_log, format_payload_roundtrip) {
+    uint8_t payload[64];
+    size_t pos = 0;
+    int64_t order_id = 12345;
+    uint16_t length = 4;
+    double price = 100.5;
+    int32_t quantity = 7;
+
+    memcpy(payload + pos, &order_id, sizeof(order_id));
+    pos += sizeof(order_id);
+    memcpy(payload + pos, &length, sizeof(length));
+    pos += sizeof(length);
+    memcpy(payload + pos, "AAPL", length);
+    pos += length;
+    memcpy(payload + pos, &price, sizeof(price));
+    pos += sizeof(price);
+    memcpy(payload + pos, &quantity, sizeof(quantity));
+    pos += sizeof(quantity);
+
+    char text[128];
+    int written = format_log_payload("Order %lu %s @ %.2f x %u", payload, pos, text, sizeof(text));
+    cr_assert_gt(written, 0, "Decoding failed");
+    cr_assert_str_eq(text, "Order 12345 AAPL @ 100.50 x 7", "Decoded text mismatch");
+
+    cr_assert_eq(format_log_payload("Order %lu %s", payload, 4, text, sizeof(text)), -1,
+                 "Truncated payload must be rejected");
+}
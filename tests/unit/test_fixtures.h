@@ -0,0 +1,80 @@
+// tests/unit/test_fixtures.h
+// Fixtures shared by the unit tests that drive a whole server context: a
+// config with one AAPL book, AAPL limit orders, and lookup of resting
+// orders by the client order id a test sent, since the server assigns the
+// order ids. Header-only so each test stays a single source file.
+#ifndef TRADESYNTH_TEST_FIXTURES_H
+#define TRADESYNTH_TEST_FIXTURES_H
+
+#include <criterion/criterion.h>
+#include "../../include/server/server.h"
+
+#define FIXTURE_SYMBOL "AAPL"
+
+// Four clients, room for eight symbols, AAPL the only configured one
+static inline ServerConfig fixture_config(void) {
+    ServerConfig config = {
+        .port = DEFAULT_PORT,
+        .max_clients = 4,
+        .max_symbols = 8,
+        .symbols = { FIXTURE_SYMBOL },
+        .symbol_count = 1
+    };
+    return config;
+}
+
+// A context with no listening socket, for driving the handlers directly
+static inline ServerContext* start_context(const ServerConfig* config) {
+    ServerContext* context = initialize_server_context(config);
+    cr_assert_not_null(context, "Failed to initialize server context");
+    context->server_socket = -1;
+    return context;
+}
+
+// A GTC limit order for AAPL in cents
+static inline Order make_order(const char* client, uint64_t client_order_id, OrderSide side,
+                               int64_t cents, uint32_t quantity) {
+    Order order = {
+        .client_order_id = client_order_id,
+        .type = ORDER_TYPE_LIMIT,
+        .side = side,
+        .time_in_force = TIF_GTC,
+        .price = create_price(cents, -2),
+        .quantity = quantity
+    };
+    strcpy(order.symbol, FIXTURE_SYMBOL);
+    strcpy(order.client_id, client);
+    return order;
+}
+
+static inline int submit(ServerContext* context, const char* client, uint64_t client_order_id,
+                         OrderSide side, int64_t cents, uint32_t quantity) {
+    Order order = make_order(client, client_order_id, side, cents, quantity);
+    return process_order(context, &order);
+}
+
+typedef struct {
+    uint64_t client_order_id;
+    const Order* order;
+} ClientOrderSearch;
+
+static inline void match_client_order(const OrderBookEntry* entry, void* arg) {
+    ClientOrderSearch* search = arg;
+    if (entry->order.client_order_id == search->client_order_id) search->order = &entry->order;
+}
+
+// The resting or pending order sent with client_order_id, NULL if none
+static inline const Order* find_client_order(const OrderBook* book, uint64_t client_order_id) {
+    ClientOrderSearch search = { .client_order_id = client_order_id };
+    orderbook_for_each(book, match_client_order, &search);
+    return search.order;
+}
+
+// Server order id of a resting AAPL order, for cancels and modifies
+static inline uint64_t resting_order_id(ServerContext* context, uint64_t client_order_id) {
+    const Order* order = find_client_order(find_order_book(context, FIXTURE_SYMBOL), client_order_id);
+    cr_assert_not_null(order, "No resting order with client order id %lu", client_order_id);
+    return order->order_id;
+}
+
+#endif
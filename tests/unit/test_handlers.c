@@ -0,0 +1,235 @@
+// tests/unit/test_handlers.c
+#include <criterion/criterion.h>
+#include "../../include/server/server.h"
+
+#define ID_THREADS 4
+#define IDS_PER_THREAD (ID_BLOCK_SIZE * 3 + 17)
+
+typedef struct {
+    ServerContext* context;
+    uint64_t* ids;
+} IdWorker;
+
+static void* take_ids(void* arg) {
+    IdWorker* worker = arg;
+    for (uint32_t i = 0; i < IDS_PER_THREAD; i++) {
+        worker->ids[i] = generate_order_id(worker->context);
+    }
+    return NULL;
+}
+
+static int compare_ids(const void* a, const void* b) {
+    uint64_t left = *(const uint64_t*)a;
+    uint64_t right = *(const uint64_t*)b;
+    return (left > right) - (left < right);
+}
+
+Test(handlers, id_blocks_are_unique_across_threads) {
+    ServerConfig config = { .port = DEFAULT_PORT, .max_clients = 1 };
+    ServerContext* context = initialize_server_context(&config);
+    cr_assert_not_null(context);
+
+    uint64_t* ids = calloc(ID_THREADS * IDS_PER_THREAD, sizeof(uint64_t));
+    pthread_t threads[ID_THREADS];
+    IdWorker workers[ID_THREADS];
+    for (int i = 0; i < ID_THREADS; i++) {
+        workers[i] = (IdWorker){ .context = context, .ids = ids + i * IDS_PER_THREAD };
+        pthread_create(&threads[i], NULL, take_ids, &workers[i]);
+    }
+    for (int i = 0; i < ID_THREADS; i++) {
+        pthread_join(threads[i], NULL);
+    }
+
+    // Increasing within a thread, never repeated across threads
+    for (int i = 0; i < ID_THREADS; i++) {
+        for (uint32_t j = 1; j < IDS_PER_THREAD; j++) {
+            cr_assert_gt(workers[i].ids[j], workers[i].ids[j - 1]);
+        }
+    }
+    qsort(ids, ID_THREADS * IDS_PER_THREAD, sizeof(uint64_t), compare_ids);
+    cr_assert_geq(ids[0], 1, "Id 0 is reserved for empty index slots");
+    for (uint32_t i = 1; i < ID_THREADS * IDS_PER_THREAD; i++) {
+        cr_assert_neq(ids[i], ids[i - 1], "Id %lu handed out twice", ids[i]);
+    }
+    cr_assert_eq(atomic_load(&context->next_order_id), 1 + ID_THREADS * 4 * ID_BLOCK_SIZE,
+                 "Each thread should have reserved exactly four blocks");
+
+    // Trade ids are a separate space; a new context does not inherit blocks
+    cr_assert_eq(generate_trade_id(context), 1);
+    context->server_socket = -1;
+    cleanup_server(context);
+    context = initialize_server_context(&config);
+    cr_assert_eq(generate_order_id(context), 1, "Block from a freed context reused");
+    context->server_socket = -1;
+    cleanup_server(context);
+    free(ids);
+}
+
+Test(handlers, session_sequence_numbers) {
+    ServerConfig config = {
+        .port = DEFAULT_PORT,
+        .max_clients = 2,
+        .symbols = { "AAPL" },
+        .symbol_count = 1
+    };
+    ServerContext* context = initialize_server_context(&config);
+    cr_assert_not_null(context);
+
+    // Two sessions on socket pairs; the server writes to [0]
+    int pairs[2][2];
+    for (int i = 0; i < 2; i++) {
+        cr_assert_eq(socketpair(AF_UNIX, SOCK_STREAM, 0, pairs[i]), 0);
+        ClientConnection* client = &context->clients[i];
+        client->socket = pairs[i][0];
+        client->active = 1;
+        snprintf(client->id, sizeof(client->id), "client%d", i);
+    }
+
+    Order order = {
+        .type = ORDER_TYPE_LIMIT,
+        .side = ORDER_SIDE_SELL,
+        .time_in_force = TIF_GTC,
+        .price = create_price(10000, -2),
+        .quantity = 10
+    };
+    strcpy(order.symbol, "AAPL");
+    strcpy(order.client_id, "client0");
+    process_order(context, &order);
+    order.side = ORDER_SIDE_BUY;
+    strcpy(order.client_id, "client1");
+    process_order(context, &order);
+    Message heartbeat = { .type = MSG_HEARTBEAT, .sequence_num = 99 };
+    handle_heartbeat(context, &context->clients[1], &heartbeat);
+
+    // Each session counts from 1 regardless of what the other was sent
+    for (int i = 0; i < 2; i++) {
+        uint8_t buffer[BUFFER_SIZE];
+        ssize_t length = recv(pairs[i][1], buffer, sizeof(buffer), MSG_DONTWAIT);
+        cr_assert_gt(length, 0, "Nothing sent to client%d", i);
+        uint64_t expected = 1;
+        for (ssize_t offset = 0; offset < length; expected++) {
+            Message msg;
+            int consumed = deserialize_message(buffer + offset, (size_t)(length - offset), &msg);
+            cr_assert_gt(consumed, 0);
+            cr_assert_eq(msg.sequence_num, expected, "client%d message %lu out of sequence", i, expected);
+            offset += consumed;
+        }
+        cr_assert_eq(context->clients[i].outbound_sequence, expected - 1);
+        cr_assert_eq(atomic_load(&context->clients[i].messages_sent), expected - 1);
+    }
+    // Ack, trade and the heartbeat for client1
+    cr_assert_eq(context->clients[1].outbound_sequence, 3);
+
+    for (int i = 0; i < 2; i++) {
+        context->clients[i].active = 0;
+        close(pairs[i][0]);
+        close(pairs[i][1]);
+    }
+    context->server_socket = -1;
+    cleanup_server(context);
+}
+
+Test(handlers, large_sweep_is_sent_after_matching) {
+    ServerConfig config = {
+        .port = DEFAULT_PORT,
+        .max_clients = 2,
+        .symbols = { "AAPL" },
+        .symbol_count = 1
+    };
+    ServerContext* context = initialize_server_context(&config);
+    cr_assert_not_null(context);
+
+    int pair[2];
+    cr_assert_eq(socketpair(AF_UNIX, SOCK_STREAM, 0, pair), 0);
+    ClientConnection* client = &context->clients[0];
+    client->socket = pair[0];
+    client->active = 1;
+    strcpy(client->id, "buyer");
+
+    // More resting orders than a batch holds on the stack
+    Order order = {
+        .type = ORDER_TYPE_LIMIT,
+        .side = ORDER_SIDE_SELL,
+        .time_in_force = TIF_GTC,
+        .price = create_price(10000, -2),
+        .quantity = 1
+    };
+    strcpy(order.symbol, "AAPL");
+    strcpy(order.client_id, "seller");
+    for (int i = 0; i < 150; i++) {
+        cr_assert_eq(process_order(context, &order), SUCCESS);
+    }
+    order.side = ORDER_SIDE_BUY;
+    order.quantity = 150;
+    strcpy(order.client_id, "buyer");
+    cr_assert_eq(process_order(context, &order), SUCCESS);
+
+    // The ack goes out once the book is unlocked, then every trade after it
+    uint8_t buffer[64 * 1024];
+    size_t length = 0;
+    ssize_t received;
+    while ((received = recv(pair[1], buffer + length, sizeof(buffer) - length, MSG_DONTWAIT)) > 0) {
+        length += (size_t)received;
+    }
+    uint32_t trades = 0;
+    size_t offset = 0;
+    Message msg;
+    int consumed = deserialize_message(buffer, length, &msg);
+    cr_assert_gt(consumed, 0);
+    cr_assert_eq(msg.type, MSG_ORDER_STATUS, "Trades sent before the order was acked");
+    cr_assert_eq(msg.data.order.status, ORDER_STATUS_FILLED);
+    for (offset = (size_t)consumed; offset < length; offset += (size_t)consumed) {
+        consumed = deserialize_message(buffer + offset, length - offset, &msg);
+        cr_assert_gt(consumed, 0);
+        cr_assert_eq(msg.type, MSG_TRADE_EXEC);
+        trades++;
+    }
+    cr_assert_eq(trades, 150);
+
+    client->active = 0;
+    close(pair[0]);
+    close(pair[1]);
+    context->server_socket = -1;
+    cleanup_server(context);
+}
+
+Test(handlers, messages_never_create_books) {
+    ServerConfig config = {
+        .port = DEFAULT_PORT,
+        .max_clients = 1,
+        .symbols = { "AAPL" },
+        .symbol_count = 1,
+        .match_policies = { { .symbol = "MSFT", .policy = MATCH_PRO_RATA, .min_allocation = 1 } },
+        .match_policy_count = 1
+    };
+    ServerContext* context = initialize_server_context(&config);
+    cr_assert_not_null(context);
+    cr_assert_eq(context->symbol_count, 2, "Listed and policy symbols are registered at startup");
+
+    Order order = {
+        .type = ORDER_TYPE_LIMIT,
+        .side = ORDER_SIDE_BUY,
+        .price = create_price(10000, -2),
+        .quantity = 1
+    };
+    strcpy(order.symbol, "ZZZZ");
+    strcpy(order.client_id, "client");
+    cr_assert_eq(process_order(context, &order), ERROR_SYMBOL_NOT_FOUND);
+
+    MarketData quote = { .bid = create_price(9900, -2), .ask = create_price(10100, -2) };
+    strcpy(quote.symbol, "ZZZZ");
+    cr_assert_eq(broadcast_market_data(context, &quote), ERROR_SYMBOL_NOT_FOUND);
+
+    TradeExecution trade = { .price = create_price(10000, -2), .quantity = 1 };
+    strcpy(trade.symbol, "ZZZZ");
+    cr_assert_eq(update_symbol_last_trade(context, &trade), ERROR_SYMBOL_NOT_FOUND);
+
+    cr_assert_null(find_order_book(context, "ZZZZ"), "A message created a book");
+    cr_assert_eq(context->symbol_count, 2);
+
+    strcpy(order.symbol, "MSFT");
+    cr_assert_eq(process_order(context, &order), SUCCESS);
+
+    context->server_socket = -1;
+    cleanup_server(context);
+}
@@ -0,0 +1,128 @@
+// tests/unit/test_journal.c
+#include <pthread.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include "test_fixtures.h"
+
+#define JOURNAL_TEST_FILE "/tmp/tradesynth_test_journal.bin"
+#define APPEND_THREADS 4
+#define APPENDS_PER_THREAD 5000
+
+static ServerStats stats;
+
+static void* append_orders(void* arg) {
+    Journal* journal = arg;
+    Order order = { .type = ORDER_TYPE_LIMIT, .side = ORDER_SIDE_BUY, .quantity = 100 };
+    strcpy(order.symbol, "AAPL");
+    for (int i = 0; i < APPENDS_PER_THREAD; i++) {
+        order.order_id = (uint64_t)i;
+        journal_append_order(journal, JOURNAL_ORDER_NEW, &order);
+    }
+    return NULL;
+}
+
+static uint64_t count_records(void) {
+    FILE* file = fopen(JOURNAL_TEST_FILE, "rb");
+    cr_assert_not_null(file, "Journal file missing");
+
+    JournalFileHeader header;
+    cr_assert_eq(fread(&header, sizeof(header), 1, file), 1, "Header missing");
+    cr_assert_eq(memcmp(header.magic, JOURNAL_MAGIC, sizeof(header.magic)), 0, "Bad magic");
+
+    JournalRecord record;
+    uint64_t expected = 1;
+    while (fread(&record, sizeof(record), 1, file) == 1) {
+        cr_assert_eq(record.sequence, expected, "Sequence gap at %lu", expected);
+        expected++;
+    }
+    fclose(file);
+    return expected - 1;
+}
+
+Test(journal, concurrent_appends_are_dense) {
+    unlink(JOURNAL_TEST_FILE);
+    memset(&stats, 0, sizeof(stats));
+
+    Journal* journal = journal_open(JOURNAL_TEST_FILE, 500, 64, &stats);
+    cr_assert_not_null(journal, "Failed to open journal");
+
+    pthread_t threads[APPEND_THREADS];
+    for (int i = 0; i < APPEND_THREADS; i++) {
+        pthread_create(&threads[i], NULL, append_orders, journal);
+    }
+    for (int i = 0; i < APPEND_THREADS; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    journal_close(journal);
+
+    uint64_t total = APPEND_THREADS * APPENDS_PER_THREAD;
+    cr_assert_eq(count_records(), total, "Record count mismatch");
+    cr_assert_eq(atomic_load(&stats.journal_events), total, "Stats event count mismatch");
+    cr_assert_gt(atomic_load(&stats.journal_syncs), 0, "Group commit never synced");
+}
+
+Test(journal, reopen_continues_and_drops_torn_tail) {
+    unlink(JOURNAL_TEST_FILE);
+
+    Journal* journal = journal_open(JOURNAL_TEST_FILE, 0, 1, NULL);
+    cr_assert_not_null(journal, "Failed to open journal");
+    TradeExecution trade = { .trade_id = 1, .quantity = 10 };
+    for (int i = 0; i < 10; i++) {
+        journal_append_trade(journal, &trade);
+    }
+    journal_close(journal);
+
+    // Simulate a crash halfway through writing a record
+    int fd = open(JOURNAL_TEST_FILE, O_WRONLY | O_APPEND);
+    char garbage[sizeof(JournalRecord) / 2] = {0x5a};
+    cr_assert_eq(write(fd, garbage, sizeof(garbage)), (ssize_t)sizeof(garbage), "Short write");
+    close(fd);
+
+    journal = journal_open(JOURNAL_TEST_FILE, 0, 1, NULL);
+    cr_assert_not_null(journal, "Failed to reopen journal");
+    cr_assert_eq(journal_last_sequence(journal), 10, "Recovered sequence mismatch");
+    journal_append_trade(journal, &trade);
+    journal_close(journal);
+
+    cr_assert_eq(count_records(), 11, "Torn tail not truncated");
+    unlink(JOURNAL_TEST_FILE);
+}
+
+// The file size limit makes the writer's next write fail with EFBIG
+Test(journal, failure_refuses_orders) {
+    unlink(JOURNAL_TEST_FILE);
+    ServerConfig config = fixture_config();
+    strcpy(config.journal_file, JOURNAL_TEST_FILE);
+    config.journal_sync_events = 1;
+    ServerContext* context = start_context(&config);
+
+    struct stat file;
+    cr_assert_eq(stat(JOURNAL_TEST_FILE, &file), 0);
+    struct rlimit saved;
+    getrlimit(RLIMIT_FSIZE, &saved);
+    signal(SIGXFSZ, SIG_IGN);
+    struct rlimit full = { .rlim_cur = (rlim_t)file.st_size, .rlim_max = saved.rlim_max };
+    setrlimit(RLIMIT_FSIZE, &full);
+
+    cr_assert_eq(submit(context, "desk", 1, ORDER_SIDE_BUY, 10000, 10), SUCCESS);
+    for (int i = 0; i < 1000 && !journal_failed(context->journal); i++) {
+        usleep(1000);
+    }
+    setrlimit(RLIMIT_FSIZE, &saved);
+    signal(SIGXFSZ, SIG_DFL);
+    cr_assert(journal_failed(context->journal), "Write failure not noticed");
+
+    // New orders and modifies are refused; cancels still go through
+    cr_assert_eq(submit(context, "desk", 2, ORDER_SIDE_BUY, 10000, 10), ERROR_JOURNAL_FAILED);
+    cr_assert_null(find_client_order(find_order_book(context, FIXTURE_SYMBOL), 2));
+    Order modify = make_order("desk", 1, ORDER_SIDE_BUY, 10000, 20);
+    modify.order_id = resting_order_id(context, 1);
+    cr_assert_eq(process_modify_order(context, &modify), ERROR_JOURNAL_FAILED);
+    cr_assert_eq(process_cancel_order(context, &modify), SUCCESS);
+
+    cleanup_server(context);
+    cr_assert_eq(count_records(), 0, "Nothing is written after a failure");
+    unlink(JOURNAL_TEST_FILE);
+}
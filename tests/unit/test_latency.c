@@ -0,0 +1,72 @@
+// tests/unit/test_latency.c
+#include <criterion/criterion.h>
+#include <pthread.h>
+#include <string.h>
+#include "../../include/common/latency.h"
+
+static LatencyHistogram histogram;
+
+Test(latency, exact_small_values) {
+    latency_histogram_reset(&histogram);
+    for (uint64_t value = 1; value <= 50; value++) {
+        latency_histogram_record(&histogram, value);
+    }
+    cr_assert_eq(histogram.total_count, 50, "Count mismatch");
+    cr_assert_eq(latency_histogram_percentile(&histogram, 50.0), 25, "p50 should be exact below 64ns");
+    cr_assert_eq(latency_histogram_percentile(&histogram, 100.0), 50, "p100 should be the max");
+    cr_assert_eq(histogram.min, 1, "Min mismatch");
+}
+
+Test(latency, relative_error_bounded) {
+    latency_histogram_reset(&histogram);
+    for (uint64_t value = 1000; value <= 1000000; value += 1000) {
+        latency_histogram_record(&histogram, value);
+    }
+    uint64_t p99 = latency_histogram_percentile(&histogram, 99.0);
+    cr_assert_geq(p99, 990000, "p99 below true value");
+    cr_assert_leq(p99, 990000 + 990000 / 16, "p99 outside bucket precision");
+    cr_assert_eq(latency_histogram_percentile(&histogram, 99.99), histogram.max,
+                 "Upper percentiles must not exceed max");
+}
+
+static void* record_samples(void* arg) {
+    uint64_t value = (uint64_t)(uintptr_t)arg;
+    for (int i = 0; i < 1000; i++) {
+        latency_record(STAGE_DECODE, value);
+    }
+    return NULL;
+}
+
+Test(latency, per_thread_merge) {
+    latency_reset();
+    pthread_t threads[4];
+    for (uintptr_t i = 0; i < 4; i++) {
+        pthread_create(&threads[i], NULL, record_samples, (void*)(100 * (i + 1)));
+    }
+    for (int i = 0; i < 4; i++) {
+        pthread_join(threads[i], NULL);
+    }
+
+    cr_assert_eq(latency_snapshot(STAGE_DECODE, &histogram), 0, "Snapshot failed");
+    cr_assert_eq(histogram.total_count, 4000, "Samples from exited threads must be kept");
+    cr_assert_eq(histogram.max, 400, "Max mismatch");
+    cr_assert_eq(histogram.min, 100, "Min mismatch");
+}
+
+Test(latency, hdr_distribution) {
+    latency_histogram_reset(&histogram);
+    for (uint64_t i = 1; i <= 1000; i++) {
+        latency_histogram_record(&histogram, i * 1000);
+    }
+
+    char text[16384];
+    FILE* output = fmemopen(text, sizeof(text), "w");
+    latency_histogram_print_distribution(&histogram, output, 1000.0);
+    fclose(output);
+
+    cr_assert_not_null(strstr(text, "Percentile"), "Missing header");
+    cr_assert_not_null(strstr(text, "0.500000000000"), "Missing median row");
+    cr_assert_not_null(strstr(text, "1000.000 1.000000000000       1000"), "Last row must be the max");
+    cr_assert_not_null(strstr(text, "#[Max     =     1000.000, Total count    =         1000]"),
+                       "Missing footer");
+}
@@ -0,0 +1,120 @@
+// tests/unit/test_metrics.c
+#include "test_fixtures.h"
+
+static void keep_order(const OrderBookEntry* entry, void* arg) {
+    *(Order*)arg = entry->order;
+}
+
+Test(metrics, segment_publishes_counters_to_readers) {
+    char name[64];
+    snprintf(name, sizeof(name), "/tradesynth-test-%d", (int)getpid());
+    ServerConfig config = fixture_config();
+    strcpy(config.metrics_name, name);
+    ServerContext* context = start_context(&config);
+
+    submit(context, "client", 1, ORDER_SIDE_SELL, 10001, 100);
+    submit(context, "client", 2, ORDER_SIDE_SELL, 10002, 100);
+    submit(context, "client", 3, ORDER_SIDE_BUY, 10001, 40);
+    metrics_thread_name("test");
+    metrics_thread_add(THREAD_MESSAGES_SENT, 3);
+    metrics_thread_add(THREAD_BYTES_SENT, 300);
+    atomic_store(&context->stats.messages_processed, 3);
+    metrics_publish(context);
+
+    MetricsReader reader;
+    cr_assert_eq(metrics_reader_open(&reader, name), SUCCESS, "Failed to open %s", name);
+    cr_assert_eq(metrics_reader_read(&reader), SUCCESS);
+    const MetricsHeader* snapshot = reader.snapshot;
+    cr_assert_eq(snapshot->connection_capacity, 4);
+    cr_assert_eq(snapshot->symbol_capacity, 8);
+    cr_assert_eq(snapshot->generation % 2, 0, "Snapshot taken mid-publish");
+    cr_assert_eq(snapshot->totals.messages_processed, 3);
+    cr_assert_geq(snapshot->totals.bytes_sent, 300);
+    cr_assert_eq(atomic_load(&context->stats.bytes_sent), snapshot->totals.bytes_sent);
+    cr_assert_eq(snapshot->histograms[STAGE_MATCH].total_count >= 3, 1);
+
+    cr_assert_eq(snapshot->symbol_count, 1);
+    const MetricsSymbol* symbol = &metrics_symbols(snapshot)[0];
+    cr_assert_str_eq(symbol->symbol, "AAPL");
+    cr_assert_eq(symbol->orders, 3);
+    cr_assert_eq(symbol->trades, 1);
+    cr_assert_eq(symbol->volume, 40);
+    cr_assert_eq(symbol->ask_orders, 2);
+    cr_assert_eq(symbol->best_ask, 10001);
+    cr_assert_eq(symbol->best_ask_size, 60);
+    cr_assert_eq(symbol->best_bid_size, 0);
+    cr_assert_eq(symbol->price_exponent, -2);
+
+    const MetricsThread* threads = metrics_threads(snapshot);
+    const MetricsThread* row = NULL;
+    for (uint32_t i = 0; i < snapshot->thread_capacity; i++) {
+        if (threads[i].active && strcmp(threads[i].name, "test") == 0) row = &threads[i];
+    }
+    cr_assert_not_null(row, "Calling thread missing from the thread rows");
+    cr_assert_eq(row->messages_sent, 3);
+    cr_assert_eq(row->bytes_sent, 300);
+    cr_assert_gt(row->cpu_ns, 0);
+
+    // A modify cancels and replaces inside the book but is no new order;
+    // the last order visited is the ask at 100.02
+    Order modify;
+    orderbook_for_each(find_order_book(context, "AAPL"), keep_order, &modify);
+    modify.quantity = 50;
+    cr_assert_eq(process_modify_order(context, &modify), SUCCESS);
+    metrics_publish(context);
+    cr_assert_eq(metrics_reader_read(&reader), SUCCESS);
+    symbol = &metrics_symbols(reader.snapshot)[0];
+    cr_assert_eq(symbol->orders, 3, "A modify was counted as an order");
+    cr_assert_eq(symbol->ask_orders, 2);
+    cr_assert_eq(symbol->best_ask_size, 60);
+
+    // The segment is removed on shutdown; mapped readers keep the final state
+    cleanup_server(context);
+    cr_assert_eq(metrics_reader_read(&reader), SUCCESS);
+    cr_assert_eq(reader.snapshot->totals.messages_processed, 3);
+    metrics_reader_close(&reader);
+    cr_assert_neq(metrics_reader_open(&reader, name), SUCCESS, "Segment left behind");
+}
+
+Test(metrics, prometheus_exposition) {
+    size_t size = metrics_segment_size(2, 2, 2);
+    MetricsHeader* header = calloc(1, size);
+    cr_assert_not_null(header);
+    metrics_segment_init(header, 2, 2, 2, METRICS_DEFAULT_INTERVAL_MS);
+    header->publish_time = header->start_time + 2 * NANOS_PER_SECOND;
+    header->totals.messages_processed = 42;
+
+    MetricsConnection* connection = &metrics_connections(header)[1];
+    connection->active = 1;
+    strcpy(connection->client_id, "desk \"a\"");
+    strcpy(connection->address, "127.0.0.1:4000");
+    connection->messages_received = 7;
+
+    MetricsSymbol* symbol = &metrics_symbols(header)[0];
+    strcpy(symbol->symbol, "MSFT");
+    symbol->price_exponent = -2;
+    symbol->best_bid = 31050;
+    symbol->orders = 9;
+    header->symbol_count = 1;
+
+    latency_histogram_record(&header->histograms[STAGE_MATCH], 1500);
+
+    char* text = NULL;
+    size_t length = 0;
+    FILE* stream = open_memstream(&text, &length);
+    cr_assert_eq(metrics_write_prometheus(header, stream), SUCCESS);
+    fclose(stream);
+
+    cr_assert_not_null(strstr(text, "tradesynth_messages_processed_total 42\n"));
+    cr_assert_not_null(strstr(text, "tradesynth_uptime_seconds 2\n"));
+    cr_assert_not_null(strstr(text, "tradesynth_connection_messages_received_total{slot=\"1\","
+                                    "client=\"desk \\\"a\\\"\",address=\"127.0.0.1:4000\"} 7\n"));
+    cr_assert_not_null(strstr(text, "tradesynth_symbol_orders_total{symbol=\"MSFT\"} 9\n"));
+    cr_assert_not_null(strstr(text, "tradesynth_symbol_best_bid{symbol=\"MSFT\"} 310.50\n"));
+    cr_assert_null(strstr(text, "tradesynth_symbol_best_ask{"), "Empty prices are not exported");
+    cr_assert_not_null(strstr(text, "tradesynth_latency_seconds_count{stage=\"match\"} 1\n"));
+    cr_assert_not_null(strstr(text, "tradesynth_latency_seconds{stage=\"match\",quantile=\"0.5\"}"));
+
+    free(text);
+    free(header);
+}
@@ -0,0 +1,430 @@
+// tests/unit/test_orderbook.c
+#include <criterion/criterion.h>
+#include "../../include/server/server.h"
+
+static OrderBook book;
+static uint32_t fill_count;
+static uint32_t filled_quantity;
+static uint64_t last_resting_id;
+
+static void setup(void) {
+    memset(&book, 0, sizeof(book));
+    strcpy(book.symbol, "TEST");
+    book.tick_exponent = -2;
+    cr_assert_eq(orderbook_init(&book, 128), SUCCESS, "Failed to init book");
+    fill_count = 0;
+    filled_quantity = 0;
+}
+
+static void teardown(void) {
+    orderbook_destroy(&book);
+}
+
+static void count_fill(OrderBook* b, const OrderFill* fill, void* arg) {
+    (void)b;
+    (void)arg;
+    fill_count++;
+    filled_quantity += fill->quantity;
+    last_resting_id = fill->resting->order_id;
+}
+
+static Order make_order(uint64_t id, OrderSide side, int64_t cents, uint32_t quantity) {
+    Order order = {
+        .order_id = id,
+        .type = ORDER_TYPE_LIMIT,
+        .side = side,
+        .time_in_force = TIF_GTC,
+        .price = create_price(cents, -2),
+        .quantity = quantity
+    };
+    strcpy(order.symbol, "TEST");
+    return order;
+}
+
+Test(orderbook, price_time_priority, .init = setup, .fini = teardown) {
+    Order a = make_order(1, ORDER_SIDE_SELL, 10100, 100);
+    Order b = make_order(2, ORDER_SIDE_SELL, 10000, 100);
+    Order c = make_order(3, ORDER_SIDE_SELL, 10000, 100);
+    orderbook_add_order(&book, &a, count_fill, NULL);
+    orderbook_add_order(&book, &b, count_fill, NULL);
+    orderbook_add_order(&book, &c, count_fill, NULL);
+    cr_assert_eq(book.best_ask.mantissa, 10000, "Best ask mismatch");
+
+    // Takes all of b, then part of c; a is priced out
+    Order buy = make_order(4, ORDER_SIDE_BUY, 10000, 150);
+    cr_assert_eq(orderbook_add_order(&book, &buy, count_fill, NULL), SUCCESS, "Buy rejected");
+    cr_assert_eq(fill_count, 2, "Expected two fills");
+    cr_assert_eq(last_resting_id, 3, "Second fill should hit the later order");
+    cr_assert_eq(buy.status, ORDER_STATUS_FILLED, "Aggressor should be filled");
+    cr_assert_eq(orderbook_find_order(&book, 3)->order.remaining_quantity, 50, "Partial fill wrong");
+    cr_assert_null(orderbook_find_order(&book, 2), "Filled order still resting");
+    cr_assert_eq(book.ask_count, 2, "Ask count mismatch");
+}
+
+Test(orderbook, remainder_rests_and_cancels, .init = setup, .fini = teardown) {
+    Order sell = make_order(1, ORDER_SIDE_SELL, 5000, 40);
+    orderbook_add_order(&book, &sell, count_fill, NULL);
+
+    Order buy = make_order(2, ORDER_SIDE_BUY, 5001, 100);
+    orderbook_add_order(&book, &buy, count_fill, NULL);
+    cr_assert_eq(buy.status, ORDER_STATUS_PARTIAL, "Aggressor should be partial");
+    cr_assert_eq(book.best_bid.mantissa, 5001, "Remainder not resting");
+    cr_assert_eq(book.asks.level_count, 0, "Empty level not removed");
+
+    Order cancelled;
+    cr_assert_eq(orderbook_cancel_order(&book, 2, &cancelled), SUCCESS, "Cancel failed");
+    cr_assert_eq(cancelled.remaining_quantity, 60, "Cancelled quantity mismatch");
+    cr_assert_eq(book.bid_count, 0, "Bid still resting");
+    cr_assert_eq(orderbook_cancel_order(&book, 2, NULL), ERROR_ORDER_NOT_FOUND, "Double cancel");
+}
+
+Test(orderbook, rejects_off_tick_and_duplicates, .init = setup, .fini = teardown) {
+    Order off_tick = make_order(1, ORDER_SIDE_BUY, 0, 10);
+    off_tick.price = create_price(1005, -3);
+    cr_assert_eq(orderbook_add_order(&book, &off_tick, NULL, NULL), ERROR_INVALID_ORDER, "Off-tick accepted");
+
+    Order first = make_order(2, ORDER_SIDE_BUY, 100, 10);
+    Order duplicate = make_order(2, ORDER_SIDE_BUY, 101, 10);
+    orderbook_add_order(&book, &first, NULL, NULL);
+    cr_assert_eq(orderbook_add_order(&book, &duplicate, NULL, NULL), ERROR_INVALID_ORDER,
+                 "Duplicate id accepted");
+}
+
+Test(orderbook, modify_keeps_priority_only_when_shrinking, .init = setup, .fini = teardown) {
+    Order a = make_order(1, ORDER_SIDE_BUY, 100, 50);
+    Order b = make_order(2, ORDER_SIDE_BUY, 100, 50);
+    orderbook_add_order(&book, &a, NULL, NULL);
+    orderbook_add_order(&book, &b, NULL, NULL);
+
+    Order shrink = make_order(1, ORDER_SIDE_BUY, 100, 20);
+    cr_assert_eq(orderbook_modify_order(&book, &shrink, NULL, NULL), SUCCESS, "Shrink failed");
+    cr_assert_eq(book.bids.levels[0].head->order.order_id, 1, "Shrink lost priority");
+    cr_assert_eq(book.bids.levels[0].total_quantity, 70, "Level quantity mismatch");
+
+    Order grow = make_order(1, ORDER_SIDE_BUY, 100, 80);
+    cr_assert_eq(orderbook_modify_order(&book, &grow, NULL, NULL), SUCCESS, "Grow failed");
+    cr_assert_eq(book.bids.levels[0].head->order.order_id, 2, "Grow kept priority");
+    cr_assert_eq(book.bids.levels[0].total_quantity, 130, "Level quantity mismatch");
+}
+
+Test(orderbook, modify_after_partial_fill_keeps_size, .init = setup, .fini = teardown) {
+    Order buy = make_order(1, ORDER_SIDE_BUY, 100, 100);
+    Order sell = make_order(2, ORDER_SIDE_SELL, 100, 40);
+    orderbook_add_order(&book, &buy, NULL, NULL);
+    orderbook_add_order(&book, &sell, NULL, NULL);
+
+    // Re-pricing twice at the original size must not restore the 40 filled
+    Order reprice = make_order(1, ORDER_SIDE_BUY, 101, 100);
+    cr_assert_eq(orderbook_modify_order(&book, &reprice, NULL, NULL), SUCCESS);
+    cr_assert_eq(reprice.status, ORDER_STATUS_PARTIAL);
+    reprice = make_order(1, ORDER_SIDE_BUY, 102, 100);
+    cr_assert_eq(orderbook_modify_order(&book, &reprice, NULL, NULL), SUCCESS);
+    const Order* resting = &orderbook_find_order(&book, 1)->order;
+    cr_assert_eq(resting->quantity, 100, "Original size lost");
+    cr_assert_eq(resting->filled_quantity, 40, "Fills lost");
+    cr_assert_eq(resting->remaining_quantity, 60);
+
+    // A shrink in place is measured against the whole order too
+    Order shrink = make_order(1, ORDER_SIDE_BUY, 102, 50);
+    cr_assert_eq(orderbook_modify_order(&book, &shrink, NULL, NULL), SUCCESS);
+    cr_assert_eq(orderbook_find_order(&book, 1)->order.remaining_quantity, 10);
+
+    Order sweep = make_order(3, ORDER_SIDE_SELL, 100, 200);
+    orderbook_add_order(&book, &sweep, count_fill, NULL);
+    cr_assert_eq(filled_quantity, 10, "Order filled past its size");
+}
+
+Test(orderbook, market_orders_never_rest, .init = setup, .fini = teardown) {
+    Order sell = make_order(1, ORDER_SIDE_SELL, 100, 10);
+    orderbook_add_order(&book, &sell, NULL, NULL);
+
+    Order market = make_order(2, ORDER_SIDE_BUY, 0, 25);
+    market.type = ORDER_TYPE_MARKET;
+    orderbook_add_order(&book, &market, count_fill, NULL);
+    cr_assert_eq(filled_quantity, 10, "Market order fill mismatch");
+    cr_assert_eq(market.status, ORDER_STATUS_CANCELLED, "Market remainder should cancel");
+    cr_assert_eq(book.bid_count, 0, "Market order rested");
+}
+
+typedef struct {
+    uint64_t ids[16];
+    uint32_t count;
+} Released;
+
+static void record_release(OrderBook* b, const Order* order, void* arg) {
+    (void)b;
+    Released* released = arg;
+    released->ids[released->count++] = order->order_id;
+}
+
+static Order make_stop(uint64_t id, OrderSide side, int64_t stop_cents, int64_t limit_cents, uint32_t quantity) {
+    Order order = make_order(id, side, limit_cents, quantity);
+    order.type = limit_cents ? ORDER_TYPE_STOP_LIMIT : ORDER_TYPE_STOP;
+    order.stop_price = create_price(stop_cents, -2);
+    return order;
+}
+
+Test(orderbook, stops_trigger_in_arrival_order, .init = setup, .fini = teardown) {
+    for (uint64_t id = 1; id <= 3; id++) {
+        Order sell = make_order(id, ORDER_SIDE_SELL, 100 + (int64_t)id, 10);
+        orderbook_add_order(&book, &sell, NULL, NULL);
+    }
+
+    // Nothing has traded yet, so every stop waits
+    Order stops[] = {
+        make_stop(10, ORDER_SIDE_BUY, 101, 0, 5),
+        make_stop(11, ORDER_SIDE_BUY, 102, 102, 10),
+        make_stop(12, ORDER_SIDE_BUY, 110, 0, 1),
+        make_stop(13, ORDER_SIDE_SELL, 90, 0, 1),
+        make_stop(14, ORDER_SIDE_BUY, 101, 0, 5)
+    };
+    for (size_t i = 0; i < sizeof(stops) / sizeof(stops[0]); i++) {
+        cr_assert_eq(orderbook_add_order(&book, &stops[i], NULL, NULL), SUCCESS);
+        cr_assert_eq(stops[i].status, ORDER_STATUS_NEW);
+    }
+    cr_assert_eq(book.stop_count, 5);
+    cr_assert_eq(book.bid_count, 0, "Stops are not bids");
+    Order no_trigger = make_stop(15, ORDER_SIDE_BUY, 0, 0, 1);
+    cr_assert_eq(orderbook_add_order(&book, &no_trigger, NULL, NULL), ERROR_INVALID_ORDER);
+
+    // A trade at 1.01 releases both 1.01 stops in arrival order; their
+    // trades at 1.02 release the stop-limit, which rests below the 1.03 ask
+    Released released = { .count = 0 };
+    Order buy = make_order(20, ORDER_SIDE_BUY, 102, 10);
+    orderbook_add_order(&book, &buy, NULL, NULL);
+    cr_assert_eq(book.last_trade, 101);
+    cr_assert_eq(orderbook_release_stops(&book, count_fill, record_release, &released), 3);
+    cr_assert_eq(released.count, 3);
+    cr_assert_eq(released.ids[0], 10);
+    cr_assert_eq(released.ids[1], 14);
+    cr_assert_eq(released.ids[2], 11);
+    cr_assert_eq(filled_quantity, 10);
+    cr_assert_eq(book.stop_count, 2);
+    const OrderBookEntry* rested = orderbook_find_order(&book, 11);
+    cr_assert_not_null(rested);
+    cr_assert_eq(rested->order.type, ORDER_TYPE_LIMIT);
+    cr_assert_eq(book.best_bid.mantissa, 102);
+
+    // Pending stops cancel like orders; one already passed enters at once
+    cr_assert_eq(orderbook_cancel_order(&book, 13, NULL), SUCCESS);
+    cr_assert_eq(book.stop_count, 1);
+    Order late = make_stop(30, ORDER_SIDE_BUY, 100, 0, 1);
+    cr_assert_eq(orderbook_add_order(&book, &late, count_fill, NULL), SUCCESS);
+    cr_assert_eq(late.status, ORDER_STATUS_FILLED);
+    cr_assert_eq(last_resting_id, 3);
+    cr_assert_eq(orderbook_release_stops(&book, NULL, NULL, NULL), 0, "1.10 stop released early");
+}
+
+Test(orderbook, ioc_and_fok, .init = setup, .fini = teardown) {
+    Order first = make_order(1, ORDER_SIDE_SELL, 101, 10);
+    Order second = make_order(2, ORDER_SIDE_SELL, 102, 10);
+    Order third = make_order(3, ORDER_SIDE_SELL, 104, 10);
+    orderbook_add_order(&book, &first, NULL, NULL);
+    orderbook_add_order(&book, &second, NULL, NULL);
+    orderbook_add_order(&book, &third, NULL, NULL);
+    uint32_t free_entries = 0;
+    for (OrderBookEntry* entry = book.free_entries; entry; entry = entry->next) free_entries++;
+
+    // FOK: 25 are offered up to 1.04 but only 20 up to 1.03
+    Order fok = make_order(10, ORDER_SIDE_BUY, 103, 25);
+    fok.time_in_force = TIF_FOK;
+    cr_assert_eq(orderbook_add_order(&book, &fok, count_fill, NULL), SUCCESS);
+    cr_assert_eq(fok.status, ORDER_STATUS_CANCELLED);
+    cr_assert_eq(fill_count, 0, "A killed FOK must not trade");
+    cr_assert_eq(book.asks.levels[book.asks.level_count - 1].total_quantity, 10);
+
+    fok = make_order(11, ORDER_SIDE_BUY, 104, 25);
+    fok.time_in_force = TIF_FOK;
+    cr_assert_eq(orderbook_add_order(&book, &fok, count_fill, NULL), SUCCESS);
+    cr_assert_eq(fok.status, ORDER_STATUS_FILLED);
+    cr_assert_eq(filled_quantity, 25);
+
+    // IOC: takes what crosses and drops the rest without a book entry
+    Order ioc = make_order(12, ORDER_SIDE_BUY, 104, 20);
+    ioc.time_in_force = TIF_IOC;
+    cr_assert_eq(orderbook_add_order(&book, &ioc, count_fill, NULL), SUCCESS);
+    cr_assert_eq(ioc.filled_quantity, 5);
+    cr_assert_eq(ioc.status, ORDER_STATUS_CANCELLED);
+    cr_assert_eq(book.bid_count, 0);
+    cr_assert_null(orderbook_find_order(&book, 12));
+
+    uint32_t free_after = 0;
+    for (OrderBookEntry* entry = book.free_entries; entry; entry = entry->next) free_after++;
+    cr_assert_eq(free_after, free_entries + 3, "Only the filled asks change the pool");
+}
+
+Test(orderbook, iceberg_refills_to_back_of_level, .init = setup, .fini = teardown) {
+    Order iceberg = make_order(1, ORDER_SIDE_SELL, 101, 100);
+    iceberg.display_quantity = 30;
+    Order plain = make_order(2, ORDER_SIDE_SELL, 101, 20);
+    orderbook_add_order(&book, &iceberg, NULL, NULL);
+    orderbook_add_order(&book, &plain, NULL, NULL);
+
+    BookDepthLevel depth[2];
+    cr_assert_eq(orderbook_depth(&book, ORDER_SIDE_SELL, depth, 2), 1);
+    cr_assert_eq(depth[0].quantity, 50, "Only the slice is shown");
+    cr_assert_eq(depth[0].order_count, 2);
+    cr_assert_eq(book.asks.levels[0].total_quantity, 120);
+
+    // 40 takes the slice, then part of the plain order, which is now ahead of the refill
+    Order buy = make_order(10, ORDER_SIDE_BUY, 101, 40);
+    orderbook_add_order(&book, &buy, count_fill, NULL);
+    cr_assert_eq(fill_count, 2);
+    cr_assert_eq(last_resting_id, 2);
+    const OrderBookEntry* rested = orderbook_find_order(&book, 1);
+    cr_assert_eq(rested->order.visible_quantity, 30);
+    cr_assert_eq(rested->order.remaining_quantity, 70);
+    cr_assert_eq(book.asks.levels[0].head->order.order_id, 2);
+    cr_assert_eq(book.asks.levels[0].tail, rested);
+    orderbook_depth(&book, ORDER_SIDE_SELL, depth, 1);
+    cr_assert_eq(depth[0].quantity, 40);
+
+    // A large order walks through the queue, taking each refill behind later orders
+    Order late = make_order(3, ORDER_SIDE_SELL, 101, 10);
+    orderbook_add_order(&book, &late, NULL, NULL);
+    buy = make_order(11, ORDER_SIDE_BUY, 101, 75);
+    orderbook_add_order(&book, &buy, count_fill, NULL);
+    cr_assert_eq(buy.status, ORDER_STATUS_FILLED);
+    cr_assert_eq(fill_count, 6);
+    cr_assert_eq(last_resting_id, 1);
+    cr_assert_null(orderbook_find_order(&book, 3), "Later order filled before the refill");
+    cr_assert_eq(rested->order.remaining_quantity, 15);
+    cr_assert_eq(rested->order.visible_quantity, 5);
+
+    // Shrinking comes out of the reserve first and keeps the place
+    Order smaller = make_order(1, ORDER_SIDE_SELL, 101, 88);
+    cr_assert_eq(orderbook_modify_order(&book, &smaller, NULL, NULL), SUCCESS);
+    cr_assert_eq(rested->order.remaining_quantity, 3);
+    cr_assert_eq(rested->order.visible_quantity, 3);
+    cr_assert_eq(book.asks.levels[0].visible_quantity, 3);
+
+    Order bad = make_order(4, ORDER_SIDE_SELL, 101, 10);
+    bad.display_quantity = 11;
+    cr_assert_eq(orderbook_add_order(&book, &bad, NULL, NULL), ERROR_INVALID_ORDER);
+}
+
+static void check_uncross_fill(OrderBook* b, const OrderFill* fill, void* arg) {
+    (void)b;
+    (void)arg;
+    cr_assert(fill->uncross, "Uncross fill not flagged");
+    cr_assert_eq(fill->aggressor->side, ORDER_SIDE_BUY, "Uncross reports the buy as aggressor");
+    cr_assert_eq(fill->price, 10200, "Uncross fill away from the auction price");
+    fill_count++;
+    filled_quantity += fill->quantity;
+}
+
+Test(orderbook, call_auction_uncrosses_at_one_price, .init = setup, .fini = teardown) {
+    book.phase = BOOK_PHASE_CALL;
+    Order orders[] = {
+        make_order(1, ORDER_SIDE_BUY, 10300, 30),
+        make_order(2, ORDER_SIDE_BUY, 10200, 20),
+        make_order(3, ORDER_SIDE_BUY, 10000, 40),
+        make_order(4, ORDER_SIDE_SELL, 9900, 25),
+        make_order(5, ORDER_SIDE_SELL, 10100, 25),
+        make_order(6, ORDER_SIDE_SELL, 10400, 30)
+    };
+    orders[4].display_quantity = 10;
+    for (int i = 0; i < 6; i++) {
+        cr_assert_eq(orderbook_add_order(&book, &orders[i], count_fill, NULL), SUCCESS);
+    }
+    cr_assert_eq(fill_count, 0, "A call does not match");
+    cr_assert_eq(book.best_bid.mantissa, 10300);
+    cr_assert_eq(book.best_ask.mantissa, 9900, "Crossed while collecting");
+
+    // Only orders that can wait for the uncross are taken; stops wait regardless
+    Order market = make_order(7, ORDER_SIDE_BUY, 0, 10);
+    market.type = ORDER_TYPE_MARKET;
+    cr_assert_eq(orderbook_add_order(&book, &market, count_fill, NULL), ERROR_INVALID_ORDER);
+    Order ioc = make_order(8, ORDER_SIDE_SELL, 9000, 10);
+    ioc.time_in_force = TIF_IOC;
+    cr_assert_eq(orderbook_add_order(&book, &ioc, count_fill, NULL), ERROR_INVALID_ORDER);
+    Order stop = make_order(9, ORDER_SIDE_BUY, 0, 10);
+    stop.type = ORDER_TYPE_STOP;
+    stop.stop_price = create_price(10100, -2);
+    book.last_trade = 11000;
+    cr_assert_eq(orderbook_add_order(&book, &stop, count_fill, NULL), SUCCESS);
+    cr_assert_eq(book.stop_count, 1, "Stop triggered during a call");
+    cr_assert_eq(orderbook_release_stops(&book, count_fill, NULL, NULL), 0);
+
+    // 50 can trade at 101 or 102, both balanced; the last trade breaks the tie
+    AuctionQuote quote;
+    book.last_trade = 0;
+    cr_assert_eq(orderbook_auction_quote(&book, &quote), SUCCESS);
+    cr_assert_eq(quote.price, 10100);
+    cr_assert_eq(quote.volume, 50);
+    cr_assert_eq(quote.imbalance, 0);
+    book.last_trade = 11000;
+    orderbook_auction_quote(&book, &quote);
+    cr_assert_eq(quote.price, 10200);
+
+    cr_assert_eq(orderbook_uncross(&book, check_uncross_fill, NULL), 50);
+    cr_assert_eq(fill_count, 3);
+    cr_assert_eq(filled_quantity, 50);
+    cr_assert_eq(book.last_trade, 10200);
+    cr_assert_null(orderbook_find_order(&book, 1));
+    cr_assert_null(orderbook_find_order(&book, 2));
+    cr_assert_null(orderbook_find_order(&book, 4));
+    cr_assert_null(orderbook_find_order(&book, 5), "Iceberg reserve trades in an uncross");
+    cr_assert_eq(book.best_bid.mantissa, 10000);
+    cr_assert_eq(book.best_ask.mantissa, 10400);
+    orderbook_auction_quote(&book, &quote);
+    cr_assert_eq(quote.volume, 0, "Book still crossed");
+
+    // Continuous again: the stop the auction price reached goes in as a market order
+    book.phase = BOOK_PHASE_CONTINUOUS;
+    cr_assert_eq(orderbook_release_stops(&book, count_fill, NULL, NULL), 1);
+    cr_assert_eq(orderbook_find_order(&book, 6)->order.remaining_quantity, 20);
+}
+
+static uint32_t filled_by_id[16];
+
+static void record_fill(OrderBook* b, const OrderFill* fill, void* arg) {
+    count_fill(b, fill, arg);
+    filled_by_id[fill->resting->order_id] += fill->quantity;
+}
+
+Test(orderbook, pro_rata_and_hybrid_allocation, .init = setup, .fini = teardown) {
+    cr_assert_eq(orderbook_set_match_policy(&book, MATCH_POLICY_COUNT, 1, 0), ERROR_INVALID_PARAM);
+    cr_assert_eq(orderbook_set_match_policy(&book, MATCH_HYBRID, 1, 101), ERROR_INVALID_PARAM);
+    cr_assert_eq(orderbook_set_match_policy(&book, MATCH_PRO_RATA, 5, 0), SUCCESS);
+
+    Order a = make_order(1, ORDER_SIDE_SELL, 10000, 60);
+    Order b = make_order(2, ORDER_SIDE_SELL, 10000, 30);
+    Order c = make_order(3, ORDER_SIDE_SELL, 10000, 10);
+    orderbook_add_order(&book, &a, record_fill, NULL);
+    orderbook_add_order(&book, &b, record_fill, NULL);
+    orderbook_add_order(&book, &c, record_fill, NULL);
+
+    // 45 of 100: shares 27, 13 and 4, the 4 under the minimum; the 5 left go oldest first
+    memset(filled_by_id, 0, sizeof(filled_by_id));
+    Order buy = make_order(4, ORDER_SIDE_BUY, 10000, 45);
+    cr_assert_eq(orderbook_add_order(&book, &buy, record_fill, NULL), SUCCESS);
+    cr_assert_eq(buy.status, ORDER_STATUS_FILLED);
+    cr_assert_eq(filled_by_id[1], 32);
+    cr_assert_eq(filled_by_id[2], 13);
+    cr_assert_eq(filled_by_id[3], 0, "Share below the minimum allocated");
+    cr_assert_eq(fill_count, 2);
+
+    // An order for the whole level takes it in time order
+    fill_count = 0;
+    Order sweep = make_order(5, ORDER_SIDE_BUY, 10000, 55);
+    orderbook_add_order(&book, &sweep, record_fill, NULL);
+    cr_assert_eq(fill_count, 3);
+    cr_assert_eq(last_resting_id, 3);
+    cr_assert_eq(book.asks.level_count, 0);
+
+    // Hybrid: 20 of 50 oldest first, then 30 shared over the 30 and 50 left
+    cr_assert_eq(orderbook_set_match_policy(&book, MATCH_HYBRID, 1, 40), SUCCESS);
+    Order d = make_order(10, ORDER_SIDE_SELL, 10000, 50);
+    Order e = make_order(11, ORDER_SIDE_SELL, 10000, 50);
+    orderbook_add_order(&book, &d, record_fill, NULL);
+    orderbook_add_order(&book, &e, record_fill, NULL);
+    memset(filled_by_id, 0, sizeof(filled_by_id));
+    Order hybrid = make_order(12, ORDER_SIDE_BUY, 10000, 50);
+    orderbook_add_order(&book, &hybrid, record_fill, NULL);
+    cr_assert_eq(hybrid.status, ORDER_STATUS_FILLED);
+    cr_assert_eq(filled_by_id[10], 32);
+    cr_assert_eq(filled_by_id[11], 18);
+    cr_assert_eq(orderbook_find_order(&book, 11)->order.remaining_quantity, 32);
+    cr_assert_eq(book.asks.levels[0].visible_quantity, 50);
+}
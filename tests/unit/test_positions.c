@@ -0,0 +1,187 @@
+// tests/unit/test_positions.c
+#include "test_fixtures.h"
+
+static ServerContext* make_context(uint32_t position_limit) {
+    ServerConfig config = fixture_config();
+    config.position_limit = position_limit;
+    return start_context(&config);
+}
+
+static const ClientPosition* position_of(ServerContext* context, const char* client) {
+    OrderBook* book = find_order_book(context, "AAPL");
+    cr_assert_not_null(book);
+    const ClientPosition* row = find_position(context, client, book->symbol_id);
+    cr_assert_not_null(row, "No position row for %s", client);
+    return row;
+}
+
+Test(positions, fills_and_open_exposure) {
+    ServerContext* context = make_context(0);
+    cr_assert_eq(context->config.position_limit, DEFAULT_POSITION_LIMIT);
+
+    cr_assert_eq(submit(context, "seller", 1, ORDER_SIDE_SELL, 10000, 100), SUCCESS);
+    cr_assert_eq(atomic_load(&position_of(context, "seller")->open_sell), 100);
+
+    cr_assert_eq(submit(context, "buyer", 2, ORDER_SIDE_BUY, 10000, 40), SUCCESS);
+    const ClientPosition* seller = position_of(context, "seller");
+    const ClientPosition* buyer = position_of(context, "buyer");
+    cr_assert_eq(atomic_load(&seller->position), -40);
+    cr_assert_eq(atomic_load(&seller->open_sell), 60, "Fill must release resting quantity");
+    cr_assert_eq(atomic_load(&buyer->position), 40);
+    cr_assert_eq(atomic_load(&buyer->open_buy), 0, "A filled aggressor never rests");
+    cr_assert_eq(atomic_load(&buyer->total_volume), 40);
+
+    // Quantity reduction, then cancel
+    cr_assert_eq(submit(context, "buyer", 3, ORDER_SIDE_BUY, 9900, 50), SUCCESS);
+    cr_assert_eq(atomic_load(&buyer->open_buy), 50);
+    Order modify = make_order("buyer", 3, ORDER_SIDE_BUY, 9900, 20);
+    modify.order_id = resting_order_id(context, 3);
+    cr_assert_eq(process_modify_order(context, &modify), SUCCESS);
+    cr_assert_eq(atomic_load(&buyer->open_buy), 20);
+    Order cancel = make_order("buyer", 3, ORDER_SIDE_BUY, 0, 0);
+    cancel.order_id = modify.order_id;
+    cr_assert_eq(process_cancel_order(context, &cancel), SUCCESS);
+    cr_assert_eq(atomic_load(&buyer->open_buy), 0);
+
+    // A repriced order that crosses trades as an aggressor
+    cr_assert_eq(submit(context, "buyer", 4, ORDER_SIDE_BUY, 9900, 30), SUCCESS);
+    modify = make_order("buyer", 4, ORDER_SIDE_BUY, 10000, 30);
+    modify.order_id = resting_order_id(context, 4);
+    cr_assert_eq(process_modify_order(context, &modify), SUCCESS);
+    cr_assert_eq(atomic_load(&buyer->position), 70);
+    cr_assert_eq(atomic_load(&buyer->open_buy), 0);
+    cr_assert_eq(atomic_load(&seller->position), -70);
+    cr_assert_eq(atomic_load(&seller->open_sell), 30);
+
+    cleanup_server(context);
+}
+
+Test(positions, limit_counts_position_and_open_orders) {
+    ServerContext* context = make_context(100);
+
+    cr_assert_eq(submit(context, "desk", 1, ORDER_SIDE_BUY, 10000, 101), ERROR_POSITION_LIMIT);
+    cr_assert_eq(submit(context, "desk", 2, ORDER_SIDE_BUY, 10000, 80), SUCCESS);
+    cr_assert_eq(submit(context, "desk", 3, ORDER_SIDE_BUY, 9900, 30), ERROR_POSITION_LIMIT,
+                 "Resting buys count toward the long limit");
+    cr_assert_eq(submit(context, "desk", 4, ORDER_SIDE_SELL, 10100, 100), SUCCESS,
+                 "Sells are checked against the short side only");
+
+    // Filled quantity counts against the limit like resting quantity
+    cr_assert_eq(submit(context, "other", 5, ORDER_SIDE_SELL, 10000, 80), SUCCESS);
+    cr_assert_eq(atomic_load(&position_of(context, "desk")->position), 80);
+    cr_assert_eq(submit(context, "desk", 6, ORDER_SIDE_BUY, 9900, 21), ERROR_POSITION_LIMIT);
+    cr_assert_eq(submit(context, "desk", 7, ORDER_SIDE_BUY, 9900, 20), SUCCESS);
+    cr_assert_eq(submit(context, "other", 8, ORDER_SIDE_SELL, 10200, 20), SUCCESS);
+    cr_assert_eq(submit(context, "other", 9, ORDER_SIDE_SELL, 10300, 1), ERROR_POSITION_LIMIT,
+                 "Short position plus resting sells is at the limit");
+
+    cleanup_server(context);
+}
+
+static int64_t unrealized_of(ServerContext* context, const char* client) {
+    return atomic_load(&position_of(context, client)->unrealized_pnl);
+}
+
+Test(positions, realized_and_marked_pnl) {
+    ServerContext* context = make_context(0);
+    OrderBook* book = get_or_create_order_book(context, "AAPL");
+
+    cr_assert_eq(submit(context, "mm", 1, ORDER_SIDE_SELL, 10000, 100), SUCCESS);
+    cr_assert_eq(submit(context, "a", 2, ORDER_SIDE_BUY, 10000, 100), SUCCESS);
+    cr_assert_eq(atomic_load(&book->mark), 10000);
+    cr_assert_eq(unrealized_of(context, "a"), 0);
+
+    // Selling 40 of 100 bought at $100 for $101 realizes $40; the mark
+    // moving to $101 revalues mm too, though it was not in the trade
+    cr_assert_eq(submit(context, "b", 3, ORDER_SIDE_BUY, 10100, 50), SUCCESS);
+    cr_assert_eq(submit(context, "a", 4, ORDER_SIDE_SELL, 10100, 40), SUCCESS);
+    const ClientPosition* a = position_of(context, "a");
+    cr_assert_eq(atomic_load(&a->realized_pnl), 4000);
+    cr_assert_eq(atomic_load(&a->unrealized_pnl), 6000);
+    cr_assert_eq(unrealized_of(context, "mm"), -10000);
+    cr_assert_eq(context->holder_counts[book->symbol_id], 3);
+
+    // Through flat to short: the 50 long close at a $50 profit, the 40 short
+    // start again at the fill price
+    cr_assert_eq(submit(context, "a", 5, ORDER_SIDE_SELL, 10100, 100), SUCCESS);
+    cr_assert_eq(submit(context, "c", 6, ORDER_SIDE_BUY, 10100, 90), SUCCESS);
+    cr_assert_eq(atomic_load(&a->position), -40);
+    cr_assert_eq(atomic_load(&a->cost), -404000);
+    cr_assert_eq(atomic_load(&a->realized_pnl), 10000);
+    cr_assert_eq(atomic_load(&a->unrealized_pnl), 0);
+
+    // A trade at $99 closes b out at a loss and drops it from the holders
+    cr_assert_eq(submit(context, "mm", 7, ORDER_SIDE_BUY, 9900, 100), SUCCESS);
+    cr_assert_eq(submit(context, "b", 8, ORDER_SIDE_SELL, 9900, 50), SUCCESS);
+    const ClientPosition* b = position_of(context, "b");
+    cr_assert_eq(atomic_load(&b->position), 0);
+    cr_assert_eq(atomic_load(&b->realized_pnl), -10000);
+    cr_assert_eq(atomic_load(&b->unrealized_pnl), 0);
+    cr_assert_eq(b->holder_slot, 0);
+    cr_assert_eq(context->holder_counts[book->symbol_id], 3);
+    cr_assert_eq(atomic_load(&a->unrealized_pnl), 8000);
+    cr_assert_eq(atomic_load(&position_of(context, "mm")->realized_pnl), 5000);
+    cr_assert_eq(unrealized_of(context, "mm"), 5000);
+    cr_assert_eq(unrealized_of(context, "c"), -18000);
+
+    // Account sums follow the rows
+    const AccountExposure* exposure = &context->exposures[find_account(context, "a")];
+    cr_assert_eq(atomic_load(&exposure->realized_pnl), 10000);
+    cr_assert_eq(atomic_load(&exposure->unrealized_pnl), 8000);
+
+    cleanup_server(context);
+}
+
+Test(positions, pnl_query) {
+    ServerContext* context = make_context(0);
+    cr_assert_eq(submit(context, "mm", 1, ORDER_SIDE_SELL, 10000, 30), SUCCESS);
+    cr_assert_eq(submit(context, "a", 2, ORDER_SIDE_BUY, 10000, 30), SUCCESS);
+    cr_assert_eq(submit(context, "mm", 3, ORDER_SIDE_SELL, 10050, 10), SUCCESS);
+    cr_assert_eq(submit(context, "a", 4, ORDER_SIDE_BUY, 10050, 10), SUCCESS);
+
+    int pair[2];
+    cr_assert_eq(socketpair(AF_UNIX, SOCK_STREAM, 0, pair), 0);
+    ClientConnection* client = &context->clients[0];
+    client->socket = pair[0];
+    client->active = 1;
+    strcpy(client->id, "a");
+
+    PnlReport query = { .client_id = "a", .symbol = "AAPL" };
+    cr_assert_eq(process_pnl_query(context, client, &query), SUCCESS);
+    query.symbol[0] = '\0';
+    cr_assert_eq(process_pnl_query(context, client, &query), SUCCESS);
+    strcpy(query.client_id, "mm");
+    cr_assert_eq(process_pnl_query(context, client, &query), SUCCESS);
+
+    uint8_t buffer[BUFFER_SIZE];
+    ssize_t length = 0, received;
+    while (length < 3 * (ssize_t)(sizeof(MessageHeader) + sizeof(PnlReport)) &&
+           (received = read(pair[1], buffer + length, sizeof(buffer) - (size_t)length)) > 0) {
+        length += received;
+    }
+
+    Message symbol, totals, refused;
+    int offset = deserialize_message(buffer, (size_t)length, &symbol);
+    cr_assert_gt(offset, 0);
+    cr_assert_eq(symbol.type, MSG_PNL);
+    cr_assert_str_eq(symbol.data.pnl.symbol, "AAPL");
+    cr_assert_eq(symbol.data.pnl.position, 40);
+    // ($3000 + $1005) / 40
+    cr_assert_eq(symbol.data.pnl.average_price.mantissa, 100125000);
+    cr_assert_eq(symbol.data.pnl.average_price.exponent, AVERAGE_PRICE_EXPONENT);
+    cr_assert_eq(symbol.data.pnl.mark.mantissa, 10050);
+    cr_assert_eq(symbol.data.pnl.unrealized_pnl.mantissa, 1500);
+
+    int size = deserialize_message(buffer + offset, (size_t)length - offset, &totals);
+    cr_assert_gt(size, 0);
+    cr_assert_eq(totals.type, MSG_PNL);
+    cr_assert_str_eq(totals.data.pnl.symbol, "");
+    cr_assert_eq(totals.data.pnl.unrealized_pnl.mantissa, 1500);
+    cr_assert_eq(totals.data.pnl.realized_pnl.mantissa, 0);
+
+    cr_assert_gt(deserialize_message(buffer + offset + size, (size_t)length - offset - size, &refused), 0);
+    cr_assert_eq(refused.type, MSG_ERROR, "A session only sees its own client's PnL");
+
+    close(pair[1]);
+    cleanup_server(context);
+}
@@ -0,0 +1,78 @@
+// tests/unit/test_price.c
+#include <criterion/criterion.h>
+#include "../../include/common/types.h"
+#include "../../include/common/utils.h"
+
+Test(price, ticks_rescale_exactly) {
+    int64_t ticks;
+    cr_assert_eq(price_to_ticks(create_price(150250000, -6), -2, &ticks), 0, "On-grid price rejected");
+    cr_assert_eq(ticks, 15025, "Tick count mismatch");
+
+    cr_assert_eq(price_to_ticks(create_price(15025, -2), -6, &ticks), 0, "Finer tick rejected");
+    cr_assert_eq(ticks, 150250000, "Tick count mismatch");
+
+    cr_assert_eq(price_to_ticks(create_price(-3, 0), -2, &ticks), 0, "Negative price rejected");
+    cr_assert_eq(ticks, -300, "Negative tick count mismatch");
+}
+
+Test(price, ticks_reject_off_grid_and_overflow) {
+    int64_t ticks;
+    cr_assert_lt(price_to_ticks(create_price(150255000, -6), -2, &ticks), 0,
+                 "Off-grid price accepted");
+    cr_assert_lt(price_to_ticks(create_price(INT64_MAX / 10, 0), -2, &ticks), 0,
+                 "Overflow not detected");
+}
+
+Test(price, compare_mixed_exponents) {
+    Price a = create_price(10050, -2);
+    Price b = create_price(100500000, -6);
+    Price c = create_price(101, 0);
+    Price huge = create_price(INT64_MAX, 0);
+    Price tiny = create_price(INT64_MAX, -18);
+
+    cr_assert_eq(compare_prices(&a, &b), 0, "Equal prices compare unequal");
+    cr_assert_lt(compare_prices(&a, &c), 0, "100.50 should be below 101");
+    cr_assert_gt(compare_prices(&c, &b), 0, "101 should be above 100.5");
+    cr_assert_gt(compare_prices(&huge, &tiny), 0, "Overflowing rescale mis-ordered");
+    cr_assert_lt(compare_prices(&tiny, &huge), 0, "Overflowing rescale mis-ordered");
+}
+
+Test(price, double_round_trip) {
+    Price p = double_to_price(123.456789);
+    cr_assert_eq(p.exponent, DEFAULT_PRICE_EXPONENT, "Exponent mismatch");
+    cr_assert_eq(p.mantissa, 123456789, "Rounding lost precision");
+}
+
+Test(price, format_exact_decimals) {
+    char buffer[64];
+    cr_assert_str_eq(price_to_string(&(Price){150250000, -6}, buffer, sizeof(buffer)), "150.250000", "Six decimals mismatch");
+    cr_assert_str_eq(price_to_string(&(Price){-5, -3}, buffer, sizeof(buffer)), "-0.005", "Leading zeros mismatch");
+    cr_assert_str_eq(price_to_string(&(Price){42, 3}, buffer, sizeof(buffer)), "42000", "Positive exponent mismatch");
+    cr_assert_str_eq(price_to_string(&(Price){INT64_MIN, 0}, buffer, sizeof(buffer)),
+                     "-9223372036854775808", "INT64_MIN mismatch");
+    cr_assert_null(price_to_string(&(Price){123456, -2}, buffer, 7), "Truncation not reported");
+}
+
+Test(price, parse_round_trip) {
+    const char* inputs[] = {"150.250000", "-0.005", "42000", "0.0", "9223372036854775807"};
+    char buffer[64];
+    for (size_t i = 0; i < sizeof(inputs) / sizeof(inputs[0]); i++) {
+        Price p;
+        cr_assert_eq(parse_price_string(inputs[i], &p), SUCCESS, "Failed to parse %s", inputs[i]);
+        cr_assert_str_eq(price_to_string(&p, buffer, sizeof(buffer)), inputs[i], "Round trip mismatch");
+    }
+
+    Price p;
+    cr_assert_eq(parse_price_string("15025e-2", &p), SUCCESS, "Exponent suffix rejected");
+    cr_assert_eq(p.mantissa, 15025, "Mantissa mismatch");
+    cr_assert_eq(p.exponent, -2, "Exponent mismatch");
+}
+
+Test(price, parse_rejects_malformed) {
+    Price p;
+    cr_assert_neq(parse_price_string("", &p), SUCCESS, "Empty string accepted");
+    cr_assert_neq(parse_price_string("1.2.3", &p), SUCCESS, "Two points accepted");
+    cr_assert_neq(parse_price_string("12a", &p), SUCCESS, "Trailing garbage accepted");
+    cr_assert_neq(parse_price_string("1e", &p), SUCCESS, "Empty exponent accepted");
+    cr_assert_neq(parse_price_string("9223372036854775808", &p), SUCCESS, "Overflow accepted");
+}
@@ -0,0 +1,267 @@
+// tests/unit/test_risk.c
+#include <poll.h>
+#include "test_fixtures.h"
+
+#define LIMITS_FILE "test_risk_limits.txt"
+
+static void write_limits(const char* rules) {
+    FILE* file = fopen(LIMITS_FILE, "w");
+    cr_assert_not_null(file);
+    fputs(rules, file);
+    fclose(file);
+}
+
+static ServerContext* make_context(const char* rules) {
+    ServerConfig config = fixture_config();
+    if (rules) {
+        write_limits(rules);
+        strcpy(config.risk_limits_file, LIMITS_FILE);
+    }
+    return start_context(&config);
+}
+
+// Which check an order fails, RISK_CHECK_COUNT if none, against a last trade in cents
+static RiskCheck failed_check(ServerContext* context, const char* client, OrderSide side,
+                              int64_t cents, uint32_t quantity, int64_t last_cents) {
+    OrderBook* book = find_order_book(context, "AAPL");
+    cr_assert_not_null(book);
+    Order order = make_order(client, 1, side, cents, quantity);
+    RiskCheck failed;
+    risk_check_order(context, book, &order, last_cents, &failed);
+    return failed;
+}
+
+static uint64_t rejects(ServerContext* context, RiskCheck check) {
+    return atomic_load(&context->stats.risk_rejects[check]);
+}
+
+static const char* const RULES =
+    "# Order size and price sanity\n"
+    "symbol *    max_qty=500 collar_bps=500\n"
+    "symbol AAPL max_notional=20000   # $20k per order\n"
+    "\n"
+    "client small max_qty=10 credit=1000\n"
+    "client *     net=50000 gross=75000\n";
+
+Test(risk, order_limits) {
+    ServerContext* context = make_context(RULES);
+
+    cr_assert_eq(failed_check(context, "desk", ORDER_SIDE_BUY, 10000, 501, 0), RISK_CHECK_QUANTITY);
+    cr_assert_eq(failed_check(context, "small", ORDER_SIDE_SELL, 10000, 11, 0), RISK_CHECK_QUANTITY,
+                 "Client quantity limit applies as well as the symbol's");
+    cr_assert_eq(failed_check(context, "desk", ORDER_SIDE_BUY, 10000, 201, 0), RISK_CHECK_NOTIONAL);
+    cr_assert_eq(failed_check(context, "desk", ORDER_SIDE_BUY, 10000, 200, 0), RISK_CHECK_COUNT);
+
+    // Collar: 5% either side of the last trade, skipped before the first
+    cr_assert_eq(failed_check(context, "desk", ORDER_SIDE_BUY, 10600, 1, 10000), RISK_CHECK_COLLAR);
+    cr_assert_eq(failed_check(context, "desk", ORDER_SIDE_SELL, 9400, 1, 10000), RISK_CHECK_COLLAR);
+    cr_assert_eq(failed_check(context, "desk", ORDER_SIDE_BUY, 10500, 1, 10000), RISK_CHECK_COUNT);
+    cr_assert_eq(failed_check(context, "desk", ORDER_SIDE_BUY, 10600, 1, 0), RISK_CHECK_COUNT);
+
+    // Market orders are valued at the last trade
+    OrderBook* book = find_order_book(context, "AAPL");
+    Order market = make_order("desk", 1, ORDER_SIDE_BUY, 0, 300);
+    market.type = ORDER_TYPE_MARKET;
+    cr_assert_eq(risk_check_order(context, book, &market, 10000, NULL), ERROR_RISK_LIMIT);
+    cr_assert_eq(risk_check_order(context, book, &market, 1000, NULL), SUCCESS);
+
+    // Rejects through the order path are counted and never reach the book
+    cr_assert_eq(submit(context, "desk", 1, ORDER_SIDE_BUY, 10000, 501), ERROR_RISK_LIMIT);
+    cr_assert_null(find_client_order(book, 1));
+    cr_assert_geq(rejects(context, RISK_CHECK_QUANTITY), 3);
+
+    // A buy improved a tick towards the book's ask is checked at the improved price
+    cr_assert_eq(submit(context, "other", 3, ORDER_SIDE_SELL, 10100, 10), SUCCESS);
+    uint64_t notional_rejects = rejects(context, RISK_CHECK_NOTIONAL);
+    cr_assert_eq(submit(context, "desk", 2, ORDER_SIDE_BUY, 10000, 200), ERROR_RISK_LIMIT,
+                 "$20,002 at the improved price is over the notional limit");
+    cr_assert_eq(rejects(context, RISK_CHECK_NOTIONAL), notional_rejects + 1);
+
+    // Market data a client sends in moves neither the ask nor the collar
+    MarketData quote = { .last_price = create_price(20000, -2), .ask = create_price(20000, -2) };
+    strcpy(quote.symbol, "AAPL");
+    cr_assert_eq(update_symbol_market_data(context, &quote), SUCCESS);
+    cr_assert_eq(submit(context, "desk", 4, ORDER_SIDE_BUY, 10000, 10), SUCCESS,
+                 "A quote sent in moved the collar");
+    cr_assert_eq(find_client_order(book, 4)->price.mantissa, 10001, "Improved towards a quote sent in");
+
+    cleanup_server(context);
+}
+
+Test(risk, exposure_limits) {
+    ServerContext* context = make_context(RULES);
+
+    // Credit counts filled and resting buys; sells never use it
+    cr_assert_eq(submit(context, "small", 1, ORDER_SIDE_BUY, 10000, 10), SUCCESS);
+    cr_assert_eq(submit(context, "small", 2, ORDER_SIDE_BUY, 9900, 1), ERROR_RISK_LIMIT);
+    cr_assert_eq(rejects(context, RISK_CHECK_CREDIT), 1);
+    cr_assert_eq(submit(context, "small", 3, ORDER_SIDE_SELL, 10100, 10), SUCCESS);
+
+    // $20k resting per buy, improved a tick towards small's ask: the third
+    // would take net long to $60k
+    cr_assert_eq(submit(context, "desk", 4, ORDER_SIDE_BUY, 9999, 200), SUCCESS);
+    cr_assert_eq(submit(context, "desk", 5, ORDER_SIDE_BUY, 9999, 200), SUCCESS);
+    cr_assert_eq(submit(context, "desk", 6, ORDER_SIDE_BUY, 9999, 200), ERROR_RISK_LIMIT);
+    cr_assert_eq(rejects(context, RISK_CHECK_NET), 1);
+
+    // Sells add to gross but not to net long: $40k + $19.19k + $19.19k > $75k
+    cr_assert_eq(submit(context, "desk", 7, ORDER_SIDE_SELL, 10100, 190), SUCCESS);
+    cr_assert_eq(submit(context, "desk", 8, ORDER_SIDE_SELL, 10100, 190), ERROR_RISK_LIMIT);
+    cr_assert_eq(rejects(context, RISK_CHECK_GROSS), 1);
+
+    // A fill moves resting notional into the position at the same cost;
+    // small's earlier buy at the same price fills first
+    cr_assert_eq(submit(context, "other", 9, ORDER_SIDE_SELL, 10000, 100), SUCCESS);
+    uint32_t account = find_account(context, "desk");
+    cr_assert_neq(account, UINT32_MAX);
+    cr_assert_eq(atomic_load(&context->exposures[account].net), 900000);
+    cr_assert_eq(atomic_load(&context->exposures[account].open_buy), 3100000);
+    cr_assert_eq(atomic_load(&context->exposures[account].open_sell), 1919000);
+
+    cleanup_server(context);
+}
+
+static int modify(ServerContext* context, const char* client, uint64_t client_order_id,
+                  int64_t cents, uint32_t quantity) {
+    Order order = make_order(client, client_order_id, ORDER_SIDE_BUY, cents, quantity);
+    order.order_id = resting_order_id(context, client_order_id);
+    return process_modify_order(context, &order);
+}
+
+Test(risk, modifies) {
+    ServerContext* context = make_context(RULES);
+    OrderBook* book = find_order_book(context, "AAPL");
+
+    // Checked on what the modify adds over what already rests: $900 in
+    // place of $500 is within small's $1000 credit
+    cr_assert_eq(submit(context, "small", 1, ORDER_SIDE_BUY, 10000, 5), SUCCESS);
+    cr_assert_eq(modify(context, "small", 1, 10000, 9), SUCCESS);
+    cr_assert_eq(find_client_order(book, 1)->quantity, 9);
+
+    // Over the limit, the order rests as it was
+    cr_assert_eq(modify(context, "small", 1, 10100, 10), ERROR_RISK_LIMIT);
+    cr_assert_eq(rejects(context, RISK_CHECK_CREDIT), 1);
+    cr_assert_eq(modify(context, "small", 1, 10000, 11), ERROR_RISK_LIMIT);
+    cr_assert_eq(rejects(context, RISK_CHECK_QUANTITY), 1);
+    const Order* resting = find_client_order(book, 1);
+    cr_assert_eq(resting->quantity, 9);
+    cr_assert_eq(resting->price.mantissa, 10000);
+
+    // Shrinking always passes; filled shares count once, in the position
+    cr_assert_eq(modify(context, "small", 1, 10000, 4), SUCCESS);
+    cr_assert_eq(submit(context, "other", 2, ORDER_SIDE_SELL, 10000, 3), SUCCESS);
+    cr_assert_eq(modify(context, "small", 1, 10000, 10), SUCCESS,
+                 "$300 filled and $700 open is within credit");
+    cr_assert_eq(modify(context, "small", 1, 10001, 10), ERROR_RISK_LIMIT);
+    cr_assert_eq(rejects(context, RISK_CHECK_CREDIT), 2);
+
+    cleanup_server(context);
+}
+
+Test(risk, defaults_and_reload) {
+    ServerContext* context = make_context(NULL);
+    cr_assert_eq(submit(context, "desk", 1, ORDER_SIDE_BUY, 10000, DEFAULT_MAX_ORDER_QUANTITY + 1),
+                 ERROR_RISK_LIMIT);
+    cr_assert_eq(submit(context, "desk", 2, ORDER_SIDE_BUY, 10000, 50000), SUCCESS,
+                 "Notional and exposure checks are off by default");
+
+    write_limits("symbol * max_qty=50\n");
+    strcpy(context->config.risk_limits_file, LIMITS_FILE);
+    cr_assert_eq(risk_load_limits(context), SUCCESS);
+    cr_assert_eq(submit(context, "desk", 3, ORDER_SIDE_BUY, 9000, 51), ERROR_RISK_LIMIT);
+    cr_assert_eq(submit(context, "desk", 4, ORDER_SIDE_BUY, 9000, 50), SUCCESS);
+
+    // A bad file leaves the current limits in force
+    write_limits("symbol * max_qty=50\nclient desk bogus=1\n");
+    cr_assert_neq(risk_load_limits(context), SUCCESS);
+    cr_assert_eq(submit(context, "desk", 5, ORDER_SIDE_BUY, 9000, 51), ERROR_RISK_LIMIT);
+
+    // Named rules override only the fields they list, wherever they appear
+    write_limits("client desk max_qty=100\nsymbol * max_qty=50\n");
+    cr_assert_eq(risk_load_limits(context), SUCCESS);
+    cr_assert_eq(submit(context, "desk", 6, ORDER_SIDE_BUY, 9000, 51), ERROR_RISK_LIMIT,
+                 "Symbol limit still applies");
+    cr_assert_eq(submit(context, "other", 7, ORDER_SIDE_BUY, 9000, 50), SUCCESS);
+    const RiskLimits* limits = atomic_load(&context->risk_limits);
+    uint32_t account = find_account(context, "desk");
+    cr_assert_eq(limits->clients[account].max_order_quantity, 100);
+    cr_assert_eq(limits->clients[account].position_limit, DEFAULT_POSITION_LIMIT);
+    cr_assert_not_null(limits->retired, "Replaced tables stay valid for readers");
+
+    cleanup_server(context);
+    remove(LIMITS_FILE);
+}
+
+Test(risk, session_acts_for_one_client) {
+    ServerContext* context = make_context(RULES);
+    int pair[2];
+    cr_assert_eq(socketpair(AF_UNIX, SOCK_STREAM, 0, pair), 0);
+    ClientConnection* client = &context->clients[0];
+    client->socket = pair[0];
+    client->context = context;
+    client->active = 1;
+    client->account_id = UINT32_MAX;
+    atomic_store(&context->client_count, 1);
+    atomic_store(&context->stats.active_connections, 1);
+    pthread_t thread;
+    cr_assert_eq(pthread_create(&thread, NULL, handle_client, client), 0);
+
+    // The first message names the session's client; another id cannot
+    // borrow its limits, or cancel its orders, or read its PnL, and no
+    // session may report a trade of its own
+    Message msgs[5] = {
+        { .type = MSG_ORDER_NEW, .data.order = make_order("small", 0, ORDER_SIDE_BUY, 10000, 10) },
+        { .type = MSG_ORDER_NEW, .data.order = make_order("desk", 0, ORDER_SIDE_BUY, 10000, 10) },
+        { .type = MSG_ORDER_CANCEL, .data.order = make_order("desk", 1, ORDER_SIDE_BUY, 10000, 10) },
+        { .type = MSG_PNL },
+        { .type = MSG_TRADE_EXEC, .data.trade = { .trade_id = 1, .price = { 20000, -2 }, .quantity = 50 } }
+    };
+    strcpy(msgs[3].data.pnl.client_id, "desk");
+    strcpy(msgs[4].data.trade.symbol, "AAPL");
+    strcpy(msgs[4].data.trade.buyer_id, "small");
+    uint8_t frame[BUFFER_SIZE];
+    size_t length = 0;
+    for (int i = 0; i < 5; i++) {
+        int size = serialize_message(&msgs[i], frame + length, sizeof(frame) - length);
+        cr_assert_gt(size, 0);
+        length += (size_t)size;
+    }
+    cr_assert_eq(write(pair[1], frame, length), (ssize_t)length);
+
+    uint32_t acks = 0, errors = 0;
+    uint8_t buffer[BUFFER_SIZE];
+    size_t buffered = 0;
+    struct pollfd reader = { .fd = pair[1], .events = POLLIN };
+    while (acks + errors < 5 && poll(&reader, 1, 2000) > 0) {
+        ssize_t received = read(pair[1], buffer + buffered, sizeof(buffer) - buffered);
+        cr_assert_gt(received, 0);
+        buffered += (size_t)received;
+        size_t offset = 0;
+        Message msg;
+        int consumed;
+        while ((consumed = deserialize_message(buffer + offset, buffered - offset, &msg)) > 0) {
+            offset += (size_t)consumed;
+            if (msg.type == MSG_ORDER_STATUS) {
+                cr_assert_str_eq(msg.data.order.client_id, "small");
+                acks++;
+            } else if (msg.type == MSG_ERROR) {
+                cr_assert_eq(msg.data.error.code, ERROR_INVALID_MESSAGE);
+                errors++;
+            }
+        }
+        buffered -= offset;
+        memmove(buffer, buffer + offset, buffered);
+    }
+    cr_assert_eq(acks, 1);
+    cr_assert_eq(errors, 4);
+
+    close(pair[1]);
+    pthread_join(thread, NULL);
+    OrderBook* book = find_order_book(context, "AAPL");
+    cr_assert_eq(book->bid_count, 1);
+    MarketData market_data;
+    get_symbol_market_data(context, book, &market_data);
+    cr_assert_eq(market_data.num_trades, 0, "A client's trade moved the market data");
+    cr_assert_eq(find_account(context, "desk"), UINT32_MAX, "Refused id was given an account");
+    cleanup_server(context);
+}
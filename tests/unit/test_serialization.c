@@ -6,7 +6,7 @@ Test(serialization, message_serialization) {
    Message msg = {
        .type = MSG_ORDER_NEW,
        .sequence_num = 1,
-       .timestamp = time(NULL),
+       .timestamp = clock_now_ns(),
        .data.order = {
            .order_id = 12345,
            .type = ORDER_TYPE_LIMIT,
@@ -27,9 +27,33 @@ Test(serialization, message_serialization) {
    cr_assert_eq(decode_size, size, "Deserialization size mismatch");
    cr_assert_eq(decoded.type, msg.type, "Message type mismatch");
    cr_assert_eq(decoded.sequence_num, msg.sequence_num, "Sequence number mismatch");
+   cr_assert_eq(decoded.timestamp, msg.timestamp, "Timestamp mismatch");
    cr_assert_eq(decoded.data.order.order_id, msg.data.order.order_id, "Order ID mismatch");
    cr_assert_eq(decoded.data.order.type, msg.data.order.type, "Order type mismatch");
    cr_assert_eq(decoded.data.order.side, msg.data.order.side, "Order side mismatch");
    cr_assert_eq(decoded.data.order.price.mantissa, msg.data.order.price.mantissa, "Price mismatch");
    cr_assert_str_eq(decoded.data.order.symbol, msg.data.order.symbol, "Symbol mismatch");
 }
+
+Test(serialization, stream_of_messages) {
+   Message status = { .type = MSG_ORDER_STATUS, .sequence_num = 7 };
+   status.data.order.order_id = 42;
+   status.data.order.status = ORDER_STATUS_FILLED;
+   Message heartbeat = { .type = MSG_HEARTBEAT, .sequence_num = 8 };
+
+   uint8_t buffer[BUFFER_SIZE];
+   int first = serialize_message(&status, buffer, BUFFER_SIZE);
+   int second = serialize_message(&heartbeat, buffer + first, BUFFER_SIZE - first);
+   cr_assert(first > 0 && second > 0, "Serialization failed");
+
+   Message decoded;
+   cr_assert_eq(deserialize_message(buffer, first + second, &decoded), first);
+   cr_assert_eq(decoded.type, MSG_ORDER_STATUS);
+   cr_assert_eq(decoded.data.order.order_id, 42);
+   cr_assert_eq(deserialize_message(buffer + first, second, &decoded), second);
+   cr_assert_eq(decoded.type, MSG_HEARTBEAT);
+   cr_assert_eq(decoded.sequence_num, 8);
+
+   // A partial message asks for more data instead of failing
+   cr_assert_eq(deserialize_message(buffer, first - 1, &decoded), SERIAL_ERROR_INCOMPLETE);
+}
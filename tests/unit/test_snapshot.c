@@ -0,0 +1,201 @@
+// tests/unit/test_snapshot.c
+#include <sys/stat.h>
+#include "test_fixtures.h"
+
+#define SNAPSHOT_TEST_DIR "/tmp/tradesynth_test_snapshots"
+#define SNAPSHOT_TEST_JOURNAL SNAPSHOT_TEST_DIR "/orders.journal"
+
+static ServerConfig make_config(void) {
+    ServerConfig config = {
+        .port = DEFAULT_PORT,
+        .max_clients = MAX_CLIENTS,
+        .symbols = { "AAPL", "MSFT", "IBM" },
+        .symbol_count = 3,
+        .journal_sync_events = 1
+    };
+    strcpy(config.journal_file, SNAPSHOT_TEST_JOURNAL);
+    strcpy(config.snapshot_dir, SNAPSHOT_TEST_DIR);
+    return config;
+}
+
+static void clean_directory(void) {
+    char command[256];
+    snprintf(command, sizeof(command), "rm -rf %s", SNAPSHOT_TEST_DIR);
+    cr_assert_eq(system(command), 0, "Failed to clean test directory");
+    mkdir(SNAPSHOT_TEST_DIR, 0755);
+}
+
+static void submit_as(ServerContext* context, const char* client, const char* symbol, uint64_t id,
+                      OrderSide side, int64_t cents, uint32_t quantity) {
+    Order order = make_order(client, id, side, cents, quantity);
+    strcpy(order.symbol, symbol);
+    process_order(context, &order);
+}
+
+static void submit_to(ServerContext* context, const char* symbol, uint64_t id,
+                      OrderSide side, int64_t cents, uint32_t quantity) {
+    submit_as(context, "client", symbol, id, side, cents, quantity);
+}
+
+typedef struct {
+    uint64_t ids[64];
+    uint32_t count;
+} IdList;
+
+static void collect_id(const OrderBookEntry* entry, void* arg) {
+    IdList* list = arg;
+    list->ids[list->count++] = entry->order.client_order_id;
+}
+
+// Highest order id in [0] and trade id in [1]
+static int track_max_id(const JournalRecord* record, void* arg) {
+    uint64_t* max_id = arg;
+    if (record->type == JOURNAL_TRADE) {
+        if (record->data.trade.trade_id > max_id[1]) max_id[1] = record->data.trade.trade_id;
+    } else if (record->data.order.order_id > max_id[0]) {
+        max_id[0] = record->data.order.order_id;
+    }
+    return 0;
+}
+
+Test(snapshot, restore_snapshot_plus_journal_tail) {
+    clean_directory();
+    ServerConfig config = make_config();
+
+    ServerContext* context = start_context(&config);
+    submit_to(context, "AAPL", 1, ORDER_SIDE_BUY, 15000, 100);
+    submit_to(context, "AAPL", 2, ORDER_SIDE_BUY, 15000, 200);
+    submit_to(context, "MSFT", 3, ORDER_SIDE_SELL, 30000, 50);
+    cr_assert_eq(snapshot_write(context), SUCCESS, "Snapshot failed");
+
+    // Tail after the snapshot: a fill, a cancel and a new level
+    submit_to(context, "AAPL", 4, ORDER_SIDE_SELL, 15000, 150);
+    const Order* resting = find_client_order(find_order_book(context, "MSFT"), 3);
+    Order cancel = { .order_id = resting->order_id };
+    strcpy(cancel.symbol, "MSFT");
+    strcpy(cancel.client_id, "client");
+    cr_assert_eq(process_cancel_order(context, &cancel), SUCCESS, "Cancel failed");
+    submit_to(context, "AAPL", 5, ORDER_SIDE_BUY, 14900, 10);
+    cleanup_server(context);
+
+    uint64_t max_id[2] = { 0, 0 };
+    cr_assert_eq(journal_replay(SNAPSHOT_TEST_JOURNAL, 0, track_max_id, max_id), 8,
+                 "Journal record count mismatch");
+
+    context = start_context(&config);
+
+    OrderBook* aapl = find_order_book(context, "AAPL");
+    OrderBook* msft = find_order_book(context, "MSFT");
+    cr_assert_not_null(aapl, "AAPL book missing");
+    cr_assert_not_null(msft, "MSFT book missing");
+
+    IdList list = { .count = 0 };
+    orderbook_for_each(aapl, collect_id, &list);
+    cr_assert_eq(list.count, 2, "AAPL order count mismatch");
+    cr_assert_eq(list.ids[0], 2, "Priority not preserved");
+    cr_assert_eq(list.ids[1], 5, "Tail order missing");
+    cr_assert_eq(find_client_order(aapl, 2)->remaining_quantity, 150, "Partial fill lost");
+    cr_assert_eq(msft->ask_count, 0, "Cancel not replayed");
+    cr_assert_gt(generate_order_id(context), max_id[0], "Restored order ids reuse ids");
+    cr_assert_gt(generate_trade_id(context), max_id[1], "Restored trade ids reuse ids");
+
+    cleanup_server(context);
+}
+
+Test(snapshot, journal_only_restore) {
+    clean_directory();
+    ServerConfig config = make_config();
+    config.snapshot_dir[0] = '\0';
+
+    ServerContext* context = start_context(&config);
+    for (uint64_t id = 1; id <= 20; id++) {
+        submit_to(context, "IBM", id, id % 2 ? ORDER_SIDE_BUY : ORDER_SIDE_SELL, 10000 + (int64_t)id * 10, 5);
+    }
+    OrderBook* book = find_order_book(context, "IBM");
+    uint32_t bids = book->bid_count;
+    uint32_t asks = book->ask_count;
+    cleanup_server(context);
+
+    uint64_t max_id[2] = { 0, 0 };
+    journal_replay(SNAPSHOT_TEST_JOURNAL, 0, track_max_id, max_id);
+    cr_assert_gt(max_id[1], 0, "No trades journaled");
+
+    context = start_context(&config);
+    book = find_order_book(context, "IBM");
+    cr_assert_not_null(book, "Book missing after replay");
+    cr_assert_eq(book->bid_count, bids, "Bid count mismatch");
+    cr_assert_eq(book->ask_count, asks, "Ask count mismatch");
+    cr_assert_gt(generate_trade_id(context), max_id[1], "Replayed trade ids reused");
+    cleanup_server(context);
+}
+
+Test(snapshot, positions_survive_restart) {
+    clean_directory();
+    ServerConfig config = make_config();
+
+    ServerContext* context = start_context(&config);
+    Order sell = make_order("seller", 1, ORDER_SIDE_SELL, 10000, 100);
+    sell.display_quantity = 40;
+    process_order(context, &sell);
+    submit_to(context, "AAPL", 2, ORDER_SIDE_BUY, 10000, 30);
+
+    // A $10 gain realized in MSFT, last traded at $51
+    submit_as(context, "maker", "MSFT", 10, ORDER_SIDE_SELL, 5000, 10);
+    submit_as(context, "flip", "MSFT", 11, ORDER_SIDE_BUY, 5000, 10);
+    submit_as(context, "bidder", "MSFT", 12, ORDER_SIDE_BUY, 5100, 10);
+    submit_as(context, "flip", "MSFT", 13, ORDER_SIDE_SELL, 5100, 10);
+    Order stop = { .client_order_id = 14, .type = ORDER_TYPE_STOP, .side = ORDER_SIDE_BUY,
+                   .time_in_force = TIF_GTC, .stop_price = create_price(5200, -2), .quantity = 5 };
+    strcpy(stop.symbol, "MSFT");
+    strcpy(stop.client_id, "bidder");
+    cr_assert_eq(process_order(context, &stop), SUCCESS);
+    cr_assert_eq(snapshot_write(context), SUCCESS, "Snapshot failed");
+
+    // The saved stop triggers on a trade in the journal tail
+    submit_as(context, "maker", "MSFT", 15, ORDER_SIDE_SELL, 5200, 10);
+    submit_as(context, "flip", "MSFT", 16, ORDER_SIDE_BUY, 5200, 1);
+
+    // Tail: another fill and a resting buy, replayed from the journal
+    submit_to(context, "AAPL", 3, ORDER_SIDE_BUY, 10000, 20);
+    submit_to(context, "AAPL", 4, ORDER_SIDE_BUY, 9900, 15);
+    cleanup_server(context);
+
+    context = start_context(&config);
+    OrderBook* book = find_order_book(context, "AAPL");
+    const ClientPosition* seller = find_position(context, "seller", book->symbol_id);
+    const ClientPosition* buyer = find_position(context, "client", book->symbol_id);
+    cr_assert_not_null(seller);
+    cr_assert_not_null(buyer);
+    cr_assert_eq(atomic_load(&seller->position), -50);
+    cr_assert_eq(atomic_load(&seller->open_sell), 50, "Open quantity not rebuilt from the book");
+
+    // The saved iceberg showed 10 of its slice, so the tail's 20 took a refill
+    const Order* iceberg = find_client_order(book, 1);
+    cr_assert_eq(iceberg->visible_quantity, 30, "Visible slice not restored");
+    cr_assert_eq(atomic_load(&buyer->position), 50);
+    cr_assert_eq(atomic_load(&buyer->open_buy), 15);
+    cr_assert_eq(atomic_load(&buyer->total_volume), 50);
+    cr_assert_eq(atomic_load(&seller->cost), -500000, "Average cost lost across the restart");
+    cr_assert_eq(atomic_load(&buyer->cost), 500000);
+    uint32_t account = find_account(context, "seller");
+    cr_assert_eq(atomic_load(&context->exposures[account].gross), 500000);
+    cr_assert_eq(atomic_load(&context->exposures[account].open_sell), 500000);
+
+    // One trade before the snapshot and two in the tail, each counted once
+    MarketData traded;
+    get_symbol_market_data(context, book, &traded);
+    cr_assert_eq(traded.num_trades, 3, "Trades in the snapshot replayed again");
+    cr_assert_eq(traded.volume, 50);
+
+    OrderBook* msft = find_order_book(context, "MSFT");
+    cr_assert_eq(msft->stop_count, 0, "Stop not triggered by the replayed trade");
+    cr_assert_eq(find_client_order(msft, 15)->remaining_quantity, 4);
+    cr_assert_eq(atomic_load(&find_position(context, "bidder", msft->symbol_id)->position), 15);
+
+    // Realized PnL is saved; unrealized is re-marked at the last trade
+    cr_assert_eq(atomic_load(&msft->mark), 5200);
+    cr_assert_eq(atomic_load(&find_position(context, "flip", msft->symbol_id)->realized_pnl), 1000);
+    cr_assert_eq(atomic_load(&find_position(context, "maker", msft->symbol_id)->unrealized_pnl), -2000);
+    cr_assert_eq(atomic_load(&context->exposures[find_account(context, "flip")].realized_pnl), 1000);
+    cleanup_server(context);
+}
@@ -0,0 +1,204 @@
+// tests/unit/test_throttle.c
+#include <criterion/criterion.h>
+#include <poll.h>
+#include "../../include/server/server.h"
+
+#define SHARED_THREADS 4
+#define SHARED_ATTEMPTS 1000
+#define MS (NANOS_PER_SECOND / 1000)
+
+static const uint64_t T0 = 1000 * NANOS_PER_SECOND;
+
+typedef struct {
+    ThrottleBucket* bucket;
+    uint32_t taken;
+} BucketWorker;
+
+static void* drain_bucket(void* arg) {
+    BucketWorker* worker = arg;
+    for (int i = 0; i < SHARED_ATTEMPTS; i++) {
+        worker->taken += (uint32_t)throttle_take(worker->bucket, 100 * MS, 300 * MS, T0);
+    }
+    return NULL;
+}
+
+Test(throttle, bucket_refills_at_rate) {
+    // 10 per second, burst of 3
+    ThrottleBucket bucket = { 0 };
+    for (int i = 0; i < 3; i++) {
+        cr_assert(throttle_take(&bucket, 100 * MS, 300 * MS, T0), "Burst token %d refused", i);
+    }
+    cr_assert_not(throttle_take(&bucket, 100 * MS, 300 * MS, T0));
+    cr_assert_not(throttle_take(&bucket, 100 * MS, 300 * MS, T0 + 99 * MS));
+    cr_assert(throttle_take(&bucket, 100 * MS, 300 * MS, T0 + 100 * MS), "One token per interval");
+    cr_assert_not(throttle_take(&bucket, 100 * MS, 300 * MS, T0 + 100 * MS));
+
+    // Idle time refills up to the burst and no further
+    for (int i = 0; i < 3; i++) {
+        cr_assert(throttle_take(&bucket, 100 * MS, 300 * MS, T0 + 10 * NANOS_PER_SECOND));
+    }
+    cr_assert_not(throttle_take(&bucket, 100 * MS, 300 * MS, T0 + 10 * NANOS_PER_SECOND));
+
+    // Threads sharing a bucket never take more than it holds
+    ThrottleBucket shared = { 0 };
+    pthread_t threads[SHARED_THREADS];
+    BucketWorker workers[SHARED_THREADS];
+    for (int i = 0; i < SHARED_THREADS; i++) {
+        workers[i] = (BucketWorker){ .bucket = &shared };
+        pthread_create(&threads[i], NULL, drain_bucket, &workers[i]);
+    }
+    uint32_t taken = 0;
+    for (int i = 0; i < SHARED_THREADS; i++) {
+        pthread_join(threads[i], NULL);
+        taken += workers[i].taken;
+    }
+    cr_assert_eq(taken, 3);
+}
+
+static ServerContext* make_context(void) {
+    ServerConfig config = {
+        .port = DEFAULT_PORT,
+        .max_clients = 4,
+        .max_symbols = 8,
+        .symbols = { "AAPL" },
+        .symbol_count = 1,
+        .throttle = {
+            [THROTTLE_SESSION_ORDERS] = { .rate = 2 },
+            [THROTTLE_CLIENT_MESSAGES] = { .rate = 4 }
+        }
+    };
+    ServerContext* context = initialize_server_context(&config);
+    cr_assert_not_null(context, "Failed to initialize server context");
+    context->server_socket = -1;
+    return context;
+}
+
+Test(throttle, session_and_client_buckets) {
+    ServerContext* context = make_context();
+    cr_assert(context->throttle_active);
+    ClientConnection* first = &context->clients[0];
+    ClientConnection* second = &context->clients[1];
+    ClientConnection* anonymous = &context->clients[2];
+    first->account_id = second->account_id = get_or_create_account(context, "fund");
+    cr_assert_eq(anonymous->account_id, UINT32_MAX);
+
+    cr_assert_eq(throttle_admit(context, first, MSG_ORDER_NEW, T0), THROTTLE_COUNT);
+    cr_assert_eq(throttle_admit(context, first, MSG_ORDER_MODIFY, T0), THROTTLE_COUNT);
+    cr_assert_eq(throttle_admit(context, first, MSG_ORDER_NEW, T0), THROTTLE_SESSION_ORDERS);
+    cr_assert_eq(throttle_admit(context, first, MSG_HEARTBEAT, T0), THROTTLE_COUNT);
+
+    // The client id's message budget is shared by both sessions
+    cr_assert_eq(throttle_admit(context, second, MSG_ORDER_CANCEL, T0), THROTTLE_COUNT,
+                 "Cancels are not orders");
+    cr_assert_eq(throttle_admit(context, second, MSG_ORDER_NEW, T0), THROTTLE_COUNT);
+    cr_assert_eq(throttle_admit(context, second, MSG_ORDER_NEW, T0), THROTTLE_CLIENT_MESSAGES);
+
+    // A session that has not named its client id is limited by session buckets only
+    for (int i = 0; i < 2; i++) {
+        cr_assert_eq(throttle_admit(context, anonymous, MSG_ORDER_NEW, T0), THROTTLE_COUNT);
+    }
+
+    cr_assert_eq(throttle_admit(context, first, MSG_ORDER_NEW, T0 + NANOS_PER_SECOND), THROTTLE_COUNT,
+                 "Buckets refill after a second");
+    cleanup_server(context);
+}
+
+static int frame_order(uint8_t* buffer, size_t size, uint64_t order_id) {
+    Message msg = {
+        .type = MSG_ORDER_NEW,
+        .data.order = {
+            .client_order_id = order_id,
+            .type = ORDER_TYPE_LIMIT,
+            .side = ORDER_SIDE_BUY,
+            .time_in_force = TIF_GTC,
+            .price = create_price(10000 - (int64_t)order_id, -2),
+            .quantity = 10
+        }
+    };
+    strcpy(msg.data.order.symbol, "AAPL");
+    strcpy(msg.data.order.client_id, "fund");
+    return serialize_message(&msg, buffer, size);
+}
+
+// Read replies until count have arrived; the last error's text goes to error
+static void read_replies(int fd, uint32_t count, uint32_t* acks, uint32_t* errors, char* error) {
+    uint8_t buffer[BUFFER_SIZE];
+    size_t buffered = 0;
+    struct pollfd reader = { .fd = fd, .events = POLLIN };
+    *acks = *errors = 0;
+    while (*acks + *errors < count && poll(&reader, 1, 2000) > 0) {
+        ssize_t received = read(fd, buffer + buffered, sizeof(buffer) - buffered);
+        cr_assert_gt(received, 0);
+        buffered += (size_t)received;
+        size_t offset = 0;
+        Message msg;
+        int consumed;
+        while ((consumed = deserialize_message(buffer + offset, buffered - offset, &msg)) > 0) {
+            offset += (size_t)consumed;
+            if (msg.type == MSG_ORDER_STATUS) {
+                (*acks)++;
+            } else if (msg.type == MSG_ERROR) {
+                cr_assert_eq(msg.data.error.code, ERROR_THROTTLED);
+                strcpy(error, msg.data.error.message);
+                (*errors)++;
+            }
+        }
+        buffered -= offset;
+        memmove(buffer, buffer + offset, buffered);
+    }
+}
+
+static void send_orders(int fd, uint64_t first_id, uint64_t last_id) {
+    uint8_t frame[BUFFER_SIZE];
+    size_t length = 0;
+    for (uint64_t id = first_id; id <= last_id; id++) {
+        int size = frame_order(frame + length, sizeof(frame) - length, id);
+        cr_assert_gt(size, 0);
+        length += (size_t)size;
+    }
+    cr_assert_eq(write(fd, frame, length), (ssize_t)length);
+}
+
+Test(throttle, flood_is_rejected_before_decode) {
+    ServerContext* context = make_context();
+
+    int pair[2];
+    cr_assert_eq(socketpair(AF_UNIX, SOCK_STREAM, 0, pair), 0);
+    ClientConnection* client = &context->clients[0];
+    client->socket = pair[0];
+    client->context = context;
+    client->active = 1;
+    atomic_store(&context->client_count, 1);
+    atomic_store(&context->stats.active_connections, 1);
+    pthread_t thread;
+    cr_assert_eq(pthread_create(&thread, NULL, handle_client, client), 0);
+
+    // Five orders in one frame against two per second per session: one
+    // error answers all three rejects
+    uint32_t acks, errors;
+    char error[MAX_ERROR_MSG_LENGTH];
+    send_orders(pair[1], 1, 5);
+    read_replies(pair[1], 3, &acks, &errors, error);
+    cr_assert_eq(acks, 2);
+    cr_assert_eq(errors, 1);
+    cr_assert(strstr(error, "Order 3 throttled"), "%s", error);
+    cr_assert_null(strstr(error, "more throttled"), "%s", error);
+
+    // A refill later the next error owns up to the two left unanswered
+    usleep(600 * 1000);
+    send_orders(pair[1], 6, 7);
+    read_replies(pair[1], 2, &acks, &errors, error);
+    cr_assert_eq(acks, 1);
+    cr_assert_eq(errors, 1);
+    cr_assert(strstr(error, "Order 7 throttled"), "%s", error);
+    cr_assert(strstr(error, "(2 more throttled since the last error)"), "%s", error);
+
+    // Counters are final once the handler has seen the disconnect
+    close(pair[1]);
+    pthread_join(thread, NULL);
+    cr_assert_eq(atomic_load(&context->stats.throttled[THROTTLE_SESSION_ORDERS]), 4,
+                 "Every reject is counted, answered or not");
+    cr_assert_eq(atomic_load(&context->stats.messages_processed), 3, "Throttled messages are not processed");
+    cr_assert_eq(atomic_load(&client->messages_received), 7);
+    cleanup_server(context);
+}
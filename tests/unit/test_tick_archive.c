@@ -0,0 +1,165 @@
+// tests/unit/test_tick_archive.c
+#include <criterion/criterion.h>
+#include "../../include/server/server.h"
+#include "../../include/common/tick_archive.h"
+
+#define ARCHIVE_TEST_DIR "/tmp/tradesynth_test_archive"
+#define ARCHIVE_TEST_FILE ARCHIVE_TEST_DIR "/AAPL.tca"
+#define ARCHIVE_TEST_DAY 20000u
+#define ARCHIVE_TEST_RECORDS 5000
+
+typedef struct {
+    uint64_t rows;
+    uint64_t first_timestamp;
+    uint64_t last_timestamp;
+    int64_t price_sum;
+    int missing_columns;
+} ScanTotals;
+
+static uint64_t timestamp_of(uint64_t i) {
+    return ARCHIVE_TEST_DAY * NANOS_PER_DAY + i * NANOS_PER_MICRO;
+}
+
+static TickRecord make_record(uint64_t i) {
+    TickRecord record = {
+        .timestamp = timestamp_of(i),
+        .type = i % 3 == 0 ? TICK_TRADE : TICK_MARKET_DATA,
+        .quantity = (uint32_t)(100 * (1 + i % 7)),
+        .price = 15000 + (int64_t)(i % 11) - 5,
+        .bid = 14999,
+        .ask = 15001,
+        .bid_size = 500,
+        .ask_size = 700,
+        .volume = i * 100,
+        // Alternating extremes force full 64-bit deltas
+        .id = i % 2 ? UINT64_MAX - i : i
+    };
+    return record;
+}
+
+// Writes two segments so compaction has to stitch inputs together
+static void write_tick_files(TickFile files[2]) {
+    char command[256];
+    snprintf(command, sizeof(command), "rm -rf %s", ARCHIVE_TEST_DIR);
+    cr_assert_eq(system(command), 0, "Failed to clean test directory");
+
+    OrderBook book = { .symbol_id = 0, .tick_exponent = -2 };
+    strcpy(book.symbol, "AAPL");
+    TickStore* store = tick_store_open(ARCHIVE_TEST_DIR, 1, 3000, NULL);
+    cr_assert_not_null(store, "Failed to open tick store");
+    for (uint64_t i = 0; i < ARCHIVE_TEST_RECORDS; i++) {
+        TickRecord record = make_record(i);
+        cr_assert_eq(tick_store_prepare(store, &book, record.timestamp), SUCCESS);
+        cr_assert_eq(tick_store_append(store, &book, &record), SUCCESS);
+    }
+    tick_store_close(store);
+
+    for (uint32_t segment = 0; segment < 2; segment++) {
+        char path[512];
+        tick_file_path(path, sizeof(path), ARCHIVE_TEST_DIR, "AAPL", ARCHIVE_TEST_DAY, segment);
+        cr_assert_eq(tick_file_open(&files[segment], path), SUCCESS, "Missing segment %u", segment);
+    }
+}
+
+static int check_rows(const TickBlockView* view, void* arg) {
+    ScanTotals* totals = arg;
+    for (uint32_t i = 0; i < view->count; i++) {
+        uint64_t index = (uint64_t)(view->columns[TICK_COLUMN_TIMESTAMP][i] -
+                                    (int64_t)timestamp_of(0)) / NANOS_PER_MICRO;
+        TickRecord expected = make_record(index);
+        cr_assert_eq(view->columns[TICK_COLUMN_TYPE][i], expected.type);
+        cr_assert_eq(view->columns[TICK_COLUMN_QUANTITY][i], expected.quantity);
+        cr_assert_eq(view->columns[TICK_COLUMN_PRICE][i], expected.price);
+        cr_assert_eq(view->columns[TICK_COLUMN_ASK_SIZE][i], expected.ask_size);
+        cr_assert_eq(view->columns[TICK_COLUMN_VOLUME][i], (int64_t)expected.volume);
+        cr_assert_eq((uint64_t)view->columns[TICK_COLUMN_ID][i], expected.id, "Row %lu id", index);
+        if (totals->rows == 0) totals->first_timestamp = (uint64_t)view->columns[TICK_COLUMN_TIMESTAMP][i];
+        totals->last_timestamp = (uint64_t)view->columns[TICK_COLUMN_TIMESTAMP][i];
+        totals->rows++;
+    }
+    return 0;
+}
+
+static int sum_prices(const TickBlockView* view, void* arg) {
+    ScanTotals* totals = arg;
+    totals->missing_columns += view->columns[TICK_COLUMN_TIMESTAMP] != NULL ||
+                               view->columns[TICK_COLUMN_ID] != NULL;
+    for (uint32_t i = 0; i < view->count; i++) {
+        totals->price_sum += view->columns[TICK_COLUMN_PRICE][i];
+    }
+    totals->rows += view->count;
+    return 0;
+}
+
+Test(tick_archive, round_trips_every_column) {
+    TickFile files[2];
+    write_tick_files(files);
+    cr_assert_eq(tick_archive_write(ARCHIVE_TEST_FILE, files, 2), SUCCESS);
+    tick_file_close(&files[0]);
+    tick_file_close(&files[1]);
+
+    TickArchive archive;
+    cr_assert_eq(tick_archive_open(&archive, ARCHIVE_TEST_FILE), SUCCESS);
+    cr_assert_eq(archive.header->record_count, ARCHIVE_TEST_RECORDS);
+    cr_assert_eq(archive.header->price_exponent, -2);
+    cr_assert_str_eq(archive.header->symbol, "AAPL");
+
+    ScanTotals totals = {0};
+    int64_t rows = tick_archive_scan(&archive, 0, UINT64_MAX, TICK_COLUMNS_ALL, check_rows, &totals);
+    cr_assert_eq(rows, ARCHIVE_TEST_RECORDS);
+    cr_assert_eq(totals.first_timestamp, timestamp_of(0));
+    cr_assert_eq(totals.last_timestamp, timestamp_of(ARCHIVE_TEST_RECORDS - 1));
+    tick_archive_close(&archive);
+}
+
+Test(tick_archive, time_range_selects_rows) {
+    TickFile files[2];
+    write_tick_files(files);
+    cr_assert_eq(tick_archive_write(ARCHIVE_TEST_FILE, files, 2), SUCCESS);
+    tick_file_close(&files[0]);
+    tick_file_close(&files[1]);
+
+    TickArchive archive;
+    cr_assert_eq(tick_archive_open(&archive, ARCHIVE_TEST_FILE), SUCCESS);
+
+    // Straddles block boundaries on both ends
+    ScanTotals totals = {0};
+    int64_t rows = tick_archive_scan(&archive, timestamp_of(1000), timestamp_of(3500),
+                                     TICK_COLUMNS_ALL, check_rows, &totals);
+    cr_assert_eq(rows, 2500);
+    cr_assert_eq(totals.first_timestamp, timestamp_of(1000));
+    cr_assert_eq(totals.last_timestamp, timestamp_of(3499));
+
+    rows = tick_archive_scan(&archive, timestamp_of(ARCHIVE_TEST_RECORDS), UINT64_MAX,
+                             TICK_COLUMNS_ALL, check_rows, &totals);
+    cr_assert_eq(rows, 0, "Range past the end returned rows");
+    tick_archive_close(&archive);
+}
+
+Test(tick_archive, decodes_only_requested_columns) {
+    TickFile files[2];
+    write_tick_files(files);
+    cr_assert_eq(tick_archive_write(ARCHIVE_TEST_FILE, files, 2), SUCCESS);
+
+    int64_t expected = 0;
+    for (uint64_t i = 0; i < ARCHIVE_TEST_RECORDS; i++) {
+        expected += make_record(i).price;
+    }
+
+    TickArchive archive;
+    cr_assert_eq(tick_archive_open(&archive, ARCHIVE_TEST_FILE), SUCCESS);
+    ScanTotals totals = {0};
+    int64_t rows = tick_archive_scan(&archive, timestamp_of(0), UINT64_MAX,
+                                     TICK_COLUMN_BIT(TICK_COLUMN_PRICE), sum_prices, &totals);
+    cr_assert_eq(rows, ARCHIVE_TEST_RECORDS);
+    cr_assert_eq(totals.price_sum, expected);
+    cr_assert_eq(totals.missing_columns, 0, "Unrequested columns were exposed");
+
+    // Constant and narrow columns must pack well below the raw records
+    uint64_t raw = ARCHIVE_TEST_RECORDS * sizeof(TickRecord);
+    cr_assert_lt(archive.map_size * 2, raw, "Archive is %zu bytes for %lu raw", archive.map_size, raw);
+
+    tick_archive_close(&archive);
+    tick_file_close(&files[0]);
+    tick_file_close(&files[1]);
+}
@@ -0,0 +1,156 @@
+// tests/unit/test_tick_store.c
+#include <criterion/criterion.h>
+#include "../../include/server/server.h"
+
+#define TICK_TEST_DIR "/tmp/tradesynth_test_ticks"
+#define TICK_TEST_DAY 20000u
+
+static void clean_directory(void) {
+    char command[256];
+    snprintf(command, sizeof(command), "rm -rf %s", TICK_TEST_DIR);
+    cr_assert_eq(system(command), 0, "Failed to clean test directory");
+}
+
+static OrderBook make_book(void) {
+    OrderBook book = { .symbol_id = 0, .tick_exponent = -2 };
+    strcpy(book.symbol, "AAPL");
+    return book;
+}
+
+static TickRecord make_trade(uint32_t day, uint64_t id) {
+    TickRecord record = {
+        .timestamp = day * NANOS_PER_DAY + id * NANOS_PER_MICRO,
+        .type = TICK_TRADE,
+        .quantity = (uint32_t)id,
+        .price = 15000 + (int64_t)id,
+        .id = id
+    };
+    return record;
+}
+
+static uint64_t file_count(uint32_t day, uint32_t segment) {
+    char path[512];
+    cr_assert_geq(tick_file_path(path, sizeof(path), TICK_TEST_DIR, "AAPL", day, segment), 0);
+
+    TickFile file;
+    cr_assert_eq(tick_file_open(&file, path), SUCCESS, "Failed to open %s", path);
+    uint64_t count = tick_file_count(&file);
+    tick_file_close(&file);
+    return count;
+}
+
+Test(tick_store, records_read_back_in_place) {
+    clean_directory();
+    ServerStats stats;
+    memset(&stats, 0, sizeof(stats));
+    OrderBook book = make_book();
+
+    TickStore* store = tick_store_open(TICK_TEST_DIR, 4, 0, &stats);
+    cr_assert_not_null(store, "Failed to open tick store");
+
+    // Nothing is opened on the append path; a file has to be prepared first
+    TickRecord early = make_trade(TICK_TEST_DAY, 0);
+    cr_assert_eq(tick_store_append(store, &book, &early), ERROR_INVALID_STATE);
+    cr_assert_eq(atomic_load(&stats.ticks_dropped), 1);
+    cr_assert_eq(atomic_load(&stats.tick_files), 0);
+    cr_assert_eq(tick_store_prepare(store, &book, TICK_TEST_DAY * NANOS_PER_DAY), SUCCESS);
+    for (uint64_t id = 1; id <= 1000; id++) {
+        TickRecord record = make_trade(TICK_TEST_DAY, id);
+        cr_assert_eq(tick_store_append(store, &book, &record), SUCCESS);
+    }
+
+    // Readers see published records while the file is still being written
+    char path[512];
+    tick_file_path(path, sizeof(path), TICK_TEST_DIR, "AAPL", TICK_TEST_DAY, 0);
+    TickFile file;
+    cr_assert_eq(tick_file_open(&file, path), SUCCESS);
+    cr_assert_eq(tick_file_count(&file), 1000);
+    cr_assert_str_eq(file.header->symbol, "AAPL");
+    cr_assert_eq(file.header->price_exponent, -2);
+    cr_assert_eq(file.header->capacity, TICK_STORE_DEFAULT_RECORDS);
+
+    for (uint64_t i = 0; i < 1000; i++) {
+        const TickRecord* record = &file.records[i];
+        cr_assert_eq(record->id, i + 1, "Record %lu out of order", i);
+        cr_assert_eq(record->price, 15001 + (int64_t)i);
+    }
+    Price price = tick_price(&file, file.records[0].price);
+    cr_assert_eq(price.mantissa, 15001);
+    cr_assert_eq(price.exponent, -2);
+
+    tick_store_close(store);
+    tick_file_close(&file);
+    cr_assert_eq(atomic_load(&stats.ticks_captured), 1000);
+    cr_assert_eq(atomic_load(&stats.ticks_dropped), 1);
+}
+
+Test(tick_store, rolls_over_by_day_and_when_full) {
+    clean_directory();
+    OrderBook book = make_book();
+
+    // Prepared between appends, as the timer tick would
+    TickStore* store = tick_store_open(TICK_TEST_DIR, 4, 4, NULL);
+    cr_assert_not_null(store, "Failed to open tick store");
+    uint64_t noon = TICK_TEST_DAY * NANOS_PER_DAY + NANOS_PER_DAY / 2;
+    for (uint64_t id = 1; id <= 6; id++) {
+        cr_assert_eq(tick_store_prepare(store, &book, noon), SUCCESS);
+        TickRecord record = make_trade(TICK_TEST_DAY, id);
+        cr_assert_eq(tick_store_append(store, &book, &record), SUCCESS);
+    }
+
+    // The next day's file is ready before midnight
+    cr_assert_eq(tick_store_prepare(store, &book, (TICK_TEST_DAY + 1) * NANOS_PER_DAY - 1), SUCCESS);
+    TickRecord next_day = make_trade(TICK_TEST_DAY + 1, 7);
+    cr_assert_eq(tick_store_append(store, &book, &next_day), SUCCESS);
+    tick_store_close(store);
+
+    cr_assert_eq(file_count(TICK_TEST_DAY, 0), 4);
+    cr_assert_eq(file_count(TICK_TEST_DAY, 1), 2);
+    cr_assert_eq(file_count(TICK_TEST_DAY + 1, 0), 1);
+
+    // Reopening appends to the segment that still has room
+    store = tick_store_open(TICK_TEST_DIR, 4, 4, NULL);
+    cr_assert_eq(tick_store_prepare(store, &book, noon), SUCCESS);
+    TickRecord late = make_trade(TICK_TEST_DAY, 8);
+    cr_assert_eq(tick_store_append(store, &book, &late), SUCCESS);
+    tick_store_close(store);
+    cr_assert_eq(file_count(TICK_TEST_DAY, 1), 3);
+}
+
+Test(tick_store, server_captures_quotes_and_trades) {
+    clean_directory();
+    ServerConfig config = {
+        .port = DEFAULT_PORT,
+        .max_clients = MAX_CLIENTS
+    };
+    strcpy(config.tick_dir, TICK_TEST_DIR);
+    ServerContext* context = initialize_server_context(&config);
+    cr_assert_not_null(context, "Failed to initialize server");
+    cr_assert_not_null(get_or_create_order_book(context, "AAPL"), "Registering prepares its first file");
+
+    MarketData quote = { .bid = create_price(14990, -2), .ask = create_price(15010, -2),
+                         .bid_size = 300, .ask_size = 200 };
+    strcpy(quote.symbol, "AAPL");
+    cr_assert_eq(update_symbol_market_data(context, &quote), SUCCESS);
+
+    TradeExecution trade = { .trade_id = 42, .price = create_price(150, 0), .quantity = 25 };
+    strcpy(trade.symbol, "AAPL");
+    cr_assert_eq(update_symbol_last_trade(context, &trade), SUCCESS);
+
+    uint32_t day = (uint32_t)(clock_now_ns() / NANOS_PER_DAY);
+    context->server_socket = -1;
+    cleanup_server(context);
+
+    char path[512];
+    tick_file_path(path, sizeof(path), TICK_TEST_DIR, "AAPL", day, 0);
+    TickFile file;
+    cr_assert_eq(tick_file_open(&file, path), SUCCESS);
+    cr_assert_eq(tick_file_count(&file), 2);
+    cr_assert_eq(file.records[0].type, TICK_MARKET_DATA);
+    cr_assert_eq(file.records[0].bid, 14990);
+    cr_assert_eq(file.records[1].type, TICK_TRADE);
+    cr_assert_eq(file.records[1].price, 15000, "Trade price not in ticks");
+    cr_assert_eq(file.records[1].ask, 15010, "Trade missing the quote in force");
+    cr_assert_eq(file.records[1].volume, 25);
+    tick_file_close(&file);
+}
@@ -0,0 +1,283 @@
+// tests/unit/test_timers.c
+#include <poll.h>
+#include "test_fixtures.h"
+
+#define MS (NANOS_PER_SECOND / 1000)
+#define TIMER_COUNT 600
+#define YEAR (365 * NANOS_PER_DAY)
+
+static const uint64_t T0 = 1000 * NANOS_PER_SECOND;
+
+typedef struct {
+    TimerNode node;
+    uint64_t deadline;
+    uint32_t fired;
+} TestTimer;
+
+typedef struct {
+    TimerWheel* wheel;
+    uint64_t now;
+    uint64_t step;
+} Sweep;
+
+static TestTimer timers[TIMER_COUNT];
+
+static void record(TimerNode* node, void* arg) {
+    Sweep* sweep = arg;
+    TestTimer* timer = (TestTimer*)node;
+    cr_assert_leq(timer->deadline, sweep->now, "Timer fired early");
+    cr_assert_lt(sweep->now - timer->deadline, sweep->step + (1ULL << TIMER_TICK_SHIFT), "Timer fired late");
+    timer->fired++;
+
+    // The first timer puts itself back once, as a session deadline does
+    if (timer == &timers[0] && timer->fired == 1) {
+        timer->deadline = sweep->now + NANOS_PER_SECOND;
+        timer_arm(sweep->wheel, node, timer->deadline);
+    }
+}
+
+Test(timers, wheel_fires_each_timer_once_on_time) {
+    TimerWheel wheel;
+    timer_wheel_init(&wheel, T0);
+
+    // Spread from already due to days out, plus some past the wheel's reach
+    for (uint32_t i = 0; i < TIMER_COUNT; i++) {
+        uint64_t offset = (uint64_t)i * i * 7919 * MS % (3 * NANOS_PER_DAY);
+        timers[i].deadline = i % 100 == 99 ? T0 + 3 * YEAR + i : T0 + offset;
+        timers[i].fired = 0;
+        timer_arm(&wheel, &timers[i].node, timers[i].deadline);
+    }
+    cr_assert_eq(wheel.count, TIMER_COUNT);
+    cr_assert_leq(timer_wheel_due(&wheel), T0 + (1ULL << TIMER_TICK_SHIFT));
+
+    // Every fifth is cancelled, every seventh moved
+    for (uint32_t i = 5; i < TIMER_COUNT; i += 5) {
+        timer_cancel(&wheel, &timers[i].node);
+        cr_assert_not(timer_armed(&timers[i].node));
+    }
+    for (uint32_t i = 7; i < TIMER_COUNT; i += 7) {
+        if (timer_armed(&timers[i].node)) {
+            timers[i].deadline += 90 * MS;
+            timer_arm(&wheel, &timers[i].node, timers[i].deadline);
+        }
+    }
+
+    // Small steps for the first minutes, then growing ones
+    Sweep sweep = { .wheel = &wheel, .now = T0, .step = MS };
+    while (sweep.now < T0 + 4 * YEAR) {
+        sweep.now += sweep.step;
+        timer_wheel_advance(&wheel, sweep.now, record, &sweep);
+        if (sweep.now > T0 + 120 * NANOS_PER_SECOND && sweep.step < NANOS_PER_DAY) {
+            sweep.step *= 2;
+        }
+    }
+
+    for (uint32_t i = 0; i < TIMER_COUNT; i++) {
+        uint32_t expected = i == 0 ? 2 : (i % 5 == 0 ? 0 : 1);
+        cr_assert_eq(timers[i].fired, expected, "Timer %u fired %u times", i, timers[i].fired);
+    }
+    cr_assert_eq(wheel.count, 0);
+    cr_assert_eq(timer_wheel_due(&wheel), UINT64_MAX);
+
+    // A wheel left alone jumps straight to the next timer
+    timers[1].deadline = sweep.now + 30 * NANOS_PER_DAY;
+    timer_arm(&wheel, &timers[1].node, timers[1].deadline);
+    sweep.step = 30 * NANOS_PER_DAY + MS;
+    sweep.now += sweep.step;
+    cr_assert_eq(timer_wheel_advance(&wheel, sweep.now, record, &sweep), 1);
+}
+
+static ServerContext* make_context(uint32_t day_end, int socket_timeout) {
+    ServerConfig config = fixture_config();
+    config.socket_timeout = socket_timeout;
+    config.day_end = day_end;
+    return start_context(&config);
+}
+
+// A desk buy of 10 at $99, or a stop at $110 for the stop types
+static int submit_expiring(ServerContext* context, uint64_t id, OrderType type, TimeInForce tif,
+                           uint64_t expiration_time) {
+    Order order = make_order("desk", id, ORDER_SIDE_BUY, 9900, 10);
+    order.type = type;
+    order.time_in_force = tif;
+    order.stop_price = create_price(11000, -2);
+    order.expiration_time = expiration_time;
+    return process_order(context, &order);
+}
+
+Test(timers, orders_expire_at_deadline_and_day_end) {
+    // The day ends an hour from now
+    uint64_t now = clock_now_ns();
+    uint32_t day_end = (uint32_t)((now / NANOS_PER_SECOND + 3600) % 86400);
+    ServerContext* context = make_context(day_end ? day_end : 86400, 0);
+    uint64_t day_end_ns = timers_next_day_end(context->config.day_end, now);
+    cr_assert_leq(day_end_ns - now, 3600 * NANOS_PER_SECOND);
+
+    cr_assert_eq(submit_expiring(context, 1, ORDER_TYPE_LIMIT, TIF_GTC, now + 2 * NANOS_PER_SECOND), SUCCESS);
+    cr_assert_eq(submit_expiring(context, 2, ORDER_TYPE_LIMIT, TIF_DAY, 0), SUCCESS);
+    cr_assert_eq(submit_expiring(context, 3, ORDER_TYPE_LIMIT, TIF_GTC, 0), SUCCESS);
+    cr_assert_eq(submit_expiring(context, 4, ORDER_TYPE_STOP_LIMIT, TIF_DAY, day_end_ns + NANOS_PER_SECOND), SUCCESS);
+    cr_assert_eq(submit_expiring(context, 5, ORDER_TYPE_LIMIT, TIF_GTC, now - NANOS_PER_SECOND), ERROR_INVALID_ORDER,
+                 "Already expired");
+
+    OrderBook* book = find_order_book(context, "AAPL");
+    const ClientPosition* row = find_position(context, "desk", book->symbol_id);
+    cr_assert_not_null(row);
+    cr_assert_eq(atomic_load(&row->open_buy), 30, "Stops are not open quantity");
+
+    timers_tick(context, now + NANOS_PER_SECOND);
+    cr_assert_not_null(find_client_order(book, 1));
+    timers_tick(context, now + 3 * NANOS_PER_SECOND);
+    cr_assert_null(find_client_order(book, 1));
+    cr_assert_eq(atomic_load(&row->open_buy), 20);
+    cr_assert_eq(atomic_load(&context->stats.orders_expired), 1);
+
+    // DAY orders go at the day end, the stop too, whatever its own expiry
+    timers_tick(context, day_end_ns - MS);
+    cr_assert_not_null(find_client_order(book, 2));
+    timers_tick(context, day_end_ns + MS);
+    cr_assert_null(find_client_order(book, 2));
+    cr_assert_null(find_client_order(book, 4));
+    cr_assert_not_null(find_client_order(book, 3), "GTC without a deadline stays");
+    cr_assert_eq(book->stop_count, 0);
+    cr_assert_eq(atomic_load(&row->open_buy), 10);
+    cr_assert_eq(atomic_load(&context->stats.orders_expired), 3);
+    cr_assert_eq(atomic_load(&book->next_expiry), UINT64_MAX);
+
+    cleanup_server(context);
+}
+
+static int readable(int socket) {
+    struct pollfd reader = { .fd = socket, .events = POLLIN };
+    return poll(&reader, 1, 0) > 0;
+}
+
+Test(timers, silent_sessions_time_out) {
+    ServerContext* context = make_context(0, 5);
+    uint64_t now = clock_now_ns();
+
+    int pair[2];
+    cr_assert_eq(socketpair(AF_UNIX, SOCK_STREAM, 0, pair), 0);
+    ClientConnection* client = &context->clients[0];
+    client->socket = pair[0];
+    client->active = 1;
+    client->connect_time = client->last_heartbeat = now;
+    timers_watch_session(context, client);
+
+    // A slot whose session has gone is dropped from the wheel when it comes due
+    ClientConnection* gone = &context->clients[1];
+    gone->connect_time = now;
+    timers_watch_session(context, gone);
+
+    timers_tick(context, now + 4 * NANOS_PER_SECOND);
+    cr_assert_not(readable(pair[1]));
+
+    // Traffic moves the deadline without touching the wheel until it comes due
+    client->last_heartbeat = now + 3 * NANOS_PER_SECOND;
+    timers_tick(context, now + 6 * NANOS_PER_SECOND);
+    cr_assert_not(readable(pair[1]));
+    cr_assert(timer_armed(&client->heartbeat_timer));
+    cr_assert_not(timer_armed(&gone->heartbeat_timer));
+
+    timers_tick(context, now + 9 * NANOS_PER_SECOND);
+    cr_assert(readable(pair[1]));
+    char byte;
+    cr_assert_eq(read(pair[1], &byte, 1), 0, "Session was shut down");
+    cr_assert_eq(atomic_load(&context->stats.sessions_timed_out), 1);
+
+    client->active = 0;
+    close(pair[0]);
+    close(pair[1]);
+    cleanup_server(context);
+}
+
+Test(timers, auction_schedule) {
+    // Opening call up to 09:30, closing call 16:00 to the 16:30 day end
+    ServerConfig config = { .auction_open = 34200, .auction_close = 57600, .day_end = 59400 };
+    uint64_t midnight = 20000 * NANOS_PER_DAY;
+    uint64_t call_ends, next;
+
+    cr_assert_eq(timers_auction_phase(&config, midnight + 8 * 3600 * NANOS_PER_SECOND, &call_ends, &next),
+                 BOOK_PHASE_CALL);
+    cr_assert_eq(call_ends, midnight + 34200 * NANOS_PER_SECOND);
+    cr_assert_eq(next, call_ends);
+    cr_assert_eq(timers_auction_phase(&config, midnight + 12 * 3600 * NANOS_PER_SECOND, &call_ends, &next),
+                 BOOK_PHASE_CONTINUOUS);
+    cr_assert_eq(call_ends, 0);
+    cr_assert_eq(next, midnight + 57600 * NANOS_PER_SECOND);
+    cr_assert_eq(timers_auction_phase(&config, midnight + 58000 * NANOS_PER_SECOND, &call_ends, &next),
+                 BOOK_PHASE_CALL);
+    cr_assert_eq(call_ends, midnight + 59400 * NANOS_PER_SECOND, "Closing call uncrosses at the day end");
+
+    // After the day end the next opening call has already begun
+    cr_assert_eq(timers_auction_phase(&config, midnight + 60000 * NANOS_PER_SECOND, &call_ends, &next),
+                 BOOK_PHASE_CALL);
+    cr_assert_eq(call_ends, midnight + NANOS_PER_DAY + 34200 * NANOS_PER_SECOND);
+
+    ServerConfig off = { .day_end = 59400 };
+    cr_assert_eq(timers_auction_phase(&off, midnight, &call_ends, &next), BOOK_PHASE_CONTINUOUS);
+    cr_assert_eq(next, UINT64_MAX);
+}
+
+#define AUCTION_JOURNAL "/tmp/tradesynth_test_auction.journal"
+
+Test(timers, call_auction_uncrosses_on_schedule) {
+    // The opening call began an hour ago, at the day end, and uncrosses in an hour
+    uint64_t now = clock_now_ns();
+    uint32_t time_of_day = (uint32_t)(now / NANOS_PER_SECOND % 86400);
+    ServerConfig config = fixture_config();
+    config.day_end = (time_of_day + 86400 - 3600) % 86400 ? (time_of_day + 86400 - 3600) % 86400 : 86400;
+    config.auction_open = (time_of_day + 3600) % 86400 ? (time_of_day + 3600) % 86400 : 86400;
+    config.journal_sync_events = 1;
+    strcpy(config.journal_file, AUCTION_JOURNAL);
+    unlink(AUCTION_JOURNAL);
+    ServerContext* context = start_context(&config);
+
+    cr_assert_eq(submit(context, "desk", 1, ORDER_SIDE_BUY, 10000, 30), SUCCESS);
+    cr_assert_eq(submit(context, "fund", 2, ORDER_SIDE_SELL, 9900, 20), SUCCESS);
+    OrderBook* book = find_order_book(context, "AAPL");
+    cr_assert_eq(book->phase, BOOK_PHASE_CALL);
+    cr_assert_eq(book->trade_count, 0, "Orders matched during the call");
+    cr_assert_leq(book->call_ends - now, 3600 * NANOS_PER_SECOND);
+
+    Order market = make_order("desk", 3, ORDER_SIDE_BUY, 0, 5);
+    market.type = ORDER_TYPE_MARKET;
+    cr_assert_eq(process_order(context, &market), ERROR_INVALID_ORDER, "Market order accepted in a call");
+
+    // The indicative quote goes out once per change
+    cr_assert_eq(publish_indicative(context, book), 1);
+    cr_assert_eq(publish_indicative(context, book), 0);
+    MarketData quoted;
+    get_symbol_market_data(context, book, &quoted);
+    cr_assert_eq(quoted.indicative_price.mantissa, 9900);
+    cr_assert_eq(quoted.indicative_volume, 20);
+
+    timers_tick(context, book->call_ends - MS);
+    cr_assert_eq(book->phase, BOOK_PHASE_CALL);
+    timers_tick(context, book->call_ends + MS);
+    cr_assert_eq(book->phase, BOOK_PHASE_CONTINUOUS);
+    cr_assert_eq(book->trade_count, 1);
+    cr_assert_eq(book->last_trade, 9900);
+    get_symbol_market_data(context, book, &quoted);
+    cr_assert_eq(quoted.indicative_volume, 0, "Indicative quote not cleared after the uncross");
+
+    // Both sides were resting: each releases open quantity at its own limit
+    uint32_t desk = find_account(context, "desk");
+    const ClientPosition* buyer = find_position(context, "desk", book->symbol_id);
+    cr_assert_eq(atomic_load(&buyer->position), 20);
+    cr_assert_eq(atomic_load(&buyer->open_buy), 10);
+    cr_assert_eq(atomic_load(&context->exposures[desk].open_buy), position_notional(10000, 10, -2));
+    cr_assert_eq(atomic_load(&context->exposures[find_account(context, "fund")].open_sell), 0);
+    cleanup_server(context);
+
+    // A replay of the journal uncrosses at the same point
+    context = start_context(&config);
+    book = find_order_book(context, "AAPL");
+    cr_assert_eq(book->phase, BOOK_PHASE_CONTINUOUS);
+    cr_assert_eq(book->last_trade, 9900);
+    cr_assert_eq(find_client_order(book, 1)->remaining_quantity, 10);
+    cr_assert_null(find_client_order(book, 2));
+    cr_assert_eq(atomic_load(&find_position(context, "fund", book->symbol_id)->position), -20);
+    cleanup_server(context);
+    unlink(AUCTION_JOURNAL);
+}